@@ -0,0 +1,236 @@
+#include "../headers/exporter.hpp"
+#include "../../core/header/TerminalRenderer.hpp"
+#include "../../core/header/Exceptions.hpp"
+#include "../../core/header/Shell.hpp"
+
+#ifndef _WIN32
+#include "../../modules/headers/MetricsExporter.hpp"
+#include "../../modules/headers/NetlinkRoute.hpp"
+#include "../../modules/headers/ProcSampler.hpp"
+#include "../../modules/headers/ReachabilityProbe.hpp"
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+namespace {
+
+using RedTops::MetricsWriter;
+using Type = MetricsWriter::Type;
+
+struct ExporterOptions {
+    std::string listen = ":9100";
+    double interval = 5.0;                  // seconds between renders
+    std::vector<std::string> probes;        // host or host:port
+    std::vector<std::string> ifaces;        // empty = all
+};
+
+void SplitList(const std::string& text, std::vector<std::string>& out) {
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        if (!item.empty()) out.push_back(item);
+}
+
+ExporterOptions ParseOptions(const std::vector<std::string>& args) {
+    ExporterOptions o;
+    auto value = [&](size_t& i) -> const std::string& {
+        if (i + 1 >= args.size()) throw RedTops::CommandError("exporter: " + args[i] + " needs a value");
+        return args[++i];
+    };
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if (arg == "-l" || arg == "--listen" || arg == "--exporter") o.listen = value(i);
+        else if (arg == "-i" || arg == "--interval") {
+            o.interval = std::strtod(value(i).c_str(), nullptr);
+            if (o.interval < 0.1) throw RedTops::CommandError("exporter: interval must be at least 0.1 s");
+        }
+        else if (arg == "--probe") SplitList(value(i), o.probes);
+        else if (arg == "--iface") SplitList(value(i), o.ifaces);
+        else if (!arg.empty() && arg[0] != '-') o.listen = arg;
+        else throw RedTops::CommandError("exporter: unknown option " + arg);
+    }
+    return o;
+}
+
+// Cumulative CPU time per core and mode, plus load and context switches
+void AddCpuCollector(RedTops::MetricsExporter& exporter) {
+    struct State {
+        RedTops::ProcFile stat{"/proc/stat"};
+        RedTops::ProcFile loadavg{"/proc/loadavg"};
+        double tick = 1.0 / static_cast<double>(std::max(1L, sysconf(_SC_CLK_TCK)));
+    };
+    auto st = std::make_shared<State>();
+    exporter.AddCollector("cpu", [st](MetricsWriter& w) {
+        static const char* kModes[] = {"user", "nice", "system", "idle", "iowait", "irq", "softirq", "steal"};
+        std::string_view text = st->stat.Read();
+        if (text.empty()) throw RedTops::CommandError("exporter: /proc/stat unreadable");
+
+        w.Family("redtops_cpu_seconds", Type::Counter, "CPU time spent in each mode");
+        uint64_t ctxt = 0;
+        while (!text.empty()) {
+            size_t eol = text.find('\n');
+            std::string_view line = text.substr(0, eol);
+            text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+
+            RedTops::FieldReader r(line);
+            std::string_view key = r.Word();
+            if (key == "ctxt") ctxt = r.U64();
+            if (key.size() <= 3 || key.substr(0, 3) != "cpu") continue;   // per-core lines only
+            std::string cpu(key.substr(3));
+            for (const char* mode : kModes)
+                w.Sample(static_cast<double>(r.U64()) * st->tick, {{"cpu", cpu}, {"mode", mode}});
+        }
+        w.Family("redtops_context_switches", Type::Counter, "Context switches since boot");
+        w.Sample(static_cast<double>(ctxt));
+
+        RedTops::FieldReader la(st->loadavg.Read());
+        const char* kLoads[] = {"redtops_load1", "redtops_load5", "redtops_load15"};
+        for (const char* name : kLoads) {
+            w.Family(name, Type::Gauge, "Load average");
+            w.Sample(la.Double());
+        }
+    });
+}
+
+void AddMemoryCollector(RedTops::MetricsExporter& exporter) {
+    auto memory = std::make_shared<RedTops::MemorySampler>();
+    auto pressure = std::make_shared<RedTops::PressureSampler>();
+    exporter.AddCollector("memory", [memory, pressure](MetricsWriter& w) {
+        RedTops::MemoryInfo m = memory->Sample();
+        if (!m.total) throw RedTops::CommandError("exporter: /proc/meminfo unreadable");
+        struct Row { const char* name; const char* help; uint64_t value; };
+        const Row rows[] = {
+            {"redtops_memory_total_bytes", "Physical memory", m.total},
+            {"redtops_memory_available_bytes", "Memory available without swapping (MemAvailable)", m.available},
+            {"redtops_memory_used_bytes", "Total minus available", m.used()},
+            {"redtops_memory_cache_bytes", "Buffers, page cache and reclaimable slab", m.cache()},
+            {"redtops_memory_shmem_bytes", "Shared memory and tmpfs", m.shmem},
+            {"redtops_memory_dirty_bytes", "Dirty pages waiting for writeback", m.dirty},
+            {"redtops_swap_total_bytes", "Swap space", m.swap_total},
+            {"redtops_swap_used_bytes", "Swap in use", m.swap_used()},
+        };
+        for (const Row& row : rows) {
+            w.Family(row.name, Type::Gauge, row.help);
+            w.Sample(static_cast<double>(row.value));
+        }
+
+        pressure->Sample();
+        w.Family("redtops_pressure_stalled_seconds", Type::Counter, "Time tasks stalled on a resource (PSI)");
+        for (int r = 0; r < RedTops::PressureSampler::kResources; ++r) {
+            auto res = static_cast<RedTops::PressureSampler::Resource>(r);
+            const RedTops::Pressure& p = pressure->Get(res);
+            if (!p.available) continue;
+            const char* name = RedTops::PressureSampler::Name(res);
+            w.Sample(static_cast<double>(p.some.total_us) / 1e6, {{"resource", name}, {"kind", "some"}});
+            w.Sample(static_cast<double>(p.full.total_us) / 1e6, {{"resource", name}, {"kind", "full"}});
+        }
+    });
+}
+
+// Interface counters from one RTM_GETLINK dump per render
+void AddNetworkCollector(RedTops::MetricsExporter& exporter, const std::vector<std::string>& only) {
+    auto nl = std::make_shared<RedTops::NetlinkRoute>(false);
+    exporter.AddCollector("network", [nl, only](MetricsWriter& w) {
+        std::vector<RedTops::LinkInfo> links = nl->Links();
+        if (!only.empty())
+            links.erase(std::remove_if(links.begin(), links.end(), [&](const RedTops::LinkInfo& l) {
+                return std::find(only.begin(), only.end(), l.name) == only.end();
+            }), links.end());
+
+        struct Counter { const char* name; const char* help; uint64_t RedTops::LinkInfo::*field; };
+        const Counter counters[] = {
+            {"redtops_network_receive_bytes", "Bytes received", &RedTops::LinkInfo::rx_bytes},
+            {"redtops_network_transmit_bytes", "Bytes transmitted", &RedTops::LinkInfo::tx_bytes},
+            {"redtops_network_receive_packets", "Packets received", &RedTops::LinkInfo::rx_packets},
+            {"redtops_network_transmit_packets", "Packets transmitted", &RedTops::LinkInfo::tx_packets},
+            {"redtops_network_receive_errors", "Receive errors", &RedTops::LinkInfo::rx_errors},
+            {"redtops_network_transmit_errors", "Transmit errors", &RedTops::LinkInfo::tx_errors},
+            {"redtops_network_receive_drops", "Received packets dropped", &RedTops::LinkInfo::rx_dropped},
+            {"redtops_network_transmit_drops", "Transmitted packets dropped", &RedTops::LinkInfo::tx_dropped},
+        };
+        for (const Counter& c : counters) {
+            w.Family(c.name, Type::Counter, c.help);
+            for (const auto& link : links) w.Sample(static_cast<double>(link.*c.field), {{"device", link.name}});
+        }
+        w.Family("redtops_network_up", Type::Gauge, "Whether the interface is administratively up");
+        for (const auto& link : links) w.Sample(link.up() ? 1 : 0, {{"device", link.name}});
+    });
+}
+
+// ICMP and TCP reachability, probed concurrently once per render
+void AddProbeCollector(RedTops::MetricsExporter& exporter, const std::vector<std::string>& specs, int timeout_ms) {
+    std::vector<RedTops::ProbeTarget> targets;
+    for (const auto& spec : specs) targets.push_back(RedTops::ParseProbeTarget(spec));
+    exporter.AddCollector("probe", [targets, timeout_ms](MetricsWriter& w) {
+        RedTops::ReachabilityProbe probe(timeout_ms);
+        for (const auto& t : targets) probe.Add(t);
+        std::vector<RedTops::ProbeResult> results = probe.Run();
+
+        w.Family("redtops_probe_success", Type::Gauge, "Whether the target answered (echo reply or TCP handshake)");
+        for (const auto& r : results)
+            w.Sample(r.status == RedTops::ProbeStatus::Reachable ? 1 : 0,
+                     {{"target", r.target.spec}, {"protocol", r.target.port ? "tcp" : "icmp"}});
+        w.Family("redtops_probe_duration_seconds", Type::Gauge, "Round-trip time of the last successful probe");
+        for (const auto& r : results)
+            if (r.status == RedTops::ProbeStatus::Reachable)
+                w.Sample(r.rtt_ms / 1000.0, {{"target", r.target.spec}});
+    });
+}
+
+} // namespace
+#endif
+
+void ExporterCommand::Execute(const std::vector<std::string>& args) {
+    TerminalRenderer& term = TerminalRenderer::Instance();
+
+#ifdef _WIN32
+    (void)args;
+    term.PrintLine("exporter: only available on Linux");
+#else
+    ExporterOptions opts = ParseOptions(args);
+    int interval_ms = static_cast<int>(opts.interval * 1000);
+
+    RedTops::MetricsExporter exporter(opts.listen, interval_ms);
+    AddCpuCollector(exporter);
+    AddMemoryCollector(exporter);
+    AddNetworkCollector(exporter, opts.ifaces);
+    if (!opts.probes.empty())
+        AddProbeCollector(exporter, opts.probes, std::clamp(interval_ms * 4 / 5, 100, 2000));
+    exporter.Start();
+
+    term.PrintLine("\033[1;34m=== Metrics Exporter ===\033[0m");
+    term.PrintLine("Serving OpenMetrics on http://" + exporter.Address() + "/metrics", Color::GREEN);
+    term.PrintLine("Collectors: cpu, memory, network" + std::string(opts.probes.empty() ? "" : ", probe (" +
+                   std::to_string(opts.probes.size()) + " targets)") + "; rendering every " +
+                   std::to_string(interval_ms) + " ms. Ctrl+C to stop.", Color::DIM);
+
+    InterruptScope interrupt_scope;
+    auto next_status = std::chrono::steady_clock::now();
+    while (!Shell::Instance().InterruptRequested()) {
+        if (std::chrono::steady_clock::now() >= next_status) {
+            char line[160];
+            std::snprintf(line, sizeof(line), "  %llu scrapes, %llu renders, last render %.1f ms, %zu bytes",
+                          static_cast<unsigned long long>(exporter.Scrapes()),
+                          static_cast<unsigned long long>(exporter.Renders()),
+                          exporter.LastRenderMs(), exporter.LastSize());
+            std::cout << "\r\x1b[2K" << Color::DIM << line << Color::RESET << std::flush;
+            next_status += std::chrono::seconds(1);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    std::cout << "\r\x1b[2K";
+    exporter.Stop();
+    term.PrintLine("Exporter stopped after " + std::to_string(exporter.Scrapes()) + " scrape(s).");
+#endif
+}
@@ -1,6 +1,13 @@
 #include "../headers/fs_commands.hpp"
 #include "../../core/header/TerminalRenderer.hpp"
 #include "../../core/header/Exceptions.hpp" // Include custom exceptions
+#include "../../core/header/RecordEmitter.hpp"
+#include "../../core/header/Shell.hpp"
+#include "../../modules/headers/CopyEngine.hpp"
+#include "../../modules/headers/DirListing.hpp"
+#include "../../modules/headers/DiskUsage.hpp"
+#include "../../modules/headers/MoveEngine.hpp"
+#include "../../modules/headers/TreeRemover.hpp"
 #include <filesystem>
 #include <fstream>
 #include <iostream>
@@ -8,9 +15,18 @@
 #include <iomanip>
 #include <chrono>
 #include <system_error>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
 #include <unistd.h>    // for getuid()
 #include <pwd.h>
+#include <cstdio>
 #include <cstdlib>
+#include <ctime>
+#include <algorithm>
 
 namespace fs = std::filesystem;
 
@@ -30,29 +46,62 @@ static std::string ExpandHome(const std::string& path) {
     return path;
 }
 
-// Converts fs::perms to a string like rwxr-xr--
-static std::string PermString(fs::perms p) {
-    std::string s = "---------";
-    s[0] = ((p & fs::perms::owner_read) != fs::perms::none) ? 'r' : '-';
-    s[1] = ((p & fs::perms::owner_write) != fs::perms::none) ? 'w' : '-';
-    s[2] = ((p & fs::perms::owner_exec) != fs::perms::none) ? 'x' : '-';
-    s[3] = ((p & fs::perms::group_read) != fs::perms::none) ? 'r' : '-';
-    s[4] = ((p & fs::perms::group_write) != fs::perms::none) ? 'w' : '-';
-    s[5] = ((p & fs::perms::group_exec) != fs::perms::none) ? 'x' : '-';
-    s[6] = ((p & fs::perms::others_read) != fs::perms::none) ? 'r' : '-';
-    s[7] = ((p & fs::perms::others_write) != fs::perms::none) ? 'w' : '-';
-    s[8] = ((p & fs::perms::others_exec) != fs::perms::none) ? 'x' : '-';
-    return s;
+// 1536 -> "1.5 KiB"
+static std::string FormatBytes(double bytes) {
+    static const char* units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+    int u = 0;
+    while (bytes >= 1024 && u < 4) {
+        bytes /= 1024;
+        ++u;
+    }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), u ? "%.1f %s" : "%.0f %s", bytes, units[u]);
+    return buf;
+}
+
+// One ls entry as a structured record
+static void EmitEntry(std::string_view name, const RedTops::ListedEntry& e) {
+    const uint32_t type = e.mode & S_IFMT;
+    const char* kind = type == S_IFDIR ? "dir" : type == S_IFREG ? "file" : type == S_IFLNK ? "symlink" : "other";
+    char mode[8];
+    std::snprintf(mode, sizeof(mode), "%04o", e.mode & 07777u);
+    RecordEmitter::Instance().Record("entry").Field("name", name).Field("kind", kind)
+        .Field("size", type == S_IFREG ? e.size : uint64_t(0)).Field("mode", mode)
+        .Field("mtime", e.mtime_ns / 1000000000).Commit();
 }
 
-// Formats a time_t into YYYY-MM-DD HH:MM
-static std::string FormatTime(std::time_t t) {
-    std::tm tm = *std::localtime(&t);
-    std::ostringstream oss;
-    oss << std::put_time(&tm, "%Y-%m-%d %H:%M");
-    return oss.str();
+// "rwxr-xr-x" from st_mode
+static void ModeString(uint32_t mode, char* out) {
+    const char* flags = "rwxrwxrwx";
+    for (int i = 0; i < 9; ++i) out[i] = (mode & (0400u >> i)) ? flags[i] : '-';
+    out[9] = '\0';
 }
 
+// One `ls -l` line; consecutive entries from the same minute share the formatted time
+struct LongLineFormatter {
+    int64_t minute = -1;
+    char time[32] = "";
+
+    void Append(std::string& out, std::string_view name, const RedTops::ListedEntry& e) {
+        int64_t secs = e.mtime_ns / 1000000000;
+        if (secs / 60 != minute) {
+            minute = secs / 60;
+            std::time_t t = static_cast<std::time_t>(secs);
+            std::tm tm{};
+            localtime_r(&t, &tm);
+            std::strftime(time, sizeof(time), "%Y-%m-%d %H:%M", &tm);
+        }
+        char perms[10];
+        ModeString(e.mode, perms);
+        char line[96];
+        int n = std::snprintf(line, sizeof(line), "%s %8llu %s ", perms,
+                              static_cast<unsigned long long>((e.mode & S_IFMT) == S_IFREG ? e.size : 0), time);
+        out.append(line, static_cast<size_t>(n));
+        out.append(name);
+        out += '\n';
+    }
+};
+
 // ---------- pwd ----------
 void PwdCommand::Execute(const std::vector<std::string>&) {
     try {
@@ -98,88 +147,223 @@ void CdCommand::Execute(const std::vector<std::string>& args) {
 void LsCommand::Execute(const std::vector<std::string>& args) {
     bool show_all = false;
     bool long_listing = false;
+    bool reverse = false;
+    enum class SortKey { Name, Time, Size, None } sort = SortKey::Name;
     fs::path target = fs::current_path();
 
-    // parse simple flags: -a, -l (combinations allowed)
+    // parse simple flags: -a, -l, -t, -S, -U, -r (combinations allowed)
     std::vector<std::string> paths;
     for (auto &a : args) {
         if (a.size() > 1 && a[0] == '-') {
             for (size_t i = 1; i < a.size(); ++i) {
                 if (a[i] == 'a') show_all = true;
                 else if (a[i] == 'l') long_listing = true;
+                else if (a[i] == 't') sort = SortKey::Time;
+                else if (a[i] == 'S') sort = SortKey::Size;
+                else if (a[i] == 'U') sort = SortKey::None;
+                else if (a[i] == 'r') reverse = true;
             }
         } else {
             paths.push_back(ExpandHome(a));
         }
     }
     if (!paths.empty()) target = fs::path(paths[0]);
+    if (target.is_relative()) target = fs::current_path() / target;
+
+    const bool structured = RecordEmitter::Instance().Active();
+    RedTops::ListedEntry self;
+    if (!RedTops::StatEntry(target.string(), self)) {
+        throw RedTops::CommandError("ls: target does not exist: " + target.string());
+    }
 
+    if ((self.mode & S_IFMT) != S_IFDIR) {
+        std::string name = target.filename().string();
+        if (structured) {
+            EmitEntry(name, self);
+        } else if (long_listing) {
+            std::string line;
+            LongLineFormatter().Append(line, name, self);
+            line.pop_back();
+            TerminalRenderer::Instance().PrintLine(line);
+        } else {
+            TerminalRenderer::Instance().PrintLine(name);
+        }
+        return;
+    }
+
+    // Attributes cost one statx per entry, so fetch them only when something uses them
+    const bool need_stat = structured || long_listing || sort == SortKey::Time || sort == SortKey::Size;
+    RedTops::DirListing listing;
     try {
-        if (target.is_relative()) target = fs::current_path() / target;
-        if (!fs::exists(target)) {
-            throw RedTops::CommandError("ls: target does not exist: " + target.string());
-        }
-
-        if (!fs::is_directory(target)) {
-            std::ostringstream line;
-            if (long_listing) {
-                auto st = fs::status(target);
-                auto sz = fs::is_regular_file(target) ? fs::file_size(target) : 0;
-                auto perms = PermString(st.permissions());
-                auto ftime = fs::last_write_time(target);
-                auto sctp = std::chrono::system_clock::to_time_t(std::chrono::file_clock::to_sys(ftime));
-                line << perms << " " << std::setw(8) << sz << " " << FormatTime(sctp) << " " << target.filename().string();
-                TerminalRenderer::Instance().PrintLine(line.str());
-            } else {
-                TerminalRenderer::Instance().PrintLine(target.filename().string());
-            }
-            return;
+        listing = RedTops::DirListing::Read(target.string(), show_all, need_stat);
+    } catch (const RedTops::CommandError& e) {
+        throw RedTops::CommandError(std::string("ls: ") + e.what());
+    }
+
+    // Sort an index by precomputed keys rather than shuffling entries around
+    const auto& entries = listing.Entries();
+    std::vector<uint32_t> order(entries.size());
+    for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+    auto by_name = [&](uint32_t a, uint32_t b) { return listing.Name(entries[a]) < listing.Name(entries[b]); };
+    if (sort == SortKey::Name) {
+        std::sort(order.begin(), order.end(), by_name);
+    } else if (sort != SortKey::None) {
+        std::vector<int64_t> key(entries.size());
+        for (size_t i = 0; i < entries.size(); ++i)
+            key[i] = sort == SortKey::Time ? entries[i].mtime_ns : static_cast<int64_t>(entries[i].size);
+        // Newest / largest first, ties by name
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return key[a] != key[b] ? key[a] > key[b] : by_name(a, b);
+        });
+    }
+    if (reverse) std::reverse(order.begin(), order.end());
+
+    if (structured) {
+        for (uint32_t i : order) EmitEntry(listing.Name(entries[i]), entries[i]);
+        return;
+    }
+
+    // Lines are assembled in one buffer and written in large pieces, not flushed one by one
+    std::string out;
+    out.reserve(1 << 20);
+    LongLineFormatter formatter;
+    for (uint32_t i : order) {
+        if (long_listing) {
+            formatter.Append(out, listing.Name(entries[i]), entries[i]);
+        } else {
+            out.append(listing.Name(entries[i]));
+            out += '\n';
+        }
+        if (out.size() >= (1 << 20)) {
+            std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+            out.clear();
         }
+    }
+    std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+    std::cout.flush();
+}
 
-        for (auto &entry : fs::directory_iterator(target)) {
-            auto name = entry.path().filename().string();
-            if (!show_all && !name.empty() && name[0] == '.') continue;
-
-            if (long_listing) {
-                auto st = entry.status();
-                std::ostringstream line;
-                auto sz = fs::is_regular_file(entry.status()) ? fs::file_size(entry.path()) : 0;
-                auto perms = PermString(st.permissions());
-                auto ftime = fs::last_write_time(entry.path());
-                auto sctp = std::chrono::system_clock::to_time_t(std::chrono::file_clock::to_sys(ftime));
-                line << perms << " " << std::setw(8) << sz << " " << FormatTime(sctp) << " " << name;
-                TerminalRenderer::Instance().PrintLine(line.str());
-            } else {
-                TerminalRenderer::Instance().PrintLine(name);
+// ---------- cat ----------
+
+// Writes all of data to fd; false with errno set on failure
+static bool WriteAll(int fd, const char* data, size_t len) {
+    while (len) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Copies a whole file to out byte for byte without going through iostreams:
+// sendfile(2) keeps the data in the kernel when the destination accepts it,
+// otherwise large writes come straight from an mmap of the file, and pipes
+// and pseudo-files (/proc reports size 0) are read in big blocks. `last`
+// receives the final byte written. Returns false with errno set on failure.
+static bool StreamFile(int in, const struct stat& st, int out, char& last) {
+    constexpr size_t kChunk = 8 << 20;
+    auto interrupted = [] { return Shell::Instance().InterruptRequested(); };
+
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        const size_t size = static_cast<size_t>(st.st_size);
+        off_t off = 0;
+        bool unsupported = false;
+        while (static_cast<size_t>(off) < size && !interrupted()) {
+            ssize_t n = sendfile(out, in, &off, std::min(kChunk, size - static_cast<size_t>(off)));
+            if (n > 0) continue;
+            if (n == 0) break;                  // the file shrank under us
+            if (errno == EINTR) continue;
+            if (off == 0 && (errno == EINVAL || errno == ENOSYS)) {
+                unsupported = true;
+                break;
             }
+            return false;
         }
-    } catch (const fs::filesystem_error& e) {
-        throw RedTops::CommandError(std::string("ls: ") + e.what());
+        if (!unsupported) {
+            if (off > 0) pread(in, &last, 1, off - 1);
+            return true;
+        }
+
+        void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, in, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, size, MADV_SEQUENTIAL);
+            const char* data = static_cast<const char*>(map);
+            bool ok = true;
+            for (size_t pos = 0; pos < size && ok && !interrupted(); pos += kChunk)
+                ok = WriteAll(out, data + pos, std::min(kChunk, size - pos));
+            int err = errno;
+            last = data[size - 1];
+            munmap(map, size);
+            errno = err;
+            return ok;
+        }
+    }
+
+    std::vector<char> buf(256 * 1024);
+    while (!interrupted()) {
+        ssize_t n = read(in, buf.data(), buf.size());
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (n == 0) break;
+        if (!WriteAll(out, buf.data(), static_cast<size_t>(n))) return false;
+        last = buf[static_cast<size_t>(n) - 1];
     }
+    return true;
 }
 
-// ---------- cat ----------
 void CatCommand::Execute(const std::vector<std::string>& args) {
     if (args.empty()) {
         throw RedTops::CommandError("cat: missing file operand");
     }
-    fs::path p(ExpandHome(args[0]));
-    if (p.is_relative()) p = fs::current_path() / p;
 
-    try {
-        if (!fs::exists(p)) {
-            throw RedTops::CommandError("cat: file does not exist: " + p.string());
+    InterruptScope interrupt_scope;
+    std::cout.flush();
+    // Under --output the record stream owns stdout
+    const int out = RecordEmitter::Instance().Active() ? STDERR_FILENO : STDOUT_FILENO;
+    char last = '\n';
+    std::vector<std::string> failures;
+
+    for (const auto& arg : args) {
+        fs::path p(ExpandHome(arg));
+        if (p.is_relative()) p = fs::current_path() / p;
+
+        int fd = open(p.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            failures.push_back(errno == ENOENT ? "cat: file does not exist: " + p.string()
+                                               : "cat: " + p.string() + ": " + std::strerror(errno));
+            continue;
         }
-        if (fs::is_directory(p)) {
-            throw RedTops::CommandError("cat: cannot display a directory: " + p.string());
+        struct stat st;
+        if (fstat(fd, &st) != 0 || S_ISDIR(st.st_mode)) {
+            failures.push_back("cat: cannot display a directory: " + p.string());
+            close(fd);
+            continue;
         }
-        std::ifstream ifs(p, std::ios::binary);
-        std::string line;
-        while (std::getline(ifs, line)) {
-            TerminalRenderer::Instance().PrintLine(line);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        bool ok = StreamFile(fd, st, out, last);
+        int err = errno;
+        close(fd);
+        if (!ok) {
+            if (err == EPIPE) break;            // the reader went away (cat big.log | head)
+            failures.push_back("cat: " + p.string() + ": " + std::strerror(err));
         }
-    } catch (const fs::filesystem_error& e) {
-        throw RedTops::CommandError(std::string("cat: ") + e.what());
+        if (Shell::Instance().InterruptRequested()) break;
+    }
+
+    // Keep the prompt off the end of a file without a trailing newline
+    if (last != '\n' && isatty(out)) WriteAll(out, "\n", 1);
+
+    if (failures.size() == 1) throw RedTops::CommandError(failures[0]);
+    if (!failures.empty()) {
+        for (const auto& message : failures) TerminalRenderer::Instance().PrintWarning(message);
+        throw RedTops::CommandError("cat: " + std::to_string(failures.size()) + " of " + std::to_string(args.size()) +
+                                    " files could not be read");
     }
 }
 
@@ -200,16 +384,62 @@ void MkdirCommand::Execute(const std::vector<std::string>& args) {
 }
 
 // ---------- rm ----------
+
+// rm -r of one directory tree, with a progress line once it runs long enough to need one
+static void RemoveTree(const fs::path& p, unsigned threads) {
+    InterruptScope interrupt_scope;
+    RedTops::TreeRemover remover(threads);
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&] { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+    const bool progress = !RecordEmitter::Instance().Active() && isatty(STDOUT_FILENO);
+    bool shown = false;
+    bool complete = remover.Remove(p.string(),
+        [] { return Shell::Instance().InterruptRequested(); },
+        [&] {
+            double secs = elapsed();
+            if (!progress || secs < 0.3) return;
+            shown = true;
+            RedTops::RemoveStats st = remover.Stats();
+            std::cout << "\r\x1b[2K" << Color::DIM << "  removed " << st.files << " files, " << st.dirs << " directories ("
+                      << static_cast<uint64_t>((st.files + st.dirs) / secs) << "/s)" << Color::RESET << std::flush;
+        });
+    double secs = elapsed();
+    if (shown) std::cout << "\r\x1b[2K" << std::flush;
+
+    RedTops::RemoveStats st = remover.Stats();
+    if (RecordEmitter::Instance().Active()) {
+        RecordEmitter::Instance().Record("remove").Field("path", p.string()).Field("files", st.files)
+            .Field("dirs", st.dirs).Field("errors", st.errors).Field("seconds", secs).Field("complete", complete).Commit();
+    } else if (shown) {
+        char line[160];
+        std::snprintf(line, sizeof(line), "Removed %llu files and %llu directories in %.2f s (%u threads)",
+                      static_cast<unsigned long long>(st.files), static_cast<unsigned long long>(st.dirs), secs, remover.Threads());
+        TerminalRenderer::Instance().PrintLine(line, Color::DIM);
+    }
+
+    for (const auto& message : remover.Errors()) TerminalRenderer::Instance().PrintWarning("rm: " + message);
+    if (!complete) throw RedTops::CommandError("rm: interrupted; " + p.string() + " was partly removed");
+    if (st.errors) throw RedTops::CommandError("rm: " + std::to_string(st.errors) + " entries could not be removed");
+}
+
 void RmCommand::Execute(const std::vector<std::string>& args) {
     if (args.empty()) {
         throw RedTops::CommandError("rm: missing operand");
     }
 
     bool recursive = false;
+    unsigned threads = 0;
     std::vector<std::string> operands;
 
-    for (auto &a : args) {
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& a = args[i];
         if (a == "-r" || a == "-R") recursive = true;
+        else if (a == "-j") {
+            if (i + 1 >= args.size()) throw RedTops::CommandError("rm: -j needs a value");
+            long n = std::strtol(args[++i].c_str(), nullptr, 10);
+            if (n < 1 || n > 256) throw RedTops::CommandError("rm: invalid thread count: " + args[i]);
+            threads = static_cast<unsigned>(n);
+        }
         else operands.push_back(a);
     }
 
@@ -221,43 +451,54 @@ void RmCommand::Execute(const std::vector<std::string>& args) {
         fs::path p = ExpandHome(op);
         if (p.is_relative()) p = fs::current_path() / p;
 
-        try {
-            if (!fs::exists(p)) {
-                throw RedTops::CommandError("rm: " + op + ": No such file or directory");
-            }
-            if (fs::is_directory(p) && !recursive) {
-                throw RedTops::CommandError("rm: " + op + ": is a directory (use -r to remove directories)");
-            }
-
-            std::error_code ec;
-            if (fs::is_directory(p))
-                fs::remove_all(p, ec);
-            else
-                fs::remove(p, ec);
-
-            if (ec) throw RedTops::CommandError("rm: " + ec.message());
-
-        } catch (const fs::filesystem_error& e) {
-            throw RedTops::CommandError(std::string("rm: ") + e.what());
+        // lstat: a symlink to a directory is removed itself, never followed
+        struct stat st;
+        if (lstat(p.c_str(), &st) != 0) {
+            throw RedTops::CommandError("rm: " + op + ": No such file or directory");
+        }
+        if (!S_ISDIR(st.st_mode)) {
+            if (unlink(p.c_str()) != 0) throw RedTops::CommandError("rm: " + op + ": " + std::strerror(errno));
+            if (RecordEmitter::Instance().Active())
+                RecordEmitter::Instance().Record("remove").Field("path", p.string()).Field("files", 1).Field("dirs", 0)
+                    .Field("complete", true).Commit();
+            continue;
+        }
+        if (!recursive) {
+            throw RedTops::CommandError("rm: " + op + ": is a directory (use -r to remove directories)");
         }
+        if (p.lexically_normal() == p.root_path()) {
+            throw RedTops::CommandError("rm: refusing to remove " + p.root_path().string());
+        }
+        RemoveTree(p, threads);
     }
 }
 
 // ---------- cp ----------
 void CpCommand::Execute(const std::vector<std::string>& args) {
+    const std::string usage = "cp: usage: cp [-r] [-j <threads>] [--no-reflink] <source> <dest>";
     if (args.size() < 2) {
-        throw RedTops::CommandError("cp: usage: cp [-r] <source> <dest>");
+        throw RedTops::CommandError(usage);
     }
 
     bool recursive = false;
+    bool reflink = true;
+    unsigned threads = 0;
     std::vector<std::string> ops;
-    for (auto &a : args) {
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& a = args[i];
         if (a == "-r" || a == "-R") recursive = true;
+        else if (a == "--no-reflink") reflink = false;
+        else if (a == "-j") {
+            if (i + 1 >= args.size()) throw RedTops::CommandError("cp: -j needs a value");
+            long n = std::strtol(args[++i].c_str(), nullptr, 10);
+            if (n < 1 || n > 256) throw RedTops::CommandError("cp: invalid thread count: " + args[i]);
+            threads = static_cast<unsigned>(n);
+        }
         else ops.push_back(a);
     }
 
     if (ops.size() != 2) {
-        throw RedTops::CommandError("cp: usage: cp [-r] <source> <dest>");
+        throw RedTops::CommandError(usage);
     }
 
     fs::path src = ExpandHome(ops[0]);
@@ -265,6 +506,7 @@ void CpCommand::Execute(const std::vector<std::string>& args) {
     if (src.is_relative()) src = fs::current_path() / src;
     if (dst.is_relative()) dst = fs::current_path() / dst;
 
+    RedTops::CopyEngine engine(threads, reflink);
     try {
         if (!fs::exists(src)) {
             throw RedTops::CommandError("cp: source does not exist: " + src.string());
@@ -274,41 +516,171 @@ void CpCommand::Execute(const std::vector<std::string>& args) {
             throw RedTops::CommandError("cp: omitting directory (use -r to copy directories): " + src.string());
         }
 
-        if (fs::is_directory(src)) {
-            for (auto &entry : fs::recursive_directory_iterator(src)) {
-                auto rel = fs::relative(entry.path(), src);
-                fs::path target = dst / rel;
-                if (entry.is_directory())
-                    fs::create_directories(target);
-                else {
-                    fs::create_directories(target.parent_path());
-                    fs::copy_file(entry.path(), target, fs::copy_options::overwrite_existing);
-                }
-            }
-        } else {
+        if (!fs::is_directory(src)) {
             if (fs::is_directory(dst))
                 dst /= src.filename();
             fs::create_directories(dst.parent_path());
-            fs::copy_file(src, dst, fs::copy_options::overwrite_existing);
+            engine.CopyFile(src.string(), dst.string());
+            if (RecordEmitter::Instance().Active()) {
+                RedTops::CopyStats st = engine.Stats();
+                RecordEmitter::Instance().Record("copy").Field("source", src.string()).Field("dest", dst.string())
+                    .Field("files", st.files).Field("bytes", st.bytes).Field("reflinked", st.cloned).Field("complete", true)
+                    .Commit();
+            }
+            return;
         }
+
+        // Copying a tree into itself would never finish
+        fs::path from = fs::canonical(src);
+        fs::path to = fs::weakly_canonical(dst);
+        auto mismatch = std::mismatch(from.begin(), from.end(), to.begin(), to.end());
+        if (mismatch.first == from.end()) {
+            throw RedTops::CommandError("cp: cannot copy a directory into itself: " + dst.string());
+        }
+        fs::create_directories(dst.parent_path());
     } catch (const fs::filesystem_error& e) {
         throw RedTops::CommandError(std::string("cp: ") + e.what());
     }
+
+    InterruptScope interrupt_scope;
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&] { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+    const bool structured = RecordEmitter::Instance().Active();
+    const bool progress = !structured && isatty(STDOUT_FILENO);
+    bool shown = false;
+    bool complete = engine.CopyTree(src.string(), dst.string(),
+        [] { return Shell::Instance().InterruptRequested(); },
+        [&] {
+            double secs = elapsed();
+            if (!progress || secs < 0.3) return;     // small trees finish without a progress line
+            shown = true;
+            RedTops::CopyStats st = engine.Stats();
+            std::cout << "\r\x1b[2K" << Color::DIM << "  " << st.files << " files, " << FormatBytes(st.bytes)
+                      << ", " << FormatBytes(st.bytes / secs) << "/s" << Color::RESET << std::flush;
+        });
+    double secs = elapsed();
+    if (shown) std::cout << "\r\x1b[2K" << std::flush;
+
+    RedTops::CopyStats st = engine.Stats();
+    if (structured) {
+        RecordEmitter::Instance().Record("copy").Field("source", src.string()).Field("dest", dst.string())
+            .Field("files", st.files).Field("bytes", st.bytes).Field("dirs", st.dirs).Field("symlinks", st.symlinks)
+            .Field("reflinked", st.cloned).Field("skipped", st.skipped).Field("errors", st.errors)
+            .Field("seconds", secs).Field("complete", complete).Commit();
+    } else {
+        std::string summary = "Copied " + std::to_string(st.files) + " files (" + FormatBytes(st.bytes) + ") and " +
+                              std::to_string(st.dirs) + " directories in ";
+        char timing[64];
+        std::snprintf(timing, sizeof(timing), "%.2f s, %s/s", secs, FormatBytes(secs > 0 ? st.bytes / secs : 0).c_str());
+        summary += timing;
+        if (st.cloned) summary += ", " + std::to_string(st.cloned) + " reflinked";
+        if (st.symlinks) summary += ", " + std::to_string(st.symlinks) + " symlinks";
+        if (st.skipped) summary += ", " + std::to_string(st.skipped) + " special files skipped";
+        TerminalRenderer::Instance().PrintLine(summary + " (" + std::to_string(engine.Threads()) + " threads)", Color::DIM);
+    }
+
+    for (const auto& message : engine.Errors()) TerminalRenderer::Instance().PrintWarning("cp: " + message);
+    if (!complete) throw RedTops::CommandError("cp: interrupted; " + dst.string() + " is incomplete");
+    if (st.errors) throw RedTops::CommandError("cp: " + std::to_string(st.errors) + " entries could not be copied");
 }
 
 // ---------- mv ----------
+// rename(2) cannot cross filesystems: every file is copied, synced and
+// verified, and only then is the source removed
+static void MoveAcrossDevices(const fs::path& src, const fs::path& dst, bool is_dir,
+                              const RedTops::MoveEngine::Options& options) {
+    InterruptScope interrupt_scope;
+    RedTops::MoveEngine engine(options);
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&] { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+    const bool structured = RecordEmitter::Instance().Active();
+    const bool progress = !structured && isatty(STDOUT_FILENO);
+    auto should_stop = [] { return Shell::Instance().InterruptRequested(); };
+    auto on_tick = [&] {
+        double secs = elapsed();
+        if (!progress || secs < 0.3) return;
+        RedTops::MoveStats st = engine.Stats();
+        std::cout << "\r\x1b[2K" << Color::DIM << "  " << st.files << " files, " << FormatBytes(st.bytes) << " copied";
+        if (options.verify) std::cout << ", " << FormatBytes(st.verified) << " verified";
+        std::cout << ", " << FormatBytes(st.bytes / secs) << "/s" << Color::RESET << std::flush;
+    };
+    bool complete = false;
+    try {
+        complete = is_dir ? engine.MoveTree(src.string(), dst.string(), should_stop, on_tick)
+                          : engine.MoveFile(src.string(), dst.string(), should_stop, on_tick);
+    } catch (const RedTops::CommandError&) {
+        if (progress) std::cout << "\r\x1b[2K" << std::flush;
+        throw;
+    }
+    double secs = elapsed();
+    if (progress) std::cout << "\r\x1b[2K" << std::flush;
+
+    RedTops::MoveStats st = engine.Stats();
+    bool removed = complete && (is_dir ? engine.SourceRemoved() : true);
+    if (structured) {
+        RecordEmitter::Instance().Record("move").Field("source", src.string()).Field("dest", dst.string())
+            .Field("cross_device", true).Field("files", st.files).Field("bytes", st.bytes).Field("verified", st.verified)
+            .Field("dirs", st.dirs).Field("symlinks", st.symlinks).Field("hardlinks", st.links)
+            .Field("specials", st.specials).Field("errors", st.errors).Field("seconds", secs)
+            .Field("complete", complete).Field("source_removed", removed).Commit();
+    } else if (complete) {
+        std::string summary = "Moved " + std::to_string(st.files) + (st.files == 1 ? " file (" : " files (") +
+                              FormatBytes(st.bytes) + ")";
+        if (is_dir) summary += " and " + std::to_string(st.dirs) + " directories";
+        char timing[64];
+        std::snprintf(timing, sizeof(timing), " across devices in %.2f s, %s/s",
+                      secs, FormatBytes(secs > 0 ? st.bytes / secs : 0).c_str());
+        summary += timing;
+        if (st.links) summary += ", " + std::to_string(st.links) + " hard links";
+        if (st.symlinks) summary += ", " + std::to_string(st.symlinks) + " symlinks";
+        summary += options.verify ? ", verified" : ", not verified";
+        if (is_dir) summary += " (" + std::to_string(engine.Threads()) + " threads)";
+        TerminalRenderer::Instance().PrintLine(summary, Color::DIM);
+    }
+
+    for (const auto& message : engine.Errors()) TerminalRenderer::Instance().PrintWarning("mv: " + message);
+    if (!complete) {
+        throw RedTops::CommandError("mv: interrupted; " + src.string() + " was kept" +
+                                    (is_dir ? " and " + dst.string() + " holds a partial copy" : ""));
+    }
+    if (!removed && !engine.Arrived()) {
+        throw RedTops::CommandError("mv: " + std::to_string(st.errors) + " entries could not be moved; " + src.string() +
+                                    " was kept and " + dst.string() + " holds a partial copy");
+    }
+    if (!removed) {
+        throw RedTops::CommandError("mv: " + dst.string() + " is complete but " + std::to_string(st.errors) +
+                                    " entries of " + src.string() + " could not be removed");
+    }
+}
+
 void MvCommand::Execute(const std::vector<std::string>& args) {
-    if (args.size() != 2) {
-        throw RedTops::CommandError("mv: usage: mv <source> <dest>");
+    const std::string usage = "mv: usage: mv [-j <threads>] [--no-sync] [--no-verify] <source> <dest>";
+    RedTops::MoveEngine::Options options;
+    std::vector<std::string> ops;
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& a = args[i];
+        if (a == "--no-sync") options.sync = false;
+        else if (a == "--no-verify") options.verify = false;
+        else if (a == "-j") {
+            if (i + 1 >= args.size()) throw RedTops::CommandError("mv: -j needs a value");
+            long n = std::strtol(args[++i].c_str(), nullptr, 10);
+            if (n < 1 || n > 256) throw RedTops::CommandError("mv: invalid thread count: " + args[i]);
+            options.threads = static_cast<unsigned>(n);
+        }
+        else ops.push_back(a);
+    }
+    if (ops.size() != 2) {
+        throw RedTops::CommandError(usage);
     }
 
-    fs::path src = ExpandHome(args[0]);
-    fs::path dst = ExpandHome(args[1]);
+    fs::path src = ExpandHome(ops[0]);
+    fs::path dst = ExpandHome(ops[1]);
     if (src.is_relative()) src = fs::current_path() / src;
     if (dst.is_relative()) dst = fs::current_path() / dst;
 
+    bool is_dir = false;
     try {
-        if (!fs::exists(src)) {
+        if (!fs::exists(fs::symlink_status(src))) {
             throw RedTops::CommandError("mv: source does not exist: " + src.string());
         }
 
@@ -317,10 +689,120 @@ void MvCommand::Execute(const std::vector<std::string>& args) {
         else
             fs::create_directories(dst.parent_path());
 
-        fs::rename(src, dst);
+        std::error_code ec;
+        fs::rename(src, dst, ec);
+        if (!ec) {
+            if (RecordEmitter::Instance().Active())
+                RecordEmitter::Instance().Record("move").Field("source", src.string()).Field("dest", dst.string())
+                    .Field("cross_device", false).Field("complete", true).Field("source_removed", true).Commit();
+            return;
+        }
+        if (ec != std::errc::cross_device_link) throw fs::filesystem_error("rename", src, dst, ec);
 
+        is_dir = fs::is_directory(fs::symlink_status(src));
+        if (is_dir) {
+            if (fs::exists(fs::symlink_status(dst)) && !fs::is_directory(fs::symlink_status(dst))) {
+                throw RedTops::CommandError("mv: cannot overwrite non-directory " + dst.string() + " with a directory");
+            }
+            // A mount point inside the source would otherwise be copied into itself
+            fs::path from = fs::canonical(src);
+            fs::path to = fs::weakly_canonical(dst);
+            auto mismatch = std::mismatch(from.begin(), from.end(), to.begin(), to.end());
+            if (mismatch.first == from.end()) {
+                throw RedTops::CommandError("mv: cannot move a directory into itself: " + dst.string());
+            }
+        } else if (fs::is_directory(fs::symlink_status(dst))) {
+            throw RedTops::CommandError("mv: cannot overwrite directory " + dst.string());
+        }
     } catch (const fs::filesystem_error& e) {
         throw RedTops::CommandError(std::string("mv: ") + e.what());
     }
+
+    MoveAcrossDevices(src, dst, is_dir, options);
 }
 
+
+// ---------- du ----------
+void DuCommand::Execute(const std::vector<std::string>& args) {
+    const std::string usage = "du: usage: du [-n <top>] [-j <threads>] [--apparent] [-x] [path...]";
+    RedTops::DiskUsage::Options options;
+    std::vector<std::string> operands;
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& a = args[i];
+        if (a == "--apparent") options.apparent = true;
+        else if (a == "-x") options.one_filesystem = true;
+        else if (a == "-n" || a == "-j") {
+            if (i + 1 >= args.size()) throw RedTops::CommandError("du: " + a + " needs a value");
+            long n = std::strtol(args[++i].c_str(), nullptr, 10);
+            if (n < 1 || n > (a == "-j" ? 256 : 100000)) throw RedTops::CommandError("du: invalid value for " + a + ": " + args[i]);
+            if (a == "-n") options.top = static_cast<size_t>(n);
+            else options.threads = static_cast<unsigned>(n);
+        }
+        else if (!a.empty() && a[0] == '-') throw RedTops::CommandError("du: unknown option " + a + "\n" + usage);
+        else operands.push_back(a);
+    }
+    if (operands.empty()) operands.push_back(".");
+
+    const bool structured = RecordEmitter::Instance().Active();
+    const bool progress = !structured && isatty(STDOUT_FILENO);
+    InterruptScope interrupt_scope;
+    for (const auto& op : operands) {
+        std::string root = ExpandHome(op);
+        struct stat st;
+        if (stat(root.c_str(), &st) != 0) throw RedTops::CommandError("du: " + op + ": " + std::strerror(errno));
+        if (!S_ISDIR(st.st_mode)) {
+            uint64_t bytes = options.apparent ? static_cast<uint64_t>(st.st_size) : static_cast<uint64_t>(st.st_blocks) * 512;
+            if (structured) RecordEmitter::Instance().Record("usage").Field("path", op).Field("bytes", bytes)
+                                .Field("files", uint64_t(1)).Field("complete", true).Commit();
+            else std::cout << std::setw(10) << FormatBytes(static_cast<double>(bytes)) << "  " << op << "\n";
+            continue;
+        }
+
+        RedTops::DiskUsage du(options);
+        auto start = std::chrono::steady_clock::now();
+        auto elapsed = [&] { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+        bool shown = false;
+        bool complete = du.Scan(root,
+            [] { return Shell::Instance().InterruptRequested(); },
+            [&] {
+                double secs = elapsed();
+                if (!progress || secs < 0.3) return;
+                shown = true;
+                RedTops::UsageStats s = du.Stats();
+                std::cout << "\r\x1b[2K" << Color::DIM << "  " << s.files << " files, " << s.dirs << " directories, "
+                          << FormatBytes(static_cast<double>(s.bytes)) << " (" << static_cast<uint64_t>((s.files + s.dirs) / secs)
+                          << "/s)" << Color::RESET << std::flush;
+            });
+        double secs = elapsed();
+        if (shown) std::cout << "\r\x1b[2K" << std::flush;
+
+        std::string prefix = op;
+        while (prefix.size() > 1 && prefix.back() == '/') prefix.pop_back();
+        RedTops::UsageStats s = du.Stats();
+        if (structured) {
+            for (const auto& e : du.Top())
+                RecordEmitter::Instance().Record("usage").Field("path", e.path.empty() ? prefix : prefix + "/" + e.path)
+                    .Field("bytes", e.bytes).Field("files", e.files).Field("complete", e.complete).Commit();
+            RecordEmitter::Instance().Record("du").Field("path", prefix).Field("files", s.files).Field("dirs", s.dirs)
+                .Field("bytes", s.bytes).Field("hardlinks", s.hardlinks).Field("errors", s.errors)
+                .Field("seconds", secs).Field("complete", complete).Commit();
+        } else {
+            std::cout << "\033[1;34m=== Disk usage: " << prefix << " ===\033[0m\n";
+            for (const auto& e : du.Top()) {
+                std::cout << std::setw(10) << FormatBytes(static_cast<double>(e.bytes)) << "  " << Color::DIM
+                          << std::setw(9) << e.files << " files" << Color::RESET << "  "
+                          << (e.path.empty() ? prefix : prefix + "/" + e.path);
+                if (!e.complete) std::cout << Color::AMBER << "  (incomplete)" << Color::RESET;
+                std::cout << "\n";
+            }
+            char line[200];
+            std::snprintf(line, sizeof(line), "Scanned %llu files and %llu directories in %.2f s (%u threads)%s",
+                          static_cast<unsigned long long>(s.files), static_cast<unsigned long long>(s.dirs), secs, du.Threads(),
+                          s.hardlinks ? (", " + std::to_string(s.hardlinks) + " extra hardlinks counted once").c_str() : "");
+            TerminalRenderer::Instance().PrintLine(line, Color::DIM);
+        }
+
+        for (const auto& message : du.Errors()) TerminalRenderer::Instance().PrintWarning("du: " + message);
+        if (!complete) throw RedTops::CommandError("du: interrupted; totals for " + op + " are partial");
+    }
+}
@@ -0,0 +1,263 @@
+#include "../headers/hash.hpp"
+#include "../../core/header/TerminalRenderer.hpp"
+#include "../../core/header/Exceptions.hpp"
+#include "../../core/header/RecordEmitter.hpp"
+#include "../../core/header/Shell.hpp"
+#include "../../modules/headers/FileHasher.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// One line of a manifest: "TAG (path) = hex", the BSD tagged format, so
+// `sha256sum -c` can also check the SHA256 lines
+struct ManifestLine {
+    std::string tag;
+    std::string path;
+    std::string digest;
+};
+
+std::string Tag(const RedTops::FileHasher::Options& options) {
+    std::string tag = options.algorithm == RedTops::HashAlgorithm::Xxh3 ? "XXH3"
+                    : options.algorithm == RedTops::HashAlgorithm::Sha256 ? "SHA256" : "BLAKE3";
+    // BLAKE3 is a tree already, so its tree mode is the plain digest
+    if (options.tree && options.algorithm != RedTops::HashAlgorithm::Blake3) tag += "-TREE";
+    return tag;
+}
+
+bool ParseTag(const std::string& tag, RedTops::FileHasher::Options& options) {
+    std::string name = tag;
+    options.tree = name.size() > 5 && name.compare(name.size() - 5, 5, "-TREE") == 0;
+    if (options.tree) name.resize(name.size() - 5);
+    for (auto& c : name) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return RedTops::ParseHashAlgorithm(name, options.algorithm);
+}
+
+bool ParseLine(const std::string& line, ManifestLine& out) {
+    size_t open = line.find(" (");
+    size_t close = line.rfind(") = ");
+    if (open == std::string::npos || close == std::string::npos || close < open + 2) return false;
+    out.tag = line.substr(0, open);
+    out.path = line.substr(open + 2, close - open - 2);
+    out.digest = line.substr(close + 4);
+    while (!out.digest.empty() && (out.digest.back() == '\r' || out.digest.back() == ' ')) out.digest.pop_back();
+    return !out.path.empty() && !out.digest.empty();
+}
+
+unsigned ParseThreads(const std::vector<std::string>& args, size_t& i) {
+    if (i + 1 >= args.size()) throw RedTops::CommandError("hash: -j needs a value");
+    long n = std::strtol(args[++i].c_str(), nullptr, 10);
+    if (n < 1 || n > 256) throw RedTops::CommandError("hash: invalid value for -j: " + args[i]);
+    return static_cast<unsigned>(n);
+}
+
+// Runs a hasher with Ctrl+C handling and a progress line on a terminal
+bool RunHasher(RedTops::FileHasher& hasher, const std::vector<std::string>& files, uint64_t total,
+               std::vector<RedTops::HashResult>& results, bool progress) {
+    auto start = std::chrono::steady_clock::now();
+    bool shown = false;
+    bool complete = hasher.Hash(files, results,
+        [] { return Shell::Instance().InterruptRequested(); },
+        [&] {
+            double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (!progress || secs < 0.3) return;
+            shown = true;
+            RedTops::HashStats s = hasher.Stats();
+            std::cout << "\r\x1b[2K" << Color::DIM << "  " << s.files << "/" << total << " files, "
+                      << s.bytes / 1048576 << " MiB (" << static_cast<uint64_t>(s.bytes / secs / 1048576) << " MiB/s)"
+                      << Color::RESET << std::flush;
+        });
+    if (shown) std::cout << "\r\x1b[2K" << std::flush;
+    return complete;
+}
+
+// `hash -o dir/sums dir` would otherwise list the manifest it is writing,
+// truncated and half-written, among the digests. Only names that match
+// are stat'ed, so large trees pay nothing for the check.
+void ExcludeManifest(std::vector<std::string>& files, const std::string& manifest) {
+    struct stat out;
+    if (stat(manifest.c_str(), &out) != 0) return;
+    const std::string name = manifest.substr(manifest.find_last_of('/') + 1);
+    files.erase(std::remove_if(files.begin(), files.end(), [&](const std::string& f) {
+        struct stat st;
+        return f.compare(f.find_last_of('/') + 1, std::string::npos, name) == 0 && stat(f.c_str(), &st) == 0 &&
+               st.st_dev == out.st_dev && st.st_ino == out.st_ino;
+    }), files.end());
+}
+
+void Verify(const std::string& manifest, unsigned threads, bool structured) {
+    std::ifstream in(manifest);
+    if (!in) throw RedTops::CommandError("hash: cannot open " + manifest + ": " + std::strerror(errno));
+
+    // Entries are grouped by tag so each group is hashed in one parallel pass
+    std::map<std::string, std::vector<ManifestLine>> groups;
+    std::string line;
+    size_t number = 0, malformed = 0;
+    while (std::getline(in, line)) {
+        ++number;
+        if (line.empty() || line[0] == '#') continue;
+        ManifestLine entry;
+        RedTops::FileHasher::Options options;
+        if (!ParseLine(line, entry) || !ParseTag(entry.tag, options)) {
+            if (++malformed <= 3)
+                TerminalRenderer::Instance().PrintWarning("hash: " + manifest + ":" + std::to_string(number) + ": not a manifest line");
+            continue;
+        }
+        for (auto& c : entry.digest) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        groups[entry.tag].push_back(std::move(entry));
+    }
+    if (groups.empty()) throw RedTops::CommandError("hash: " + manifest + ": no digests found");
+
+    const bool color = !structured && isatty(STDOUT_FILENO);
+    InterruptScope interrupt_scope;
+    auto start = std::chrono::steady_clock::now();
+    uint64_t ok = 0, failed = 0, missing = 0;
+    for (const auto& [tag, entries] : groups) {
+        RedTops::FileHasher::Options options;
+        ParseTag(tag, options);
+        options.threads = threads;
+        RedTops::FileHasher hasher(options);
+        std::vector<std::string> files;
+        for (const auto& e : entries) files.push_back(e.path);
+
+        std::vector<RedTops::HashResult> results;
+        if (!RunHasher(hasher, files, files.size(), results, color)) throw RedTops::CommandError("hash: interrupted");
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const auto& r = results[i];
+            std::string status = r.error.empty() ? (r.digest == entries[i].digest ? "OK" : "FAILED")
+                               : (access(r.path.c_str(), F_OK) != 0 ? "MISSING" : "ERROR");
+            if (status == "OK") ++ok;
+            else if (status == "MISSING") ++missing;
+            else ++failed;
+
+            if (structured) {
+                RecordEmitter::Instance().Record("check").Field("path", r.path).Field("algorithm", tag)
+                    .Field("status", status).Commit();
+            } else if (status != "OK" || !color) {
+                std::cout << r.path << ": ";
+                if (color) std::cout << Color::RED;
+                std::cout << status;
+                if (color) std::cout << Color::RESET;
+                if (!r.error.empty() && status == "ERROR") std::cout << " (" << r.error << ")";
+                std::cout << "\n";
+            }
+        }
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (structured) {
+        RecordEmitter::Instance().Record("verify").Field("manifest", manifest).Field("ok", ok).Field("failed", failed)
+            .Field("missing", missing).Field("seconds", secs).Commit();
+    } else if (color) {
+        char summary[200];
+        std::snprintf(summary, sizeof(summary), "%llu OK, %llu failed, %llu missing in %.2f s",
+                      static_cast<unsigned long long>(ok), static_cast<unsigned long long>(failed),
+                      static_cast<unsigned long long>(missing), secs);
+        TerminalRenderer::Instance().PrintLine(summary, failed || missing ? Color::RED : Color::GREEN);
+    }
+    if (failed || missing)
+        throw RedTops::CommandError("hash: " + std::to_string(failed + missing) + " of " +
+                                    std::to_string(ok + failed + missing) + " files did not verify");
+}
+
+} // namespace
+
+void HashCommand::Execute(const std::vector<std::string>& args) {
+    const std::string usage = "hash: usage: hash [-a xxh3|sha256|blake3] [--tree] [-j <threads>] [-o <manifest>] <path>... "
+                              "| hash -c <manifest> [-j <threads>]";
+    RedTops::FileHasher::Options options;
+    std::vector<std::string> paths;
+    std::string output, check;
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& a = args[i];
+        auto value = [&]() -> const std::string& {
+            if (i + 1 >= args.size()) throw RedTops::CommandError("hash: " + a + " needs a value");
+            return args[++i];
+        };
+        if (a == "-a") {
+            const std::string& name = value();
+            if (!RedTops::ParseHashAlgorithm(name, options.algorithm))
+                throw RedTops::CommandError("hash: unknown algorithm " + name + " (xxh3, sha256 or blake3)");
+        }
+        else if (a == "--tree") options.tree = true;
+        else if (a == "-j") options.threads = ParseThreads(args, i);
+        else if (a == "-o") output = value();
+        else if (a == "-c" || a == "--verify") check = value();
+        else if (!a.empty() && a[0] == '-' && a != "-") throw RedTops::CommandError("hash: unknown option " + a + "\n" + usage);
+        else paths.push_back(a);
+    }
+
+    const bool structured = RecordEmitter::Instance().Active();
+    if (!check.empty()) {
+        if (!paths.empty()) throw RedTops::CommandError(usage);
+        return Verify(check, options.threads, structured);
+    }
+    if (paths.empty()) throw RedTops::CommandError(usage);
+
+    std::ofstream manifest;
+    if (!output.empty()) {
+        manifest.open(output, std::ios::trunc);
+        if (!manifest) throw RedTops::CommandError("hash: cannot write " + output + ": " + std::strerror(errno));
+    }
+
+    const bool color = !structured && isatty(STDOUT_FILENO);
+    InterruptScope interrupt_scope;
+    RedTops::FileHasher hasher(options);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> files = hasher.Collect(paths, [] { return Shell::Instance().InterruptRequested(); });
+    if (Shell::Instance().InterruptRequested()) throw RedTops::CommandError("hash: interrupted");
+    if (!output.empty()) ExcludeManifest(files, output);
+
+    std::vector<RedTops::HashResult> results;
+    bool complete = RunHasher(hasher, files, files.size(), results, color);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const std::string tag = Tag(options);
+    for (const auto& r : results) {
+        if (!r.error.empty() || r.digest.empty()) continue;
+        std::string line = tag + " (" + r.path + ") = " + r.digest;
+        if (manifest.is_open()) manifest << line << "\n";
+        if (structured) {
+            RecordEmitter::Instance().Record("digest").Field("path", r.path).Field("algorithm", tag)
+                .Field("digest", r.digest).Field("bytes", r.bytes).Commit();
+        } else if (!manifest.is_open()) {
+            std::cout << line << "\n";
+        }
+    }
+    if (manifest.is_open()) {
+        manifest.close();
+        if (!manifest) throw RedTops::CommandError("hash: error writing " + output);
+    }
+
+    RedTops::HashStats st = hasher.Stats();
+    if (structured) {
+        RecordEmitter::Instance().Record("hash").Field("algorithm", tag).Field("files", st.files).Field("bytes", st.bytes)
+            .Field("errors", st.errors).Field("seconds", secs).Field("complete", complete).Commit();
+    } else if (color || !output.empty()) {
+        char line[200];
+        std::snprintf(line, sizeof(line), "%s: %llu files, %.1f MiB in %.2f s (%.0f MiB/s, %u threads)%s",
+                      tag.c_str(), static_cast<unsigned long long>(st.files), st.bytes / 1048576.0, secs,
+                      secs > 0 ? st.bytes / secs / 1048576 : 0.0, hasher.Threads(),
+                      output.empty() ? "" : (" -> " + output).c_str());
+        TerminalRenderer::Instance().PrintLine(line, Color::DIM);
+    }
+
+    for (const auto& message : hasher.Errors()) TerminalRenderer::Instance().PrintWarning("hash: " + message);
+    if (!complete) throw RedTops::CommandError("hash: interrupted");
+    if (st.errors) throw RedTops::CommandError("hash: " + std::to_string(st.errors) + " files could not be hashed");
+}
@@ -25,21 +25,30 @@ static std::unordered_map<std::string, CommandMeta> command_metadata = {
     {"pwd",      {"Print working directory", "Built-in", "pwd"}},
 
     // ---------------- Filesystem commands ----------------
-    {"ls",       {"List files and directories", "Filesystem", "ls [-a] [-l] [PATH]"}},
-    {"cat",      {"Display file contents", "Filesystem", "cat <file>"}},
+    {"ls",       {"List files and directories", "Filesystem", "ls [-a] [-l] [-t|-S|-U] [-r] [PATH]"}},
+    {"cat",      {"Display file contents (byte-exact, sendfile/mmap)", "Filesystem", "cat <file> [file...]"}},
     {"mkdir",    {"Create directories", "Filesystem", "mkdir <dir>"}},
-    {"rm",       {"Remove files or directories", "Filesystem", "rm [-r] <file|dir>"}},
-    {"cp",       {"Copy files or directories", "Filesystem", "cp [-r] <source> <dest>"}},
-    {"mv",       {"Move or rename files/directories", "Filesystem", "mv <source> <dest>"}},
+    {"rm",       {"Remove files or directories (parallel with -r)", "Filesystem", "rm [-r] [-j <threads>] <file|dir> [...]"}},
+    {"cp",       {"Copy files or directories (parallel, reflink/copy_file_range)", "Filesystem", "cp [-r] [-j <threads>] [--no-reflink] <source> <dest>"}},
+    {"mv",       {"Move or rename files/directories (across devices: parallel copy, fsync, verify)", "Filesystem", "mv [-j <threads>] [--no-sync] [--no-verify] <source> <dest>"}},
+    {"du",       {"Show the heaviest subtrees (parallel statx, hardlinks counted once)", "Filesystem", "du [-n <top>] [-j <threads>] [--apparent] [-x] [path...]"}},
+    {"search",   {"Search file contents in parallel (SIMD literals, regex fallback, .gitignore aware)", "Filesystem", "search [-i] [-F] [-l|-c] [-m <n>] [-e <pattern>]... [--include <glob>] [--exclude <glob>] [--no-ignore] [-j <threads>] <pattern> [path...] | search --name <glob> [path...]"}},
+    {"hash",     {"Hash files and trees in parallel (xxh3, sha256, blake3) or verify a manifest", "Filesystem", "hash [-a xxh3|sha256|blake3] [--tree] [-j <threads>] [-o <manifest>] <path>... | hash -c <manifest> [-j <threads>]"}},
+    {"log",      {"Follow log files with inotify, surviving rotation and truncation", "Filesystem", "log [--no-follow] [-n <lines>] [-e <pattern>]... [-F] [-i] <file>..."}},
+    {"tail",     {"Show the end of files; -f follows them like log", "Filesystem", "tail [-f|-F] [-n <lines>] [-e <pattern>]... [--fixed] [-i] <file>..."}},
+    {"view",     {"Page through a file of any size (mmap, background line index, / ? search, :line or :N%)", "Filesystem", "view <file>"}},
 
     // ---------------- Network commands ----------------
     {"ping",     {"Check connectivity to a host", "Network", "ping 8.8.8.8"}},
-    {"netinfo",  {"Display network information", "Network", "netinfo"}},
-    {"sysinfo",  {"Display system information", "Network", "sysinfo"}},
+    {"netinfo",  {"Display network information", "Network", "netinfo [-i] [-r] [-n] [-v] [-c <host[:port]>[,...] ...] [--timeout <ms>] | netinfo --watch | netinfo --rate [if1,if2] [--hz <1-100>] [--count <n>]"}},
+    {"sockets",  {"List sockets via sock_diag with kernel-side filters", "Network", "sockets [-t|-u] [-4|-6] [-l] [-s <state,...>] [--sport <p[-q]>] [--dport <p[-q]>] [-i] [--by state|peer] [-n <rows>] [--top <n>]"}},
+    {"exporter", {"Serve CPU, memory, interface and probe metrics in OpenMetrics format", "Network", "exporter [[host]:port] [-i <sec>] [--probe <host[:port]>,...] [--iface <if1,if2>]  (also: redtops --exporter :9100)"}},
+    {"sysinfo",  {"Display system information", "Network", "sysinfo [-cpu|-mem|-io|-os|-uptime|-net|-adv] | sysinfo --watch [-i <sec>] [--top <n>] [--count <n>]"}},
     {"trace",    {"Perform a traceroute to a host", "Network", "trace <host>"}},
     {"netscan",  {"Scan local subnet for live hosts", "Network", "netscan [subnet]"}},
     {"portscan", {"Scan ports on a host", "Network", "portscan <host> [start_port] [end_port]"}},
-    {"sniff", {"Sniffs packets from a network device.", "Network", "sniff <interface> [count]"}}
+    {"results",  {"List, query and diff recorded portscan/ping/trace/probe runs", "Network", "results [list] [--cmd <c>] [--target <t>] [--since <1h|7d|YYYY-MM-DD>] [--until <t>] [-n <runs>] | results show <id> | results query --host <h> [--port <p>] | results diff <id1> <id2> | results diff --last <cmd> [target]"}},
+    {"sniff", {"Sniffs packets from a network device.", "Network", "sniff <interface>[,<interface>...] [count] [-b] [-w <file>] | sniff <interface> [count] -F <workers> [--mode hash|cpu|rr] [--pin] [-b] | sniff -r <file> [count] [--since <t>] [--until <t>] [--flow <a:p-b:p>] [--index]; each with [--tcp] [--streams <dir>]"}}
 };
 
 
@@ -93,6 +102,8 @@ void HelpCommand::Execute(const std::vector<std::string>& args) {
             renderer.PrintLine(std::string(COLOR_YELLOW) + cmd + COLOR_RESET + desc);
         }
     }
+    renderer.PrintLine("\n--output json|ndjson|csv <command> writes records to stdout and text to stderr.\n"
+                       "ls, cp, mv, rm, du, search, hash, log, sniff, sockets, portscan, results and netinfo -c emit records.", Color::DIM);
 }
 
 // Auto-register HelpCommand
@@ -0,0 +1,110 @@
+#include "../headers/log.hpp"
+#include "../../core/header/TerminalRenderer.hpp"
+#include "../../core/header/Exceptions.hpp"
+#include "../../core/header/RecordEmitter.hpp"
+#include "../../core/header/Shell.hpp"
+#include "../../modules/headers/LogFollower.hpp"
+#include "../../modules/headers/TextSearch.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+void LogCommand::Execute(const std::vector<std::string>& args) {
+    const std::string name = Name();
+    const std::string usage = follow_by_default_
+        ? "log: usage: log [--no-follow] [-n <lines>] [-e <pattern>]... [-F] [-i] <file>..."
+        : "tail: usage: tail [-f|-F] [-n <lines>] [-e <pattern>]... [--fixed] [-i] <file>...";
+    RedTops::LogFollower::Options options;
+    std::vector<std::string> patterns, paths;
+    bool follow = follow_by_default_, fixed = false, ignore_case = false;
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& a = args[i];
+        auto value = [&]() -> const std::string& {
+            if (i + 1 >= args.size()) throw RedTops::CommandError(name + ": " + a + " needs a value");
+            return args[++i];
+        };
+        if (a == "-n") {
+            const std::string& v = value();
+            char* end = nullptr;
+            long n = std::strtol(v.c_str(), &end, 10);
+            if (v.empty() || *end || n < 0 || n > 10000000) throw RedTops::CommandError(name + ": invalid line count " + v);
+            options.initial_lines = static_cast<size_t>(n);
+        }
+        else if (a == "-e") patterns.push_back(value());
+        else if (a == "-i") ignore_case = true;
+        // tail's -F (follow by name) is what every follow here does; for log,
+        // -F means fixed strings as in search
+        else if (a == "-f" || (a == "-F" && !follow_by_default_)) follow = true;
+        else if (a == "-F" || a == "--fixed") fixed = true;
+        else if (a == "--no-follow") follow = false;
+        else if (!a.empty() && a[0] == '-') throw RedTops::CommandError(name + ": unknown option " + a + "\n" + usage);
+        else paths.push_back(a);
+    }
+    if (paths.empty()) throw RedTops::CommandError(usage);
+
+    std::unique_ptr<RedTops::TextMatcher> matcher;
+    if (!patterns.empty()) {
+        matcher = std::make_unique<RedTops::TextMatcher>(patterns, fixed, ignore_case);
+        options.matcher = matcher.get();
+    }
+
+    const bool structured = RecordEmitter::Instance().Active();
+    const bool color = !structured && isatty(STDOUT_FILENO);
+    const bool headers = paths.size() > 1;
+    RedTops::LogFollower follower(paths, options);
+
+    // Lines are gathered per batch and written with one call, which keeps up
+    // with hundreds of thousands of lines a second
+    std::string pending;
+    size_t current = static_cast<size_t>(-1);
+    RedTops::LogFollower::Handler handler;
+    handler.line = [&](size_t file, std::string_view line) {
+        if (structured) {
+            RecordEmitter::Instance().Record("line").Field("path", follower.Path(file)).Field("text", line).Commit();
+            return;
+        }
+        if (headers && file != current) {
+            if (current != static_cast<size_t>(-1)) pending += '\n';
+            if (color) pending += Color::CYAN;
+            pending += "==> " + follower.Path(file) + " <==";
+            if (color) pending += Color::RESET;
+            pending += '\n';
+            current = file;
+        }
+        pending.append(line.data(), line.size());
+        pending += '\n';
+    };
+    handler.notice = [&](size_t file, const std::string& message) {
+        if (structured) {
+            RecordEmitter::Instance().Record("notice").Field("path", follower.Path(file)).Field("message", message).Commit();
+            return;
+        }
+        handler.flush();
+        TerminalRenderer::Instance().PrintWarning(name + ": " + follower.Path(file) + ": " + message);
+    };
+    handler.flush = [&] {
+        if (pending.empty()) return;
+        std::cout.write(pending.data(), static_cast<std::streamsize>(pending.size()));
+        std::cout.flush();
+        pending.clear();
+    };
+
+    InterruptScope interrupt_scope;
+    follower.Start(handler);
+    if (follow) follower.Follow(handler, [] { return Shell::Instance().InterruptRequested(); });
+    else follower.Drain(handler);
+
+    RedTops::FollowStats st = follower.Stats();
+    if (structured) {
+        RecordEmitter::Instance().Record("log").Field("lines", st.lines).Field("shown", st.shown).Field("bytes", st.bytes)
+            .Field("rotations", st.rotations).Field("truncations", st.truncations).Commit();
+    } else if (follow && color && matcher) {
+        TerminalRenderer::Instance().PrintLine(std::to_string(st.shown) + " of " + std::to_string(st.lines) +
+                                               " lines matched", Color::DIM);
+    }
+}
@@ -1,5 +1,8 @@
 #include "../headers/netinfo.hpp"
 #include "../../core/header/TerminalRenderer.hpp"
+#include "../../core/header/Exceptions.hpp"
+#include "../../core/header/Shell.hpp"
+#include "../../core/header/RecordEmitter.hpp"
 
 // ===== Platform-Specific Includes =====
 #ifdef _WIN32
@@ -19,10 +22,18 @@
 inline int getifaddrs(struct ifaddrs**) { return -1; }
 inline void freeifaddrs(struct ifaddrs*) {}
 #else
-#include <ifaddrs.h>
 #include <net/if.h>
+#include <sys/resource.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <ctime>
+#include <unordered_map>
+#include <linux/neighbour.h>
+#include <linux/rtnetlink.h>
+#include "../../modules/headers/IfaceRateMonitor.hpp"
+#include "../../modules/headers/NetlinkRoute.hpp"
+#include "../../modules/headers/ReachabilityProbe.hpp"
+#include "../../modules/headers/ResultStore.hpp"
 #endif
 
 #include <fstream>
@@ -33,6 +44,331 @@ inline void freeifaddrs(struct ifaddrs*) {}
 #include <set>
 #include <cstdlib>
 #include <iomanip>
+#include <algorithm>
+#include <cstdio>
+#include <chrono>
+
+#ifndef _WIN32
+namespace {
+
+struct RateOptions {
+    std::vector<std::string> interfaces;   // empty = all
+    int hz = 10;                           // samples per second
+    long count = 0;                        // redraws before exiting, 0 = until Ctrl+C
+};
+
+constexpr size_t kSparkWidth = 48;
+constexpr int kMaxRedrawHz = 10;
+
+// "12.3M" style with the given unit suffix
+void FormatRate(char* out, size_t size, double value, const char* unit) {
+    static const char* prefixes[] = {"", "k", "M", "G", "T"};
+    int p = 0;
+    while (value >= 1000.0 && p < 4) { value /= 1000.0; ++p; }
+    std::snprintf(out, size, p == 0 ? "%.0f %s%s" : "%.1f %s%s", value, prefixes[p], unit);
+}
+
+void AppendSparkline(std::string& out, const RedTops::IfaceRateMonitor& mon, size_t iface) {
+    static const char* levels[] = {" ", "\u2581", "\u2582", "\u2583", "\u2584", "\u2585", "\u2586", "\u2587", "\u2588"};
+    size_t n = std::min(kSparkWidth, mon.HistoryLength());
+    double peak = 0;
+    for (size_t age = 0; age < n; ++age) peak = std::max(peak, mon.History(iface, age));
+    out.append(kSparkWidth - n, ' ');
+    for (size_t age = n; age-- > 0;) {
+        double v = mon.History(iface, age);
+        int level = peak > 0 ? static_cast<int>(v / peak * 8.0 + 0.5) : 0;
+        if (v > 0 && level == 0) level = 1;
+        out += levels[level];
+    }
+}
+
+timespec AddNs(timespec t, long ns) {
+    t.tv_nsec += ns;
+    while (t.tv_nsec >= 1000000000L) { t.tv_nsec -= 1000000000L; ++t.tv_sec; }
+    return t;
+}
+
+// Live per-interface throughput, sampled at up to 100 Hz and redrawn at up to 10 Hz
+void RunRate(const RateOptions& opts) {
+    TerminalRenderer& term = TerminalRenderer::Instance();
+    InterruptScope interrupt_scope;
+
+    RedTops::IfaceRateMonitor mon(opts.interfaces);
+    if (mon.Count() == 0) throw RedTops::CommandError("netinfo: no interfaces to monitor");
+
+    const long period_ns = 1000000000L / opts.hz;
+    const int samples_per_redraw = std::max(1, opts.hz / kMaxRedrawHz);
+
+    // Everything the loop touches is allocated here, once
+    std::string frame;
+    frame.reserve(512 + mon.Count() * (256 + kSparkWidth * 3));
+    char line[256], rx[24], tx[24], rxp[24], txp[24];
+    double cost_ms = 0;
+
+    std::cout << "\033[2J\033[?25l" << std::flush;
+    mon.Sample();
+    timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    for (long redraw = 0; opts.count == 0 || redraw < opts.count; ++redraw) {
+        double busy_ms = 0;
+        for (int s = 0; s < samples_per_redraw; ++s) {
+            // Absolute deadlines keep the cadence steady regardless of sample cost
+            next = AddNs(next, period_ns);
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+            if (Shell::Instance().InterruptRequested()) break;
+            timespec a, b;
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &a);
+            mon.Sample();
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &b);
+            busy_ms += (b.tv_sec - a.tv_sec) * 1e3 + (b.tv_nsec - a.tv_nsec) / 1e6;
+        }
+        if (Shell::Instance().InterruptRequested()) break;
+        mon.EndWindow();
+
+        timespec a, b;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &a);
+        frame.clear();
+        std::snprintf(line, sizeof(line), "\033[1;34m=== Interface Rates ===\033[0m  %d Hz sampling  (Ctrl+C to stop)\n\n", opts.hz);
+        frame += line;
+        frame += Color::CYAN;
+        std::snprintf(line, sizeof(line), "%-12s %12s %12s %10s %10s %7s %7s  %s\n",
+                      "IFACE", "RX", "TX", "RX pps", "TX pps", "ERR/s", "DROP/s", "rx+tx history");
+        frame += line;
+        frame += Color::RESET;
+
+        for (size_t i = 0; i < mon.Count(); ++i) {
+            const RedTops::IfaceRates& r = mon.Window(i);
+            FormatRate(rx, sizeof(rx), r.rx_bps, "b/s");
+            FormatRate(tx, sizeof(tx), r.tx_bps, "b/s");
+            FormatRate(rxp, sizeof(rxp), r.rx_pps, "");
+            FormatRate(txp, sizeof(txp), r.tx_pps, "");
+            double errors = r.rx_errors + r.tx_errors;
+            double drops = r.rx_drops + r.tx_drops;
+            std::snprintf(line, sizeof(line), "%-12.12s %12s %12s %10s %10s %s%7.0f %7.0f%s  ",
+                          mon.Name(i).c_str(), rx, tx, rxp, txp,
+                          (errors > 0 || drops > 0) ? Color::RED.c_str() : "", errors, drops,
+                          Color::RESET.c_str());
+            frame += line;
+            if (!mon.Up(i)) {
+                frame += Color::DIM + "(gone)" + Color::RESET;
+            } else {
+                frame += Color::GREEN;
+                AppendSparkline(frame, mon, i);
+                frame += Color::RESET;
+            }
+            frame += '\n';
+        }
+
+        std::snprintf(line, sizeof(line), "\n%ssampling %.3f ms/s  render %.3f ms  overhead %.3f%% CPU%s",
+                      Color::DIM.c_str(), busy_ms * opts.hz / samples_per_redraw, cost_ms,
+                      (busy_ms + cost_ms) / (samples_per_redraw * period_ns / 1e6) * 100.0, Color::RESET.c_str());
+        frame += line;
+        term.DrawFrame(frame);
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &b);
+        cost_ms = (b.tv_sec - a.tv_sec) * 1e3 + (b.tv_nsec - a.tv_nsec) / 1e6;
+    }
+
+    std::cout << "\033[?25h" << std::flush;
+    term.PrintLine("");
+}
+
+std::string FormatRoute(const RedTops::RouteInfo& r, const std::string& dev) {
+    std::string out = r.dst.empty() ? (r.dst_len == 0 ? std::string("default") : std::string("?"))
+                                    : r.dst + "/" + std::to_string(r.dst_len);
+    if (r.type == RTN_UNREACHABLE) out = "unreachable " + out;
+    else if (r.type == RTN_BLACKHOLE) out = "blackhole " + out;
+    else if (r.type == RTN_LOCAL) out = "local " + out;
+    else if (r.type == RTN_BROADCAST) out = "broadcast " + out;
+    if (!r.gateway.empty()) out += " via " + r.gateway;
+    if (r.oif) out += " dev " + dev;
+    out += std::string(" proto ") + RedTops::RouteProtocolName(r.protocol);
+    if (r.scope != RT_SCOPE_UNIVERSE) out += std::string(" scope ") + RedTops::ScopeName(r.scope);
+    if (!r.prefsrc.empty()) out += " src " + r.prefsrc;
+    if (r.metric) out += " metric " + std::to_string(r.metric);
+    if (r.table != RT_TABLE_MAIN) out += " table " + std::to_string(r.table);
+    return out;
+}
+
+std::string FormatNeigh(const RedTops::NeighInfo& n, const std::string& dev) {
+    std::string out = n.address + " dev " + dev;
+    if (!n.lladdr.empty()) out += " lladdr " + n.lladdr;
+    return out + " " + RedTops::NeighStateName(n.state);
+}
+
+std::string FormatLinkFlags(const RedTops::LinkInfo& link) {
+    std::string out = link.up() ? "UP" : "DOWN";
+    if (link.running()) out += ",RUNNING";
+    if (link.flags & IFF_LOOPBACK) out += ",LOOPBACK";
+    if (link.flags & IFF_PROMISC) out += ",PROMISC";
+    return out;
+}
+
+std::string TimeStamp() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    tm local{};
+    localtime_r(&ts.tv_sec, &local);
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%02d:%02d:%02d.%03ld", local.tm_hour, local.tm_min, local.tm_sec, ts.tv_nsec / 1000000);
+    return buf;
+}
+
+// Streams link/address/route/neighbour changes as the kernel announces them
+void RunWatch() {
+    TerminalRenderer& term = TerminalRenderer::Instance();
+    InterruptScope interrupt_scope;
+
+    // Subscribe first so nothing falls between the name dump and the first event
+    RedTops::NetlinkRoute events(true);
+    std::unordered_map<int, std::string> names;
+    {
+        RedTops::NetlinkRoute dump;
+        for (const auto& link : dump.Dump().links) names[link.index] = link.name;
+    }
+    auto dev = [&](int index) {
+        auto it = names.find(index);
+        return it != names.end() ? it->second : "if" + std::to_string(index);
+    };
+
+    term.PrintLine("\033[1;34m=== Watching network changes ===\033[0m  (Ctrl+C to stop)");
+    while (!Shell::Instance().InterruptRequested()) {
+        bool complete = events.ReadEvents(100, [&](const RedTops::NetlinkEvent& ev) {
+            std::string sign = ev.removed ? Color::RED + "-" : Color::GREEN + "+";
+            std::string text;
+            switch (ev.kind) {
+                case RedTops::NetlinkEvent::Kind::Link:
+                    // RTM_NEWLINK also reports changes to links we already know
+                    if (!ev.removed && names.count(ev.link.index)) sign = Color::AMBER + "~";
+                    if (!ev.removed) names[ev.link.index] = ev.link.name;
+                    text = "link  " + ev.link.name + " " + FormatLinkFlags(ev.link) + " mtu " + std::to_string(ev.link.mtu);
+                    if (!ev.link.kind.empty()) text += " (" + ev.link.kind + ")";
+                    if (ev.removed) names.erase(ev.link.index);
+                    break;
+                case RedTops::NetlinkEvent::Kind::Addr:
+                    text = "addr  " + ev.addr.address + "/" + std::to_string(ev.addr.prefix) + " dev " + dev(ev.addr.index) +
+                           " scope " + RedTops::ScopeName(ev.addr.scope);
+                    break;
+                case RedTops::NetlinkEvent::Kind::Route:
+                    if (ev.route.table == RT_TABLE_LOCAL) return;   // churns with every address change
+                    text = "route " + FormatRoute(ev.route, dev(ev.route.oif));
+                    break;
+                case RedTops::NetlinkEvent::Kind::Neigh:
+                    text = "neigh " + FormatNeigh(ev.neigh, dev(ev.neigh.index));
+                    break;
+            }
+            term.PrintLine(Color::DIM + TimeStamp() + Color::RESET + " " + sign + Color::RESET + " " + text);
+        });
+        if (!complete)
+            term.PrintLine(Color::AMBER + "netinfo: kernel dropped notifications (socket buffer overflow)" + Color::RESET);
+    }
+}
+
+// Appends a check to the result store so `results` can list and diff it
+void RecordResults(const std::vector<std::string>& specs, const std::vector<RedTops::ProbeResult>& results,
+                   std::chrono::system_clock::time_point started) {
+    std::vector<RedTops::ResultRow> rows;
+    rows.reserve(results.size());
+    for (const auto& r : results) {
+        RedTops::ResultRow row;
+        row.host = r.target.host;
+        row.port = r.target.port;
+        switch (r.status) {
+            case RedTops::ProbeStatus::Reachable:   row.status = RedTops::ResultStatus::Up; break;
+            case RedTops::ProbeStatus::Refused:     row.status = RedTops::ResultStatus::Refused; break;
+            case RedTops::ProbeStatus::Unreachable: row.status = RedTops::ResultStatus::Down; break;
+            case RedTops::ProbeStatus::Timeout:     row.status = RedTops::ResultStatus::Timeout; break;
+            default:                                row.status = RedTops::ResultStatus::Error; break;
+        }
+        if (r.status == RedTops::ProbeStatus::Reachable || r.status == RedTops::ProbeStatus::Refused)
+            row.value = static_cast<float>(r.rtt_ms);
+        rows.push_back(std::move(row));
+    }
+    std::string target;
+    for (const auto& spec : specs) target += (target.empty() ? "" : " ") + spec;
+    try {
+        RedTops::ResultStore().Append(RedTops::ResultKind::Probe, target, started, std::move(rows));
+    } catch (const RedTops::RedTopsException& e) {
+        TerminalRenderer::Instance().PrintWarning(e.what());
+    }
+}
+
+// The probe holds a socket per target; lift the soft descriptor limit for
+// them where the hard limit allows. A target that still gets no socket is
+// reported as an error rather than failing the run.
+void RaiseFdLimit(size_t wanted) {
+    rlimit lim{};
+    if (getrlimit(RLIMIT_NOFILE, &lim) != 0) return;
+    rlim_t need = static_cast<rlim_t>(wanted + 64);
+    if (lim.rlim_cur >= need) return;
+    lim.rlim_cur = std::min(need, lim.rlim_max);
+    setrlimit(RLIMIT_NOFILE, &lim);
+}
+
+// Concurrent ICMP / TCP reachability of every target, printed as one table
+void RunChecks(const std::vector<std::string>& specs, int timeout_ms) {
+    TerminalRenderer& term = TerminalRenderer::Instance();
+    InterruptScope interrupt_scope;
+
+    RedTops::ReachabilityProbe probe(timeout_ms);
+    for (const auto& spec : specs) probe.Add(RedTops::ParseProbeTarget(spec));
+
+    RaiseFdLimit(probe.Count());
+
+    term.PrintLine("\033[1;34m=== Checking Connectivity ===\033[0m  " + std::to_string(probe.Count()) +
+                   " target(s), timeout " + std::to_string(timeout_ms) + " ms");
+    auto started_wall = std::chrono::system_clock::now();
+    auto started = std::chrono::steady_clock::now();
+    std::vector<RedTops::ProbeResult> results = probe.Run([] { return Shell::Instance().InterruptRequested(); });
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    RecordResults(specs, results, started_wall);
+
+    RecordEmitter& records = RecordEmitter::Instance();
+    if (records.Active()) {
+        for (const auto& r : results) {
+            bool answered = r.status == RedTops::ProbeStatus::Reachable || r.status == RedTops::ProbeStatus::Refused;
+            records.Record("probe").Field("target", r.target.spec).Field("address", r.address)
+                .Field("protocol", r.target.port ? "tcp" : "icmp").Field("port", r.target.port)
+                .Field("status", RedTops::ProbeStatusName(r.status)).Field("rtt_ms", answered ? r.rtt_ms : 0.0)
+                .Field("detail", r.detail).Commit();
+        }
+        return;
+    }
+
+    size_t width = 6, addr_width = 7;
+    for (const auto& r : results) {
+        width = std::max(width, r.target.spec.size());
+        addr_width = std::max(addr_width, r.address.size());
+    }
+    width = std::min<size_t>(width, 40);
+
+    std::string out;
+    char line[512];
+    std::snprintf(line, sizeof(line), "%-*s  %-*s  %-9s  %-11s  %9s\n", static_cast<int>(width), "TARGET", static_cast<int>(addr_width), "ADDRESS", "PROBE", "STATUS", "RTT");
+    out += Color::CYAN + line + Color::RESET;
+    size_t up = 0;
+    for (const auto& r : results) {
+        bool ok = r.status == RedTops::ProbeStatus::Reachable || r.status == RedTops::ProbeStatus::Refused;
+        if (ok) ++up;
+        std::string probe_name = r.target.port ? "tcp/" + std::to_string(r.target.port) : "icmp";
+        char rtt[24] = "-";
+        if (ok) std::snprintf(rtt, sizeof(rtt), "%.2f ms", r.rtt_ms);
+        const std::string& color = r.status == RedTops::ProbeStatus::Reachable ? Color::GREEN
+                                 : r.status == RedTops::ProbeStatus::Refused ? Color::AMBER : Color::RED;
+        std::snprintf(line, sizeof(line), "%-*.*s  %-*s  %-9s  %s%-11s%s  %9s", static_cast<int>(width), static_cast<int>(width),
+                      r.target.spec.c_str(), static_cast<int>(addr_width), r.address.empty() ? "-" : r.address.c_str(), probe_name.c_str(),
+                      color.c_str(), RedTops::ProbeStatusName(r.status), Color::RESET.c_str(), rtt);
+        out += line;
+        if (!r.detail.empty()) out += "  " + Color::DIM + r.detail + Color::RESET;
+        out += '\n';
+    }
+    std::snprintf(line, sizeof(line), "%zu/%zu reachable in %.0f ms", up, results.size(), elapsed_ms);
+    out += line;
+    term.PrintLine(out);
+}
+
+} // namespace
+#endif
 
 
 void NetInfoCommand::Execute(const std::vector<std::string>& args) {
@@ -43,6 +379,11 @@ void NetInfoCommand::Execute(const std::vector<std::string>& args) {
     bool check_connectivity = false;
     bool verbose = false;
     std::vector<std::string> hosts_to_check;
+    int check_timeout_ms = 2000;
+    bool show_rate = false;
+    bool show_neighbors = false;
+    bool watch = false;
+    RateOptions rate_opts;
 
     // Parse flags
     for (size_t i = 0; i < args.size(); ++i) {
@@ -52,16 +393,80 @@ void NetInfoCommand::Execute(const std::vector<std::string>& args) {
         else if (arg == "-v" || arg == "--verbose") verbose = true;
         else if ((arg == "-c" || arg == "--check") && i + 1 < args.size()) {
             check_connectivity = true;
-            hosts_to_check.push_back(args[++i]);
+            // "-c a,b:443 c" - comma lists and any following bare targets
+            while (i + 1 < args.size() && args[i + 1][0] != '-') {
+                std::stringstream list(args[++i]);
+                std::string host;
+                while (std::getline(list, host, ',')) if (!host.empty()) hosts_to_check.push_back(host);
+            }
+        }
+        else if (arg == "--timeout" && i + 1 < args.size()) {
+            char* end = nullptr;
+            long value = std::strtol(args[++i].c_str(), &end, 10);
+            if (end == args[i].c_str() || *end || value < 1 || value > 60000)
+                throw RedTops::CommandError("netinfo: --timeout must be 1-60000 ms");
+            check_timeout_ms = static_cast<int>(value);
+        }
+        else if (arg == "-n" || arg == "--neighbors") show_neighbors = true;
+        else if (arg == "--watch") watch = true;
+        else if (arg == "--rate") {
+            show_rate = true;
+            // Optional comma-separated interface list
+            if (i + 1 < args.size() && args[i + 1][0] != '-') {
+                std::stringstream list(args[++i]);
+                std::string name;
+                while (std::getline(list, name, ',')) if (!name.empty()) rate_opts.interfaces.push_back(name);
+            }
+        }
+        else if ((arg == "--hz" || arg == "--count") && i + 1 < args.size()) {
+            long value = std::strtol(args[++i].c_str(), nullptr, 10);
+            if (arg == "--hz") {
+                if (value < 1 || value > 100) throw RedTops::CommandError("netinfo: --hz must be between 1 and 100");
+                rate_opts.hz = static_cast<int>(value);
+            } else {
+                if (value < 0) throw RedTops::CommandError("netinfo: invalid --count");
+                rate_opts.count = value;
+            }
         }
     }
 
+    // Only the reachability checks write records
+    if (RecordEmitter::Instance().Active() && (watch || show_rate || !check_connectivity))
+        throw RedTops::CommandError("netinfo: --output needs -c; the other views write no records");
+
+    if (watch) {
+#ifndef _WIN32
+        RunWatch();
+#else
+        throw RedTops::CommandError("netinfo: --watch is only available on Linux");
+#endif
+        return;
+    }
+
+    if (show_rate) {
+#ifndef _WIN32
+        RunRate(rate_opts);
+#else
+        throw RedTops::CommandError("netinfo: --rate is only available on Linux");
+#endif
+        return;
+    }
+
     // Default behavior
-    if (!show_interfaces && !show_routes && !check_connectivity) {
+    if (!show_interfaces && !show_routes && !show_neighbors && !check_connectivity) {
         show_interfaces = true;
         show_routes = true;
     }
 
+#ifndef _WIN32
+    // One netlink pass serves the interface, route and neighbour views
+    RedTops::NetlinkSnapshot snapshot;
+    if (show_interfaces || show_routes || show_neighbors) {
+        RedTops::NetlinkRoute netlink;
+        snapshot = netlink.Dump();
+    }
+#endif
+
     // ===== Interfaces =====
     if (show_interfaces) {
         term.PrintLine("\033[1;34m=== Network Interfaces ===\033[0m");
@@ -70,66 +475,37 @@ void NetInfoCommand::Execute(const std::vector<std::string>& args) {
         // =========================
         // LINUX IMPLEMENTATION
         // =========================
-        struct ifaddrs* ifaddr;
-        if (getifaddrs(&ifaddr) == -1) {
-            term.PrintLine("Failed to retrieve network interfaces.");
-        } else {
-            std::set<std::string> seen;
-            for (struct ifaddrs* ifa = ifaddr; ifa != nullptr; ifa = ifa->ifa_next) {
-                if (!ifa->ifa_addr) continue;
-                std::string name = ifa->ifa_name;
-                if (seen.count(name)) continue;
-                seen.insert(name);
-
-                std::vector<std::string> ipv4_addrs, ipv6_addrs;
-
-                for (struct ifaddrs* cur = ifaddr; cur != nullptr; cur = cur->ifa_next) {
-                    if (!cur->ifa_addr) continue;
-                    if (name != cur->ifa_name) continue;
-
-                    char buf[INET6_ADDRSTRLEN];
-                    if (cur->ifa_addr->sa_family == AF_INET) {
-                        sockaddr_in* sa = reinterpret_cast<sockaddr_in*>(cur->ifa_addr);
-                        inet_ntop(AF_INET, &(sa->sin_addr), buf, INET_ADDRSTRLEN);
-                        ipv4_addrs.push_back(buf);
-                    } else if (cur->ifa_addr->sa_family == AF_INET6) {
-                        sockaddr_in6* sa6 = reinterpret_cast<sockaddr_in6*>(cur->ifa_addr);
-                        inet_ntop(AF_INET6, &(sa6->sin6_addr), buf, INET6_ADDRSTRLEN);
-                        ipv6_addrs.push_back(buf);
-                    }
-                }
-
-                std::ifstream macfile("/sys/class/net/" + name + "/address");
-                std::string mac = "?";
-                if (macfile) std::getline(macfile, mac);
-
-                term.PrintLine("Interface: " + name);
-                term.PrintLine("  IPv4: " + (ipv4_addrs.empty() ? "N/A" : ipv4_addrs[0]));
-                term.PrintLine("  IPv6: " + (ipv6_addrs.empty() ? "N/A" : ipv6_addrs[0]));
-                term.PrintLine("  MAC : " + (mac.empty() ? "?" : mac));
-
-                if (verbose) {
-                    std::ifstream mtufile("/sys/class/net/" + name + "/mtu");
-                    std::string mtu;
-                    if (mtufile) std::getline(mtufile, mtu);
-
-                    term.PrintLine("  MTU : " + (mtu.empty() ? "?" : mtu));
-                    term.PrintLine("  Flags: " + std::to_string(ifa->ifa_flags));
-
-                    // Optional: RX/TX stats
-                    std::ifstream rxfile("/sys/class/net/" + name + "/statistics/rx_bytes");
-                    std::ifstream txfile("/sys/class/net/" + name + "/statistics/tx_bytes");
-                    std::string rx, tx;
-                    if (rxfile) std::getline(rxfile, rx);
-                    if (txfile) std::getline(txfile, tx);
-                    term.PrintLine("  RX  : " + (rx.empty() ? "?" : rx) + " bytes");
-                    term.PrintLine("  TX  : " + (tx.empty() ? "?" : tx) + " bytes");
-                }
-
-                term.PrintLine(""); // spacing
+        std::unordered_map<int, std::vector<const RedTops::AddrInfo*>> addrs_by_link;
+        for (const auto& addr : snapshot.addrs) addrs_by_link[addr.index].push_back(&addr);
+
+        std::string out;
+        for (const auto& link : snapshot.links) {
+            out += "Interface: " + link.name + "  [" + FormatLinkFlags(link) + "]";
+            if (!link.kind.empty()) out += " (" + link.kind + ")";
+            out += "\n";
+
+            bool any_v4 = false, any_v6 = false;
+            for (const RedTops::AddrInfo* addr : addrs_by_link[link.index]) {
+                bool v6 = addr->family == AF_INET6;
+                (v6 ? any_v6 : any_v4) = true;
+                out += std::string(v6 ? "  IPv6: " : "  IPv4: ") + addr->address + "/" + std::to_string(addr->prefix);
+                if (addr->scope != RT_SCOPE_UNIVERSE) out += std::string(" (") + RedTops::ScopeName(addr->scope) + ")";
+                out += "\n";
+            }
+            if (!any_v4) out += "  IPv4: N/A\n";
+            if (!any_v6) out += "  IPv6: N/A\n";
+            out += "  MAC : " + (link.mac.empty() ? std::string("?") : link.mac) + "\n";
+
+            if (verbose) {
+                out += "  MTU : " + std::to_string(link.mtu) + "\n";
+                out += "  Flags: " + std::to_string(link.flags) + "\n";
+                if (link.master) out += "  Master: " + snapshot.LinkName(link.master) + "\n";
+                out += "  RX  : " + std::to_string(link.rx_bytes) + " bytes, " + std::to_string(link.rx_packets) + " packets\n";
+                out += "  TX  : " + std::to_string(link.tx_bytes) + " bytes, " + std::to_string(link.tx_packets) + " packets\n";
             }
-            freeifaddrs(ifaddr);
+            out += "\n";
         }
+        term.PrintLine(out);
 
 #else
         // =========================
@@ -194,44 +570,53 @@ void NetInfoCommand::Execute(const std::vector<std::string>& args) {
         term.PrintLine("\033[1;34m=== Routing Table ===\033[0m");
 
 #ifndef _WIN32
-        // Linux route parsing
-        std::ifstream route_file("/proc/net/route");
-        std::string line;
-        int lineno = 0;
-        while (std::getline(route_file, line)) {
-            lineno++;
-            if (lineno == 1) continue;
-            std::istringstream iss(line);
-            std::string iface, dest_hex, gateway_hex;
-            int flags, refcnt, use, metric, mask_hex;
-            if (!(iss >> iface >> dest_hex >> gateway_hex >> std::hex >> flags >> refcnt >> use >> metric >> mask_hex))
-                continue;
-
-            if (dest_hex == "00000000") {
-                unsigned long gw = std::stoul(gateway_hex, nullptr, 16);
-                std::ostringstream oss;
-                oss << ((gw & 0xFF)) << "." << ((gw >> 8) & 0xFF) << "."
-                    << ((gw >> 16) & 0xFF) << "." << ((gw >> 24) & 0xFF);
-                term.PrintLine("Default Gateway: " + oss.str() + " via " + iface);
+        // Main table by default; -v adds policy tables and the kernel's local table
+        std::string out;
+        for (const auto& route : snapshot.routes) {
+            if (route.dst.empty() && route.dst_len == 0 && route.table == RT_TABLE_MAIN && !route.gateway.empty())
+                out += "Default Gateway: " + route.gateway + " via " + snapshot.LinkName(route.oif) + "\n";
+        }
+        for (int family : {AF_INET, AF_INET6}) {
+            for (const auto& route : snapshot.routes) {
+                if (route.family != family) continue;
+                if (!verbose && route.table != RT_TABLE_MAIN) continue;
+                out += "  " + FormatRoute(route, snapshot.LinkName(route.oif)) + "\n";
             }
         }
+        if (!out.empty()) out.pop_back();
+        term.PrintLine(out.empty() ? "No routes." : out);
 #else
         // Windows fallback (not removing logic, just adding minimal support)
         term.PrintLine("Routing table view is not implemented on Windows yet.");
 #endif
     }
 
+    // ===== Neighbours =====
+    if (show_neighbors) {
+        term.PrintLine("\033[1;34m=== Neighbor Table ===\033[0m");
+#ifndef _WIN32
+        std::string out;
+        for (const auto& neigh : snapshot.neighbors) {
+            if (neigh.address.empty() || (neigh.state & NUD_NOARP)) continue;
+            out += FormatNeigh(neigh, snapshot.LinkName(neigh.index)) + "\n";
+        }
+        if (!out.empty()) out.pop_back();
+        term.PrintLine(out.empty() ? "No neighbor entries." : out);
+#else
+        term.PrintLine("Neighbor table view is not implemented on Windows yet.");
+#endif
+    }
+
     // ===== Connectivity Check =====
     if (check_connectivity) {
+#ifndef _WIN32
+        RunChecks(hosts_to_check, check_timeout_ms);
+#else
         for (auto& host : hosts_to_check) {
             term.PrintLine("\033[1;34m=== Checking Connectivity ===\033[0m");
             term.PrintLine("Pinging " + host + " ...");
 
-#ifndef _WIN32
-            FILE* pipe = popen(("ping -c 1 " + host).c_str(), "r");
-#else
             FILE* pipe = _popen(("ping -n 1 " + host).c_str(), "r");
-#endif
 
             if (!pipe) {
                 term.PrintLine("Failed to execute ping.");
@@ -242,18 +627,14 @@ void NetInfoCommand::Execute(const std::vector<std::string>& args) {
             bool reachable = false;
             while (fgets(buffer, sizeof(buffer), pipe)) {
                 std::string line(buffer);
-                if (line.find("1 received") != std::string::npos ||
-                    line.find("TTL=") != std::string::npos)
+                if (line.find("TTL=") != std::string::npos)
                     reachable = true;
             }
 
-#ifndef _WIN32
-            pclose(pipe);
-#else
             _pclose(pipe);
-#endif
 
             term.PrintLine(host + (reachable ? " is reachable." : " is not reachable."));
         }
+#endif
     }
 }
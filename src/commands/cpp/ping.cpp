@@ -1,5 +1,9 @@
 #include "../headers/ping.hpp"
 #include "../../core/header/TerminalRenderer.hpp"
+#include "../../core/header/Exceptions.hpp"
+#include "../../modules/headers/ResultStore.hpp"
+#include <sys/wait.h>
+#include <algorithm>
 #include <thread>
 #include <chrono>
 #include <iostream>
@@ -32,6 +36,9 @@ void PingCommand::Execute(const std::vector<std::string>& args) {
         else hosts.push_back(arg);
     }
 
+    auto started = std::chrono::system_clock::now();
+    std::vector<RedTops::ResultRow> results;
+
     for (auto& host : hosts) {
         TerminalRenderer::Instance().PrintLine("\n\033[1;34m=== Pinging " + host + " ===\033[0m");
 
@@ -75,13 +82,16 @@ void PingCommand::Execute(const std::vector<std::string>& args) {
                     line.erase(std::remove(line.begin(), line.end(), '\n'), line.end());
                     if (!line.empty()) TerminalRenderer::Instance().PrintLine(line);
                 }
-                pclose(pipe);
+                int status = pclose(pipe);
 
                 auto end = std::chrono::high_resolution_clock::now();
                 int ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-                latencies.push_back(ms);
                 ++sent;
-                ++received;
+                // ping(8) exits 0 only when the echo came back
+                if (status != -1 && WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+                    latencies.push_back(ms);
+                    ++received;
+                }
 
                 std::this_thread::sleep_for(std::chrono::milliseconds(500));
             }
@@ -89,6 +99,13 @@ void PingCommand::Execute(const std::vector<std::string>& args) {
 
         do_ping();
 
+        RedTops::ResultRow row;
+        row.host = host;
+        row.status = received ? RedTops::ResultStatus::Up : RedTops::ResultStatus::Timeout;
+        if (!latencies.empty())
+            row.value = static_cast<float>(std::accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size());
+        results.push_back(row);
+
         if (!latencies.empty()) {
             int min_latency = *std::min_element(latencies.begin(), latencies.end());
             int max_latency = *std::max_element(latencies.begin(), latencies.end());
@@ -116,5 +133,13 @@ void PingCommand::Execute(const std::vector<std::string>& args) {
             }
         }
     }
-}
 
+    if (results.empty()) return;
+    std::string target;
+    for (const auto& host : hosts) target += (target.empty() ? "" : ",") + host;
+    try {
+        RedTops::ResultStore().Append(RedTops::ResultKind::Ping, target, started, std::move(results));
+    } catch (const RedTops::RedTopsException& e) {
+        TerminalRenderer::Instance().PrintWarning(e.what());
+    }
+}
@@ -1,4 +1,8 @@
 #include "../headers/portscan.hpp"
+#include "../../core/header/RecordEmitter.hpp"
+#include "../../core/header/TerminalRenderer.hpp"
+#include "../../core/header/Exceptions.hpp"
+#include "../../modules/headers/ResultStore.hpp"
 #include <iostream>
 #include <vector>
 #include <string>
@@ -7,6 +11,7 @@
 #include <mutex>
 #include <queue>
 #include <algorithm>
+#include <chrono>
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <unistd.h>
@@ -98,6 +103,7 @@ void PortScanCommand::Execute(const std::vector<std::string>& args)
 
     std::cout << "Scanning " << host << " ports " 
               << start_port << "-" << end_port << "...\n";
+    auto started = std::chrono::system_clock::now();
 
     // Prepare a task queue
     std::queue<int> tasks;
@@ -123,6 +129,22 @@ void PortScanCommand::Execute(const std::vector<std::string>& args)
     // Print ordered results
     std::sort(open_ports.begin(), open_ports.end());
 
+    // Keep the scan for `results diff`; the target includes the range so only like scans are compared
+    try {
+        std::vector<RedTops::ResultRow> rows;
+        for (int p : open_ports) rows.push_back({host, static_cast<uint16_t>(p), RedTops::ResultStatus::Up, 0.0f});
+        RedTops::ResultStore().Append(RedTops::ResultKind::PortScan,
+            host + " " + std::to_string(start_port) + "-" + std::to_string(end_port), started, std::move(rows));
+    } catch (const RedTops::RedTopsException& e) {
+        TerminalRenderer::Instance().PrintWarning(e.what());
+    }
+
+    RecordEmitter& out = RecordEmitter::Instance();
+    if (out.Active()) {
+        for (int p : open_ports)
+            out.Record("port").Field("host", host).Field("port", p).Field("state", "open").Commit();
+    }
+
     if (open_ports.empty()) {
         std::cout << "No open ports found.\n";
     } else {
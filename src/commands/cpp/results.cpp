@@ -0,0 +1,342 @@
+#include "../headers/results.hpp"
+#include "../../core/header/TerminalRenderer.hpp"
+#include "../../core/header/Exceptions.hpp"
+#include "../../core/header/RecordEmitter.hpp"
+#include "../../modules/headers/ResultStore.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct ResultsOptions {
+    std::string action = "list";
+    std::vector<std::string> positional;
+    RedTops::RunFilter filter;
+    std::string host;
+    int port = -1;
+    std::string last;          // diff --last <cmd>
+    size_t limit = 20;
+};
+
+int64_t NowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// "90s", "30m", "1h", "7d" back from now, or a local "YYYY-MM-DD[ HH:MM]"
+int64_t ParseWhen(const std::string& text) {
+    char* end = nullptr;
+    long n = std::strtol(text.c_str(), &end, 10);
+    if (end != text.c_str() && end[0] && !end[1] && n >= 0) {
+        int64_t unit = 0;
+        switch (*end) {
+            case 's': unit = 1; break;
+            case 'm': unit = 60; break;
+            case 'h': unit = 3600; break;
+            case 'd': unit = 86400; break;
+        }
+        if (unit) return NowUs() - n * unit * 1000000;
+    }
+    std::tm tm{};
+    int matched = std::sscanf(text.c_str(), "%d-%d-%d%*[ T]%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min);
+    if (matched != 3 && matched != 5) throw RedTops::CommandError("results: invalid time: " + text);
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    tm.tm_isdst = -1;
+    std::time_t t = std::mktime(&tm);
+    if (t == -1) throw RedTops::CommandError("results: invalid time: " + text);
+    return static_cast<int64_t>(t) * 1000000;
+}
+
+RedTops::ResultKind ParseKind(const std::string& name) {
+    RedTops::ResultKind kind;
+    if (!RedTops::ParseResultKind(name, kind))
+        throw RedTops::CommandError("results: unknown command '" + name + "' (portscan, ping, trace, probe)");
+    return kind;
+}
+
+ResultsOptions ParseOptions(const std::vector<std::string>& args) {
+    ResultsOptions o;
+    size_t i = 0;
+    if (!args.empty() && (args[0] == "list" || args[0] == "show" || args[0] == "query" || args[0] == "diff"))
+        o.action = args[i++];
+
+    auto value = [&](const std::string& flag) -> const std::string& {
+        if (i + 1 >= args.size()) throw RedTops::CommandError("results: " + flag + " needs a value");
+        return args[++i];
+    };
+    for (; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if (arg == "--cmd") {
+            o.filter.any_kind = false;
+            o.filter.kind = ParseKind(value(arg));
+        }
+        else if (arg == "--target") o.filter.target = value(arg);
+        else if (arg == "--since") o.filter.since_us = ParseWhen(value(arg));
+        else if (arg == "--until") o.filter.until_us = ParseWhen(value(arg));
+        else if (arg == "--host") o.host = value(arg);
+        else if (arg == "--port") {
+            long p = std::strtol(value(arg).c_str(), nullptr, 10);
+            if (p < 0 || p > 65535) throw RedTops::CommandError("results: invalid port: " + args[i]);
+            o.port = static_cast<int>(p);
+        }
+        else if (arg == "--last") o.last = value(arg);
+        else if (arg == "-n") {
+            long n = std::strtol(value(arg).c_str(), nullptr, 10);
+            if (n <= 0) throw RedTops::CommandError("results: invalid value for -n");
+            o.limit = static_cast<size_t>(n);
+        }
+        else if (!arg.empty() && arg[0] == '-') throw RedTops::CommandError("results: unknown option " + arg);
+        else o.positional.push_back(arg);
+    }
+    return o;
+}
+
+std::string FormatTime(int64_t us) {
+    std::time_t t = static_cast<std::time_t>(us / 1000000);
+    std::tm tm{};
+    localtime_r(&t, &tm);
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+    return buf;
+}
+
+// Port column: a hop number for traces, nothing for ICMP
+std::string FormatPort(RedTops::ResultKind kind, uint16_t port) {
+    if (kind == RedTops::ResultKind::Trace) return "hop " + std::to_string(port);
+    return port ? std::to_string(port) : "-";
+}
+
+std::string FormatValue(float value) {
+    if (value <= 0) return "-";
+    char buf[24];
+    std::snprintf(buf, sizeof(buf), "%.2f ms", value);
+    return buf;
+}
+
+const std::string& StatusColor(RedTops::ResultStatus status) {
+    switch (status) {
+        case RedTops::ResultStatus::Up: return Color::GREEN;
+        case RedTops::ResultStatus::Refused: return Color::AMBER;
+        default: return Color::RED;
+    }
+}
+
+uint64_t ParseId(const std::string& text) {
+    char* end = nullptr;
+    unsigned long long id = std::strtoull(text.c_str(), &end, 10);
+    if (text.empty() || *end || id == 0) throw RedTops::CommandError("results: invalid run id: " + text);
+    return id;
+}
+
+RedTops::RunInfo LoadRun(const RedTops::ResultStore& store, uint64_t id) {
+    RedTops::RunInfo run;
+    if (!store.Run(id, run)) throw RedTops::CommandError("results: no run " + std::to_string(id));
+    return run;
+}
+
+void EmitRun(RecordEmitter& out, const RedTops::RunInfo& run) {
+    out.Record("run").Field("id", run.id).Field("command", RedTops::ResultKindName(run.kind))
+        .Field("target", run.target).Field("started", FormatTime(run.started_us)).Field("started_us", run.started_us)
+        .Field("duration_ms", run.duration_ms).Field("rows", run.rows).Commit();
+}
+
+void EmitRow(RecordEmitter& out, const RedTops::RunInfo& run, const RedTops::ResultRow& row) {
+    out.Record("row").Field("run", run.id).Field("command", RedTops::ResultKindName(run.kind))
+        .Field("host", row.host).Field("port", row.port).Field("status", RedTops::ResultStatusName(row.status))
+        .Field("value_ms", static_cast<double>(row.value)).Commit();
+}
+
+// The store returns rows ordered by (host, port); a trace's port is its hop
+// number, so its rows go back into hop order
+void HopOrder(const RedTops::RunInfo& run, std::vector<RedTops::ResultRow>& rows) {
+    if (run.kind != RedTops::ResultKind::Trace) return;
+    std::stable_sort(rows.begin(), rows.end(),
+                     [](const RedTops::ResultRow& a, const RedTops::ResultRow& b) { return a.port < b.port; });
+}
+
+void PrintRunHeader(TerminalRenderer& term, const RedTops::RunInfo& run) {
+    term.PrintLine("\033[1;34m=== Run " + std::to_string(run.id) + " ===\033[0m  " + RedTops::ResultKindName(run.kind) +
+                   " " + run.target + Color::DIM + "  " + FormatTime(run.started_us) + ", " +
+                   std::to_string(run.duration_ms) + " ms, " + std::to_string(run.rows) + " row(s)" + Color::RESET);
+}
+
+void List(const RedTops::ResultStore& store, const ResultsOptions& o) {
+    std::vector<RedTops::RunInfo> runs = store.Runs(o.filter);
+    RecordEmitter& out = RecordEmitter::Instance();
+    if (out.Active()) {
+        for (const auto& run : runs) EmitRun(out, run);
+        return;
+    }
+
+    TerminalRenderer& term = TerminalRenderer::Instance();
+    if (runs.empty()) {
+        term.PrintLine("No recorded runs in " + store.Directory());
+        return;
+    }
+    // The newest runs, oldest first, like shell history
+    size_t first = runs.size() > o.limit ? runs.size() - o.limit : 0;
+    std::string text;
+    char line[512];
+    std::snprintf(line, sizeof(line), "%6s  %-19s  %-8s  %6s  %9s  %s\n", "ID", "STARTED", "COMMAND", "ROWS", "DURATION", "TARGET");
+    text += Color::CYAN + line + Color::RESET;
+    for (size_t i = first; i < runs.size(); ++i) {
+        const auto& run = runs[i];
+        std::snprintf(line, sizeof(line), "%6llu  %-19s  %-8s  %6u  %6u ms  %s\n", static_cast<unsigned long long>(run.id),
+                      FormatTime(run.started_us).c_str(), RedTops::ResultKindName(run.kind), run.rows, run.duration_ms,
+                      run.target.c_str());
+        text += line;
+    }
+    if (first) text += Color::DIM + std::to_string(first) + " older run(s) not shown (-n)" + Color::RESET + "\n";
+    text.pop_back();
+    term.PrintLine(text);
+}
+
+void Show(const RedTops::ResultStore& store, const ResultsOptions& o) {
+    if (o.positional.size() != 1) throw RedTops::CommandError("results: usage: results show <id>");
+    RedTops::RunInfo run = LoadRun(store, ParseId(o.positional[0]));
+    std::vector<RedTops::ResultRow> rows = store.Rows(run);
+    HopOrder(run, rows);
+
+    RecordEmitter& out = RecordEmitter::Instance();
+    if (out.Active()) {
+        for (const auto& row : rows) EmitRow(out, run, row);
+        return;
+    }
+    TerminalRenderer& term = TerminalRenderer::Instance();
+    PrintRunHeader(term, run);
+    std::string text;
+    char line[512];
+    for (const auto& row : rows) {
+        std::snprintf(line, sizeof(line), "  %-40s %-8s %s%-8s%s %10s\n", row.host.c_str(), FormatPort(run.kind, row.port).c_str(),
+                      StatusColor(row.status).c_str(), RedTops::ResultStatusName(row.status), Color::RESET.c_str(),
+                      FormatValue(row.value).c_str());
+        text += line;
+    }
+    if (!text.empty()) text.pop_back();
+    term.PrintLine(text.empty() ? "  (no rows)" : text);
+}
+
+void Query(const RedTops::ResultStore& store, const ResultsOptions& o) {
+    std::string host = o.host;
+    if (host.empty() && o.positional.size() == 1) host = o.positional[0];
+    if (host.empty()) throw RedTops::CommandError("results: usage: results query --host <h> [--port <p>]");
+
+    RecordEmitter& out = RecordEmitter::Instance();
+    TerminalRenderer& term = TerminalRenderer::Instance();
+    std::string text;
+    char line[512];
+    size_t hits = 0;
+    for (uint64_t id : store.RunsWithHost(host)) {
+        RedTops::RunInfo run;
+        if (!store.Run(id, run)) continue;
+        if (!o.filter.any_kind && run.kind != o.filter.kind) continue;
+        if (!o.filter.target.empty() && run.target != o.filter.target) continue;
+        if (o.filter.since_us && run.started_us < o.filter.since_us) continue;
+        if (o.filter.until_us && run.started_us >= o.filter.until_us) continue;
+        std::vector<RedTops::ResultRow> rows = store.Rows(run, host);
+        HopOrder(run, rows);
+        for (const auto& row : rows) {
+            if (o.port >= 0 && row.port != o.port) continue;
+            ++hits;
+            if (out.Active()) {
+                EmitRow(out, run, row);
+                continue;
+            }
+            std::snprintf(line, sizeof(line), "%6llu  %-19s  %-8s  %-8s  %s%-8s%s %10s\n", static_cast<unsigned long long>(run.id),
+                          FormatTime(run.started_us).c_str(), RedTops::ResultKindName(run.kind), FormatPort(run.kind, row.port).c_str(),
+                          StatusColor(row.status).c_str(), RedTops::ResultStatusName(row.status), Color::RESET.c_str(),
+                          FormatValue(row.value).c_str());
+            text += line;
+        }
+    }
+    if (out.Active()) return;
+    term.PrintLine("\033[1;34m=== History of " + host + " ===\033[0m");
+    if (!hits) {
+        term.PrintLine("  (no recorded results)");
+        return;
+    }
+    std::snprintf(line, sizeof(line), "%6s  %-19s  %-8s  %-8s  %-8s %10s\n", "RUN", "STARTED", "COMMAND", "PORT", "STATUS", "RTT");
+    text.insert(0, Color::CYAN + line + Color::RESET);
+    text.pop_back();
+    term.PrintLine(text);
+}
+
+void Diff(const RedTops::ResultStore& store, const ResultsOptions& o) {
+    RedTops::RunInfo older, newer;
+    if (!o.last.empty()) {
+        // The two most recent runs of the same command against the same target
+        RedTops::RunFilter filter = o.filter;
+        filter.any_kind = false;
+        filter.kind = ParseKind(o.last);
+        std::vector<RedTops::RunInfo> runs = store.Runs(filter);
+        if (!runs.empty() && filter.target.empty()) {
+            std::string target = o.positional.empty() ? runs.back().target : o.positional[0];
+            runs.erase(std::remove_if(runs.begin(), runs.end(), [&](const RedTops::RunInfo& r) { return r.target != target; }),
+                       runs.end());
+        }
+        if (runs.size() < 2) throw RedTops::CommandError("results: need two matching " + o.last + " runs to diff");
+        older = runs[runs.size() - 2];
+        newer = runs.back();
+    } else {
+        if (o.positional.size() != 2) throw RedTops::CommandError("results: usage: results diff <id1> <id2> | --last <cmd> [target]");
+        older = LoadRun(store, ParseId(o.positional[0]));
+        newer = LoadRun(store, ParseId(o.positional[1]));
+    }
+
+    RedTops::ResultDiff d = RedTops::ResultStore::Diff(store.Rows(older), store.Rows(newer));
+
+    RecordEmitter& out = RecordEmitter::Instance();
+    if (out.Active()) {
+        auto emit = [&](const char* change, const RedTops::ResultRow& row, const char* before, const char* after) {
+            out.Record("change").Field("older", older.id).Field("newer", newer.id).Field("change", change)
+                .Field("host", row.host).Field("port", row.port).Field("before", before).Field("after", after).Commit();
+        };
+        for (const auto& row : d.added) emit("added", row, "", RedTops::ResultStatusName(row.status));
+        for (const auto& row : d.removed) emit("removed", row, RedTops::ResultStatusName(row.status), "");
+        for (const auto& [was, now] : d.changed)
+            emit("changed", now, RedTops::ResultStatusName(was.status), RedTops::ResultStatusName(now.status));
+        return;
+    }
+
+    TerminalRenderer& term = TerminalRenderer::Instance();
+    term.PrintLine("\033[1;34m=== Run " + std::to_string(older.id) + " -> " + std::to_string(newer.id) + " ===\033[0m  " +
+                   RedTops::ResultKindName(newer.kind) + " " + newer.target + Color::DIM + "  " +
+                   FormatTime(older.started_us) + " -> " + FormatTime(newer.started_us) + Color::RESET);
+    if (d.added.empty() && d.removed.empty() && d.changed.empty()) {
+        term.PrintLine("  no changes");
+        return;
+    }
+    std::string text;
+    auto where = [&](const RedTops::ResultRow& row) {
+        std::string port = FormatPort(newer.kind, row.port);
+        return port == "-" ? row.host : row.host + " " + port;
+    };
+    for (const auto& row : d.added)
+        text += Color::GREEN + "  + " + where(row) + "  " + RedTops::ResultStatusName(row.status) + Color::RESET + "\n";
+    for (const auto& row : d.removed)
+        text += Color::RED + "  - " + where(row) + "  " + RedTops::ResultStatusName(row.status) + Color::RESET + "\n";
+    for (const auto& [was, now] : d.changed)
+        text += Color::AMBER + "  ~ " + where(now) + "  " + RedTops::ResultStatusName(was.status) + " -> " +
+                RedTops::ResultStatusName(now.status) + Color::RESET + "\n";
+    text += Color::DIM + std::to_string(d.added.size()) + " added, " + std::to_string(d.removed.size()) + " removed, " +
+            std::to_string(d.changed.size()) + " changed" + Color::RESET;
+    term.PrintLine(text);
+}
+
+} // namespace
+
+void ResultsCommand::Execute(const std::vector<std::string>& args) {
+    ResultsOptions opts = ParseOptions(args);
+    RedTops::ResultStore store;
+    if (opts.action == "show") Show(store, opts);
+    else if (opts.action == "query") Query(store, opts);
+    else if (opts.action == "diff") Diff(store, opts);
+    else List(store, opts);
+}
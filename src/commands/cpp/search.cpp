@@ -0,0 +1,221 @@
+#include "../headers/search.hpp"
+#include "../../core/header/TerminalRenderer.hpp"
+#include "../../core/header/Exceptions.hpp"
+#include "../../core/header/RecordEmitter.hpp"
+#include "../../core/header/Shell.hpp"
+#include "../../modules/headers/FileSearcher.hpp"
+#include "../../modules/headers/TextSearch.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t kMaxShownLine = 300;       // longer lines are cut around the match
+constexpr size_t kFlushBytes = 64 * 1024;
+
+struct SearchOptions {
+    std::vector<std::string> patterns;
+    std::vector<std::string> paths;
+    bool fixed = false;
+    bool ignore_case = false;
+    bool files_only = false;    // -l
+    bool count = false;         // -c
+    bool list = false;          // --name without a pattern
+    RedTops::FileSearcher::Options searcher;
+};
+
+unsigned ParseCount(const std::vector<std::string>& args, size_t& i, const char* flag, unsigned max) {
+    if (i + 1 >= args.size()) throw RedTops::CommandError(std::string("search: ") + flag + " needs a value");
+    long n = std::strtol(args[++i].c_str(), nullptr, 10);
+    if (n < 1 || static_cast<unsigned long>(n) > max) throw RedTops::CommandError(std::string("search: invalid value for ") + flag + ": " + args[i]);
+    return static_cast<unsigned>(n);
+}
+
+SearchOptions ParseArgs(const std::vector<std::string>& args) {
+    const std::string usage = "search: usage: search [-i] [-F] [-l|-c] [-m <n>] [-e <pattern>]... [--include <glob>] "
+                              "[--exclude <glob>] [--no-ignore] [-j <threads>] <pattern> [path...] | search --name <glob> [path...]";
+    SearchOptions o;
+    std::vector<std::string> positional;
+    bool options_done = false;
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& a = args[i];
+        auto value = [&](const char* flag) -> const std::string& {
+            if (i + 1 >= args.size()) throw RedTops::CommandError(std::string("search: ") + flag + " needs a value");
+            return args[++i];
+        };
+        if (options_done || a.empty() || a[0] != '-' || a == "-") positional.push_back(a);
+        else if (a == "--") options_done = true;
+        else if (a == "-e") o.patterns.push_back(value("-e"));
+        else if (a == "-F") o.fixed = true;
+        else if (a == "-E") o.fixed = false;
+        else if (a == "-i") o.ignore_case = true;
+        else if (a == "-l") o.files_only = true;
+        else if (a == "-c") o.count = true;
+        else if (a == "-m") o.searcher.max_per_file = ParseCount(args, i, "-m", 1000000000u);
+        else if (a == "-j") o.searcher.threads = ParseCount(args, i, "-j", 256);
+        else if (a == "--include") o.searcher.includes.push_back(value("--include"));
+        else if (a == "--exclude") o.searcher.excludes.push_back(value("--exclude"));
+        else if (a == "--name") {
+            o.searcher.includes.push_back(value("--name"));
+            o.list = true;
+        }
+        else if (a == "--no-ignore") o.searcher.use_ignore_files = false;
+        else throw RedTops::CommandError("search: unknown option " + a + "\n" + usage);
+    }
+
+    // --name alone lists files; to filter a content search by name use --include
+    if (o.patterns.empty() && !o.list) {
+        if (positional.empty()) throw RedTops::CommandError(usage);
+        o.patterns.push_back(positional.front());
+        positional.erase(positional.begin());
+    }
+    if (!o.patterns.empty()) o.list = false;
+    o.paths = positional.empty() ? std::vector<std::string>{"."} : positional;
+    if (o.files_only) {
+        o.searcher.max_per_file = 1;
+        o.searcher.collect_lines = false;
+    }
+    if (o.count) o.searcher.collect_lines = false;
+    return o;
+}
+
+// The visible part of a long line: a window starting a little before the match
+std::string_view ShownText(const RedTops::LineMatch& m, size_t& match_at, bool& cut_front, bool& cut_back) {
+    match_at = m.column - 1;
+    cut_front = cut_back = false;
+    std::string_view text = m.text;
+    if (text.size() <= kMaxShownLine) return text;
+    size_t begin = match_at > kMaxShownLine / 3 ? match_at - kMaxShownLine / 3 : 0;
+    cut_front = begin > 0;
+    cut_back = begin + kMaxShownLine < text.size();
+    match_at -= begin;
+    return text.substr(begin, kMaxShownLine);
+}
+
+void AppendLine(std::string& out, const std::string& path, const RedTops::LineMatch& m, bool color) {
+    size_t match_at;
+    bool cut_front, cut_back;
+    std::string_view text = ShownText(m, match_at, cut_front, cut_back);
+    size_t match_len = std::min(m.match_length, text.size() - match_at);
+
+    if (color) out += Color::CYAN;
+    out += path;
+    if (color) out += Color::RESET + Color::DIM;
+    out += ':';
+    out += std::to_string(m.line);
+    out += ':';
+    if (color) out += Color::RESET;
+    if (cut_front) out += "...";
+    if (color && match_len) {
+        out.append(text.data(), match_at);
+        out += Color::RED;
+        out.append(text.data() + match_at, match_len);
+        out += Color::RESET;
+        out.append(text.data() + match_at + match_len, text.size() - match_at - match_len);
+    } else {
+        out.append(text.data(), text.size());
+    }
+    if (cut_back) out += "...";
+    out += '\n';
+}
+
+} // namespace
+
+void SearchCommand::Execute(const std::vector<std::string>& args) {
+    SearchOptions o = ParseArgs(args);
+    std::unique_ptr<RedTops::TextMatcher> matcher;
+    if (!o.list) matcher = std::make_unique<RedTops::TextMatcher>(o.patterns, o.fixed, o.ignore_case);
+
+    const bool structured = RecordEmitter::Instance().Active();
+    const bool color = !structured && isatty(STDOUT_FILENO);
+    std::mutex out_mutex;
+    std::string pending;        // text output waiting for the next flush
+    auto flush = [&] {
+        std::lock_guard<std::mutex> lock(out_mutex);
+        if (pending.empty()) return;
+        std::cout.write(pending.data(), static_cast<std::streamsize>(pending.size()));
+        std::cout.flush();
+        pending.clear();
+    };
+
+    auto on_file = [&](const std::string& path, uint64_t matches, const std::vector<RedTops::LineMatch>& lines, bool binary) {
+        if (structured) {
+            std::lock_guard<std::mutex> lock(out_mutex);
+            auto& out = RecordEmitter::Instance();
+            if (o.list || o.files_only || o.count || binary) {
+                out.Record("file").Field("path", path);
+                if (!o.list) out.Field("matches", matches).Field("binary", binary);
+                out.Commit();
+                return;
+            }
+            for (const auto& m : lines)
+                out.Record("match").Field("path", path).Field("line", m.line).Field("column", static_cast<uint64_t>(m.column))
+                    .Field("text", m.text).Commit();
+            return;
+        }
+
+        // Format outside the lock; only the append is serialized
+        thread_local std::string text;
+        text.clear();
+        if (o.list || o.files_only) {
+            text += path;
+            text += '\n';
+        } else if (binary) {
+            text += path + ": binary file matches\n";
+        } else if (o.count) {
+            text += path + ":" + std::to_string(matches) + "\n";
+        } else {
+            for (const auto& m : lines) AppendLine(text, path, m, color);
+        }
+        bool full;
+        {
+            std::lock_guard<std::mutex> lock(out_mutex);
+            pending += text;
+            full = pending.size() >= kFlushBytes;
+        }
+        if (full) flush();
+    };
+
+    InterruptScope interrupt_scope;
+    RedTops::FileSearcher searcher(matcher.get(), o.searcher);
+    auto start = std::chrono::steady_clock::now();
+    bool complete = true;
+    for (const auto& path : o.paths) {
+        // Matches stream out on every tick, so a long search shows results as it goes
+        complete = searcher.Search(path, on_file, [] { return Shell::Instance().InterruptRequested(); }, flush);
+        flush();
+        if (!complete) break;
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    RedTops::SearchStats st = searcher.Stats();
+    if (structured) {
+        RecordEmitter::Instance().Record("search").Field("files", st.files).Field("bytes", st.bytes)
+            .Field("matched_files", st.matched_files).Field("matched_lines", st.matched_lines)
+            .Field("errors", st.errors).Field("seconds", secs).Field("complete", complete).Commit();
+    } else if (color) {
+        char line[200];
+        if (o.list) {
+            std::snprintf(line, sizeof(line), "%llu files in %.2f s (%u threads)",
+                          static_cast<unsigned long long>(st.files), secs, searcher.Threads());
+        } else {
+            std::snprintf(line, sizeof(line), "%llu matching lines in %llu of %llu files, %.1f MiB in %.2f s (%.2f GB/s, %u threads)",
+                          static_cast<unsigned long long>(st.matched_lines), static_cast<unsigned long long>(st.matched_files),
+                          static_cast<unsigned long long>(st.files), st.bytes / 1048576.0, secs,
+                          secs > 0 ? st.bytes / secs / 1e9 : 0.0, searcher.Threads());
+        }
+        TerminalRenderer::Instance().PrintLine(line, Color::DIM);
+    }
+
+    for (const auto& message : searcher.Errors()) TerminalRenderer::Instance().PrintWarning("search: " + message);
+    if (!complete) throw RedTops::CommandError("search: interrupted");
+}
@@ -2,78 +2,695 @@
 #include "../../core/header/TerminalRenderer.hpp"
 #include "../../core/header/Exceptions.hpp"
 #include "../../core/header/Shell.hpp" // Include Shell.hpp for handle management
+#include "../../core/header/RecordEmitter.hpp"
+#include "../../modules/headers/CaptureIndex.hpp"
+#include "../../modules/headers/FanoutCapture.hpp"
+#include "../../modules/headers/MultiCapture.hpp"
+#include "../../modules/headers/PacketDissector.hpp"
+#include "../../modules/headers/PcapFile.hpp"
+#include "../../modules/headers/TcpFlowTracker.hpp"
 #include <pcap.h>
 #include <arpa/inet.h>
-#include <net/ethernet.h>
-#include <netinet/ip.h>
-#include <netinet/tcp.h>
-#include <netinet/udp.h>
+#include <unistd.h>
 #include <iomanip>
 #include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <ctime>
 
-// Callback function for libpcap
-void packet_handler(u_char *user_data, const struct pcap_pkthdr *pkthdr, const u_char *packet) {
-    TerminalRenderer& renderer = TerminalRenderer::Instance();
+SniffCommand::SniffCommand() {}
 
-    // Ethernet header
-    struct ethhdr *eth_header = (struct ethhdr *) packet;
-    
-    std::stringstream ss;
-    ss << "----------------------------------------------------" << std::endl;
-    ss << "Packet captured! Length: " << pkthdr->len << std::endl;
-    ss << "Source MAC: " << std::hex << std::setfill('0');
-    for (int i = 0; i < ETH_ALEN; ++i) ss << std::setw(2) << (int)eth_header->h_source[i] << (i == ETH_ALEN - 1 ? "" : ":");
-    ss << std::endl;
-    ss << "Dest MAC:   " << std::hex << std::setfill('0');
-    for (int i = 0; i < ETH_ALEN; ++i) ss << std::setw(2) << (int)eth_header->h_dest[i] << (i == ETH_ALEN - 1 ? "" : ":");
-    ss << std::endl;
-    
-    // IP header
-    if (ntohs(eth_header->h_proto) == ETHERTYPE_IP) {
-        struct iphdr *ip_header = (struct iphdr *)(packet + ETH_HLEN);
-        ss << "Source IP: " << inet_ntoa(*(in_addr *)&ip_header->saddr) << std::endl;
-        ss << "Dest IP:   " << inet_ntoa(*(in_addr *)&ip_header->daddr) << std::endl;
-        ss << "Protocol:  " << (unsigned int)ip_header->protocol << std::endl;
-
-        unsigned int ip_header_len = ip_header->ihl * 4;
-        
-        // TCP header
-        if (ip_header->protocol == IPPROTO_TCP) {
-            struct tcphdr *tcp_header = (struct tcphdr *)(packet + ETH_HLEN + ip_header_len);
-            ss << "Source Port: " << ntohs(tcp_header->source) << std::endl;
-            ss << "Dest Port:   " << ntohs(tcp_header->dest) << std::endl;
-        }
-        // UDP header
-        else if (ip_header->protocol == IPPROTO_UDP) {
-            struct udphdr *udp_header = (struct udphdr *)(packet + ETH_HLEN + ip_header_len);
-            ss << "Source Port: " << ntohs(udp_header->source) << std::endl;
-            ss << "Dest Port:   " << ntohs(udp_header->dest) << std::endl;
-        }
-    }
-    ss << "----------------------------------------------------";
-
-    renderer.PrintLine(ss.str(), Color::CYAN);
+namespace {
+
+struct SniffOptions {
+    std::string interface;
+    std::vector<std::string> interfaces;  // "eth0,eth1" split; merged by timestamp when more than one
+    int count = 0;                 // 0 means sniff indefinitely
+    unsigned fanout_workers = 0;   // 0 = single libpcap handle
+    RedTops::FanoutMode fanout_mode = RedTops::FanoutMode::Hash;
+    bool pin_workers = false;
+    bool brief = false;            // one summary line per packet
+    bool track_tcp = false;        // handshake latency / retransmission report
+    std::string stream_dir;        // reassemble TCP payloads into this directory
+    size_t max_flows = 100000;
+    size_t flow_mem_mb = 64;
+    std::string write_path;        // -w: save packets to a pcap file (and its .rtidx index)
+    std::string read_path;         // -r: read a saved capture instead of an interface
+    std::string since, until;      // -r time window
+    std::string flow;              // -r conversation filter, addr:port-addr:port
+    bool build_index = false;      // -r --index: (re)build the sidecar index only
+};
+
+const char* kSniffUsage =
+    "sniff: usage: sniff <interface>[,<interface>...] [count] [-b] [-w <file>]\n"
+    "              sniff <interface> [count] -F <workers> [--mode hash|cpu|rr] [--pin] [-b]\n"
+    "              sniff -r <file> [count] [--since <time>] [--until <time>] [--flow <a:p-b:p>] [--index]\n"
+    "       each with [--tcp] [--streams <dir>] [--max-flows <n>] [--flow-mem <MB>]";
+
+size_t ParseSize(const std::string& flag, const std::string& value) {
+    try {
+        long long n = std::stoll(value);
+        if (n <= 0) throw std::out_of_range(flag);
+        return static_cast<size_t>(n);
+    } catch (const std::exception&) {
+        throw RedTops::CommandError("sniff: invalid value for " + flag + ": " + value);
+    }
 }
 
-SniffCommand::SniffCommand() {}
+SniffOptions ParseSniffOptions(const std::vector<std::string>& args) {
+    SniffOptions opts;
+    std::vector<std::string> positional;
 
-void SniffCommand::Execute(const std::vector<std::string>& args) {
-    if (args.empty()) {
-        throw RedTops::CommandError("sniff: usage: sniff <interface> [count]");
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if ((arg == "-F" || arg == "--fanout") && i + 1 < args.size()) {
+            try {
+                int n = std::stoi(args[++i]);
+                if (n < 1 || n > 1024) throw std::out_of_range("workers");
+                opts.fanout_workers = static_cast<unsigned>(n);
+            } catch (const std::exception&) {
+                throw RedTops::CommandError("sniff: invalid worker count: " + args[i]);
+            }
+        } else if (arg == "--mode" && i + 1 < args.size()) {
+            opts.fanout_mode = RedTops::ParseFanoutMode(args[++i]);
+        } else if (arg == "--pin") {
+            opts.pin_workers = true;
+        } else if (arg == "-b" || arg == "--brief") {
+            opts.brief = true;
+        } else if (arg == "-w" && i + 1 < args.size()) {
+            opts.write_path = args[++i];
+        } else if (arg == "-r" && i + 1 < args.size()) {
+            opts.read_path = args[++i];
+        } else if (arg == "--since" && i + 1 < args.size()) {
+            opts.since = args[++i];
+        } else if (arg == "--until" && i + 1 < args.size()) {
+            opts.until = args[++i];
+        } else if (arg == "--flow" && i + 1 < args.size()) {
+            opts.flow = args[++i];
+        } else if (arg == "--index") {
+            opts.build_index = true;
+        } else if (arg == "--tcp") {
+            opts.track_tcp = true;
+        } else if (arg == "--streams" && i + 1 < args.size()) {
+            opts.track_tcp = true;
+            opts.stream_dir = args[++i];
+        } else if (arg == "--max-flows" && i + 1 < args.size()) {
+            opts.max_flows = ParseSize(arg, args[++i]);
+        } else if (arg == "--flow-mem" && i + 1 < args.size()) {
+            opts.flow_mem_mb = ParseSize(arg, args[++i]);
+        } else if (!arg.empty() && arg[0] == '-') {
+            throw RedTops::CommandError(std::string("sniff: unknown option: ") + arg + "\n" + kSniffUsage);
+        } else {
+            positional.push_back(arg);
+        }
     }
 
-    std::string interface = args[0];
-    int count = 0; // 0 means sniff indefinitely
-    if (args.size() > 1) {
+    if (!opts.read_path.empty()) {
+        // Reading a file: the only positional is the packet count
+        if (positional.size() > 1 || opts.fanout_workers > 0) throw RedTops::CommandError(kSniffUsage);
+        positional.insert(positional.begin(), std::string());
+    } else if (!opts.since.empty() || !opts.until.empty() || !opts.flow.empty() || opts.build_index) {
+        throw RedTops::CommandError("sniff: --since, --until, --flow and --index need -r <file>");
+    }
+
+    if (positional.empty() || positional.size() > 2) {
+        throw RedTops::CommandError(kSniffUsage);
+    }
+    opts.interface = positional[0];
+    std::stringstream list(opts.interface);
+    for (std::string name; std::getline(list, name, ',');) {
+        if (name.empty()) continue;
+        if (std::find(opts.interfaces.begin(), opts.interfaces.end(), name) == opts.interfaces.end())
+            opts.interfaces.push_back(name);
+    }
+    if (opts.interfaces.empty() && opts.read_path.empty()) throw RedTops::CommandError(kSniffUsage);
+    if (opts.interfaces.size() > 1 && opts.fanout_workers > 0)
+        throw RedTops::CommandError("sniff: -F captures a single interface");
+    if (!opts.write_path.empty() && opts.write_path == opts.read_path)
+        throw RedTops::CommandError("sniff: -w must not overwrite the file given to -r");
+    if (!opts.write_path.empty() && opts.fanout_workers > 0)
+        throw RedTops::CommandError("sniff: -w is not supported with -F (workers see packets out of order)");
+    if (positional.size() > 1) {
         try {
-            count = std::stoi(args[1]);
+            opts.count = std::stoi(positional[1]);
         } catch (const std::invalid_argument& e) {
-            throw RedTops::CommandError("sniff: invalid count: " + args[1]);
+            throw RedTops::CommandError("sniff: invalid count: " + positional[1]);
         } catch (const std::out_of_range& e) {
-            throw RedTops::CommandError("sniff: count out of range: " + args[1]);
+            throw RedTops::CommandError("sniff: count out of range: " + positional[1]);
+        }
+    }
+    return opts;
+}
+
+RedTops::TcpTrackerOptions MakeTrackerOptions(const SniffOptions& opts) {
+    RedTops::TcpTrackerOptions to;
+    to.max_flows = opts.max_flows;
+    to.total_buffer = opts.flow_mem_mb * 1024 * 1024;
+    if (!opts.stream_dir.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(opts.stream_dir, ec);
+        if (ec) throw RedTops::CommandError("sniff: cannot create stream directory " + opts.stream_dir + ": " + ec.message());
+        to.reassemble = true;
+        to.stream_dir = opts.stream_dir;
+    }
+    return to;
+}
+
+std::string FormatMs(uint64_t us) {
+    if (us == 0) return "-";
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(us < 10000 ? 2 : 1) << us / 1000.0;
+    return ss.str();
+}
+
+void PrintHandshake(const RedTops::TcpFlow& flow) {
+    std::ostringstream ss;
+    ss << "[handshake] " << flow.Endpoint(flow.client) << " -> " << flow.Endpoint(1 - flow.client)
+       << "  syn>syn/ack " << FormatMs(flow.ServerRttUs()) << " ms"
+       << "  syn/ack>ack " << FormatMs(flow.ClientRttUs()) << " ms";
+    if (flow.syn_retransmits) ss << "  (" << flow.syn_retransmits << " SYN retransmits)";
+    TerminalRenderer::Instance().PrintLine(ss.str(), Color::CYAN);
+}
+
+// Final per-connection table: slowest handshakes first
+void PrintTcpReport(std::vector<const RedTops::TcpFlow*> flows, const RedTops::TcpTrackerStats& st) {
+    TerminalRenderer& renderer = TerminalRenderer::Instance();
+    constexpr size_t kMaxRows = 25;
+
+    std::sort(flows.begin(), flows.end(), [](const RedTops::TcpFlow* a, const RedTops::TcpFlow* b) {
+        uint64_t ha = a->ServerRttUs() + a->ClientRttUs(), hb = b->ServerRttUs() + b->ClientRttUs();
+        if (ha != hb) return ha > hb;
+        return a->dir[0].bytes + a->dir[1].bytes > b->dir[0].bytes + b->dir[1].bytes;
+    });
+
+    renderer.PrintLine("\n\033[1;34m=== TCP Connections ===\033[0m");
+    std::ostringstream hdr;
+    hdr << std::left << std::setw(46) << "CLIENT -> SERVER" << std::setw(12) << "STATE" << std::right
+        << std::setw(10) << "SYN>SA ms" << std::setw(10) << "SA>ACK ms"
+        << std::setw(9) << "RETX c2s" << std::setw(9) << "RETX s2c"
+        << std::setw(12) << "BYTES c2s" << std::setw(12) << "BYTES s2c";
+    renderer.PrintLine(hdr.str(), Color::CYAN);
+
+    for (size_t i = 0; i < flows.size() && i < kMaxRows; ++i) {
+        const RedTops::TcpFlow& f = *flows[i];
+        uint8_t c = f.client, srv = 1 - f.client;
+        std::ostringstream row;
+        row << std::left << std::setw(46) << (f.Endpoint(c) + " -> " + f.Endpoint(srv))
+            << std::setw(12) << RedTops::TcpFlowStateName(f.state) << std::right
+            << std::setw(10) << FormatMs(f.ServerRttUs()) << std::setw(10) << FormatMs(f.ClientRttUs())
+            << std::setw(9) << f.dir[c].retransmits << std::setw(9) << f.dir[srv].retransmits
+            << std::setw(12) << f.dir[c].bytes << std::setw(12) << f.dir[srv].bytes;
+        renderer.PrintLine(row.str());
+    }
+    if (flows.size() > kMaxRows)
+        renderer.PrintLine("  ... " + std::to_string(flows.size() - kMaxRows) + " more flows", Color::DIM);
+
+    std::ostringstream sum;
+    sum << "TCP packets " << st.packets << ", flows " << st.flows_created << " (" << st.flows_evicted
+        << " evicted), handshakes " << st.handshakes << ", retransmits " << st.retransmits;
+    if (st.bytes_reassembled || st.reassembly_gaps)
+        sum << ", reassembled " << st.bytes_reassembled << " bytes (" << st.reassembly_gaps << " gaps)";
+    renderer.PrintLine(sum.str(), Color::AMBER);
+}
+
+// "HH:MM:SS.uuuuuu " in local time
+size_t FormatTimestamp(uint64_t ts_ns, char* buf, size_t cap) {
+    time_t secs = static_cast<time_t>(ts_ns / 1000000000ull);
+    tm local{};
+    localtime_r(&secs, &local);
+    int n = std::snprintf(buf, cap, "%02d:%02d:%02d.%06u ", local.tm_hour, local.tm_min, local.tm_sec,
+                          static_cast<unsigned>(ts_ns % 1000000000ull / 1000));
+    return n < 0 ? 0 : std::min(static_cast<size_t>(n), cap - 1);
+}
+
+// Where each packet ends up: printed, fed to the TCP tracker, and/or saved
+// with -w together with its sidecar index. Shared by every capture path.
+class FrameOutput {
+public:
+    FrameOutput(const SniffOptions& opts, bool timestamps, uint32_t snaplen = 65535)
+        : opts_(opts), timestamps_(timestamps) {
+        if (!opts.write_path.empty()) {
+            try {
+                writer_ = std::make_unique<RedTops::PcapWriter>(opts.write_path, snaplen);
+            } catch (const RedTops::CommandError& e) {
+                throw RedTops::CommandError(std::string("sniff: ") + e.what());
+            }
+        }
+        if (opts.track_tcp) {
+            tracker_ = std::make_unique<RedTops::TcpFlowTracker>(MakeTrackerOptions(opts));
+            tracker_->OnHandshake(PrintHandshake);
+        }
+    }
+
+    // Interface names are padded to this width in merged output
+    void SetLabelWidth(size_t width) { label_width_ = width; }
+
+    void Emit(uint64_t ts_ns, const uint8_t* data, uint32_t caplen, uint32_t len, const std::string* label = nullptr) {
+        frames_++;
+        uint64_t offset = writer_ ? writer_->Offset() : 0;
+        if (writer_) writer_->Write(ts_ns, data, caplen, len);
+
+        bool decoded = RedTops::Dissect(data, caplen, len, pkt_);
+        if (writer_) index_.Add(offset, ts_ns, decoded ? RedTops::PacketFlowHash(pkt_) : 0);
+        if (!decoded) return;
+        if (tracker_) {
+            tracker_->Process(pkt_, data, ts_ns / 1000);
+            return;
+        }
+        if (writer_) return;
+        if (records_.Active()) {
+            EmitRecord(ts_ns, label);
+            return;
+        }
+
+        size_t n = timestamps_ ? FormatTimestamp(ts_ns, line_, sizeof(line_)) : 0;
+        if (label) {
+            int w = std::snprintf(line_ + n, sizeof(line_) - n, "%-*s ", static_cast<int>(label_width_), label->c_str());
+            n += std::min(static_cast<size_t>(std::max(w, 0)), sizeof(line_) - n - 1);
+        }
+        n += opts_.brief ? RedTops::FormatSummary(pkt_, line_ + n, sizeof(line_) - n)
+                         : RedTops::FormatDetail(pkt_, line_ + n, sizeof(line_) - n);
+        std::cout << Color::CYAN;
+        std::cout.write(line_, static_cast<std::streamsize>(n));
+        std::cout << Color::RESET << '\n' << std::flush;
+    }
+
+    // Closes the -w file, writes its index and prints the TCP report
+    void Finish() {
+        TerminalRenderer& renderer = TerminalRenderer::Instance();
+        if (writer_) {
+            try {
+                writer_->Close();
+                index_.WriteFor(opts_.write_path);
+            } catch (const RedTops::CommandError& e) {
+                writer_.reset();
+                throw RedTops::CommandError(std::string("sniff: ") + e.what());
+            }
+            renderer.PrintLine("Wrote " + std::to_string(writer_->Packets()) + " packets to " + opts_.write_path +
+                               " (index: " + RedTops::CaptureIndex::PathFor(opts_.write_path) + ")", Color::AMBER);
+            writer_.reset();
+        }
+        if (tracker_) {
+            tracker_->Flush();
+            PrintTcpReport(tracker_->Flows(), tracker_->Stats());
+        }
+    }
+
+    uint64_t Frames() const { return frames_; }
+    bool Writing() const { return writer_ != nullptr; }
+
+private:
+    static constexpr uint64_t kRecordFlushNs = 200000000;   // live records reach the pipe within 200 ms
+
+    void EmitRecord(uint64_t ts_ns, const std::string* label) {
+        char src[INET6_ADDRSTRLEN + 24], dst[INET6_ADDRSTRLEN + 24];
+        const bool ip = pkt_.l3 == RedTops::L3Proto::IPv4 || pkt_.l3 == RedTops::L3Proto::IPv6;
+        if (ip) {
+            int family = pkt_.l3 == RedTops::L3Proto::IPv4 ? AF_INET : AF_INET6;
+            inet_ntop(family, pkt_.src_addr, src, sizeof(src));
+            inet_ntop(family, pkt_.dst_addr, dst, sizeof(dst));
+        } else {
+            RedTops::FormatAddress(pkt_, true, src, sizeof(src));
+            RedTops::FormatAddress(pkt_, false, dst, sizeof(dst));
+        }
+        const char* l3 = pkt_.l3 == RedTops::L3Proto::IPv4 ? "ipv4" : pkt_.l3 == RedTops::L3Proto::IPv6 ? "ipv6"
+                       : pkt_.l3 == RedTops::L3Proto::ARP ? "arp" : "eth";
+
+        records_.Record("packet").Field("ts", static_cast<double>(ts_ns) / 1e9);
+        if (label) records_.Field("iface", *label);
+        records_.Field("len", pkt_.wirelen).Field("caplen", pkt_.caplen).Field("l3", l3)
+            .Field("src", src).Field("dst", dst)
+            .Field("proto", ip ? RedTops::ProtocolName(pkt_.l4_proto) : "")
+            .Field("sport", pkt_.src_port).Field("dport", pkt_.dst_port)
+            .Field("tcp_flags", pkt_.tcp_flags).Field("ttl", pkt_.ttl)
+            .Field("payload", pkt_.payload_length).Commit();
+
+        if (ts_ns - last_flush_ns_ >= kRecordFlushNs) {
+            records_.Flush();
+            last_flush_ns_ = ts_ns;
+        }
+    }
+
+    RecordEmitter& records_ = RecordEmitter::Instance();
+    uint64_t last_flush_ns_ = 0;
+    const SniffOptions& opts_;
+    bool timestamps_;
+    size_t label_width_ = 0;
+    std::unique_ptr<RedTops::PcapWriter> writer_;
+    RedTops::CaptureIndexBuilder index_;
+    std::unique_ptr<RedTops::TcpFlowTracker> tracker_;
+    RedTops::DissectedPacket pkt_;
+    uint64_t frames_ = 0;
+    char line_[2048];
+};
+
+// Multi-threaded capture: one AF_PACKET socket + worker per core in a fanout group
+void RunFanoutCapture(const SniffOptions& opts) {
+    TerminalRenderer& renderer = TerminalRenderer::Instance();
+
+    RedTops::FanoutOptions fo;
+    fo.interface = opts.interface;
+    fo.workers = opts.fanout_workers;
+    fo.mode = opts.fanout_mode;
+    fo.pin_workers = opts.pin_workers;
+    fo.max_packets = opts.count > 0 ? static_cast<uint64_t>(opts.count) : 0;
+
+    // Hash fanout keeps both directions of a flow on one worker, so each
+    // worker can own an independent tracker without locking
+    std::vector<std::unique_ptr<RedTops::TcpFlowTracker>> trackers;
+    std::mutex print_mutex;
+    if (opts.track_tcp) {
+        if (opts.fanout_mode != RedTops::FanoutMode::Hash)
+            throw RedTops::CommandError("sniff: --tcp with -F requires --mode hash");
+        unsigned n = opts.fanout_workers;
+        RedTops::TcpTrackerOptions to = MakeTrackerOptions(opts);
+        to.max_flows = std::max<size_t>(1, to.max_flows / n);
+        to.total_buffer /= n;
+        for (unsigned i = 0; i < n; ++i) {
+            trackers.push_back(std::make_unique<RedTops::TcpFlowTracker>(to));
+            trackers.back()->OnHandshake([&print_mutex](const RedTops::TcpFlow& flow) {
+                std::lock_guard<std::mutex> lock(print_mutex);
+                std::cout << "\r\x1b[2K";
+                PrintHandshake(flow);
+            });
+        }
+        fo.on_packet = [&trackers](unsigned worker, const RedTops::DissectedPacket& pkt,
+                                   const uint8_t* frame, uint64_t ts_us) {
+            trackers[worker]->Process(pkt, frame, ts_us);
+        };
+    }
+
+    // Without --tcp each packet is printed, or written as a record, as on the
+    // single-socket path; the workers take turns on the one output stream
+    std::unique_ptr<FrameOutput> output;
+    if (!opts.track_tcp) {
+        output = std::make_unique<FrameOutput>(opts, true);
+        fo.on_packet = [&output, &print_mutex](unsigned, const RedTops::DissectedPacket& pkt,
+                                               const uint8_t* frame, uint64_t ts_us) {
+            std::lock_guard<std::mutex> lock(print_mutex);
+            output->Emit(ts_us * 1000, frame, pkt.caplen, pkt.wirelen);
+        };
+    }
+
+    RedTops::FanoutCapture capture(fo);
+    capture.Open();
+
+    renderer.PrintLine("Starting fanout capture on " + opts.interface + " with " +
+                       std::to_string(capture.Options().workers) + " workers (mode: " +
+                       RedTops::FanoutModeName(opts.fanout_mode) + (opts.pin_workers ? ", pinned" : "") + ")");
+    renderer.PrintLine(opts.count == 0 ? "Capturing until Ctrl+C." :
+                       "Capturing " + std::to_string(opts.count) + " packets.");
+
+    // The packet counter only has the line to itself while --tcp keeps packets off it
+    const bool progress = !output && !RecordEmitter::Instance().Active() && isatty(STDOUT_FILENO);
+    auto start = std::chrono::steady_clock::now();
+    uint64_t last = 0;
+    capture.Run(
+        [] { return Shell::Instance().InterruptRequested(); },
+        [&](uint64_t seen) {
+            if (!progress) return;
+            std::lock_guard<std::mutex> lock(print_mutex);
+            std::cout << "\r\x1b[2K" << Color::DIM << "  " << seen << " packets ("
+                      << (seen - last) << " pps)" << Color::RESET << std::flush;
+            last = seen;
+        });
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (progress) std::cout << "\r\x1b[2K";
+
+    // Merge per-worker statistics into one table
+    auto row = [](const std::string& label, const RedTops::FanoutWorkerStats& st) {
+        std::ostringstream ss;
+        ss << std::left << std::setw(8) << label << std::right
+           << std::setw(5) << (st.cpu >= 0 ? std::to_string(st.cpu) : "-")
+           << std::setw(12) << st.packets << std::setw(14) << st.bytes
+           << std::setw(10) << st.ipv4 << std::setw(10) << st.ipv6
+           << std::setw(10) << st.tcp << std::setw(10) << st.udp
+           << std::setw(8) << st.icmp << std::setw(8) << st.other
+           << std::setw(8) << st.kernel_drops;
+        return ss.str();
+    };
+
+    renderer.PrintLine("WORKER    CPU     PACKETS         BYTES      IPV4      IPV6       TCP       UDP    ICMP   OTHER   DROPS", Color::CYAN);
+    const auto& workers = capture.WorkerStats();
+    for (size_t i = 0; i < workers.size(); ++i) renderer.PrintLine(row("#" + std::to_string(i), workers[i]));
+    RedTops::FanoutWorkerStats total = capture.Totals();
+    total.cpu = -1;
+    renderer.PrintLine(row("total", total), Color::GREEN);
+
+    std::ostringstream summary;
+    summary << std::fixed << std::setprecision(1) << "Captured " << total.packets << " packets in " << secs
+            << "s (" << (secs > 0 ? total.packets / secs : 0.0) << " pps, "
+            << (secs > 0 ? total.bytes * 8 / secs / 1e6 : 0.0) << " Mbit/s)";
+    renderer.PrintLine(summary.str(), Color::AMBER);
+
+    if (!trackers.empty()) {
+        std::vector<const RedTops::TcpFlow*> flows;
+        RedTops::TcpTrackerStats merged;
+        for (auto& t : trackers) {
+            t->Flush();
+            auto part = t->Flows();
+            flows.insert(flows.end(), part.begin(), part.end());
+            const auto& st = t->Stats();
+            merged.packets += st.packets;
+            merged.flows_created += st.flows_created;
+            merged.flows_evicted += st.flows_evicted;
+            merged.handshakes += st.handshakes;
+            merged.retransmits += st.retransmits;
+            merged.bytes_reassembled += st.bytes_reassembled;
+            merged.reassembly_gaps += st.reassembly_gaps;
+        }
+        PrintTcpReport(std::move(flows), merged);
+    }
+    if (output) output->Finish();
+}
+
+// Several interfaces at once, merged into one timestamp-ordered stream
+void RunMergedCapture(const SniffOptions& opts) {
+    TerminalRenderer& renderer = TerminalRenderer::Instance();
+
+    RedTops::MultiCaptureOptions mo;
+    mo.interfaces = opts.interfaces;
+    mo.max_packets = opts.count > 0 ? static_cast<uint64_t>(opts.count) : 0;
+    RedTops::MultiCapture capture(mo);
+    capture.Open();
+
+    FrameOutput output(opts, true);
+    size_t width = 0;
+    for (const auto& name : opts.interfaces) width = std::max(width, name.size());
+    output.SetLabelWidth(width);
+
+    renderer.PrintLine("Starting merged capture on " + std::to_string(opts.interfaces.size()) +
+                       " interfaces (" + opts.interface + ")" + (output.Writing() ? ", writing " + opts.write_path : ""));
+    renderer.PrintLine(opts.count == 0 ? "Capturing until Ctrl+C." :
+                       "Capturing " + std::to_string(opts.count) + " packets.");
+
+    capture.Run(
+        [] { return Shell::Instance().InterruptRequested(); },
+        [&](const RedTops::CapturedFrame& f) {
+            output.Emit(f.ts_ns, f.data, f.caplen, f.len, &opts.interfaces[f.interface]);
+        });
+
+    renderer.PrintLine("INTERFACE          PACKETS         BYTES   DROPS  STALLS     CUT", Color::CYAN);
+    for (size_t i = 0; i < opts.interfaces.size(); ++i) {
+        const auto& st = capture.Stats()[i];
+        std::ostringstream row;
+        row << std::left << std::setw(14) << opts.interfaces[i] << std::right
+            << std::setw(12) << st.packets << std::setw(14) << st.bytes
+            << std::setw(8) << st.kernel_drops << std::setw(8) << st.queue_stalls << std::setw(8) << st.truncated;
+        renderer.PrintLine(row.str());
+    }
+    if (!output.Writing()) renderer.PrintLine("Merged " + std::to_string(output.Frames()) + " packets.", Color::AMBER);
+    output.Finish();
+}
+
+// Accepts epoch seconds ("1700000000.5"), a local date-time ("2024-05-01T13:00:00")
+// or a time of day ("13:00:05"), the latter on the day the capture starts
+uint64_t ParseTimeArg(const std::string& flag, const std::string& text, uint64_t capture_start_ns) {
+    auto fail = [&]() -> uint64_t {
+        throw RedTops::CommandError("sniff: invalid time for " + flag + ": " + text +
+                                    " (use epoch seconds, YYYY-MM-DDTHH:MM:SS or HH:MM:SS)");
+    };
+
+    if (text.find(':') == std::string::npos) {
+        try {
+            size_t used = 0;
+            double secs = std::stod(text, &used);
+            if (used != text.size() || secs < 0) return fail();
+            return static_cast<uint64_t>(secs * 1e9);
+        } catch (const std::exception&) {
+            return fail();
+        }
+    }
+
+    tm parts{};
+    const char* rest = nullptr;
+    if (text.find('T') != std::string::npos) {
+        rest = strptime(text.c_str(), "%Y-%m-%dT%H:%M:%S", &parts);
+    } else {
+        time_t start = static_cast<time_t>(capture_start_ns / 1000000000ull);
+        localtime_r(&start, &parts);
+        rest = strptime(text.c_str(), "%H:%M:%S", &parts);
+    }
+    if (!rest) return fail();
+
+    double frac = 0;
+    if (*rest == '.') {
+        try {
+            frac = std::stod(std::string("0") + rest);
+        } catch (const std::exception&) {
+            return fail();
+        }
+    } else if (*rest != '\0') {
+        return fail();
+    }
+    parts.tm_isdst = -1;
+    time_t secs = mktime(&parts);
+    if (secs < 0) return fail();
+    return static_cast<uint64_t>(secs) * 1000000000ull + static_cast<uint64_t>(frac * 1e9);
+}
+
+// Replays a saved capture. With a time window or flow filter the sidecar
+// index (built on first use) narrows the scan to the blocks that can match.
+void RunReadCapture(const SniffOptions& opts) {
+    TerminalRenderer& renderer = TerminalRenderer::Instance();
+
+    std::unique_ptr<RedTops::PcapReader> reader;
+    try {
+        reader = std::make_unique<RedTops::PcapReader>(opts.read_path);
+    } catch (const RedTops::CommandError& e) {
+        throw RedTops::CommandError(std::string("sniff: ") + e.what());
+    }
+    if (reader->LinkType() != RedTops::kPcapLinkEthernet)
+        throw RedTops::CommandError("sniff: " + opts.read_path + " is not an Ethernet capture");
+
+    const bool filtered = !opts.since.empty() || !opts.until.empty() || !opts.flow.empty();
+    RedTops::FlowFilter flow;
+    if (!opts.flow.empty()) {
+        try {
+            flow = RedTops::ParseFlowFilter(opts.flow);
+        } catch (const RedTops::CommandError& e) {
+            throw RedTops::CommandError(std::string("sniff: ") + e.what());
         }
     }
 
+    const std::string index_path = RedTops::CaptureIndex::PathFor(opts.read_path);
+    RedTops::CaptureIndex index;
+    bool indexed = !opts.build_index && index.Open(index_path, reader->Size(), reader->MtimeNs());
+    if (!indexed && (filtered || opts.build_index)) {
+        renderer.PrintLine("Indexing " + opts.read_path + "...", Color::DIM);
+        try {
+            RedTops::CaptureIndex::Build(*reader, index_path);
+        } catch (const RedTops::CommandError& e) {
+            throw RedTops::CommandError(std::string("sniff: ") + e.what());
+        }
+        indexed = index.Open(index_path, reader->Size(), reader->MtimeNs());
+        if (!indexed) throw RedTops::CommandError("sniff: could not read back " + index_path);
+    }
+    if (opts.build_index) {
+        renderer.PrintLine("Indexed " + opts.read_path + ": " + std::to_string(index.BlockCount()) + " blocks, " +
+                           std::to_string(index.FlowCount()) + " flows -> " + index_path, Color::AMBER);
+        return;
+    }
+
+    uint64_t start_ns = 0;
+    if (indexed) {
+        start_ns = index.FirstTimestamp();
+    } else {
+        RedTops::PcapRecord first;
+        if (reader->ReadAt(reader->FirstRecord(), first)) start_ns = first.ts_ns;
+    }
+    uint64_t since_ns = opts.since.empty() ? 0 : ParseTimeArg("--since", opts.since, start_ns);
+    uint64_t until_ns = opts.until.empty() ? UINT64_MAX : ParseTimeArg("--until", opts.until, start_ns);
+
+    // Byte ranges of the file to scan; adjacent candidate blocks are coalesced
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    if (filtered && indexed) {
+        for (uint32_t block : index.Candidates(since_ns, until_ns, opts.flow.empty() ? 0 : flow.Hash())) {
+            uint64_t begin = index.BlockOffset(block), end = index.BlockEnd(block);
+            if (!ranges.empty() && ranges.back().second == begin) ranges.back().second = end;
+            else ranges.emplace_back(begin, end);
+        }
+    } else {
+        ranges.emplace_back(reader->FirstRecord(), reader->Size());
+    }
+    reader->Advise(!filtered);
+
+    FrameOutput output(opts, true);
+    RedTops::DissectedPacket pkt;
+    RedTops::PcapRecord rec;
+    uint64_t scanned = 0, scanned_bytes = 0;
+    bool done = false;
+    for (const auto& [begin, end] : ranges) {
+        for (uint64_t off = begin; !done && off < end && reader->ReadAt(off, rec); off = rec.next) {
+            scanned++;
+            scanned_bytes += rec.next - rec.offset;
+            if (rec.ts_ns < since_ns || rec.ts_ns > until_ns) continue;
+            if (!opts.flow.empty() && !(RedTops::Dissect(rec.data, rec.caplen, rec.len, pkt) && flow.Matches(pkt)))
+                continue;
+            output.Emit(rec.ts_ns, rec.data, rec.caplen, rec.len);
+            if (opts.count > 0 && output.Frames() >= static_cast<uint64_t>(opts.count)) done = true;
+            // Cheap enough to check per record; keeps Ctrl+C responsive on huge files
+            if (Shell::Instance().InterruptRequested()) done = true;
+        }
+        if (done) break;
+    }
+
+    std::ostringstream summary;
+    summary << output.Frames() << " packets matched; scanned " << scanned << " records ("
+            << std::fixed << std::setprecision(1) << scanned_bytes / 1048576.0 << " of "
+            << reader->Size() / 1048576.0 << " MB)";
+    if (filtered) summary << " using " << opts.read_path.substr(opts.read_path.find_last_of('/') + 1) << ".rtidx";
+    renderer.PrintLine(summary.str(), Color::AMBER);
+    output.Finish();
+}
+
+} // namespace
+
+// Per-capture state handed to packet_handler through pcap's user pointer
+struct PacketPrinter {
+    FrameOutput* output = nullptr;
+    pcap_t* handle = nullptr;
+    std::string error;             // set when output fails; the loop is broken
+};
+
+// Callback function for libpcap
+void packet_handler(u_char *user_data, const struct pcap_pkthdr *pkthdr, const u_char *packet) {
+    auto* printer = reinterpret_cast<PacketPrinter*>(user_data);
+    uint64_t ts_ns = (static_cast<uint64_t>(pkthdr->ts.tv_sec) * 1000000 + pkthdr->ts.tv_usec) * 1000;
+
+    // Exceptions must not unwind through libpcap
+    try {
+        printer->output->Emit(ts_ns, packet, pkthdr->caplen, pkthdr->len);
+    } catch (const std::exception& e) {
+        printer->error = e.what();
+        pcap_breakloop(printer->handle);
+    }
+}
+
+void SniffCommand::Execute(const std::vector<std::string>& args) {
+    SniffOptions opts = ParseSniffOptions(args);
+    const std::string& interface = opts.interface;
+    int count = opts.count;
+
+    // Ctrl+C ends the capture rather than the shell
+    InterruptScope interrupt_scope;
+
+    if (opts.fanout_workers > 0) {
+        RunFanoutCapture(opts);
+        return;
+    }
+    if (!opts.read_path.empty()) {
+        RunReadCapture(opts);
+        return;
+    }
+    if (opts.interfaces.size() > 1) {
+        RunMergedCapture(opts);
+        return;
+    }
+
     char errbuf[PCAP_ERRBUF_SIZE];
     pcap_t *handle;
 
@@ -101,14 +718,26 @@ void SniffCommand::Execute(const std::vector<std::string>& args) {
 
     // Loop forever (or until 'count' packets are captured)
     // The packet_handler function will be called for each packet
-    int result = pcap_loop(handle, count, packet_handler, NULL);
+    std::unique_ptr<FrameOutput> output;
+    try {
+        output = std::make_unique<FrameOutput>(opts, false, static_cast<uint32_t>(pcap_snapshot(handle)));
+    } catch (...) {
+        Shell::Instance().ClearCurrentPcapHandle();
+        pcap_close(handle);
+        throw;
+    }
+    PacketPrinter printer;
+    printer.output = output.get();
+    printer.handle = handle;
+    int result = pcap_loop(handle, count, packet_handler, reinterpret_cast<u_char*>(&printer));
     
     // Clear the pcap handle from the Shell once done or on error
     Shell::Instance().ClearCurrentPcapHandle();
 
     if (result == -1) { // Error
+        std::string err = pcap_geterr(handle);
         pcap_close(handle);
-        throw RedTops::NetworkError("sniff: Error during capture: " + std::string(pcap_geterr(handle)));
+        throw RedTops::NetworkError("sniff: Error during capture: " + err);
     } else if (result == -2) { // Loop terminated by pcap_breakloop
         // This is fine, usually means Ctrl+C
         TerminalRenderer::Instance().PrintLine("Packet capture stopped.", Color::AMBER);
@@ -116,7 +745,12 @@ void SniffCommand::Execute(const std::vector<std::string>& args) {
         TerminalRenderer::Instance().PrintLine("Finished capturing " + std::to_string(count) + " packets.", Color::AMBER);
     }
 
+    if (!printer.error.empty()) {
+        pcap_close(handle);
+        throw RedTops::CommandError("sniff: " + printer.error);
+    }
 
     // Close the handle
     pcap_close(handle);
+    output->Finish();
 }
\ No newline at end of file
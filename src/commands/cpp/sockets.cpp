@@ -0,0 +1,289 @@
+#include "../headers/sockets.hpp"
+#include "../../core/header/TerminalRenderer.hpp"
+#include "../../core/header/Exceptions.hpp"
+#include "../../core/header/Shell.hpp"
+#include "../../core/header/RecordEmitter.hpp"
+
+#ifndef _WIN32
+#include "../../modules/headers/SockDiag.hpp"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifndef _WIN32
+namespace {
+
+enum class Grouping { None, State, Peer };
+
+struct SocketsOptions {
+    RedTops::SocketFilter filter;
+    Grouping group = Grouping::None;
+    size_t limit = 100;        // rows listed
+    size_t top = 20;           // peers shown when grouping by peer
+};
+
+void ParsePortRange(const std::string& text, uint16_t& lo, uint16_t& hi) {
+    char* end = nullptr;
+    long a = std::strtol(text.c_str(), &end, 10);
+    long b = a;
+    if (*end == '-') b = std::strtol(end + 1, &end, 10);
+    if (*end || a < 1 || b > 65535 || a > b) throw RedTops::CommandError("sockets: invalid port or range: " + text);
+    lo = static_cast<uint16_t>(a);
+    hi = static_cast<uint16_t>(b);
+}
+
+SocketsOptions ParseOptions(const std::vector<std::string>& args) {
+    SocketsOptions o;
+    uint32_t states = 0;
+    auto number = [&](size_t& i, const std::string& flag) {
+        if (i + 1 >= args.size()) throw RedTops::CommandError("sockets: " + flag + " needs a value");
+        long v = std::strtol(args[++i].c_str(), nullptr, 10);
+        if (v < 0) throw RedTops::CommandError("sockets: invalid value for " + flag);
+        return static_cast<size_t>(v);
+    };
+
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if (arg == "-t" || arg == "--tcp") o.filter.protocol = IPPROTO_TCP;
+        else if (arg == "-u" || arg == "--udp") o.filter.protocol = IPPROTO_UDP;
+        else if (arg == "-4") o.filter.family = AF_INET;
+        else if (arg == "-6") o.filter.family = AF_INET6;
+        else if (arg == "-l" || arg == "--listening") states |= 1u << 10 | 1u << 7;   // LISTEN, and UNCONN for UDP
+        else if (arg == "-i" || arg == "--info") o.filter.tcp_info = true;
+        else if ((arg == "-s" || arg == "--state") && i + 1 < args.size()) {
+            std::stringstream list(args[++i]);
+            std::string name;
+            while (std::getline(list, name, ',')) {
+                int state = RedTops::ParseSocketState(name.c_str());
+                if (state < 0) throw RedTops::CommandError("sockets: unknown state: " + name);
+                states |= 1u << state;
+            }
+        }
+        else if (arg == "--sport" && i + 1 < args.size()) ParsePortRange(args[++i], o.filter.sport_lo, o.filter.sport_hi);
+        else if (arg == "--dport" && i + 1 < args.size()) ParsePortRange(args[++i], o.filter.dport_lo, o.filter.dport_hi);
+        else if (arg == "--by" && i + 1 < args.size()) {
+            const std::string& mode = args[++i];
+            if (mode == "state") o.group = Grouping::State;
+            else if (mode == "peer") o.group = Grouping::Peer;
+            else throw RedTops::CommandError("sockets: --by takes 'state' or 'peer'");
+        }
+        else if (arg == "-n" || arg == "--limit") o.limit = number(i, arg);
+        else if (arg == "--top") o.top = number(i, arg);
+        else throw RedTops::CommandError("sockets: unknown option: " + arg);
+    }
+    if (states) o.filter.states = states;
+    return o;
+}
+
+// Remote address as a fixed-size key, so grouping never allocates per socket
+struct PeerKey {
+    std::array<uint8_t, 17> bytes{};   // family tag + address
+    bool operator==(const PeerKey& other) const { return bytes == other.bytes; }
+};
+
+struct PeerKeyHash {
+    size_t operator()(const PeerKey& k) const {
+        uint64_t h = 1469598103934665603ull;
+        for (uint8_t b : k.bytes) h = (h ^ b) * 1099511628211ull;
+        return static_cast<size_t>(h);
+    }
+};
+
+struct PeerStats {
+    uint64_t sockets = 0;
+    uint64_t established = 0;
+    uint64_t recv_q = 0, send_q = 0;
+    uint64_t retrans = 0;
+    uint64_t rtt_sum_us = 0, rtt_samples = 0;
+};
+
+std::string FormatEndpoint(int family, const uint8_t* addr, uint16_t port) {
+    char host[INET6_ADDRSTRLEN + 2];
+    RedTops::FormatSocketAddress(family, addr, host, sizeof(host));
+    return std::string(host) + ":" + (port ? std::to_string(port) : std::string("*"));
+}
+
+// Records carry bare addresses and numeric ports; brackets and "*" are for the table
+void EmitSocket(RecordEmitter& out, const RedTops::SocketEntry& s, bool tcp, bool info) {
+    char local[INET6_ADDRSTRLEN], remote[INET6_ADDRSTRLEN];
+    inet_ntop(s.family, s.local, local, sizeof(local));
+    inet_ntop(s.family, s.remote, remote, sizeof(remote));
+    out.Record("socket")
+        .Field("proto", tcp ? "tcp" : "udp")
+        .Field("state", RedTops::SocketStateName(s.state))
+        .Field("local", local).Field("local_port", s.local_port)
+        .Field("peer", remote).Field("peer_port", s.remote_port)
+        .Field("recv_q", s.recv_q).Field("send_q", s.send_q)
+        .Field("uid", s.uid).Field("inode", s.inode);
+    if (info) {
+        out.Field("rtt_ms", s.has_info ? s.rtt_us / 1000.0 : 0.0)
+            .Field("cwnd", s.snd_cwnd)
+            .Field("retrans", s.total_retrans);
+    }
+    out.Commit();
+}
+
+} // namespace
+#endif
+
+void SocketsCommand::Execute(const std::vector<std::string>& args) {
+    TerminalRenderer& term = TerminalRenderer::Instance();
+
+#ifdef _WIN32
+    (void)args;
+    term.PrintLine("sockets: sock_diag is only available on Linux");
+#else
+    SocketsOptions opts = ParseOptions(args);
+    InterruptScope interrupt_scope;
+    const bool tcp = opts.filter.protocol == IPPROTO_TCP;
+    const bool info = opts.filter.tcp_info && tcp;
+    const bool listing = opts.group == Grouping::None;
+    RecordEmitter& out = RecordEmitter::Instance();
+    const bool structured = out.Active();
+
+    std::array<uint64_t, 16> by_state{};
+    std::unordered_map<PeerKey, PeerStats, PeerKeyHash> by_peer;
+    std::string rows;
+    size_t listed = 0;
+    char line[320];
+
+    if (listing && !structured) {
+        std::snprintf(line, sizeof(line), "%-5s %-12s %8s %8s  %-47s %-47s", "PROTO", "STATE", "RECV-Q", "SEND-Q", "LOCAL", "PEER");
+        rows += Color::CYAN + line;
+        if (info) {
+            std::snprintf(line, sizeof(line), " %9s %6s %7s", "RTT ms", "CWND", "RETRANS");
+            rows += line;
+        }
+        rows += Color::RESET + "\n";
+    }
+
+    uint64_t total = RedTops::DumpSockets(opts.filter, [&](const RedTops::SocketEntry& s) {
+        by_state[s.state & 15]++;
+
+        if (opts.group == Grouping::Peer) {
+            PeerKey key;
+            key.bytes[0] = static_cast<uint8_t>(s.family);
+            std::memcpy(key.bytes.data() + 1, s.remote, 16);
+            PeerStats& p = by_peer[key];
+            p.sockets++;
+            if (s.state == 1) p.established++;
+            p.recv_q += s.recv_q;
+            p.send_q += s.send_q;
+            if (s.has_info) {
+                p.retrans += s.total_retrans;
+                if (s.rtt_us) { p.rtt_sum_us += s.rtt_us; p.rtt_samples++; }
+            }
+        } else if (listing && structured) {
+            // Pipelines get every socket; -n only bounds the table
+            EmitSocket(out, s, tcp, info);
+            return !Shell::Instance().InterruptRequested() && !out.Broken();
+        } else if (listing && listed < opts.limit) {
+            std::snprintf(line, sizeof(line), "%-5s %-12s %8u %8u  %-47s %-47s", tcp ? "tcp" : "udp",
+                          RedTops::SocketStateName(s.state), s.recv_q, s.send_q,
+                          FormatEndpoint(s.family, s.local, s.local_port).c_str(),
+                          FormatEndpoint(s.family, s.remote, s.remote_port).c_str());
+            rows += line;
+            if (info && s.has_info) {
+                std::snprintf(line, sizeof(line), " %9.3f %6u %7u", s.rtt_us / 1000.0, s.snd_cwnd, s.total_retrans);
+                rows += line;
+            }
+            rows += '\n';
+            ++listed;
+        }
+        // Large dumps can take a while; Ctrl+C stops at the next socket
+        return !Shell::Instance().InterruptRequested();
+    });
+
+    if (structured) {
+        if (opts.group == Grouping::Peer) {
+            char host[INET6_ADDRSTRLEN];
+            for (const auto& [key, p] : by_peer) {
+                inet_ntop(key.bytes[0], key.bytes.data() + 1, host, sizeof(host));
+                out.Record("peer").Field("peer", host)
+                    .Field("sockets", p.sockets).Field("established", p.established)
+                    .Field("recv_q", p.recv_q).Field("send_q", p.send_q);
+                if (info) {
+                    out.Field("avg_rtt_ms", p.rtt_samples ? p.rtt_sum_us / 1000.0 / static_cast<double>(p.rtt_samples) : 0.0)
+                        .Field("retrans", p.retrans);
+                }
+                out.Commit();
+            }
+        } else if (opts.group == Grouping::State) {
+            for (size_t st = 0; st < by_state.size(); ++st) {
+                if (!by_state[st]) continue;
+                out.Record("state").Field("proto", tcp ? "tcp" : "udp")
+                    .Field("state", RedTops::SocketStateName(static_cast<uint8_t>(st))).Field("sockets", by_state[st]).Commit();
+            }
+        }
+        return;
+    }
+
+    term.PrintLine("\033[1;34m=== Sockets ===\033[0m");
+    if (listing) {
+        if (total > listed) {
+            std::snprintf(line, sizeof(line), "%s... %llu more (raise -n or narrow with -s/--sport/--dport)%s\n",
+                          Color::DIM.c_str(), static_cast<unsigned long long>(total - listed), Color::RESET.c_str());
+            rows += line;
+        }
+        term.PrintLine(rows);
+    }
+
+    if (opts.group == Grouping::Peer) {
+        std::vector<std::pair<const PeerKey*, const PeerStats*>> peers;
+        peers.reserve(by_peer.size());
+        for (const auto& [key, stats] : by_peer) peers.emplace_back(&key, &stats);
+        size_t shown = std::min(opts.top, peers.size());
+        std::partial_sort(peers.begin(), peers.begin() + static_cast<std::ptrdiff_t>(shown), peers.end(),
+                          [](const auto& a, const auto& b) { return a.second->sockets > b.second->sockets; });
+
+        std::string out;
+        std::snprintf(line, sizeof(line), "%-41s %9s %9s %10s %10s", "PEER", "SOCKETS", "ESTAB", "RECV-Q", "SEND-Q");
+        out += Color::CYAN + line;
+        if (info) {
+            std::snprintf(line, sizeof(line), " %11s %8s", "AVG RTT ms", "RETRANS");
+            out += line;
+        }
+        out += Color::RESET + "\n";
+        char host[INET6_ADDRSTRLEN + 2];
+        for (size_t i = 0; i < shown; ++i) {
+            const PeerStats& p = *peers[i].second;
+            RedTops::FormatSocketAddress(peers[i].first->bytes[0], peers[i].first->bytes.data() + 1, host, sizeof(host));
+            std::snprintf(line, sizeof(line), "%-41s %9llu %9llu %10llu %10llu", host,
+                          static_cast<unsigned long long>(p.sockets), static_cast<unsigned long long>(p.established),
+                          static_cast<unsigned long long>(p.recv_q), static_cast<unsigned long long>(p.send_q));
+            out += line;
+            if (info) {
+                double avg = p.rtt_samples ? p.rtt_sum_us / 1000.0 / static_cast<double>(p.rtt_samples) : 0.0;
+                std::snprintf(line, sizeof(line), " %11.3f %8llu", avg, static_cast<unsigned long long>(p.retrans));
+                out += line;
+            }
+            out += '\n';
+        }
+        std::snprintf(line, sizeof(line), "%zu distinct peer(s)", by_peer.size());
+        out += line;
+        term.PrintLine(out);
+    }
+
+    // State totals close every view
+    std::string summary = std::to_string(total) + (tcp ? " tcp" : " udp") + " socket(s)";
+    bool first = true;
+    for (size_t st = 0; st < by_state.size(); ++st) {
+        if (!by_state[st]) continue;
+        summary += first ? ": " : ", ";
+        summary += std::string(RedTops::SocketStateName(static_cast<uint8_t>(st))) + " " + std::to_string(by_state[st]);
+        first = false;
+    }
+    term.PrintLine(summary);
+#endif
+}
@@ -1,5 +1,7 @@
 #include "../headers/sysinfo.hpp"
 #include "../../core/header/TerminalRenderer.hpp"
+#include "../../core/header/Exceptions.hpp"
+#include "../../core/header/Shell.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -11,6 +13,9 @@
 #include <cmath>
 #include <cstring>
 #include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 
 #ifdef _WIN32
     #include <windows.h>
@@ -19,14 +24,220 @@
 #else
     #include <unistd.h>
     #include <sys/utsname.h>
+    #include <sys/resource.h>
     #include <sys/sysinfo.h>
     #include <ifaddrs.h>
     #include <netinet/in.h>
     #include <arpa/inet.h>
     #include <net/if.h>
+    #include <ctime>
+    #include "../../modules/headers/ProcSampler.hpp"
+    #include "../../modules/headers/HardwareInventory.hpp"
 #endif
 
 
+#ifndef _WIN32
+namespace {
+
+struct WatchOptions {
+    double interval = 1.0;   // seconds between refreshes
+    size_t top = 15;         // process rows
+    long count = 0;          // refreshes before exiting, 0 = until Ctrl+C
+};
+
+double ThreadCpuMs() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// Sleeps in short steps so Ctrl+C is noticed promptly; false once interrupted
+bool WaitInterval(double seconds) {
+    auto until = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+    while (std::chrono::steady_clock::now() < until) {
+        if (Shell::Instance().InterruptRequested()) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return !Shell::Instance().InterruptRequested();
+}
+
+void AppendBar(std::string& out, double percent, int width) {
+    int filled = static_cast<int>(percent / 100.0 * width + 0.5);
+    filled = std::max(0, std::min(width, filled));
+    out += percent >= 80 ? Color::RED : percent >= 50 ? Color::AMBER : Color::GREEN;
+    out.append(static_cast<size_t>(filled), '|');
+    out += Color::DIM;
+    out.append(static_cast<size_t>(width - filled), '.');
+    out += Color::RESET;
+}
+
+std::string Mib(uint64_t bytes) {
+    return std::to_string(bytes >> 20) + " MB";
+}
+
+// "vda  r 12.3 MB/s  w 0.0 MB/s  ..." rows for the disks that did any I/O
+void AppendDiskRows(std::string& out, const std::vector<RedTops::DiskUsage>& disks, bool idle_too) {
+    char line[200];
+    std::snprintf(line, sizeof(line), "%-10s %10s %10s %9s %9s %8s %6s\n", "DISK", "READ MB/s", "WRITE MB/s", "R IOPS", "W IOPS", "AWAIT ms", "UTIL%");
+    out += Color::CYAN + line + Color::RESET;
+    size_t shown = 0;
+    for (const auto& d : disks) {
+        if (!idle_too && d.read_iops + d.write_iops == 0 && d.in_flight == 0) continue;
+        std::snprintf(line, sizeof(line), "%-10s %10.2f %10.2f %9.0f %9.0f %8.2f %6.1f\n", d.name.c_str(),
+                      d.read_bps / 1048576.0, d.write_bps / 1048576.0, d.read_iops, d.write_iops, d.await_ms, d.util);
+        out += line;
+        ++shown;
+    }
+    if (!shown) out += Color::DIM + "(no disk activity)" + Color::RESET + "\n";
+}
+
+// The process view keeps a stat file open per process; lift the soft
+// descriptor limit for it as far as the hard limit allows
+void RaiseFdLimit() {
+    rlimit lim{};
+    if (getrlimit(RLIMIT_NOFILE, &lim) != 0) return;
+    rlim_t want = std::min<rlim_t>(lim.rlim_max, 65536);
+    if (lim.rlim_cur >= want) return;
+    lim.rlim_cur = want;
+    setrlimit(RLIMIT_NOFILE, &lim);
+}
+
+// Live top-style view: per-core and per-process utilisation from /proc deltas
+void RunWatch(const WatchOptions& opts) {
+    TerminalRenderer& term = TerminalRenderer::Instance();
+    InterruptScope interrupt_scope;
+
+    RaiseFdLimit();
+    RedTops::CpuSampler cpu;
+    RedTops::ProcessSampler procs;
+    RedTops::MemorySampler memory;
+    RedTops::PressureSampler pressure;
+    RedTops::DiskSampler disks;
+    cpu.Sample();
+    procs.Sample();
+    pressure.Sample();
+    disks.Sample();
+
+    std::string frame;
+    char line[256];
+    double sample_ms = 0, render_ms = 0;
+    std::cout << "\033[2J\033[?25l" << std::flush;   // clear once, hide the cursor while live
+
+    for (long refresh = 0; opts.count == 0 || refresh < opts.count; ++refresh) {
+        if (!WaitInterval(opts.interval)) break;
+
+        double t0 = ThreadCpuMs();
+        cpu.Sample();
+        procs.Sample();
+        pressure.Sample();
+        disks.Sample();
+        RedTops::MemoryInfo mem = memory.Sample();
+        RedTops::LoadAverage load = cpu.Load();
+        double t1 = ThreadCpuMs();
+
+        frame.clear();
+        time_t now = time(nullptr);
+        tm local{};
+        localtime_r(&now, &local);
+        std::snprintf(line, sizeof(line), "\033[1;34m=== sysinfo --watch ===\033[0m  %02d:%02d:%02d  every %.1fs  (Ctrl+C to stop)\n",
+                      local.tm_hour, local.tm_min, local.tm_sec, opts.interval);
+        frame += line;
+        std::snprintf(line, sizeof(line), "load %.2f %.2f %.2f   tasks %u/%u   ctxt/s %llu   processes %zu\n\n",
+                      load.one, load.five, load.fifteen, load.running, load.total,
+                      static_cast<unsigned long long>(cpu.ContextSwitchesPerSec()), procs.Count());
+        frame += line;
+
+        frame += Color::CYAN + "CPU      USR%   SYS%   IOW%  STEAL   BUSY" + Color::RESET + "\n";
+        auto core_row = [&](const char* label, const RedTops::CpuUsage& u) {
+            std::snprintf(line, sizeof(line), "%-6s %6.1f %6.1f %6.1f %6.1f %6.1f  ",
+                          label, u.user, u.system, u.iowait, u.steal, u.busy);
+            frame += line;
+            AppendBar(frame, u.busy, 30);
+            frame += '\n';
+        };
+        core_row("all", cpu.Total());
+
+        const auto& cores = cpu.Cores();
+        if (cores.size() <= 32) {
+            for (size_t i = 0; i < cores.size(); ++i) core_row(("cpu" + std::to_string(i)).c_str(), cores[i]);
+        } else {
+            // Large hosts: a compact grid keeps the process table on screen
+            for (size_t i = 0; i < cores.size(); ++i) {
+                std::snprintf(line, sizeof(line), "%4zu ", i);
+                frame += line;
+                AppendBar(frame, cores[i].busy, 8);
+                frame += (i % 8 == 7 || i + 1 == cores.size()) ? "\n" : "  ";
+            }
+        }
+
+        std::snprintf(line, sizeof(line), "\nmem  used %llu MB of %llu MB   avail %llu MB   cache %llu MB   dirty %llu MB   swap %llu/%llu MB\n",
+                      static_cast<unsigned long long>(mem.used() >> 20), static_cast<unsigned long long>(mem.total >> 20),
+                      static_cast<unsigned long long>(mem.available >> 20), static_cast<unsigned long long>(mem.cache() >> 20),
+                      static_cast<unsigned long long>(mem.dirty >> 20), static_cast<unsigned long long>(mem.swap_used() >> 20),
+                      static_cast<unsigned long long>(mem.swap_total >> 20));
+        frame += line;
+        if (pressure.Get(RedTops::PressureSampler::Cpu).available) {
+            // Stall share over this refresh, from the PSI total counters
+            frame += "psi ";
+            for (int r = 0; r < RedTops::PressureSampler::kResources; ++r) {
+                auto res = static_cast<RedTops::PressureSampler::Resource>(r);
+                const RedTops::Pressure& p = pressure.Get(res);
+                std::snprintf(line, sizeof(line), "  %s some %5.1f%% full %5.1f%%", RedTops::PressureSampler::Name(res), p.some.now, p.full.now);
+                frame += line;
+            }
+            frame += '\n';
+        }
+        frame += '\n';
+        AppendDiskRows(frame, disks.Disks(), false);
+
+        frame += '\n';
+        frame += Color::CYAN + "    PID S   THR     RSS MB   CPU%  COMMAND" + Color::RESET + "\n";
+        for (const RedTops::ProcessUsage* p : procs.Top(opts.top)) {
+            std::snprintf(line, sizeof(line), "%7d %c %5u %10.1f %6.1f  %s\n", p->pid, p->state, p->threads,
+                          p->rss_bytes / 1048576.0, p->cpu_percent, p->name.c_str());
+            frame += line;
+        }
+
+        // What watching costs, so it can be kept honest
+        std::snprintf(line, sizeof(line), "\n%ssample %.2f ms  render %.2f ms  overhead %.3f%% CPU%s",
+                      Color::DIM.c_str(), sample_ms, render_ms,
+                      (sample_ms + render_ms) / (opts.interval * 1000.0) * 100.0, Color::RESET.c_str());
+        frame += line;
+
+        term.DrawFrame(frame);
+        sample_ms = t1 - t0;
+        render_ms = ThreadCpuMs() - t1;
+    }
+
+    std::cout << "\033[?25h" << std::flush;
+    term.PrintLine("");
+}
+
+WatchOptions ParseWatchOptions(const std::vector<std::string>& args) {
+    WatchOptions opts;
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        try {
+            if ((arg == "-i" || arg == "--interval") && i + 1 < args.size()) {
+                opts.interval = std::stod(args[++i]);
+                if (opts.interval < 0.1 || opts.interval > 3600) throw std::out_of_range(arg);
+            } else if (arg == "--top" && i + 1 < args.size()) {
+                long n = std::stol(args[++i]);
+                if (n < 0 || n > 1000) throw std::out_of_range(arg);
+                opts.top = static_cast<size_t>(n);
+            } else if (arg == "--count" && i + 1 < args.size()) {
+                opts.count = std::stol(args[++i]);
+                if (opts.count < 0) throw std::out_of_range(arg);
+            }
+        } catch (const std::exception&) {
+            throw RedTops::CommandError("sysinfo: invalid value for " + arg + ": " + args[i]);
+        }
+    }
+    return opts;
+}
+
+} // namespace
+#endif
 
 void SysInfoCommand::Execute(const std::vector<std::string>& args) {
     bool show_all = true;
@@ -35,14 +246,25 @@ void SysInfoCommand::Execute(const std::vector<std::string>& args) {
     bool show_os = false;
     bool show_uptime = false;
     bool show_net = false;
+    bool show_io = false;
     bool cpu_adv = false;
 
+    if (std::find(args.begin(), args.end(), "--watch") != args.end()) {
+    #ifdef _WIN32
+        throw RedTops::CommandError("sysinfo: --watch is only available on Linux");
+    #else
+        RunWatch(ParseWatchOptions(args));
+        return;
+    #endif
+    }
+
     for (auto& arg : args) {
         if (arg == "-cpu") { show_cpu = true; show_all = false; }
         else if (arg == "-mem") { show_mem = true; show_all = false; }
         else if (arg == "-os") { show_os = true; show_all = false; }
         else if (arg == "-uptime") { show_uptime = true; show_all = false; }
         else if (arg == "-net") { show_net = true; show_all = false; }
+        else if (arg == "-io") { show_io = true; show_all = false; }
         else if (arg == "-adv") { cpu_adv = true; show_all = false; show_cpu = true; }
     }
 
@@ -111,48 +333,56 @@ void SysInfoCommand::Execute(const std::vector<std::string>& args) {
             term.PrintLine("\033[1;33m(Advanced flags not yet supported on Windows)\033[0m");
 
     #else
-        std::ifstream cpuinfo("/proc/cpuinfo");
-        std::string line;
-        std::vector<std::map<std::string,std::string>> cpus;
-        std::map<std::string,std::string> cpu_data;
-
-        auto trim = [](std::string s)->std::string{
-            while (!s.empty() && isspace(s.front())) s.erase(0,1);
-            while (!s.empty() && isspace(s.back())) s.pop_back();
-            return s;
-        };
+        const RedTops::HardwareInventory& hw = RedTops::HardwareInventory::Get();
+        auto kib = [](uint64_t bytes) { return std::to_string(bytes >> 10) + " KB"; };
+
+        if (!hw.cpus.empty()) {
+            term.PrintLine("Model: " + hw.model);
+            term.PrintLine("Vendor: " + hw.vendor);
+            term.PrintLine("Cores: " + std::to_string(hw.cpus.size()) + " logical, " +
+                           std::to_string(hw.physical_cores) + " physical");
+            term.PrintLine("Sockets: " + std::to_string(hw.sockets) + "  NUMA nodes: " + std::to_string(hw.numa_nodes) +
+                           "  Threads/core: " + std::to_string(hw.threads_per_core));
+        }
 
-        while (std::getline(cpuinfo, line)) {
-            if (line.empty()) {
-                if (!cpu_data.empty()) {
-                    cpus.push_back(cpu_data);
-                    cpu_data.clear();
+        if (cpu_adv && !hw.cpus.empty()) {
+            term.PrintLine("\n\033[1;33m--- Advanced CPU Info ---\033[0m");
+            if (!hw.microcode.empty()) term.PrintLine("Microcode: " + hw.microcode);
+
+            if (!hw.caches.empty()) {
+                term.PrintLine("Caches:");
+                for (const auto& c : hw.caches) {
+                    std::ostringstream row;
+                    row << "  L" << c.level << " " << std::left << std::setw(12) << c.type << std::right
+                        << std::setw(10) << kib(c.size_bytes) << "  x" << c.instances
+                        << "  " << c.ways << "-way, " << c.line_size << " B lines, shared by " << c.shared_by;
+                    term.PrintLine(row.str());
                 }
-                continue;
+            } else if (hw.cache_size_bytes) {
+                term.PrintLine("Cache: " + kib(hw.cache_size_bytes));
             }
-            auto pos = line.find(':');
-            if (pos == std::string::npos) continue;
 
-            std::string key = trim(line.substr(0,pos));
-            std::string value = trim(line.substr(pos+1));
-            cpu_data[key] = value;
-        }
-        if (!cpu_data.empty()) cpus.push_back(cpu_data);
-
-        if (!cpus.empty()) {
-            term.PrintLine("Model: " + cpus[0]["model name"]);
-            term.PrintLine("Vendor: " + cpus[0]["vendor_id"]);
-            term.PrintLine("Cores: " + std::to_string(cpus.size()));
-        }
+            // Flags are normally identical on every CPU; print each distinct list once
+            for (size_t set = 0; set < hw.flag_sets.size(); ++set) {
+                std::string label = "Flags";
+                if (hw.flag_sets.size() > 1) {
+                    label += " (cpu";
+                    for (const auto& cpu : hw.cpus)
+                        if (cpu.flag_set == set) label += " " + std::to_string(cpu.id);
+                    label += ")";
+                }
+                term.PrintLine(label + ": " + hw.flag_sets[set]);
+            }
 
-        if (cpu_adv && !cpus.empty()) {
-            term.PrintLine("\n\033[1;33m--- Advanced CPU Info ---\033[0m");
-            for (size_t i = 0; i < cpus.size(); i++) {
-                term.PrintLine("Core " + std::to_string(i) + ":");
-                if (cpus[i].count("cache size")) term.PrintLine("  Cache: " + cpus[i]["cache size"]);
-                if (cpus[i].count("flags")) term.PrintLine("  Flags: " + cpus[i]["flags"]);
-                if (cpus[i].count("bogomips")) term.PrintLine("  Bogomips: " + cpus[i]["bogomips"]);
+            term.PrintLine("\nCPU  SOCKET  CORE  NODE  BOGOMIPS");
+            std::string table;
+            char row[80];
+            for (const auto& cpu : hw.cpus) {
+                std::snprintf(row, sizeof(row), "%3d  %6d  %4d  %4d  %8.2f\n", cpu.id, cpu.socket, cpu.core, cpu.node, cpu.bogomips);
+                table += row;
             }
+            table.pop_back();
+            term.PrintLine(table);
         }
     #endif
     }
@@ -170,16 +400,59 @@ void SysInfoCommand::Execute(const std::vector<std::string>& args) {
         term.PrintLine("Free RAM : " + std::to_string(mem.ullAvailPhys / 1024 / 1024) + " MB");
 
     #else
-        struct sysinfo memInfo;
-        sysinfo(&memInfo);
-
-        auto tom = [&](long long v){ return v * memInfo.mem_unit / 1024 / 1024; };
-        long long total = tom(memInfo.totalram);
-        long long free = tom(memInfo.freeram);
+        // "Used" excludes reclaimable cache: total minus MemAvailable, as free(1) reports it
+        RedTops::MemorySampler sampler;
+        RedTops::MemoryInfo mem = sampler.Sample();
+        int used_pct = mem.total ? static_cast<int>(mem.used() * 100 / mem.total) : 0;
+
+        term.PrintLine("Total RAM: " + Mib(mem.total));
+        term.PrintLine("Used RAM : " + Mib(mem.used()) + " (" + std::to_string(used_pct) + "%)");
+        term.PrintLine("Available: " + Mib(mem.available));
+        term.PrintLine("Free RAM : " + Mib(mem.free));
+        term.PrintLine("Cache    : " + Mib(mem.cache()) + " (buffers " + Mib(mem.buffers) + ", page cache " + Mib(mem.cached) +
+                       ", reclaimable slab " + Mib(mem.slab_reclaimable) + ")");
+        term.PrintLine("Slab     : " + Mib(mem.slab_reclaimable + mem.slab_unreclaimable) + " (" + Mib(mem.slab_unreclaimable) + " unreclaimable)");
+        term.PrintLine("Shmem    : " + Mib(mem.shmem) + "  Anon: " + Mib(mem.anon) + "  Mapped: " + Mib(mem.mapped));
+        term.PrintLine("Dirty    : " + Mib(mem.dirty) + "  Writeback: " + Mib(mem.writeback));
+        term.PrintLine("Swap     : " + (mem.swap_total ? Mib(mem.swap_used()) + " used of " + Mib(mem.swap_total) : std::string("none")));
+
+        RedTops::PressureSampler pressure;
+        pressure.Sample();
+        if (pressure.Get(RedTops::PressureSampler::Cpu).available) {
+            std::string psi = "\nPressure stall (% of time, avg10 / avg60 / avg300):";
+            char row[160];
+            for (int r = 0; r < RedTops::PressureSampler::kResources; ++r) {
+                auto res = static_cast<RedTops::PressureSampler::Resource>(r);
+                const RedTops::Pressure& p = pressure.Get(res);
+                std::snprintf(row, sizeof(row), "\n  %-7s some %6.2f %6.2f %6.2f   full %6.2f %6.2f %6.2f",
+                              RedTops::PressureSampler::Name(res), p.some.avg10, p.some.avg60, p.some.avg300,
+                              p.full.avg10, p.full.avg60, p.full.avg300);
+                psi += row;
+            }
+            term.PrintLine(psi);
+        } else {
+            term.PrintLine("Pressure stall information not available (kernel without PSI)");
+        }
+    #endif
+    }
 
-        term.PrintLine("Total RAM: " + std::to_string(total) + " MB");
-        term.PrintLine("Used RAM : " + std::to_string(total - free) + " MB");
-        term.PrintLine("Free RAM : " + std::to_string(free) + " MB");
+    // ===================== DISK I/O =====================
+    if (show_io) {
+        term.PrintLine("\n\033[1;34m=== Disk I/O ===\033[0m");
+    #ifdef _WIN32
+        term.PrintLine("Disk I/O rates are not implemented on Windows yet.");
+    #else
+        // Rates need two snapshots; a short window keeps the one-shot responsive
+        InterruptScope interrupt_scope;
+        RedTops::DiskSampler disks;
+        disks.Sample();
+        if (WaitInterval(0.5)) {
+            disks.Sample();
+            std::string out;
+            AppendDiskRows(out, disks.Disks(), true);
+            out.pop_back();
+            term.PrintLine(out + "\n" + Color::DIM + "(averaged over 0.5 s; sysinfo --watch for a live view)" + Color::RESET);
+        }
     #endif
     }
 
@@ -1,10 +1,13 @@
 #include "../headers/trace.hpp"
 #include "../../core/header/TerminalRenderer.hpp"
+#include "../../core/header/Exceptions.hpp"
+#include "../../modules/headers/ResultStore.hpp"
 
 #include <iostream>
 #include <string>
 #include <chrono>
 #include <cstring>
+#include <vector>
 
 #include <sys/socket.h>
 #include <arpa/inet.h>
@@ -59,6 +62,8 @@ void TraceCommand::Execute(const std::vector<std::string>& args) {
     socklen_t reply_len = sizeof(reply_addr);
 
     const int MAX_HOPS = 30;
+    auto started = std::chrono::system_clock::now();
+    std::vector<RedTops::ResultRow> hops;
 
     for (int ttl = 1; ttl <= MAX_HOPS; ++ttl) {
         // Set TTL
@@ -94,6 +99,7 @@ void TraceCommand::Execute(const std::vector<std::string>& args) {
         if (ready <= 0) {
             // Timeout — or unreachable hop
             renderer.PrintLine(std::to_string(ttl) + "   *  (timeout)");
+            hops.push_back({"*", static_cast<uint16_t>(ttl), RedTops::ResultStatus::Timeout, 0});
             continue;
         }
 
@@ -112,6 +118,7 @@ void TraceCommand::Execute(const std::vector<std::string>& args) {
             std::string(hopIP) + "   " +
             std::to_string(ms) + " ms"
         );
+        hops.push_back({hopIP, static_cast<uint16_t>(ttl), RedTops::ResultStatus::Up, static_cast<float>(ms)});
 
         // If we reached the destination, stop
         if (reply_addr.sin_addr.s_addr == dest.sin_addr.s_addr) {
@@ -121,5 +128,11 @@ void TraceCommand::Execute(const std::vector<std::string>& args) {
     }
 
     close(sock);
+
+    try {
+        RedTops::ResultStore().Append(RedTops::ResultKind::Trace, host, started, std::move(hops));
+    } catch (const RedTops::RedTopsException& e) {
+        renderer.PrintWarning(e.what());
+    }
 }
 
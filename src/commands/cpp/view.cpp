@@ -0,0 +1,372 @@
+#include "../headers/view.hpp"
+#include "../../core/header/TerminalRenderer.hpp"
+#include "../../core/header/Exceptions.hpp"
+#include "../../core/header/RecordEmitter.hpp"
+#include "../../modules/headers/FileView.hpp"
+#include "../../modules/headers/TextSearch.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t kMaxRendered = 64 * 1024;      // bytes of a line considered for display
+constexpr int kTabWidth = 8;
+
+enum Key {
+    kNone = -1,
+    kEscape = 27,
+    kUp = 1000, kDown, kLeft, kRight, kPageUp, kPageDown, kHome, kEnd
+};
+
+// Raw input and the alternate screen for the lifetime of the pager. ISIG
+// stays off, so Ctrl+C arrives as a key and quits like q.
+struct PagerTerminal {
+    termios saved{};
+    PagerTerminal() {
+        tcgetattr(STDIN_FILENO, &saved);
+        termios raw = saved;
+        raw.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+        raw.c_iflag &= ~(IXON | ICRNL);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+        std::cout << "\033[?1049h\033[?25l" << std::flush;
+    }
+    ~PagerTerminal() {
+        std::cout << "\033[?25h\033[?1049l" << std::flush;
+        tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+    }
+    PagerTerminal(const PagerTerminal&) = delete;
+    PagerTerminal& operator=(const PagerTerminal&) = delete;
+};
+
+bool ReadyWithin(int timeout_ms) {
+    struct pollfd pfd{STDIN_FILENO, POLLIN, 0};
+    return poll(&pfd, 1, timeout_ms) > 0;
+}
+
+// One key, or kNone after timeout_ms (-1 waits)
+int ReadKey(int timeout_ms) {
+    if (!ReadyWithin(timeout_ms)) return kNone;
+    unsigned char c;
+    if (read(STDIN_FILENO, &c, 1) != 1) return 'q';     // stdin closed
+    if (c != kEscape) return c;
+    // A lone Escape, or the start of a CSI sequence
+    unsigned char seq[3];
+    if (!ReadyWithin(30) || read(STDIN_FILENO, &seq[0], 1) != 1) return kEscape;
+    if (seq[0] != '[' && seq[0] != 'O') return kEscape;
+    if (!ReadyWithin(30) || read(STDIN_FILENO, &seq[1], 1) != 1) return kEscape;
+    switch (seq[1]) {
+        case 'A': return kUp;
+        case 'B': return kDown;
+        case 'C': return kRight;
+        case 'D': return kLeft;
+        case 'H': return kHome;
+        case 'F': return kEnd;
+    }
+    if (seq[1] >= '0' && seq[1] <= '9') {
+        if (!ReadyWithin(30) || read(STDIN_FILENO, &seq[2], 1) != 1 || seq[2] != '~') return kEscape;
+        switch (seq[1]) {
+            case '1': case '7': return kHome;
+            case '4': case '8': return kEnd;
+            case '5': return kPageUp;
+            case '6': return kPageDown;
+        }
+    }
+    return kNone;
+}
+
+void TerminalSize(int& rows, int& cols) {
+    winsize ws{};
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 1 && ws.ws_col > 0) {
+        rows = ws.ws_row;
+        cols = ws.ws_col;
+    } else {
+        rows = 24;
+        cols = 80;
+    }
+}
+
+// The visible columns [hscroll, hscroll + width) of a line: tabs expanded,
+// control bytes shown as '.', UTF-8 sequences kept whole, matches in reverse
+void RenderLine(std::string& out, std::string_view line, size_t hscroll, int width, const RedTops::TextMatcher* matcher) {
+    if (line.size() > kMaxRendered) line = line.substr(0, kMaxRendered);
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+    std::vector<std::pair<size_t, size_t>> hits;
+    if (matcher) {
+        size_t len = 0;
+        for (size_t at = 0; (at = matcher->Find(line.data(), line.size(), at, len)) != RedTops::kNoMatch;) {
+            hits.emplace_back(at, at + std::max<size_t>(len, 1));
+            if (matcher->IsRegex()) break;      // a regex only resumes at a line start
+            at += std::max<size_t>(len, 1);
+        }
+    }
+
+    size_t col = 0, hit = 0;
+    bool highlighted = false, shown = false;
+    const size_t end_col = hscroll + static_cast<size_t>(width);
+    for (size_t i = 0; i < line.size() && col < end_col; ++i) {
+        while (hit < hits.size() && i >= hits[hit].second) ++hit;
+        bool in_hit = hit < hits.size() && i >= hits[hit].first;
+        unsigned char c = static_cast<unsigned char>(line[i]);
+        if ((c & 0xC0) == 0x80) {               // continuation byte: follows its lead
+            if (shown) out += static_cast<char>(c);
+            continue;
+        }
+        size_t w = c == '\t' ? kTabWidth - col % kTabWidth : 1;
+        shown = col >= hscroll && col + w <= end_col;
+        if (shown) {
+            if (in_hit != highlighted) {
+                out += in_hit ? "\033[7m" : "\033[27m";
+                highlighted = in_hit;
+            }
+            if (c == '\t') out.append(w, ' ');
+            else if (c < 0x20 || c == 0x7f) out += '.';
+            else out += static_cast<char>(c);
+        }
+        col += w;
+    }
+    if (highlighted) out += "\033[27m";
+}
+
+class Pager {
+public:
+    Pager(RedTops::FileView& file, std::string name) : file_(file), name_(std::move(name)) {}
+
+    void Run() {
+        PagerTerminal terminal;
+        file_.StartIndexing();
+        RedTops::IndexProgress shown_progress;
+        bool dirty = true;
+        for (;;) {
+            TerminalSize(rows_, cols_);
+            if (Refresh()) dirty = true;
+            RedTops::IndexProgress progress = file_.Progress();
+            if (dirty || progress.bytes != shown_progress.bytes || progress.done != shown_progress.done) {
+                Draw(progress);
+                shown_progress = progress;
+                dirty = false;
+            }
+            int key = ReadKey(progress.done ? 500 : 150);
+            if (key == kNone) continue;
+            Refresh();
+            if (!Handle(key)) return;
+            dirty = true;
+        }
+    }
+
+private:
+    int Page() const { return std::max(1, rows_ - 1); }
+
+    // A file truncated under the pager is shown at its new size
+    bool Refresh() {
+        if (!file_.Refresh()) return false;
+        top_ = std::min(file_.LineStart(top_), EndTop());
+        message_ = "file shrank to " + std::to_string(file_.Size()) + " bytes";
+        return true;
+    }
+
+    // Top offset that puts the last line on the bottom row
+    uint64_t EndTop() const {
+        uint64_t size = file_.Size();
+        if (size == 0) return 0;
+        uint64_t last = file_.LineStart(file_.Data()[size - 1] == '\n' ? size - 1 : size);
+        for (int i = 1; i < Page() && last > 0; ++i) last = file_.PrevLine(last);
+        return last;
+    }
+
+    void Down(int lines) {
+        uint64_t limit = EndTop();
+        for (int i = 0; i < lines && top_ < limit; ++i) top_ = file_.NextLine(top_);
+        top_ = std::min(top_, limit);
+    }
+
+    void Up(int lines) {
+        for (int i = 0; i < lines && top_ > 0; ++i) top_ = file_.PrevLine(top_);
+    }
+
+    void Draw(const RedTops::IndexProgress& progress) {
+        std::string out;
+        out.reserve(static_cast<size_t>(rows_) * (static_cast<size_t>(cols_) + 16));
+        uint64_t offset = top_;
+        for (int row = 0; row < Page(); ++row) {
+            out += "\033[" + std::to_string(row + 1) + ";1H";
+            if (offset < file_.Size()) {
+                RenderLine(out, file_.Line(offset), hscroll_, cols_, matcher_.get());
+                offset = file_.NextLine(offset);
+            } else {
+                out += Color::DIM + "~" + Color::RESET;
+            }
+            out += "\033[K";
+        }
+
+        // Status: position, how far the index has got, then any message
+        std::string status = " " + name_;
+        uint64_t line;
+        if (file_.LineNumber(top_, line)) status += "  line " + std::to_string(line + 1);
+        if (progress.done) status += " of " + std::to_string(progress.lines);
+        uint64_t size = file_.Size();
+        status += "  " + std::to_string(size ? offset * 100 / size : 100) + "%";
+        if (!progress.done)
+            status += "  (indexing " + std::to_string(size ? progress.bytes * 100 / size : 100) + "%)";
+        if (hscroll_) status += "  col " + std::to_string(hscroll_ + 1);
+        status += "  " + (message_.empty() ? std::string("q quit  / ? search  n N next  : line or %") : message_) + " ";
+        if (status.size() > static_cast<size_t>(cols_)) status.resize(static_cast<size_t>(cols_));
+        out += "\033[" + std::to_string(rows_) + ";1H\033[7m" + status + "\033[K\033[0m";
+        std::cout << out << std::flush;
+        message_.clear();
+    }
+
+    void DrawStatus(const std::string& text) {
+        std::string s = text.substr(0, static_cast<size_t>(cols_));
+        std::cout << "\033[" << rows_ << ";1H\033[0m" << s << "\033[K" << std::flush;
+    }
+
+    // A line typed on the status row; false on Escape or Ctrl+C
+    bool Prompt(const std::string& label, std::string& text) {
+        text.clear();
+        std::cout << "\033[?25h";
+        for (;;) {
+            DrawStatus(label + text);
+            int key = ReadKey(-1);
+            if (key == '\r' || key == '\n') break;
+            if (key == kEscape || key == 3) {
+                std::cout << "\033[?25l" << std::flush;
+                return false;
+            }
+            if ((key == 127 || key == 8) && !text.empty()) text.pop_back();
+            else if (key >= 0x20 && key < 0x7f) text += static_cast<char>(key);
+        }
+        std::cout << "\033[?25l" << std::flush;
+        return true;
+    }
+
+    void Find(bool forward) {
+        if (!matcher_) {
+            message_ = "no previous search";
+            return;
+        }
+        DrawStatus("searching... (Esc to stop)");
+        bool stopped = false;
+        auto stop = [&] {
+            int key = ReadKey(0);
+            if (key == kEscape || key == 3) stopped = true;
+            return stopped;
+        };
+        size_t len = 0;
+        uint64_t from = forward ? file_.NextLine(top_) : top_;
+        uint64_t at = file_.Search(*matcher_, from, forward, len, stop);
+        if (at == RedTops::kNoMatch) {
+            if (Refresh()) return;
+            message_ = stopped ? "search stopped" : "pattern not found";
+            return;
+        }
+        top_ = std::min(file_.LineStart(at), EndTop());
+    }
+
+    // ":N" goes to line N, ":N%" to that share of the file
+    void Jump(const std::string& target) {
+        if (target.empty()) return;
+        char* end = nullptr;
+        double value = std::strtod(target.c_str(), &end);
+        if (end == target.c_str() || value < 0 || (*end && std::strcmp(end, "%") != 0)) {
+            message_ = "not a line number or percentage: " + target;
+            return;
+        }
+        if (*end == '%') {
+            uint64_t at = static_cast<uint64_t>(std::min(value, 100.0) / 100.0 * static_cast<double>(file_.Size()));
+            top_ = std::min(file_.LineStart(at), EndTop());
+            return;
+        }
+        uint64_t line = value >= 1 ? static_cast<uint64_t>(value) - 1 : 0;
+        uint64_t offset;
+        // A line beyond the indexed part waits for the indexer, which
+        // scans at memory speed
+        while (!file_.LineOffset(line, offset)) {
+            Refresh();
+            RedTops::IndexProgress p = file_.Progress();
+            if (p.done) {
+                message_ = "the file has only " + std::to_string(p.lines) + " lines";
+                return;
+            }
+            DrawStatus("indexing to line " + std::to_string(line + 1) + "... " +
+                       std::to_string(file_.Size() ? p.bytes * 100 / file_.Size() : 100) + "% (Esc to stop)");
+            int key = ReadKey(100);
+            if (key == kEscape || key == 3) return;
+        }
+        top_ = std::min(offset, EndTop());
+    }
+
+    // False to quit
+    bool Handle(int key) {
+        switch (key) {
+            case 'q': case 'Q': case 3: return false;
+            case 'j': case kDown: case '\r': case '\n': Down(1); break;
+            case 'k': case kUp: Up(1); break;
+            case ' ': case 'f': case kPageDown: case 6: Down(Page()); break;
+            case 'b': case kPageUp: case 2: Up(Page()); break;
+            case 'd': Down(Page() / 2); break;
+            case 'u': Up(Page() / 2); break;
+            case 'g': case '<': case kHome: top_ = 0; break;
+            case 'G': case '>': case kEnd: top_ = EndTop(); break;
+            case kRight: hscroll_ += static_cast<size_t>(cols_ / 2); break;
+            case kLeft: hscroll_ -= std::min(hscroll_, static_cast<size_t>(cols_ / 2)); break;
+            case '/': case '?': {
+                std::string pattern;
+                if (!Prompt(key == '/' ? "/" : "?", pattern) || pattern.empty()) break;
+                try {
+                    matcher_ = std::make_unique<RedTops::TextMatcher>(std::vector<std::string>{pattern}, false, false);
+                } catch (const RedTops::CommandError& e) {
+                    message_ = e.what();
+                    break;
+                }
+                forward_ = key == '/';
+                Find(forward_);
+                break;
+            }
+            case 'n': Find(forward_); break;
+            case 'N': Find(!forward_); break;
+            case ':': {
+                std::string target;
+                if (Prompt(":", target)) Jump(target);
+                break;
+            }
+        }
+        return true;
+    }
+
+    RedTops::FileView& file_;
+    std::string name_;
+    std::unique_ptr<RedTops::TextMatcher> matcher_;
+    bool forward_ = true;
+    uint64_t top_ = 0;
+    size_t hscroll_ = 0;
+    int rows_ = 24;
+    int cols_ = 80;
+    std::string message_;
+};
+
+} // namespace
+
+void ViewCommand::Execute(const std::vector<std::string>& args) {
+    const std::string usage = "view: usage: view <file>";
+    if (args.size() != 1 || args[0].empty() || args[0][0] == '-') throw RedTops::CommandError(usage);
+    if (RecordEmitter::Instance().Active() || !isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO))
+        throw RedTops::CommandError("view: needs an interactive terminal; use cat to print a file");
+
+    RedTops::FileView file(args[0]);
+    Pager(file, args[0]).Run();
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "../../core/header/Command.hpp"
+#include <string>
+#include <vector>
+
+class ExporterCommand : public Command {
+public:
+    void Execute(const std::vector<std::string>& args) override;
+    std::string Name() const override { return "exporter"; }
+};
@@ -22,6 +22,7 @@ class LsCommand : public Command {
 public:
     void Execute(const std::vector<std::string>& args) override;
     std::string Name() const override { return "ls"; }
+    bool EmitsRecords() const override { return true; }
     ~LsCommand() override = default;
 };
 
@@ -43,6 +44,7 @@ class RmCommand : public Command {
 public:
     void Execute(const std::vector<std::string>& args) override;
     std::string Name() const override { return "rm"; }
+    bool EmitsRecords() const override { return true; }
     ~RmCommand() override = default;
 };
 
@@ -50,6 +52,7 @@ class CpCommand : public Command {
 public:
     void Execute(const std::vector<std::string>& args) override;
     std::string Name() const override { return "cp"; }
+    bool EmitsRecords() const override { return true; }
     ~CpCommand() override = default;
 };
 
@@ -57,6 +60,15 @@ class MvCommand : public Command {
 public:
     void Execute(const std::vector<std::string>& args) override;
     std::string Name() const override { return "mv"; }
+    bool EmitsRecords() const override { return true; }
     ~MvCommand() override = default;
 };
 
+
+class DuCommand : public Command {
+public:
+    void Execute(const std::vector<std::string>& args) override;
+    std::string Name() const override { return "du"; }
+    bool EmitsRecords() const override { return true; }
+    ~DuCommand() override = default;
+};
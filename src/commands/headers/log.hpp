@@ -0,0 +1,17 @@
+#pragma once
+
+#include "../../core/header/Command.hpp"
+#include <string>
+#include <vector>
+
+// `log` follows by default; registered as `tail` it follows only with -f/-F
+class LogCommand : public Command {
+public:
+    explicit LogCommand(bool follow_by_default) : follow_by_default_(follow_by_default) {}
+    void Execute(const std::vector<std::string>& args) override;
+    std::string Name() const override { return follow_by_default_ ? "log" : "tail"; }
+    bool EmitsRecords() const override { return true; }
+
+private:
+    bool follow_by_default_;
+};
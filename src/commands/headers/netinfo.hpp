@@ -8,4 +8,5 @@ class NetInfoCommand : public Command {
 public:
     void Execute(const std::vector<std::string>& args) override;
     std::string Name() const override { return "netinfo"; } // <- implement the pure virtual
+    bool EmitsRecords() const override { return true; }
 };
@@ -5,5 +5,6 @@
 class PortScanCommand : public Command {
 public:
     std::string Name() const override { return "portscan"; }
+    bool EmitsRecords() const override { return true; }
     void Execute(const std::vector<std::string>& args) override;
 };
@@ -9,5 +9,6 @@ public:
     SniffCommand();
     void Execute(const std::vector<std::string>& args) override;
     std::string Name() const override { return "sniff"; }
+    bool EmitsRecords() const override { return true; }
     ~SniffCommand() override = default;
 };
\ No newline at end of file
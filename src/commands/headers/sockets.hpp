@@ -0,0 +1,12 @@
+#pragma once
+
+#include "../../core/header/Command.hpp"
+#include <string>
+#include <vector>
+
+class SocketsCommand : public Command {
+public:
+    void Execute(const std::vector<std::string>& args) override;
+    std::string Name() const override { return "sockets"; }
+    bool EmitsRecords() const override { return true; }
+};
@@ -0,0 +1,210 @@
+#include "../header/RecordEmitter.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+
+namespace {
+constexpr size_t kBufferSize = 64 * 1024;
+}
+
+bool ParseOutputFormat(std::string_view name, OutputFormat& format) {
+    if (name == "json") format = OutputFormat::Json;
+    else if (name == "ndjson" || name == "jsonl") format = OutputFormat::Ndjson;
+    else if (name == "csv") format = OutputFormat::Csv;
+    else if (name == "text") format = OutputFormat::Text;
+    else return false;
+    return true;
+}
+
+RecordEmitter& RecordEmitter::Instance() {
+    static RecordEmitter instance;
+    return instance;
+}
+
+RecordEmitter::RecordEmitter() : buf_(kBufferSize) {}
+
+void RecordEmitter::Begin(OutputFormat format) {
+    format_ = format;
+    len_ = 0;
+    broken_ = false;
+    records_ = 0;
+    header_.clear();
+}
+
+void RecordEmitter::End() {
+    if (format_ == OutputFormat::Json) {
+        if (records_ == 0) Put("[", 1);
+        Put("\n]\n", 3);
+    }
+    Flush();
+    format_ = OutputFormat::Text;
+}
+
+void RecordEmitter::Put(const char* data, size_t n) {
+    while (n) {
+        if (len_ == buf_.size()) Flush();
+        size_t chunk = std::min(n, buf_.size() - len_);
+        std::memcpy(buf_.data() + len_, data, chunk);
+        len_ += chunk;
+        data += chunk;
+        n -= chunk;
+    }
+}
+
+void RecordEmitter::Flush() {
+    size_t off = 0;
+    while (off < len_ && !broken_) {
+        ssize_t n = write(STDOUT_FILENO, buf_.data() + off, len_ - off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            broken_ = true;    // EPIPE when piped into head(1), or a full disk
+            break;
+        }
+        off += static_cast<size_t>(n);
+    }
+    len_ = 0;
+}
+
+RecordEmitter& RecordEmitter::Record(std::string_view type) {
+    if (format_ == OutputFormat::Csv) {
+        row_.clear();
+        keys_.assign("type");
+        String(type);
+        return *this;
+    }
+    if (format_ == OutputFormat::Json) Put(records_ ? ",\n" : "[\n", 2);
+    Put("{\"type\":", 8);
+    String(type);
+    return *this;
+}
+
+void RecordEmitter::Commit() {
+    ++records_;
+    if (format_ == OutputFormat::Csv) {
+        if (keys_ != header_) {
+            header_ = keys_;
+            Put(header_.data(), header_.size());
+            Put('\n');
+        }
+        Put(row_.data(), row_.size());
+        Put('\n');
+        return;
+    }
+    if (format_ == OutputFormat::Ndjson) Put("}\n", 2);
+    else Put('}');
+}
+
+void RecordEmitter::Key(std::string_view key) {
+    if (format_ == OutputFormat::Csv) {
+        keys_ += ',';
+        keys_.append(key);
+        row_ += ',';
+        return;
+    }
+    // Keys are identifiers chosen by commands; they never need escaping
+    Put(",\"", 2);
+    Put(key.data(), key.size());
+    Put("\":", 2);
+}
+
+void RecordEmitter::Number(const char* text, size_t len) {
+    if (format_ == OutputFormat::Csv) row_.append(text, len);
+    else Put(text, len);
+}
+
+void RecordEmitter::String(std::string_view value) {
+    if (format_ == OutputFormat::Csv) {
+        if (value.find_first_of(",\"\r\n") == std::string_view::npos) {
+            row_.append(value);
+            return;
+        }
+        row_ += '"';
+        for (char c : value) {
+            if (c == '"') row_ += '"';
+            row_ += c;
+        }
+        row_ += '"';
+        return;
+    }
+
+    Put('"');
+    size_t run = 0;   // unescaped bytes are copied in runs, not one by one
+    for (size_t i = 0; i < value.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(value[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        Put(value.data() + run, i - run);
+        run = i + 1;
+        switch (c) {
+            case '"':  Put("\\\"", 2); break;
+            case '\\': Put("\\\\", 2); break;
+            case '\n': Put("\\n", 2); break;
+            case '\r': Put("\\r", 2); break;
+            case '\t': Put("\\t", 2); break;
+            default: {
+                static const char kHex[] = "0123456789abcdef";
+                const char esc[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 15]};
+                Put(esc, 6);
+            }
+        }
+    }
+    Put(value.data() + run, value.size() - run);
+    Put('"');
+}
+
+RecordEmitter& RecordEmitter::Field(std::string_view key, std::string_view value) {
+    Key(key);
+    String(value);
+    return *this;
+}
+
+RecordEmitter& RecordEmitter::Field(std::string_view key, double value) {
+    Key(key);
+    if (!std::isfinite(value)) {
+        if (format_ != OutputFormat::Csv) Put("null", 4);
+        return *this;
+    }
+    char text[32];
+    auto res = std::to_chars(text, text + sizeof(text), value);
+    Number(text, static_cast<size_t>(res.ptr - text));
+    return *this;
+}
+
+RecordEmitter& RecordEmitter::Field(std::string_view key, bool value) {
+    Key(key);
+    Number(value ? "true" : "false", value ? 4 : 5);
+    return *this;
+}
+
+RecordEmitter& RecordEmitter::Signed(std::string_view key, int64_t value) {
+    Key(key);
+    char text[24];
+    auto res = std::to_chars(text, text + sizeof(text), value);
+    Number(text, static_cast<size_t>(res.ptr - text));
+    return *this;
+}
+
+RecordEmitter& RecordEmitter::Unsigned(std::string_view key, uint64_t value) {
+    Key(key);
+    char text[24];
+    auto res = std::to_chars(text, text + sizeof(text), value);
+    Number(text, static_cast<size_t>(res.ptr - text));
+    return *this;
+}
+
+StructuredOutputScope::StructuredOutputScope(OutputFormat format) {
+    if (format == OutputFormat::Text) return;
+    std::cout.flush();
+    saved_ = std::cout.rdbuf(std::cerr.rdbuf());
+    RecordEmitter::Instance().Begin(format);
+}
+
+StructuredOutputScope::~StructuredOutputScope() {
+    if (!saved_) return;
+    RecordEmitter::Instance().End();
+    std::cout.rdbuf(saved_);
+}
@@ -3,6 +3,7 @@
 #include "../header/CommandParser.hpp"
 #include "../header/Exceptions.hpp" // Include custom exceptions
 #include "../header/ConfigLoader.hpp" // Include ConfigLoader for configuration management
+#include "../header/RecordEmitter.hpp"
 #include "../../commands/headers/ping.hpp"
 #include "../../commands/headers/sysinfo.hpp"
 #include "../../commands/headers/netinfo.hpp"
@@ -12,6 +13,13 @@
 #include "../../commands/headers/portscan.hpp"
 #include "../../commands/headers/netscan.hpp"
 #include "../../commands/headers/sniff.hpp" // Include the new sniff command header
+#include "../../commands/headers/sockets.hpp"
+#include "../../commands/headers/exporter.hpp"
+#include "../../commands/headers/results.hpp"
+#include "../../commands/headers/search.hpp"
+#include "../../commands/headers/hash.hpp"
+#include "../../commands/headers/log.hpp"
+#include "../../commands/headers/view.hpp"
 #include <iostream>
 #include <fstream>
 #include <thread>
@@ -21,6 +29,7 @@
 #include <unistd.h>
 #include <algorithm>
 #include <filesystem>
+#include <optional>
 #include <signal.h>
 #include <cstring>
 #include <sys/ioctl.h>
@@ -114,10 +123,13 @@ void Shell::RegisterBuiltins() {
     CommandRegistry::Instance().Register("ping", std::make_unique<PingCommand>());
     CommandRegistry::Instance().Register("sysinfo", std::make_unique<SysInfoCommand>());
     CommandRegistry::Instance().Register("netinfo", std::make_unique<NetInfoCommand>());
+    CommandRegistry::Instance().Register("sockets", std::make_unique<SocketsCommand>());
+    CommandRegistry::Instance().Register("exporter", std::make_unique<ExporterCommand>());
     CommandRegistry::Instance().Register("trace", std::make_unique<TraceCommand>());
     CommandRegistry::Instance().Register("netscan", std::make_unique<NetScanCommand>());
     CommandRegistry::Instance().Register("sniff", std::make_unique<SniffCommand>());
     CommandRegistry::Instance().Register("portscan", std::make_unique<PortScanCommand>());
+    CommandRegistry::Instance().Register("results", std::make_unique<ResultsCommand>());
     CommandRegistry::Instance().Register("exit", std::make_unique<ExitCommand>(this));
     CommandRegistry::Instance().Register("pwd", std::make_unique<PwdCommand>());
     CommandRegistry::Instance().Register("cd", std::make_unique<CdCommand>());
@@ -127,6 +139,12 @@ void Shell::RegisterBuiltins() {
     CommandRegistry::Instance().Register("rm", std::make_unique<RmCommand>());
     CommandRegistry::Instance().Register("cp", std::make_unique<CpCommand>());
     CommandRegistry::Instance().Register("mv", std::make_unique<MvCommand>());
+    CommandRegistry::Instance().Register("du", std::make_unique<DuCommand>());
+    CommandRegistry::Instance().Register("search", std::make_unique<SearchCommand>());
+    CommandRegistry::Instance().Register("hash", std::make_unique<HashCommand>());
+    CommandRegistry::Instance().Register("log", std::make_unique<LogCommand>(true));
+    CommandRegistry::Instance().Register("tail", std::make_unique<LogCommand>(false));
+    CommandRegistry::Instance().Register("view", std::make_unique<ViewCommand>());
 
     class ClearCommand : public Command {
     public:
@@ -203,6 +221,57 @@ void Shell::Start(const char* argv0) {
 
 void Shell::Stop() { running_ = false; }
 
+int Shell::RunOnce(const std::vector<std::string>& tokens) {
+    RegisterBuiltins();
+    if (tokens.empty()) return 0;
+    return Dispatch(tokens) ? 0 : 1;
+}
+
+bool Shell::Dispatch(std::vector<std::string> tokens) {
+    // Outlives the handlers below, so an error under --output is printed
+    // while std::cout still points at stderr and never lands among records
+    std::optional<StructuredOutputScope> output;
+    try {
+        // --output goes before the command name, so nothing among the
+        // command's own arguments is ever taken for it
+        OutputFormat format = OutputFormat::Text;
+        size_t first = 0;
+        while (first < tokens.size()) {
+            std::string value;
+            if (tokens[first] == "--output" && first + 1 < tokens.size()) {
+                value = tokens[first + 1];
+                first += 2;
+            } else if (tokens[first].rfind("--output=", 0) == 0) {
+                value = tokens[first].substr(9);
+                first += 1;
+            } else {
+                break;
+            }
+            if (!ParseOutputFormat(value, format))
+                throw RedTops::CommandError("--output: expected json, ndjson or csv, got " + value);
+        }
+        if (first == tokens.size() || tokens[first] == "--output")
+            throw RedTops::CommandError("usage: --output json|ndjson|csv <command> [args...]");
+        tokens.erase(tokens.begin(), tokens.begin() + static_cast<long>(first));
+
+        auto* cmd = CommandRegistry::Instance().Get(tokens[0]);
+        // Without records there would be nothing but an empty document
+        if (format != OutputFormat::Text && !cmd->EmitsRecords())
+            throw RedTops::CommandError(tokens[0] + ": --output is not supported; it writes no records");
+        tokens.erase(tokens.begin());
+        output.emplace(format);
+        cmd->Execute(tokens);
+        return true;
+    } catch (const RedTops::RedTopsException& e) {
+        TerminalRenderer::Instance().PrintError(e.what());
+    } catch (const std::exception& e) {
+        TerminalRenderer::Instance().PrintError("Unhandled standard exception: " + std::string(e.what()));
+    } catch (...) {
+        TerminalRenderer::Instance().PrintError("An unknown error occurred during command execution.");
+    }
+    return false;
+}
+
 std::string Shell::ApplyAliases(const std::string& input) {
     auto tokens = CommandParser::Tokenize(input);
     if (tokens.empty()) return input;
@@ -303,18 +372,7 @@ void Shell::MainLoop() {
             while (std::getline(ss, part, ';')) {
                 auto tokens = CommandParser::Tokenize(part);
                 if (tokens.empty()) continue;
-                
-                try {
-                    auto* cmd = CommandRegistry::Instance().Get(tokens[0]);
-                    tokens.erase(tokens.begin());
-                    cmd->Execute(tokens);
-                } catch (const RedTops::RedTopsException& e) {
-                    TerminalRenderer::Instance().PrintError(e.what());
-                } catch (const std::exception& e) {
-                    TerminalRenderer::Instance().PrintError("Unhandled standard exception: " + std::string(e.what()));
-                } catch (...) {
-                    TerminalRenderer::Instance().PrintError("An unknown error occurred during command execution.");
-                }
+                Dispatch(std::move(tokens));
             }
             std::cout << std::flush;
         }
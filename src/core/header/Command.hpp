@@ -8,5 +8,7 @@ public:
     virtual ~Command() = default;
     virtual std::string Name() const = 0;
     virtual std::string Help() const { return "(no help)"; }
+    // True if the command writes records under --output json|ndjson|csv
+    virtual bool EmitsRecords() const { return false; }
     virtual void Execute(const std::vector<std::string>& args) = 0;
 };
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+enum class OutputFormat { Text, Json, Ndjson, Csv };
+
+// "json", "ndjson" or "csv" (and "text"); false for anything else
+bool ParseOutputFormat(std::string_view name, OutputFormat& format);
+
+// Structured output for `--output json|ndjson|csv`.
+//
+// Commands describe results as flat records instead of formatted lines:
+//
+//     auto& out = RecordEmitter::Instance();
+//     if (out.Active()) out.Record("port").Field("host", host).Field("port", p).Commit();
+//
+// Fields are serialized straight into one fixed output buffer — numbers with
+// to_chars, strings escaped in place — and the buffer goes to stdout with
+// write(2) only when it fills and when the command finishes, so emitting a
+// record does no per-field allocation. While a structured command runs the
+// shell points std::cout at stderr, so human-readable progress never mixes
+// with the records on stdout.
+//
+// Not thread-safe: commands with worker threads emit under their own lock.
+class RecordEmitter {
+public:
+    static RecordEmitter& Instance();
+
+    RecordEmitter(const RecordEmitter&) = delete;
+    RecordEmitter& operator=(const RecordEmitter&) = delete;
+
+    bool Active() const { return format_ != OutputFormat::Text; }
+    OutputFormat Format() const { return format_; }
+
+    // Bracket one command; End() closes the JSON array and flushes
+    void Begin(OutputFormat format);
+    void End();
+
+    RecordEmitter& Record(std::string_view type);
+    RecordEmitter& Field(std::string_view key, std::string_view value);
+    RecordEmitter& Field(std::string_view key, const char* value) { return Field(key, std::string_view(value)); }
+    RecordEmitter& Field(std::string_view key, const std::string& value) { return Field(key, std::string_view(value)); }
+    RecordEmitter& Field(std::string_view key, double value);
+    RecordEmitter& Field(std::string_view key, bool value);
+    template <typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+    RecordEmitter& Field(std::string_view key, T value) {
+        if constexpr (std::is_signed_v<T>) return Signed(key, static_cast<int64_t>(value));
+        else return Unsigned(key, static_cast<uint64_t>(value));
+    }
+    void Commit();
+
+    void Flush();
+    // The reader went away (EPIPE); further records are dropped
+    bool Broken() const { return broken_; }
+    uint64_t Records() const { return records_; }
+
+private:
+    RecordEmitter();
+
+    RecordEmitter& Signed(std::string_view key, int64_t value);
+    RecordEmitter& Unsigned(std::string_view key, uint64_t value);
+    void Key(std::string_view key);
+    void Number(const char* text, size_t len);
+    void String(std::string_view value);
+
+    void Put(char c) {
+        if (len_ == buf_.size()) Flush();
+        buf_[len_++] = c;
+    }
+    void Put(const char* data, size_t n);
+
+    OutputFormat format_ = OutputFormat::Text;
+    std::vector<char> buf_;
+    size_t len_ = 0;
+    bool broken_ = false;
+    uint64_t records_ = 0;
+
+    // CSV rows are staged so the header can be written ahead of them; a
+    // header line is repeated whenever the record shape changes
+    std::string row_;
+    std::string keys_;
+    std::string header_;
+};
+
+// While a command runs with --output, records own stdout and every
+// human-readable line (renderer output, progress, errors) goes to stderr.
+// Text leaves both alone.
+class StructuredOutputScope {
+public:
+    explicit StructuredOutputScope(OutputFormat format);
+    ~StructuredOutputScope();
+
+    StructuredOutputScope(const StructuredOutputScope&) = delete;
+    StructuredOutputScope& operator=(const StructuredOutputScope&) = delete;
+
+private:
+    std::streambuf* saved_ = nullptr;
+};
@@ -6,6 +6,7 @@
 #include <string>
 #include <filesystem> // For path manipulation
 #include <fstream>    // For file I/O
+#include <atomic>     // For the interrupt flag
 #include <pcap.h>     // For pcap_t type
 
 class Shell {
@@ -21,6 +22,10 @@ public:
     void Start(const char* argv0);
     void Stop();
 
+    // Runs one command line without the interactive loop (`redtops --output ndjson sockets -l`).
+    // Returns 0 on success, 1 if the command failed.
+    int RunOnce(const std::vector<std::string>& tokens);
+
     std::string GetPromptString() const;
 
 private:
@@ -42,6 +47,7 @@ private:
 
     void RegisterBuiltins();
     void MainLoop();
+    bool Dispatch(std::vector<std::string> tokens);   // strips --output, runs, reports errors
     void LoadHistory();
     void SaveHistory();
 
@@ -50,10 +56,28 @@ private:
     std::string TabComplete(const std::string& prefix); // completes command names starting with prefix
 
     pcap_t* current_pcap_handle_ = nullptr; // For managing active sniffing
+    std::atomic<bool> interruptible_{false};        // A long-running command is in the foreground
+    std::atomic<bool> interrupt_requested_{false};  // Ctrl+C arrived while it was running
 
 public: // Make these public so SniffCommand can access them
     void SetCurrentPcapHandle(pcap_t* handle) { current_pcap_handle_ = handle; }
     void ClearCurrentPcapHandle() { current_pcap_handle_ = nullptr; }
     pcap_t* GetCurrentPcapHandle() const { return current_pcap_handle_; }
+
+    // Cooperative cancellation for commands that run worker threads or loops.
+    // The signal handler only flips a flag; the command polls InterruptRequested().
+    void BeginInterruptible() { interrupt_requested_ = false; interruptible_ = true; }
+    void EndInterruptible() { interruptible_ = false; }
+    bool IsInterruptible() const { return interruptible_; }
+    void RequestInterrupt() { interrupt_requested_ = true; }
+    bool InterruptRequested() const { return interrupt_requested_; }
+};
+
+// Marks the enclosing scope as cancellable by Ctrl+C without stopping the shell
+struct InterruptScope {
+    InterruptScope() { Shell::Instance().BeginInterruptible(); }
+    ~InterruptScope() { Shell::Instance().EndInterruptible(); }
+    InterruptScope(const InterruptScope&) = delete;
+    InterruptScope& operator=(const InterruptScope&) = delete;
 };
 
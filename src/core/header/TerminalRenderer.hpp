@@ -57,6 +57,24 @@ public:
         std::cout << "\033[2J\033[H" << std::flush;
     }
 
+    // Repaints a live view in place: cursor home, each line cleared to its end,
+    // then everything below the frame erased. One write per frame, no flicker.
+    void DrawFrame(const std::string& frame) {
+        std::string out;
+        out.reserve(frame.size() + 64);
+        out += "\033[H";
+        size_t start = 0;
+        while (start < frame.size()) {
+            size_t eol = frame.find('\n', start);
+            if (eol == std::string::npos) eol = frame.size();
+            out.append(frame, start, eol - start);
+            out += "\033[K\n";
+            start = eol + 1;
+        }
+        out += "\033[J";
+        std::cout << out << std::flush;
+    }
+
     void DrawBootScreen(const std::string& screen) {
         Clear();
         // Print the boot screen in Cyan for that high-tech feel
@@ -1,6 +1,10 @@
 #include "core/header/Shell.hpp"
+#include "commands/headers/exporter.hpp"
 #include <csignal>
+#include <cstring>
 #include <iostream>
+#include <string>
+#include <vector>
 #include <pcap.h> // Required for pcap_breakloop
 
 void SignalHandler(int signum) {
@@ -9,6 +13,11 @@ void SignalHandler(int signum) {
     if (handle != nullptr) {
         pcap_breakloop(handle);
     }
+    // Ctrl+C cancels a long-running command instead of taking the shell down with it
+    if (Shell::Instance().IsInterruptible()) {
+        Shell::Instance().RequestInterrupt();
+        if (signum == SIGINT) return;
+    }
     Shell::Instance().Stop();
 }
 
@@ -16,6 +25,31 @@ int main(int argc, char** argv) {
     // Setup signal listeners
     std::signal(SIGINT, SignalHandler);  // Catch Ctrl+C
     std::signal(SIGTERM, SignalHandler); // Catch kill commands
+    std::signal(SIGPIPE, SIG_IGN);       // a closed pipe surfaces as EPIPE instead of killing the shell
+
+    // `redtops --exporter :9100 [exporter options]` serves metrics without the interactive shell
+    if (argc > 1 && std::strcmp(argv[1], "--exporter") == 0) {
+        std::vector<std::string> args(argv + 1, argv + argc);
+        try {
+            ExporterCommand().Execute(args);
+        } catch (const std::exception& e) {
+            TerminalRenderer::Instance().PrintError(e.what());
+            return 1;
+        }
+        return 0;
+    }
+
+    // `redtops --output json|ndjson|csv <command> [args]` runs one command for a pipeline
+    if (argc > 1 && (std::strcmp(argv[1], "--output") == 0 || std::strncmp(argv[1], "--output=", 9) == 0)) {
+        bool separate = std::strcmp(argv[1], "--output") == 0;
+        int first = separate ? 3 : 2;
+        bool has_format = separate ? argc > 2 : argv[1][9] != '\0';
+        if (!has_format || first >= argc) {
+            TerminalRenderer::Instance().PrintError("usage: redtops --output json|ndjson|csv <command> [args...]");
+            return 1;
+        }
+        return Shell::Instance().RunOnce(std::vector<std::string>(argv + 1, argv + argc));
+    }
 
     Shell::Instance().Start(argv[0]);
 
@@ -0,0 +1,326 @@
+#include "../headers/CaptureIndex.hpp"
+#include "../headers/PacketDissector.hpp"
+#include "../headers/PcapFile.hpp"
+#include "../../core/header/Exceptions.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace RedTops {
+
+namespace {
+
+// On-disk layout, host byte order:
+//   header (48 bytes) | blocks (32 bytes each) | flows (16 bytes each, sorted by hash) | postings (u32 block ids)
+constexpr char kMagic[8] = {'R', 'T', 'I', 'D', 'X', '0', '1', '\n'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 48;
+constexpr size_t kBlockEntrySize = 32;
+constexpr size_t kFlowEntrySize = 16;
+
+template <typename T>
+inline T Load(const uint8_t* p) {
+    T v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+template <typename T>
+inline void Append(std::vector<uint8_t>& out, T v) {
+    const auto* p = reinterpret_cast<const uint8_t*>(&v);
+    out.insert(out.end(), p, p + sizeof(v));
+}
+
+uint32_t HashEndpoints(const uint8_t* a, uint16_t pa, const uint8_t* b, uint16_t pb, size_t alen) {
+    // Order the two endpoints so both directions hash alike
+    int cmp = std::memcmp(a, b, alen);
+    if (cmp > 0 || (cmp == 0 && pa > pb)) {
+        std::swap(a, b);
+        std::swap(pa, pb);
+    }
+    uint32_t h = 2166136261u;  // FNV-1a
+    auto mix = [&h](const uint8_t* p, size_t n) {
+        for (size_t i = 0; i < n; ++i) { h ^= p[i]; h *= 16777619u; }
+    };
+    mix(a, alen);
+    mix(reinterpret_cast<const uint8_t*>(&pa), 2);
+    mix(b, alen);
+    mix(reinterpret_cast<const uint8_t*>(&pb), 2);
+    return h ? h : 1;  // 0 means "no flow"
+}
+
+void ParseEndpoint(const std::string& text, const std::string& whole, FlowFilter& f, int side) {
+    std::string host, port;
+    if (!text.empty() && text[0] == '[') {
+        size_t close = text.find(']');
+        if (close == std::string::npos || close + 1 >= text.size() || text[close + 1] != ':')
+            throw CommandError("invalid flow endpoint: " + text);
+        host = text.substr(1, close - 1);
+        port = text.substr(close + 2);
+    } else {
+        size_t colon = text.rfind(':');
+        if (colon == std::string::npos) throw CommandError("flow endpoint needs a port: " + text);
+        host = text.substr(0, colon);
+        port = text.substr(colon + 1);
+    }
+
+    bool v6 = host.find(':') != std::string::npos;
+    if (side == 1 && v6 != f.ipv6) throw CommandError("flow mixes IPv4 and IPv6: " + whole);
+    f.ipv6 = v6;
+    if (inet_pton(v6 ? AF_INET6 : AF_INET, host.c_str(), f.addr[side]) != 1)
+        throw CommandError("invalid address in flow: " + host);
+
+    try {
+        size_t used = 0;
+        int p = std::stoi(port, &used);
+        if (used != port.size() || p < 0 || p > 65535) throw std::out_of_range(port);
+        f.port[side] = static_cast<uint16_t>(p);
+    } catch (const std::exception&) {
+        throw CommandError("invalid port in flow: " + port);
+    }
+}
+
+} // namespace
+
+FlowFilter ParseFlowFilter(const std::string& text) {
+    size_t dash = text.find('-');
+    if (dash == std::string::npos)
+        throw CommandError("flow must look like addr:port-addr:port, got: " + text);
+    FlowFilter f;
+    ParseEndpoint(text.substr(0, dash), text, f, 0);
+    ParseEndpoint(text.substr(dash + 1), text, f, 1);
+    return f;
+}
+
+bool FlowFilter::Matches(const DissectedPacket& pkt) const {
+    if ((pkt.flags & DissectFlag::HasPorts) == 0) return false;
+    if (pkt.l3 != (ipv6 ? L3Proto::IPv6 : L3Proto::IPv4)) return false;
+    size_t alen = ipv6 ? 16 : 4;
+    auto same = [&](const uint8_t* a, uint16_t pa, const uint8_t* b, uint16_t pb) {
+        return std::memcmp(a, addr[0], alen) == 0 && pa == port[0] &&
+               std::memcmp(b, addr[1], alen) == 0 && pb == port[1];
+    };
+    return same(pkt.src_addr, pkt.src_port, pkt.dst_addr, pkt.dst_port) ||
+           same(pkt.dst_addr, pkt.dst_port, pkt.src_addr, pkt.src_port);
+}
+
+uint32_t FlowFilter::Hash() const {
+    return HashEndpoints(addr[0], port[0], addr[1], port[1], ipv6 ? 16 : 4);
+}
+
+uint32_t PacketFlowHash(const DissectedPacket& pkt) {
+    if ((pkt.flags & DissectFlag::HasPorts) == 0) return 0;
+    if (pkt.l3 != L3Proto::IPv4 && pkt.l3 != L3Proto::IPv6) return 0;
+    return HashEndpoints(pkt.src_addr, pkt.src_port, pkt.dst_addr, pkt.dst_port, pkt.l3 == L3Proto::IPv6 ? 16 : 4);
+}
+
+// ---------------- Builder ----------------
+
+void CaptureIndexBuilder::Add(uint64_t offset, uint64_t ts_ns, uint32_t flow_hash) {
+    if (blocks_.empty() || offset - blocks_.back().offset >= kBlockBytes) {
+        blocks_.push_back(Block{offset, ts_ns, ts_ns, 0, 0});
+    }
+    Block& b = blocks_.back();
+    b.first_ns = std::min(b.first_ns, ts_ns);
+    b.last_ns = std::max(b.last_ns, ts_ns);
+    b.packets++;
+
+    if (flow_hash) {
+        auto id = static_cast<uint32_t>(blocks_.size() - 1);
+        auto& list = postings_[flow_hash];
+        if (list.empty() || list.back() != id) list.push_back(id);
+    }
+}
+
+void CaptureIndexBuilder::Write(const std::string& index_path, uint64_t pcap_size, int64_t pcap_mtime_ns) const {
+    std::vector<uint32_t> hashes;
+    hashes.reserve(postings_.size());
+    uint64_t posting_count = 0;
+    for (const auto& [hash, list] : postings_) {
+        hashes.push_back(hash);
+        posting_count += list.size();
+    }
+    std::sort(hashes.begin(), hashes.end());
+
+    std::vector<uint8_t> out;
+    out.reserve(kHeaderSize + blocks_.size() * kBlockEntrySize + hashes.size() * kFlowEntrySize + posting_count * 4);
+    out.insert(out.end(), kMagic, kMagic + sizeof(kMagic));
+    Append<uint32_t>(out, kVersion);
+    Append<uint32_t>(out, kBlockBytes);
+    Append<uint64_t>(out, pcap_size);
+    Append<int64_t>(out, pcap_mtime_ns);
+    Append<uint32_t>(out, static_cast<uint32_t>(blocks_.size()));
+    Append<uint32_t>(out, static_cast<uint32_t>(hashes.size()));
+    Append<uint64_t>(out, posting_count);
+
+    for (const Block& b : blocks_) {
+        Append(out, b.offset);
+        Append(out, b.first_ns);
+        Append(out, b.last_ns);
+        Append(out, b.packets);
+        Append(out, b.reserved);
+    }
+    uint64_t start = 0;
+    for (uint32_t hash : hashes) {
+        const auto& list = postings_.at(hash);
+        Append<uint32_t>(out, hash);
+        Append<uint32_t>(out, static_cast<uint32_t>(list.size()));
+        Append<uint64_t>(out, start);
+        start += list.size();
+    }
+    for (uint32_t hash : hashes)
+        for (uint32_t id : postings_.at(hash)) Append(out, id);
+
+    std::string tmp = index_path + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) throw CommandError("cannot create " + tmp + ": " + strerror(errno));
+    size_t done = 0;
+    while (done < out.size()) {
+        ssize_t n = write(fd, out.data() + done, out.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            int err = errno;
+            close(fd);
+            unlink(tmp.c_str());
+            throw CommandError("write to " + tmp + " failed: " + strerror(err));
+        }
+        done += static_cast<size_t>(n);
+    }
+    close(fd);
+    if (rename(tmp.c_str(), index_path.c_str()) < 0) {
+        int err = errno;
+        unlink(tmp.c_str());
+        throw CommandError("cannot rename " + tmp + ": " + strerror(err));
+    }
+}
+
+void CaptureIndexBuilder::WriteFor(const std::string& pcap_path) const {
+    struct stat st{};
+    if (stat(pcap_path.c_str(), &st) < 0) throw CommandError("cannot stat " + pcap_path + ": " + strerror(errno));
+    Write(CaptureIndex::PathFor(pcap_path), static_cast<uint64_t>(st.st_size),
+          static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec);
+}
+
+// ---------------- Reader ----------------
+
+CaptureIndex::~CaptureIndex() {
+    Close();
+}
+
+void CaptureIndex::Close() {
+    if (map_) munmap(const_cast<uint8_t*>(map_), map_size_);
+    map_ = nullptr;
+    map_size_ = 0;
+    block_count_ = flow_count_ = 0;
+}
+
+void CaptureIndex::Build(const PcapReader& reader, const std::string& index_path) {
+    CaptureIndexBuilder builder;
+    DissectedPacket pkt;
+    PcapRecord rec;
+    reader.Advise(true);
+    for (uint64_t off = reader.FirstRecord(); reader.ReadAt(off, rec); off = rec.next) {
+        uint32_t hash = Dissect(rec.data, rec.caplen, rec.len, pkt) ? PacketFlowHash(pkt) : 0;
+        builder.Add(rec.offset, rec.ts_ns, hash);
+    }
+    builder.Write(index_path, reader.Size(), reader.MtimeNs());
+}
+
+bool CaptureIndex::Open(const std::string& index_path, uint64_t pcap_size, int64_t pcap_mtime_ns) {
+    Close();
+    int fd = open(index_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st{};
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < kHeaderSize) {
+        close(fd);
+        return false;
+    }
+    void* map = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+    map_ = static_cast<const uint8_t*>(map);
+    map_size_ = static_cast<size_t>(st.st_size);
+
+    const uint8_t* h = map_;
+    bool valid = std::memcmp(h, kMagic, sizeof(kMagic)) == 0 &&
+                 Load<uint32_t>(h + 8) == kVersion &&
+                 Load<uint64_t>(h + 16) == pcap_size &&
+                 Load<int64_t>(h + 24) == pcap_mtime_ns;
+    if (valid) {
+        block_count_ = Load<uint32_t>(h + 32);
+        flow_count_ = Load<uint32_t>(h + 36);
+        posting_count_ = Load<uint64_t>(h + 40);
+        uint64_t need = kHeaderSize + uint64_t(block_count_) * kBlockEntrySize +
+                        uint64_t(flow_count_) * kFlowEntrySize + posting_count_ * 4;
+        valid = need == map_size_;
+    }
+    if (!valid) {
+        Close();
+        return false;
+    }
+
+    pcap_size_ = pcap_size;
+    blocks_ = map_ + kHeaderSize;
+    flows_ = blocks_ + size_t(block_count_) * kBlockEntrySize;
+    postings_ = flows_ + size_t(flow_count_) * kFlowEntrySize;
+    return true;
+}
+
+uint64_t CaptureIndex::BlockOffset(uint32_t block) const {
+    return Load<uint64_t>(blocks_ + size_t(block) * kBlockEntrySize);
+}
+
+uint64_t CaptureIndex::BlockEnd(uint32_t block) const {
+    return block + 1 < block_count_ ? BlockOffset(block + 1) : pcap_size_;
+}
+
+uint64_t CaptureIndex::FirstTimestamp() const {
+    uint64_t first = UINT64_MAX;
+    for (uint32_t i = 0; i < block_count_; ++i)
+        first = std::min(first, Load<uint64_t>(blocks_ + size_t(i) * kBlockEntrySize + 8));
+    return block_count_ ? first : 0;
+}
+
+std::vector<uint32_t> CaptureIndex::Candidates(uint64_t since_ns, uint64_t until_ns, uint32_t flow_hash) const {
+    std::vector<uint32_t> out;
+    auto overlaps = [&](uint32_t block) {
+        if (block >= block_count_) return false;
+        const uint8_t* e = blocks_ + size_t(block) * kBlockEntrySize;
+        return Load<uint64_t>(e + 16) >= since_ns && Load<uint64_t>(e + 8) <= until_ns;
+    };
+
+    if (flow_hash == 0) {
+        for (uint32_t i = 0; i < block_count_; ++i)
+            if (overlaps(i)) out.push_back(i);
+        return out;
+    }
+
+    // Binary search the sorted flow table
+    uint32_t lo = 0, hi = flow_count_;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (Load<uint32_t>(flows_ + size_t(mid) * kFlowEntrySize) < flow_hash) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == flow_count_ || Load<uint32_t>(flows_ + size_t(lo) * kFlowEntrySize) != flow_hash) return out;
+
+    const uint8_t* entry = flows_ + size_t(lo) * kFlowEntrySize;
+    uint32_t count = Load<uint32_t>(entry + 4);
+    uint64_t start = Load<uint64_t>(entry + 8);
+    if (start + count > posting_count_) return out;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t block = Load<uint32_t>(postings_ + (start + i) * 4);
+        if (overlaps(block)) out.push_back(block);
+    }
+    return out;
+}
+
+} // namespace RedTops
@@ -0,0 +1,252 @@
+#include "../headers/CopyEngine.hpp"
+#include "../headers/TreeWalker.hpp"
+#include "../../core/header/Exceptions.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <system_error>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace RedTops {
+
+namespace {
+
+constexpr size_t kCopyChunk = size_t(1) << 30;
+constexpr size_t kControlledChunk = 64 * 1024 * 1024;  // between stop checks and progress updates
+constexpr size_t kReadWriteBuffer = 256 * 1024;
+constexpr size_t kMaxErrorMessages = 10;
+
+std::string ErrorText(int err) {
+    return std::error_code(err, std::generic_category()).message();
+}
+
+struct Fd {
+    int fd;
+    explicit Fd(int f) : fd(f) {}
+    ~Fd() { if (fd >= 0) close(fd); }
+    Fd(const Fd&) = delete;
+    Fd& operator=(const Fd&) = delete;
+};
+
+// Opens dst for writing without O_TRUNC and truncates it only once it is
+// known not to be the source itself (cp a a, another path to it, or a hard
+// link of it), which truncating first would empty. same reports that case.
+int OpenDestination(int dir, const char* path, const struct stat& src, bool& same) {
+    same = false;
+    int fd = openat(dir, path, O_WRONLY | O_CREAT | O_CLOEXEC, src.st_mode & 0777);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (same = st.st_dev == src.st_dev && st.st_ino == src.st_ino) ||
+        ftruncate(fd, 0) != 0) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    return fd;
+}
+
+bool Stopped(const CopyControl& control) {
+    if (!control.stop || !control.stop->load(std::memory_order_relaxed)) return false;
+    errno = EINTR;
+    return true;
+}
+
+void Count(const CopyControl& control, uint64_t bytes) {
+    if (control.copied) control.copied->fetch_add(bytes, std::memory_order_relaxed);
+}
+
+bool ReadWriteCopy(int in, int out, const CopyControl& control) {
+    std::vector<char> buf(kReadWriteBuffer);
+    for (;;) {
+        if (Stopped(control)) return false;
+        ssize_t n = read(in, buf.data(), buf.size());
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (n == 0) return true;
+        for (ssize_t off = 0; off < n;) {
+            ssize_t w = write(out, buf.data() + off, static_cast<size_t>(n - off));
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            off += w;
+        }
+        Count(control, static_cast<uint64_t>(n));
+    }
+}
+
+} // namespace
+
+bool CopyFileData(int in, int out, uint64_t size, bool allow_clone, CopyMethod& method, const CopyControl& control) {
+    if (allow_clone && size > 0 && ioctl(out, FICLONE, in) == 0) {
+        method = CopyMethod::Clone;
+        Count(control, size);
+        return true;
+    }
+
+    // Copy until EOF rather than to `size`, so a file that grew meanwhile is not cut short
+    method = CopyMethod::CopyRange;
+    const size_t chunk = control.copied || control.stop ? kControlledChunk : kCopyChunk;
+    uint64_t done = 0;
+    for (;;) {
+        if (Stopped(control)) return false;
+        ssize_t n = copy_file_range(in, nullptr, out, nullptr, chunk, 0);
+        if (n > 0) {
+            done += static_cast<uint64_t>(n);
+            Count(control, static_cast<uint64_t>(n));
+            continue;
+        }
+        if (n == 0) {
+            // Some pseudo-filesystems report 0 for files that do have data
+            if (done == 0 && size > 0) break;
+            return true;
+        }
+        if (errno == EINTR) continue;
+        if (done == 0 && (errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP || errno == EINVAL)) break;
+        return false;
+    }
+
+    method = CopyMethod::ReadWrite;
+    return ReadWriteCopy(in, out, control);
+}
+
+CopyEngine::CopyEngine(unsigned threads, bool allow_clone)
+    : threads_(threads ? threads : TreeWalker::DefaultThreads()), allow_clone_(allow_clone) {}
+
+void CopyEngine::Fail(const std::string& path, int err) {
+    Fail(path, ErrorText(err));
+}
+
+void CopyEngine::Fail(const std::string& path, const std::string& reason) {
+    errors_.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(errors_mutex_);
+    if (error_messages_.size() < kMaxErrorMessages) error_messages_.push_back(path + ": " + reason);
+}
+
+void CopyEngine::CopyEntry(int src_dir, const std::string& name, const std::string& rel, uint8_t type) {
+    if (type == DT_LNK) {
+        char target[PATH_MAX];
+        ssize_t n = readlinkat(src_dir, name.c_str(), target, sizeof(target) - 1);
+        if (n < 0) return Fail(rel, errno);
+        target[n] = '\0';
+        if (symlinkat(target, dst_root_, rel.c_str()) != 0) {
+            if (errno != EEXIST || unlinkat(dst_root_, rel.c_str(), 0) != 0 || symlinkat(target, dst_root_, rel.c_str()) != 0)
+                return Fail(rel, errno);
+        }
+        symlinks_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (type != DT_REG) {
+        skipped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Fd in(openat(src_dir, name.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC));
+    if (in.fd < 0) return Fail(rel, errno);
+    struct stat st;
+    if (fstat(in.fd, &st) != 0) return Fail(rel, errno);
+    bool same;
+    Fd out(OpenDestination(dst_root_, rel.c_str(), st, same));
+    if (same) return Fail(rel, "is the same file as the source");
+    if (out.fd < 0) return Fail(rel, errno);
+
+    CopyMethod method;
+    if (!CopyFileData(in.fd, out.fd, static_cast<uint64_t>(st.st_size), allow_clone_, method)) return Fail(rel, errno);
+    fchmod(out.fd, st.st_mode & 07777);    // an existing file keeps its old mode through O_CREAT
+
+    files_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(static_cast<uint64_t>(st.st_size), std::memory_order_relaxed);
+    if (method == CopyMethod::Clone) cloned_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool CopyEngine::CopyTree(const std::string& src, const std::string& dst,
+                          const std::function<bool()>& should_stop, const std::function<void()>& on_tick) {
+    Fd src_root(open(src.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (src_root.fd < 0) throw CommandError("cp: cannot open " + src + ": " + ErrorText(errno));
+    struct stat root_st;
+    fstat(src_root.fd, &root_st);
+
+    bool created = mkdir(dst.c_str(), 0700) == 0;
+    if (!created && errno != EEXIST) throw CommandError("cp: cannot create " + dst + ": " + ErrorText(errno));
+    Fd dst_root(open(dst.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (dst_root.fd < 0) throw CommandError("cp: cannot open " + dst + ": " + ErrorText(errno));
+    dst_root_ = dst_root.fd;
+
+    TreeWalker::Visitor visitor;
+    // Directories are created owner-writable so they can be filled, and get
+    // their real mode once everything below them has been copied
+    visitor.directory = [&](const TreeWalker::Entry& e) {
+        std::string rel = e.Path();
+        if (mkdirat(dst_root_, rel.c_str(), 0700) != 0 && errno != EEXIST) {
+            Fail(rel, errno);
+            return false;
+        }
+        dirs_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    };
+    visitor.entry = [&](const TreeWalker::Entry& e) {
+        CopyEntry(e.dir.fd, std::string(e.name), e.Path(), e.type);
+    };
+    visitor.leave = [&](const TreeWalker::Dir& d) {
+        struct stat st;
+        if (fstatat(d.parent_fd, std::string(d.Name()).c_str(), &st, AT_SYMLINK_NOFOLLOW) == 0)
+            fchmodat(dst_root_, d.path.c_str(), st.st_mode & 07777, 0);
+    };
+    visitor.error = [&](const std::string& path, int err) { Fail(path.empty() ? src : path, err); };
+
+    TreeWalker walker(threads_);
+    bool complete = walker.Walk(src_root.fd, visitor, should_stop, on_tick);
+    if (complete && created) fchmod(dst_root.fd, root_st.st_mode & 07777);
+    dst_root_ = -1;
+    return complete;
+}
+
+void CopyEngine::CopyFile(const std::string& src, const std::string& dst) {
+    Fd in(open(src.c_str(), O_RDONLY | O_CLOEXEC));
+    if (in.fd < 0) throw CommandError("cp: cannot open " + src + ": " + ErrorText(errno));
+    struct stat st;
+    if (fstat(in.fd, &st) != 0) throw CommandError("cp: " + src + ": " + ErrorText(errno));
+    if (S_ISDIR(st.st_mode)) throw CommandError("cp: " + src + " is a directory");
+    bool same;
+    Fd out(OpenDestination(AT_FDCWD, dst.c_str(), st, same));
+    if (same) throw CommandError("cp: " + src + " and " + dst + " are the same file");
+    if (out.fd < 0) throw CommandError("cp: cannot create " + dst + ": " + ErrorText(errno));
+
+    CopyMethod method;
+    if (!CopyFileData(in.fd, out.fd, static_cast<uint64_t>(st.st_size), allow_clone_, method))
+        throw CommandError("cp: " + dst + ": " + ErrorText(errno));
+    fchmod(out.fd, st.st_mode & 07777);
+
+    files_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(static_cast<uint64_t>(st.st_size), std::memory_order_relaxed);
+    if (method == CopyMethod::Clone) cloned_.fetch_add(1, std::memory_order_relaxed);
+}
+
+CopyStats CopyEngine::Stats() const {
+    CopyStats s;
+    s.files = files_.load(std::memory_order_relaxed);
+    s.bytes = bytes_.load(std::memory_order_relaxed);
+    s.dirs = dirs_.load(std::memory_order_relaxed);
+    s.symlinks = symlinks_.load(std::memory_order_relaxed);
+    s.cloned = cloned_.load(std::memory_order_relaxed);
+    s.skipped = skipped_.load(std::memory_order_relaxed);
+    s.errors = errors_.load(std::memory_order_relaxed);
+    return s;
+}
+
+std::vector<std::string> CopyEngine::Errors() const {
+    std::lock_guard<std::mutex> lock(errors_mutex_);
+    return error_messages_;
+}
+
+} // namespace RedTops
@@ -0,0 +1,624 @@
+#include "../headers/Digest.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <cpuid.h>
+#include <immintrin.h>
+#define REDTOPS_X86 1
+#endif
+
+namespace RedTops {
+
+namespace {
+
+std::atomic<bool> simd_enabled{true};
+
+uint32_t Load32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;       // little-endian hosts only, like the rest of the tree
+}
+
+uint64_t Load64(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+uint32_t Rotr32(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+uint64_t Rotl64(uint64_t x, int n) { return (x << n) | (x >> (64 - n)); }
+
+// ---------- XXH3-64 ----------
+
+constexpr uint32_t kP32_1 = 0x9E3779B1u;
+constexpr uint32_t kP32_2 = 0x85EBCA77u;
+constexpr uint32_t kP32_3 = 0xC2B2AE3Du;
+constexpr uint64_t kP64_1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t kP64_2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t kP64_3 = 0x165667B19E3779F9ull;
+constexpr uint64_t kP64_4 = 0x85EBCA77C2B2AE63ull;
+constexpr uint64_t kP64_5 = 0x27D4EB2F165667C5ull;
+constexpr uint64_t kPrimeMx1 = 0x165667919E3779F9ull;
+constexpr uint64_t kPrimeMx2 = 0x9FB21C651E98DF25ull;
+
+// The default 192-byte secret from the XXH3 specification
+alignas(64) constexpr uint8_t kSecret[192] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+constexpr size_t kStripeLen = 64;
+constexpr size_t kStripesPerBlock = (sizeof(kSecret) - kStripeLen) / 8;
+constexpr size_t kBlockLen = kStripeLen * kStripesPerBlock;
+
+uint64_t Mul128Fold64(uint64_t a, uint64_t b) {
+    unsigned __int128 p = static_cast<unsigned __int128>(a) * b;
+    return static_cast<uint64_t>(p) ^ static_cast<uint64_t>(p >> 64);
+}
+
+uint64_t Xxh64Avalanche(uint64_t h) {
+    h ^= h >> 33;
+    h *= kP64_2;
+    h ^= h >> 29;
+    h *= kP64_3;
+    return h ^ (h >> 32);
+}
+
+uint64_t Xxh3Avalanche(uint64_t h) {
+    h ^= h >> 37;
+    h *= kPrimeMx1;
+    return h ^ (h >> 32);
+}
+
+uint64_t Rrmxmx(uint64_t h, uint64_t len) {
+    h ^= Rotl64(h, 49) ^ Rotl64(h, 24);
+    h *= kPrimeMx2;
+    h ^= (h >> 35) + len;
+    h *= kPrimeMx2;
+    return h ^ (h >> 28);
+}
+
+uint64_t Mix16(const uint8_t* in, const uint8_t* secret) {
+    return Mul128Fold64(Load64(in) ^ Load64(secret), Load64(in + 8) ^ Load64(secret + 8));
+}
+
+void Accumulate512Scalar(uint64_t* acc, const uint8_t* in, const uint8_t* secret) {
+    for (int i = 0; i < 8; ++i) {
+        uint64_t value = Load64(in + 8 * i);
+        uint64_t key = value ^ Load64(secret + 8 * i);
+        acc[i ^ 1] += value;
+        acc[i] += static_cast<uint64_t>(static_cast<uint32_t>(key)) * (key >> 32);
+    }
+}
+
+void ScrambleScalar(uint64_t* acc, const uint8_t* secret) {
+    for (int i = 0; i < 8; ++i) {
+        uint64_t a = acc[i];
+        a ^= a >> 47;
+        a ^= Load64(secret + 8 * i);
+        acc[i] = a * kP32_1;
+    }
+}
+
+#ifdef REDTOPS_X86
+bool HasAvx2() {
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2 && simd_enabled.load(std::memory_order_relaxed);
+}
+
+// Every full block: its stripes, then a scramble. Vector versions of the
+// scalar pair above, with the accumulators kept in registers across blocks.
+__attribute__((target("avx2")))
+void Xxh3BlocksAvx2(uint64_t* acc_out, const uint8_t* in, size_t blocks) {
+    __m256i acc[2] = {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc_out)),
+                      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc_out + 4))};
+    const __m256i prime = _mm256_set1_epi32(static_cast<int>(kP32_1));
+    for (size_t b = 0; b < blocks; ++b, in += kBlockLen) {
+        for (size_t s = 0; s < kStripesPerBlock; ++s) {
+            for (int h = 0; h < 2; ++h) {
+                __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + s * kStripeLen + 32 * h));
+                __m256i key = _mm256_xor_si256(value, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(kSecret + s * 8 + 32 * h)));
+                __m256i product = _mm256_mul_epu32(key, _mm256_shuffle_epi32(key, 0x31));
+                acc[h] = _mm256_add_epi64(acc[h], _mm256_add_epi64(_mm256_shuffle_epi32(value, 0x4E), product));
+            }
+        }
+        for (int h = 0; h < 2; ++h) {
+            __m256i a = _mm256_xor_si256(acc[h], _mm256_srli_epi64(acc[h], 47));
+            a = _mm256_xor_si256(a, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(kSecret + sizeof(kSecret) - kStripeLen + 32 * h)));
+            __m256i lo = _mm256_mul_epu32(a, prime);
+            __m256i hi = _mm256_mul_epu32(_mm256_shuffle_epi32(a, 0x31), prime);
+            acc[h] = _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+        }
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc_out), acc[0]);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc_out + 4), acc[1]);
+}
+#endif
+
+void Xxh3Blocks(uint64_t* acc, const uint8_t* in, size_t blocks) {
+#ifdef REDTOPS_X86
+    if (HasAvx2()) return Xxh3BlocksAvx2(acc, in, blocks);
+#endif
+    for (size_t b = 0; b < blocks; ++b, in += kBlockLen) {
+        for (size_t s = 0; s < kStripesPerBlock; ++s) Accumulate512Scalar(acc, in + s * kStripeLen, kSecret + s * 8);
+        ScrambleScalar(acc, kSecret + sizeof(kSecret) - kStripeLen);
+    }
+}
+
+uint64_t Xxh3Long(const uint8_t* in, size_t len) {
+    alignas(32) uint64_t acc[8] = {kP32_3, kP64_1, kP64_2, kP64_3, kP64_4, kP32_2, kP64_5, kP32_1};
+    size_t blocks = (len - 1) / kBlockLen;
+    Xxh3Blocks(acc, in, blocks);
+
+    const uint8_t* tail = in + blocks * kBlockLen;
+    size_t stripes = ((len - 1) - blocks * kBlockLen) / kStripeLen;
+    for (size_t s = 0; s < stripes; ++s) Accumulate512Scalar(acc, tail + s * kStripeLen, kSecret + s * 8);
+    Accumulate512Scalar(acc, in + len - kStripeLen, kSecret + sizeof(kSecret) - kStripeLen - 7);
+
+    uint64_t result = len * kP64_1;
+    for (int i = 0; i < 4; ++i)
+        result += Mul128Fold64(acc[2 * i] ^ Load64(kSecret + 11 + 16 * i), acc[2 * i + 1] ^ Load64(kSecret + 11 + 16 * i + 8));
+    return Xxh3Avalanche(result);
+}
+
+uint64_t Xxh3(const uint8_t* in, size_t len) {
+    if (len == 0) return Xxh64Avalanche(Load64(kSecret + 56) ^ Load64(kSecret + 64));
+    if (len <= 3) {
+        uint32_t combined = (static_cast<uint32_t>(in[0]) << 16) | (static_cast<uint32_t>(in[len >> 1]) << 24) |
+                            in[len - 1] | (static_cast<uint32_t>(len) << 8);
+        uint64_t bitflip = Load32(kSecret) ^ Load32(kSecret + 4);
+        return Xxh64Avalanche(combined ^ bitflip);
+    }
+    if (len <= 8) {
+        uint64_t bitflip = Load64(kSecret + 8) ^ Load64(kSecret + 16);
+        uint64_t input = Load32(in + len - 4) + (static_cast<uint64_t>(Load32(in)) << 32);
+        return Rrmxmx(input ^ bitflip, len);
+    }
+    if (len <= 16) {
+        uint64_t lo = Load64(in) ^ (Load64(kSecret + 24) ^ Load64(kSecret + 32));
+        uint64_t hi = Load64(in + len - 8) ^ (Load64(kSecret + 40) ^ Load64(kSecret + 48));
+        return Xxh3Avalanche(len + __builtin_bswap64(lo) + hi + Mul128Fold64(lo, hi));
+    }
+    if (len <= 128) {
+        uint64_t acc = len * kP64_1;
+        if (len > 32) {
+            if (len > 64) {
+                if (len > 96) {
+                    acc += Mix16(in + 48, kSecret + 96);
+                    acc += Mix16(in + len - 64, kSecret + 112);
+                }
+                acc += Mix16(in + 32, kSecret + 64);
+                acc += Mix16(in + len - 48, kSecret + 80);
+            }
+            acc += Mix16(in + 16, kSecret + 32);
+            acc += Mix16(in + len - 32, kSecret + 48);
+        }
+        acc += Mix16(in, kSecret);
+        acc += Mix16(in + len - 16, kSecret + 16);
+        return Xxh3Avalanche(acc);
+    }
+    if (len <= 240) {
+        uint64_t acc = len * kP64_1;
+        for (size_t i = 0; i < 8; ++i) acc += Mix16(in + 16 * i, kSecret + 16 * i);
+        acc = Xxh3Avalanche(acc);
+        for (size_t i = 8; i < len / 16; ++i) acc += Mix16(in + 16 * i, kSecret + 16 * (i - 8) + 3);
+        acc += Mix16(in + len - 16, kSecret + 136 - 17);
+        return Xxh3Avalanche(acc);
+    }
+    return Xxh3Long(in, len);
+}
+
+// ---------- SHA-256 ----------
+
+alignas(16) constexpr uint32_t kSha256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+constexpr uint32_t kSha256Iv[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                   0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+void Sha256BlocksScalar(uint32_t* state, const uint8_t* in, size_t blocks) {
+    for (size_t b = 0; b < blocks; ++b, in += 64) {
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i) w[i] = __builtin_bswap32(Load32(in + 4 * i));
+        for (int i = 16; i < 64; ++i) {
+            uint32_t s0 = Rotr32(w[i - 15], 7) ^ Rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = Rotr32(w[i - 2], 17) ^ Rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = state[0], b2 = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; ++i) {
+            uint32_t t1 = h + (Rotr32(e, 6) ^ Rotr32(e, 11) ^ Rotr32(e, 25)) + ((e & f) ^ (~e & g)) + kSha256K[i] + w[i];
+            uint32_t t2 = (Rotr32(a, 2) ^ Rotr32(a, 13) ^ Rotr32(a, 22)) + ((a & b2) ^ (a & c) ^ (b2 & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b2; b2 = a; a = t1 + t2;
+        }
+        state[0] += a; state[1] += b2; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
+
+#ifdef REDTOPS_X86
+bool HasShaExtensions() {
+    static const bool sha = [] {
+        unsigned a, b, c, d;
+        if (!__get_cpuid_count(7, 0, &a, &b, &c, &d) || !(b & bit_SHA)) return false;
+        return __builtin_cpu_supports("sse4.1") != 0;
+    }();
+    return sha && simd_enabled.load(std::memory_order_relaxed);
+}
+
+// The SHA extensions do two rounds per sha256rnds2 on state split as
+// ABEF/CDGH; sha256msg1/msg2 extend the schedule four words at a time
+__attribute__((target("sha,sse4.1")))
+void Sha256BlocksShaNi(uint32_t* state, const uint8_t* in, size_t blocks) {
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bll, 0x0405060700010203ll);
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xB1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    for (size_t b = 0; b < blocks; ++b, in += 64) {
+        __m128i abef = state0, cdgh = state1;
+        __m128i w[4];
+        for (int i = 0; i < 16; ++i) {
+            __m128i& cur = w[i & 3];
+            if (i < 4) cur = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16 * i)), mask);
+            __m128i msg = _mm_add_epi32(cur, _mm_load_si128(reinterpret_cast<const __m128i*>(kSha256K + 4 * i)));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+            if (i >= 3 && i < 15) {
+                __m128i& next = w[(i + 1) & 3];
+                next = _mm_add_epi32(next, _mm_alignr_epi8(cur, w[(i + 3) & 3], 4));
+                next = _mm_sha256msg2_epu32(next, cur);
+            }
+            state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0E));
+            if (i >= 1 && i < 13) w[(i + 3) & 3] = _mm_sha256msg1_epu32(w[(i + 3) & 3], cur);
+        }
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_blend_epi16(tmp, state1, 0xF0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), _mm_alignr_epi8(state1, tmp, 8));
+}
+#endif
+
+void Sha256Blocks(uint32_t* state, const uint8_t* in, size_t blocks) {
+#ifdef REDTOPS_X86
+    if (HasShaExtensions()) return Sha256BlocksShaNi(state, in, blocks);
+#endif
+    Sha256BlocksScalar(state, in, blocks);
+}
+
+// ---------- BLAKE3 ----------
+
+constexpr size_t kBlake3Block = 64;
+constexpr size_t kBlake3Chunk = 1024;
+constexpr uint32_t kChunkStart = 1, kChunkEnd = 2, kParent = 4, kRoot = 8;
+constexpr size_t kParallelMin = 1024 * 1024;     // smaller subtrees stay on one thread
+constexpr uint8_t kMsgPermutation[16] = {2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8};
+
+using Cv = std::array<uint32_t, 8>;
+
+inline void G(uint32_t* s, int a, int b, int c, int d, uint32_t x, uint32_t y) {
+    s[a] = s[a] + s[b] + x;
+    s[d] = Rotr32(s[d] ^ s[a], 16);
+    s[c] = s[c] + s[d];
+    s[b] = Rotr32(s[b] ^ s[c], 12);
+    s[a] = s[a] + s[b] + y;
+    s[d] = Rotr32(s[d] ^ s[a], 8);
+    s[c] = s[c] + s[d];
+    s[b] = Rotr32(s[b] ^ s[c], 7);
+}
+
+Cv Compress(const Cv& cv, const uint8_t* block, uint64_t counter, uint32_t block_len, uint32_t flags) {
+    uint32_t m[16];
+    for (int i = 0; i < 16; ++i) m[i] = Load32(block + 4 * i);
+    uint32_t s[16] = {cv[0], cv[1], cv[2], cv[3], cv[4], cv[5], cv[6], cv[7],
+                      kSha256Iv[0], kSha256Iv[1], kSha256Iv[2], kSha256Iv[3],
+                      static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32), block_len, flags};
+    for (int round = 0; round < 7; ++round) {
+        G(s, 0, 4, 8, 12, m[0], m[1]);
+        G(s, 1, 5, 9, 13, m[2], m[3]);
+        G(s, 2, 6, 10, 14, m[4], m[5]);
+        G(s, 3, 7, 11, 15, m[6], m[7]);
+        G(s, 0, 5, 10, 15, m[8], m[9]);
+        G(s, 1, 6, 11, 12, m[10], m[11]);
+        G(s, 2, 7, 8, 13, m[12], m[13]);
+        G(s, 3, 4, 9, 14, m[14], m[15]);
+        if (round < 6) {
+            uint32_t p[16];
+            for (int i = 0; i < 16; ++i) p[i] = m[kMsgPermutation[i]];
+            std::memcpy(m, p, sizeof(m));
+        }
+    }
+    Cv out;
+    for (int i = 0; i < 8; ++i) out[i] = s[i] ^ s[i + 8];
+    return out;
+}
+
+// One chunk (at most 1 KiB); flags adds kRoot when the chunk is the whole input
+Cv ChunkCv(const uint8_t* in, size_t len, uint64_t counter, uint32_t extra_flags) {
+    Cv cv;
+    std::copy(std::begin(kSha256Iv), std::end(kSha256Iv), cv.begin());
+    size_t blocks = len == 0 ? 1 : (len + kBlake3Block - 1) / kBlake3Block;
+    for (size_t b = 0; b < blocks; ++b) {
+        uint8_t block[kBlake3Block] = {};
+        size_t n = std::min(kBlake3Block, len - b * kBlake3Block);
+        std::memcpy(block, in + b * kBlake3Block, n);
+        uint32_t flags = (b == 0 ? kChunkStart : 0) | (b + 1 == blocks ? kChunkEnd | extra_flags : 0);
+        cv = Compress(cv, block, counter, static_cast<uint32_t>(n), flags);
+    }
+    return cv;
+}
+
+Cv ParentCv(const Cv& left, const Cv& right, uint32_t extra_flags) {
+    uint8_t block[kBlake3Block];
+    std::memcpy(block, left.data(), 32);
+    std::memcpy(block + 32, right.data(), 32);
+    Cv key;
+    std::copy(std::begin(kSha256Iv), std::end(kSha256Iv), key.begin());
+    return Compress(key, block, 0, kBlake3Block, kParent | extra_flags);
+}
+
+#ifdef REDTOPS_X86
+__attribute__((target("avx2")))
+inline __m256i Rotr16(__m256i x) {
+    return _mm256_shuffle_epi8(x, _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+                                                  13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2));
+}
+
+__attribute__((target("avx2")))
+inline __m256i Rotr8(__m256i x) {
+    return _mm256_shuffle_epi8(x, _mm256_set_epi8(12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1,
+                                                  12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1));
+}
+
+__attribute__((target("avx2")))
+inline void G8(__m256i* s, int a, int b, int c, int d, __m256i x, __m256i y) {
+    s[a] = _mm256_add_epi32(_mm256_add_epi32(s[a], s[b]), x);
+    s[d] = Rotr16(_mm256_xor_si256(s[d], s[a]));
+    s[c] = _mm256_add_epi32(s[c], s[d]);
+    __m256i t = _mm256_xor_si256(s[b], s[c]);
+    s[b] = _mm256_or_si256(_mm256_srli_epi32(t, 12), _mm256_slli_epi32(t, 20));
+    s[a] = _mm256_add_epi32(_mm256_add_epi32(s[a], s[b]), y);
+    s[d] = Rotr8(_mm256_xor_si256(s[d], s[a]));
+    s[c] = _mm256_add_epi32(s[c], s[d]);
+    t = _mm256_xor_si256(s[b], s[c]);
+    s[b] = _mm256_or_si256(_mm256_srli_epi32(t, 7), _mm256_slli_epi32(t, 25));
+}
+
+// Eight rows of eight 32-bit words become eight columns
+__attribute__((target("avx2")))
+void Transpose8(__m256i* v) {
+    __m256i t[8], u[8];
+    for (int i = 0; i < 8; i += 2) {
+        t[i] = _mm256_unpacklo_epi32(v[i], v[i + 1]);
+        t[i + 1] = _mm256_unpackhi_epi32(v[i], v[i + 1]);
+    }
+    for (int i = 0; i < 8; i += 4) {
+        u[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+        u[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+        u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+        u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+    }
+    for (int i = 0; i < 4; ++i) {
+        v[i] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x20);
+        v[i + 4] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x31);
+    }
+}
+
+// Chaining values of eight consecutive full chunks, one per vector lane:
+// the same compressions as ChunkCv with the state held transposed
+__attribute__((target("avx2")))
+void EightChunkCvs(const uint8_t* in, uint64_t counter, Cv* out) {
+    __m256i h[8];
+    for (int i = 0; i < 8; ++i) h[i] = _mm256_set1_epi32(static_cast<int>(kSha256Iv[i]));
+    alignas(32) uint32_t lo[8], hi[8];
+    for (int l = 0; l < 8; ++l) {
+        lo[l] = static_cast<uint32_t>(counter + l);
+        hi[l] = static_cast<uint32_t>((counter + l) >> 32);
+    }
+    const __m256i counter_lo = _mm256_load_si256(reinterpret_cast<const __m256i*>(lo));
+    const __m256i counter_hi = _mm256_load_si256(reinterpret_cast<const __m256i*>(hi));
+
+    for (size_t b = 0; b < kBlake3Chunk / kBlake3Block; ++b) {
+        __m256i m[16];
+        for (int half = 0; half < 2; ++half) {
+            for (int l = 0; l < 8; ++l)
+                m[8 * half + l] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + l * kBlake3Chunk + b * kBlake3Block + 32 * half));
+            Transpose8(m + 8 * half);
+        }
+        uint32_t flags = (b == 0 ? kChunkStart : 0) | (b + 1 == kBlake3Chunk / kBlake3Block ? kChunkEnd : 0);
+        __m256i s[16] = {h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7],
+                         _mm256_set1_epi32(static_cast<int>(kSha256Iv[0])), _mm256_set1_epi32(static_cast<int>(kSha256Iv[1])),
+                         _mm256_set1_epi32(static_cast<int>(kSha256Iv[2])), _mm256_set1_epi32(static_cast<int>(kSha256Iv[3])),
+                         counter_lo, counter_hi, _mm256_set1_epi32(static_cast<int>(kBlake3Block)),
+                         _mm256_set1_epi32(static_cast<int>(flags))};
+        for (int round = 0; round < 7; ++round) {
+            G8(s, 0, 4, 8, 12, m[0], m[1]);
+            G8(s, 1, 5, 9, 13, m[2], m[3]);
+            G8(s, 2, 6, 10, 14, m[4], m[5]);
+            G8(s, 3, 7, 11, 15, m[6], m[7]);
+            G8(s, 0, 5, 10, 15, m[8], m[9]);
+            G8(s, 1, 6, 11, 12, m[10], m[11]);
+            G8(s, 2, 7, 8, 13, m[12], m[13]);
+            G8(s, 3, 4, 9, 14, m[14], m[15]);
+            if (round < 6) {
+                __m256i p[16];
+                for (int i = 0; i < 16; ++i) p[i] = m[kMsgPermutation[i]];
+                std::copy(p, p + 16, m);
+            }
+        }
+        for (int i = 0; i < 8; ++i) h[i] = _mm256_xor_si256(s[i], s[i + 8]);
+    }
+
+    Transpose8(h);
+    for (int l = 0; l < 8; ++l) _mm256_storeu_si256(reinterpret_cast<__m256i*>(out[l].data()), h[l]);
+}
+#endif
+
+// Bytes in the left subtree: the largest power-of-two number of whole
+// chunks that leaves at least one byte for the right
+size_t LeftLen(size_t len) {
+    size_t full_chunks = (len - 1) / kBlake3Chunk;
+    size_t p = 1;
+    while (p * 2 <= full_chunks) p *= 2;
+    return p * kBlake3Chunk;
+}
+
+// Chaining value of the subtree over in[0, len) starting at chunk counter;
+// root_flag is kRoot only for the node that covers the whole input
+Cv SubtreeCv(const uint8_t* in, size_t len, uint64_t counter, unsigned threads, uint32_t root_flag) {
+    if (len <= kBlake3Chunk) return ChunkCv(in, len, counter, root_flag);
+#ifdef REDTOPS_X86
+    if (len == 8 * kBlake3Chunk && HasAvx2()) {
+        Cv cvs[8];
+        EightChunkCvs(in, counter, cvs);
+        for (int width = 8; width > 2; width /= 2)
+            for (int i = 0; i < width / 2; ++i) cvs[i] = ParentCv(cvs[2 * i], cvs[2 * i + 1], 0);
+        return ParentCv(cvs[0], cvs[1], root_flag);
+    }
+#endif
+    size_t left = LeftLen(len);
+    Cv l, r;
+    if (threads > 1 && len >= kParallelMin) {
+        unsigned left_threads = threads / 2;
+        std::thread worker([&] { l = SubtreeCv(in, left, counter, left_threads, 0); });
+        r = SubtreeCv(in + left, len - left, counter + left / kBlake3Chunk, threads - left_threads, 0);
+        worker.join();
+    } else {
+        l = SubtreeCv(in, left, counter, 1, 0);
+        r = SubtreeCv(in + left, len - left, counter + left / kBlake3Chunk, 1, 0);
+    }
+    return ParentCv(l, r, root_flag);
+}
+
+} // namespace
+
+bool ParseHashAlgorithm(std::string_view name, HashAlgorithm& algorithm) {
+    if (name == "xxh3") algorithm = HashAlgorithm::Xxh3;
+    else if (name == "sha256") algorithm = HashAlgorithm::Sha256;
+    else if (name == "blake3") algorithm = HashAlgorithm::Blake3;
+    else return false;
+    return true;
+}
+
+const char* HashAlgorithmName(HashAlgorithm algorithm) {
+    switch (algorithm) {
+        case HashAlgorithm::Xxh3:   return "xxh3";
+        case HashAlgorithm::Sha256: return "sha256";
+        case HashAlgorithm::Blake3: return "blake3";
+    }
+    return "?";
+}
+
+std::vector<uint8_t> Xxh3Digest(const void* data, size_t len) {
+    uint64_t h = Xxh3(static_cast<const uint8_t*>(data), len);
+    std::vector<uint8_t> out(8);
+    for (int i = 0; i < 8; ++i) out[i] = static_cast<uint8_t>(h >> (56 - 8 * i));
+    return out;
+}
+
+std::vector<uint8_t> Sha256Digest(const void* data, size_t len) {
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+    uint32_t state[8];
+    std::copy(std::begin(kSha256Iv), std::end(kSha256Iv), state);
+    size_t full = len / 64;
+    Sha256Blocks(state, in, full);
+
+    // Padding: 0x80, zeros, then the bit length big-endian, in one or two blocks
+    uint8_t tail[128] = {};
+    size_t rest = len - full * 64;
+    std::memcpy(tail, in + full * 64, rest);
+    tail[rest] = 0x80;
+    size_t tail_len = rest + 9 <= 64 ? 64 : 128;
+    uint64_t bits = static_cast<uint64_t>(len) * 8;
+    for (int i = 0; i < 8; ++i) tail[tail_len - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+    Sha256Blocks(state, tail, tail_len / 64);
+
+    std::vector<uint8_t> out(32);
+    for (int i = 0; i < 8; ++i)
+        for (int j = 0; j < 4; ++j) out[4 * i + j] = static_cast<uint8_t>(state[i] >> (24 - 8 * j));
+    return out;
+}
+
+std::vector<uint8_t> Blake3Digest(const void* data, size_t len, unsigned threads) {
+    Cv root = SubtreeCv(static_cast<const uint8_t*>(data), len, 0, std::max(1u, threads), kRoot);
+    std::vector<uint8_t> out(32);
+    std::memcpy(out.data(), root.data(), 32);
+    return out;
+}
+
+std::vector<uint8_t> ComputeDigest(HashAlgorithm algorithm, const void* data, size_t len, unsigned threads) {
+    switch (algorithm) {
+        case HashAlgorithm::Xxh3:   return Xxh3Digest(data, len);
+        case HashAlgorithm::Sha256: return Sha256Digest(data, len);
+        case HashAlgorithm::Blake3: return Blake3Digest(data, len, threads);
+    }
+    return {};
+}
+
+std::vector<uint8_t> TreeDigest(HashAlgorithm algorithm, const void* data, size_t len, unsigned threads) {
+    if (algorithm == HashAlgorithm::Blake3) return Blake3Digest(data, len, threads);
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+    size_t leaves = std::max<size_t>(1, (len + kDigestTreeLeaf - 1) / kDigestTreeLeaf);
+    std::vector<std::vector<uint8_t>> digests(leaves);
+    auto leaf = [&](size_t i) {
+        size_t begin = i * kDigestTreeLeaf;
+        digests[i] = ComputeDigest(algorithm, in + begin, std::min(kDigestTreeLeaf, len - begin));
+    };
+
+    unsigned n = static_cast<unsigned>(std::min<size_t>(std::max(1u, threads), leaves));
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < n; ++t)
+        pool.emplace_back([&, t] { for (size_t i = t; i < leaves; i += n) leaf(i); });
+    for (size_t i = 0; i < leaves; i += n) leaf(i);
+    for (auto& t : pool) t.join();
+
+    std::vector<uint8_t> joined;
+    for (const auto& d : digests) joined.insert(joined.end(), d.begin(), d.end());
+    return ComputeDigest(algorithm, joined.data(), joined.size());
+}
+
+void SetDigestSimd(bool enabled) {
+    simd_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+std::string ToHex(const std::vector<uint8_t>& bytes) {
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    out.reserve(bytes.size() * 2);
+    for (uint8_t b : bytes) {
+        out += digits[b >> 4];
+        out += digits[b & 15];
+    }
+    return out;
+}
+
+} // namespace RedTops
@@ -0,0 +1,101 @@
+#include "../headers/DirListing.hpp"
+#include "../headers/TreeWalker.hpp"
+#include "../../core/header/Exceptions.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <system_error>
+#include <thread>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace RedTops {
+
+namespace {
+
+constexpr unsigned kStatMask = STATX_TYPE | STATX_MODE | STATX_SIZE | STATX_MTIME;
+constexpr size_t kParallelThreshold = 4096;
+constexpr size_t kStatChunk = 512;
+
+uint8_t TypeFromMode(uint32_t mode) {
+    switch (mode & S_IFMT) {
+        case S_IFDIR:  return DT_DIR;
+        case S_IFREG:  return DT_REG;
+        case S_IFLNK:  return DT_LNK;
+        case S_IFIFO:  return DT_FIFO;
+        case S_IFSOCK: return DT_SOCK;
+        case S_IFCHR:  return DT_CHR;
+        case S_IFBLK:  return DT_BLK;
+        default:       return DT_UNKNOWN;
+    }
+}
+
+bool Statx(int dirfd, const char* name, int flags, ListedEntry& e) {
+    struct statx stx;
+    if (statx(dirfd, name, flags | AT_STATX_DONT_SYNC, kStatMask, &stx) != 0) return false;
+    e.has_stat = true;
+    e.mode = stx.stx_mode;
+    e.type = TypeFromMode(stx.stx_mode);
+    e.size = stx.stx_size;
+    e.mtime_ns = static_cast<int64_t>(stx.stx_mtime.tv_sec) * 1000000000 + stx.stx_mtime.tv_nsec;
+    return true;
+}
+
+} // namespace
+
+bool StatEntry(const std::string& path, ListedEntry& out) {
+    return Statx(AT_FDCWD, path.c_str(), 0, out);
+}
+
+DirListing DirListing::Read(const std::string& path, bool include_hidden, bool with_stat, unsigned threads) {
+    int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) throw CommandError("cannot open " + path + ": " + std::error_code(errno, std::generic_category()).message());
+
+    DirListing out;
+    DirReader reader(fd, 256 * 1024);
+    DirEntry raw;
+    while (reader.Next(raw)) {
+        if (!include_hidden && raw.name[0] == '.') continue;
+        ListedEntry e;
+        e.name_offset = static_cast<uint32_t>(out.names_.size());
+        e.name_length = static_cast<uint32_t>(raw.name.size());
+        e.type = raw.type;
+        out.names_.append(raw.name);
+        out.names_.push_back('\0');         // statx wants C strings
+        out.entries_.push_back(e);
+    }
+    if (reader.Error()) {
+        int err = reader.Error();
+        close(fd);
+        throw CommandError("cannot list " + path + ": " + std::error_code(err, std::generic_category()).message());
+    }
+
+    if (with_stat && !out.entries_.empty()) {
+        const char* names = out.names_.data();
+        std::vector<ListedEntry>& entries = out.entries_;
+        std::atomic<size_t> next{0};
+        auto work = [&] {
+            for (;;) {
+                size_t begin = next.fetch_add(kStatChunk);
+                if (begin >= entries.size()) return;
+                size_t end = std::min(entries.size(), begin + kStatChunk);
+                for (size_t i = begin; i < end; ++i) Statx(fd, names + entries[i].name_offset, AT_SYMLINK_NOFOLLOW, entries[i]);
+            }
+        };
+        unsigned n = threads ? threads : TreeWalker::DefaultThreads();
+        if (entries.size() < kParallelThreshold) n = 1;
+        n = static_cast<unsigned>(std::min<size_t>(n, (entries.size() + kStatChunk - 1) / kStatChunk));
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < n; ++t) pool.emplace_back(work);
+        work();
+        for (auto& t : pool) t.join();
+    }
+    close(fd);
+    return out;
+}
+
+} // namespace RedTops
@@ -0,0 +1,208 @@
+#include "../headers/DiskUsage.hpp"
+#include "../headers/TreeWalker.hpp"
+#include "../../core/header/Exceptions.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+namespace RedTops {
+
+namespace {
+
+constexpr size_t kMaxErrorMessages = 10;
+constexpr size_t kShards = 64;
+constexpr unsigned kStatMask = STATX_TYPE | STATX_NLINK | STATX_INO | STATX_SIZE | STATX_BLOCKS;
+
+std::string ErrorText(int err) {
+    return std::error_code(err, std::generic_category()).message();
+}
+
+struct LinkKey {
+    uint64_t dev;
+    uint64_t ino;
+    bool operator==(const LinkKey& o) const { return dev == o.dev && ino == o.ino; }
+};
+
+struct LinkKeyHash {
+    size_t operator()(const LinkKey& k) const {
+        return std::hash<uint64_t>()(k.ino * 0x9E3779B97F4A7C15ull ^ k.dev);
+    }
+};
+
+bool GreaterBytes(const UsageEntry& a, const UsageEntry& b) {
+    return a.bytes > b.bytes;
+}
+
+} // namespace
+
+struct DiskUsage::Totals {
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> files{0};
+};
+
+// Directory totals are sharded by path and the hardlink set by inode, so
+// workers rarely wait on each other
+struct DiskUsage::Shard {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::unique_ptr<Totals>> dirs;
+    std::unordered_set<LinkKey, LinkKeyHash> links;
+};
+
+DiskUsage::DiskUsage(Options options)
+    : options_(options), threads_(options.threads ? options.threads : TreeWalker::DefaultThreads()) {
+    for (size_t i = 0; i < kShards; ++i) shards_.push_back(std::make_unique<Shard>());
+}
+
+DiskUsage::~DiskUsage() = default;
+
+void DiskUsage::Fail(const std::string& path, int err) {
+    errors_.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(errors_mutex_);
+    if (error_messages_.size() < kMaxErrorMessages) error_messages_.push_back(path + ": " + ErrorText(err));
+}
+
+DiskUsage::Totals* DiskUsage::Find(const std::string& path) {
+    Shard& shard = *shards_[std::hash<std::string>()(path) % kShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto& slot = shard.dirs[path];
+    if (!slot) slot = std::make_unique<Totals>();
+    return slot.get();
+}
+
+std::unique_ptr<DiskUsage::Totals> DiskUsage::Take(const std::string& path) {
+    Shard& shard = *shards_[std::hash<std::string>()(path) % kShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.dirs.find(path);
+    if (it == shard.dirs.end()) return nullptr;
+    std::unique_ptr<Totals> totals = std::move(it->second);
+    shard.dirs.erase(it);
+    return totals;
+}
+
+bool DiskUsage::FirstLink(uint64_t dev, uint64_t ino) {
+    LinkKey key{dev, ino};
+    Shard& shard = *shards_[LinkKeyHash()(key) % kShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.links.insert(key).second;
+}
+
+void DiskUsage::Offer(UsageEntry entry) {
+    std::lock_guard<std::mutex> lock(top_mutex_);
+    if (top_.size() < options_.top) {
+        top_.push_back(std::move(entry));
+        std::push_heap(top_.begin(), top_.end(), GreaterBytes);
+    } else if (!top_.empty() && entry.bytes > top_.front().bytes) {
+        std::pop_heap(top_.begin(), top_.end(), GreaterBytes);
+        top_.back() = std::move(entry);
+        std::push_heap(top_.begin(), top_.end(), GreaterBytes);
+    }
+}
+
+bool DiskUsage::Scan(const std::string& path, const std::function<bool()>& should_stop,
+                     const std::function<void()>& on_tick) {
+    int root = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (root < 0) throw CommandError("du: cannot open " + path + ": " + ErrorText(errno));
+    struct statx root_st;
+    if (statx(root, "", AT_EMPTY_PATH, kStatMask, &root_st) != 0) {
+        int err = errno;
+        close(root);
+        throw CommandError("du: cannot stat " + path + ": " + ErrorText(err));
+    }
+    const uint64_t root_dev = makedev(root_st.stx_dev_major, root_st.stx_dev_minor);
+    auto usage = [&](const struct statx& st) -> uint64_t {
+        return options_.apparent ? st.stx_size : st.stx_blocks * 512;
+    };
+    Find("")->bytes += usage(root_st);
+    bytes_ += usage(root_st);
+    dirs_ = 1;
+
+    TreeWalker::Visitor visitor;
+    visitor.directory = [&](const TreeWalker::Entry& e) {
+        std::string name(e.name);
+        struct statx st;
+        if (statx(e.dir.fd, name.c_str(), AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC, kStatMask, &st) != 0) {
+            Fail(e.Path(), errno);
+            return false;
+        }
+        if (options_.one_filesystem && makedev(st.stx_dev_major, st.stx_dev_minor) != root_dev) return false;
+        Find(e.Path())->bytes += usage(st);
+        dirs_.fetch_add(1, std::memory_order_relaxed);
+        bytes_.fetch_add(usage(st), std::memory_order_relaxed);
+        return true;
+    };
+    visitor.entry = [&](const TreeWalker::Entry& e) {
+        std::string name(e.name);
+        struct statx st;
+        if (statx(e.dir.fd, name.c_str(), AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC, kStatMask, &st) != 0) {
+            if (errno != ENOENT) Fail(e.Path(), errno);
+            return;
+        }
+        if (st.stx_nlink > 1 && !FirstLink(makedev(st.stx_dev_major, st.stx_dev_minor), st.stx_ino)) {
+            hardlinks_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        uint64_t bytes = usage(st);
+        Totals* dir = Find(e.dir.path);
+        dir->bytes.fetch_add(bytes, std::memory_order_relaxed);
+        dir->files.fetch_add(1, std::memory_order_relaxed);
+        files_.fetch_add(1, std::memory_order_relaxed);
+        bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    };
+    // Everything below d has been counted: fold it into its parent
+    visitor.leave = [&](const TreeWalker::Dir& d) {
+        std::unique_ptr<Totals> own = Take(d.path);
+        if (!own) return;
+        size_t slash = d.path.rfind('/');
+        Totals* parent = Find(slash == std::string::npos ? std::string() : d.path.substr(0, slash));
+        parent->bytes.fetch_add(own->bytes.load(), std::memory_order_relaxed);
+        parent->files.fetch_add(own->files.load(), std::memory_order_relaxed);
+        Offer(UsageEntry{d.path, own->bytes.load(), own->files.load(), d.complete});
+    };
+    visitor.leave_failed = true;
+    visitor.error = [&](const std::string& dir, int err) { Fail(dir.empty() ? path : dir, err); };
+
+    bool complete = TreeWalker(threads_).Walk(root, visitor, should_stop, on_tick);
+    close(root);
+
+    std::unique_ptr<Totals> top = Take("");
+    root_ = UsageEntry{"", top ? top->bytes.load() : 0, top ? top->files.load() : 0,
+                       complete && errors_.load() == 0};
+    for (auto& shard : shards_) {
+        shard->dirs.clear();    // left over only when the walk was stopped
+        shard->links.clear();
+    }
+    return complete;
+}
+
+UsageStats DiskUsage::Stats() const {
+    UsageStats s;
+    s.files = files_.load(std::memory_order_relaxed);
+    s.dirs = dirs_.load(std::memory_order_relaxed);
+    s.bytes = bytes_.load(std::memory_order_relaxed);
+    s.hardlinks = hardlinks_.load(std::memory_order_relaxed);
+    s.errors = errors_.load(std::memory_order_relaxed);
+    return s;
+}
+
+std::vector<UsageEntry> DiskUsage::Top() const {
+    std::vector<UsageEntry> out{root_};
+    {
+        std::lock_guard<std::mutex> lock(top_mutex_);
+        out.insert(out.end(), top_.begin(), top_.end());
+    }
+    std::stable_sort(out.begin(), out.end(), GreaterBytes);
+    return out;
+}
+
+std::vector<std::string> DiskUsage::Errors() const {
+    std::lock_guard<std::mutex> lock(errors_mutex_);
+    return error_messages_;
+}
+
+} // namespace RedTops
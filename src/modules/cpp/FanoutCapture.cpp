@@ -0,0 +1,203 @@
+#include "../headers/FanoutCapture.hpp"
+#include "../headers/PacketDissector.hpp"
+#include "../headers/PacketRing.hpp"
+#include "../../core/header/Exceptions.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include <linux/if_packet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+namespace RedTops {
+
+namespace {
+
+constexpr int kPollTimeoutMs = 100;
+
+// Counts one decoded frame in the per-worker counters
+void Classify(const DissectedPacket& d, FanoutWorkerStats& st) {
+    if (d.l3 == L3Proto::IPv4) st.ipv4++;
+    else if (d.l3 == L3Proto::IPv6) st.ipv6++;
+    else { st.other++; return; }
+
+    if (d.l4_proto == IPPROTO_TCP) st.tcp++;
+    else if (d.l4_proto == IPPROTO_UDP) st.udp++;
+    else if (d.l4_proto == IPPROTO_ICMP || d.l4_proto == IPPROTO_ICMPV6) st.icmp++;
+    else st.other++;
+}
+
+} // namespace
+
+FanoutWorkerStats& FanoutWorkerStats::operator+=(const FanoutWorkerStats& o) {
+    packets += o.packets;
+    bytes += o.bytes;
+    ipv4 += o.ipv4;
+    ipv6 += o.ipv6;
+    tcp += o.tcp;
+    udp += o.udp;
+    icmp += o.icmp;
+    other += o.other;
+    kernel_drops += o.kernel_drops;
+    return *this;
+}
+
+FanoutMode ParseFanoutMode(const std::string& name) {
+    if (name == "hash") return FanoutMode::Hash;
+    if (name == "cpu") return FanoutMode::Cpu;
+    if (name == "rr" || name == "roundrobin") return FanoutMode::RoundRobin;
+    throw CommandError("unknown fanout mode: " + name + " (expected hash, cpu or rr)");
+}
+
+const char* FanoutModeName(FanoutMode mode) {
+    switch (mode) {
+        case FanoutMode::Hash: return "hash";
+        case FanoutMode::Cpu: return "cpu";
+        case FanoutMode::RoundRobin: return "rr";
+    }
+    return "?";
+}
+
+FanoutCapture::FanoutCapture(FanoutOptions options) : options_(std::move(options)) {
+    if (options_.workers == 0) {
+        options_.workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+FanoutCapture::~FanoutCapture() {
+    Close();
+}
+
+void FanoutCapture::Close() {
+    rings_.clear();
+}
+
+void FanoutCapture::Open() {
+    Close();
+
+    // Group ids are global per network namespace; derive one unlikely to collide
+    int group_id = static_cast<int>((getpid() ^ std::chrono::steady_clock::now().time_since_epoch().count()) & 0xffff);
+    int type = PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG;
+    if (options_.mode == FanoutMode::Cpu) type = PACKET_FANOUT_CPU;
+    else if (options_.mode == FanoutMode::RoundRobin) type = PACKET_FANOUT_LB;
+    int fanout_arg = (group_id & 0xffff) | (type << 16);
+
+    stats_.assign(options_.workers, FanoutWorkerStats{});
+    try {
+        for (unsigned i = 0; i < options_.workers; ++i) {
+            rings_.push_back(std::make_unique<PacketRing>());
+            rings_.back()->Open(options_.interface, options_.promiscuous, fanout_arg);
+        }
+    } catch (...) {
+        Close();
+        throw;
+    }
+
+    // On loopback every packet is seen twice (outgoing and incoming); keep one copy.
+    // PACKET_IGNORE_OUTGOING does not apply to fanout groups, so filter in the workers.
+    skip_outgoing_ = rings_.front()->IsLoopback();
+}
+
+void FanoutCapture::WorkerLoop(unsigned index) {
+    PacketRing& ring = *rings_[index];
+    FanoutWorkerStats local;
+    local.cpu = -1;
+
+    if (options_.pin_workers) {
+        unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(index % cores, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0)
+            local.cpu = static_cast<int>(index % cores);
+    }
+
+    DissectedPacket pkt;
+    while (!stop_.load(std::memory_order_relaxed)) {
+        uint32_t in_block = ring.Ready();
+        if (in_block == 0) {
+            ring.Wait(kPollTimeoutMs);
+            continue;
+        }
+
+        uint32_t wanted = in_block;
+        if (skip_outgoing_) {
+            wanted = 0;
+            ring.ForEach([&](const RingFrame& f) { wanted += !f.outgoing; return true; });
+        }
+
+        uint32_t take = wanted;
+        // Reserve packets from the shared budget once per block rather than per packet
+        if (options_.max_packets) {
+            uint64_t before = captured_.fetch_add(wanted, std::memory_order_relaxed);
+            if (before >= options_.max_packets) take = 0;
+            else if (before + wanted > options_.max_packets)
+                take = static_cast<uint32_t>(options_.max_packets - before);
+        } else {
+            captured_.fetch_add(wanted, std::memory_order_relaxed);
+        }
+
+        uint32_t taken = 0;
+        ring.ForEach([&](const RingFrame& f) {
+            if (taken >= take) return false;
+            if (skip_outgoing_ && f.outgoing) return true;
+            taken++;
+            local.packets++;
+            local.bytes += f.len;
+            if (Dissect(f.data, f.caplen, f.len, pkt)) {
+                Classify(pkt, local);
+                if (options_.on_packet) options_.on_packet(index, pkt, f.data, f.ts_ns / 1000);
+            } else {
+                local.other++;
+            }
+            return true;
+        });
+
+        // Hand the block back to the kernel
+        ring.Release();
+
+        if (options_.max_packets && captured_.load(std::memory_order_relaxed) >= options_.max_packets)
+            stop_ = true;
+    }
+
+    local.kernel_drops = ring.Drops();
+    stats_[index] = local;
+}
+
+void FanoutCapture::Run(const std::function<bool()>& should_stop,
+                        const std::function<void(uint64_t)>& on_tick) {
+    if (rings_.empty()) Open();
+    stop_ = false;
+    captured_ = 0;
+
+    std::vector<std::thread> workers;
+    workers.reserve(rings_.size());
+    for (unsigned i = 0; i < rings_.size(); ++i)
+        workers.emplace_back(&FanoutCapture::WorkerLoop, this, i);
+
+    auto next_tick = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (!stop_) {
+        if (should_stop && should_stop()) { stop_ = true; break; }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        if (on_tick && std::chrono::steady_clock::now() >= next_tick) {
+            uint64_t seen = captured_.load(std::memory_order_relaxed);
+            if (options_.max_packets) seen = std::min(seen, options_.max_packets);
+            on_tick(seen);
+            next_tick += std::chrono::seconds(1);
+        }
+    }
+
+    for (auto& t : workers) t.join();
+}
+
+FanoutWorkerStats FanoutCapture::Totals() const {
+    FanoutWorkerStats total;
+    for (const auto& st : stats_) total += st;
+    return total;
+}
+
+} // namespace RedTops
@@ -0,0 +1,210 @@
+#include "../headers/FileHasher.hpp"
+#include "../headers/TreeWalker.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <system_error>
+#include <thread>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace RedTops {
+
+namespace {
+
+constexpr size_t kMaxErrorMessages = 10;
+constexpr size_t kReadLimit = 256 * 1024;       // smaller files are read, larger ones mapped
+
+std::string ErrorText(int err) {
+    return std::error_code(err, std::generic_category()).message();
+}
+
+bool ReadAll(int fd, char* buf, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = read(fd, buf + done, len - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+FileHasher::FileHasher(Options options)
+    : options_(options),
+      threads_(options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency())) {}
+
+void FileHasher::Fail(const std::string& path, const std::string& reason) {
+    errors_.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(errors_mutex_);
+    if (error_messages_.size() < kMaxErrorMessages) error_messages_.push_back(path + ": " + reason);
+}
+
+std::vector<std::string> FileHasher::Collect(const std::vector<std::string>& paths,
+                                             const std::function<bool()>& should_stop) {
+    std::vector<std::string> files;
+    for (const auto& path : paths) {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+            files.push_back(path);      // missing files fail when they are hashed
+            continue;
+        }
+        int root = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (root < 0) {
+            Fail(path, ErrorText(errno));
+            continue;
+        }
+        std::string prefix = path;
+        while (prefix.size() > 1 && prefix.back() == '/') prefix.pop_back();
+        if (prefix == ".") prefix.clear();
+        else if (prefix != "/") prefix += '/';
+
+        std::mutex mutex;
+        std::vector<std::string> found;
+        TreeWalker::Visitor visitor;
+        visitor.directory = [](const TreeWalker::Entry&) { return true; };
+        visitor.entry = [&](const TreeWalker::Entry& e) {
+            if (e.type != DT_REG) return;
+            std::string rel = prefix + e.Path();
+            std::lock_guard<std::mutex> lock(mutex);
+            found.push_back(std::move(rel));
+        };
+        visitor.error = [&](const std::string& dir, int err) { Fail(dir.empty() ? path : prefix + dir, ErrorText(err)); };
+        bool complete = TreeWalker().Walk(root, visitor, should_stop);
+        close(root);
+
+        std::sort(found.begin(), found.end());
+        files.insert(files.end(), std::make_move_iterator(found.begin()), std::make_move_iterator(found.end()));
+        if (!complete) break;
+    }
+    return files;
+}
+
+void FileHasher::HashOne(const std::string& path, unsigned threads, HashResult& result) {
+    auto fail = [&](const std::string& reason) {
+        result.error = reason;
+        Fail(path, reason);
+    };
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return fail(ErrorText(errno));
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        close(fd);
+        return fail(ErrorText(err));
+    }
+    if (!S_ISREG(st.st_mode)) {
+        close(fd);
+        return fail(S_ISDIR(st.st_mode) ? "is a directory" : "not a regular file");
+    }
+
+    size_t len = static_cast<size_t>(st.st_size);
+    auto digest = [&](const void* data) {
+        return options_.tree ? TreeDigest(options_.algorithm, data, len, threads)
+                             : ComputeDigest(options_.algorithm, data, len, threads);
+    };
+    if (len <= kReadLimit) {
+        thread_local std::vector<char> buf;
+        buf.resize(std::max<size_t>(len, 1));
+        if (!ReadAll(fd, buf.data(), len)) {
+            int err = errno;
+            close(fd);
+            return fail(err ? ErrorText(err) : "file changed while reading");
+        }
+        result.digest = ToHex(digest(buf.data()));
+    } else {
+        // Sequential advice doubles the read-ahead window, so the pages a
+        // worker touches next are usually in flight while it hashes
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        void* map = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            int err = errno;
+            close(fd);
+            return fail(ErrorText(err));
+        }
+        madvise(map, len, MADV_SEQUENTIAL);
+        result.digest = ToHex(digest(map));
+        munmap(map, len);
+    }
+    close(fd);
+    result.bytes = len;
+    files_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(len, std::memory_order_relaxed);
+}
+
+bool FileHasher::Hash(const std::vector<std::string>& files, std::vector<HashResult>& results,
+                      const std::function<bool()>& should_stop, const std::function<void()>& on_tick) {
+    results.assign(files.size(), HashResult{});
+    for (size_t i = 0; i < files.size(); ++i) results[i].path = files[i];
+
+    // Files big enough to split go to the second phase, one at a time
+    bool splittable = options_.tree || options_.algorithm == HashAlgorithm::Blake3;
+    std::vector<size_t> pooled, split;
+    for (size_t i = 0; i < files.size(); ++i) {
+        struct stat st;
+        bool big = splittable && threads_ > 1 && stat(files[i].c_str(), &st) == 0 &&
+                   static_cast<uint64_t>(st.st_size) >= kSplitMin;
+        (big ? split : pooled).push_back(i);
+    }
+
+    std::atomic<bool> stop{false};
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+
+    std::thread driver([&] {
+        std::atomic<size_t> next{0};
+        auto worker = [&] {
+            for (size_t i; !stop.load(std::memory_order_relaxed) && (i = next.fetch_add(1)) < pooled.size();)
+                HashOne(files[pooled[i]], 1, results[pooled[i]]);
+        };
+        std::vector<std::thread> pool;
+        unsigned n = static_cast<unsigned>(std::min<size_t>(threads_, pooled.size()));
+        for (unsigned t = 1; t < n; ++t) pool.emplace_back(worker);
+        worker();
+        for (auto& t : pool) t.join();
+
+        for (size_t i : split) {
+            if (stop.load(std::memory_order_relaxed)) break;
+            HashOne(files[i], threads_, results[i]);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+        cv.notify_all();
+    });
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!cv.wait_for(lock, std::chrono::milliseconds(100), [&] { return done; })) {
+            lock.unlock();
+            if (should_stop && should_stop()) stop = true;
+            if (on_tick) on_tick();
+            lock.lock();
+        }
+    }
+    driver.join();
+    return !stop.load();
+}
+
+HashStats FileHasher::Stats() const {
+    HashStats s;
+    s.files = files_.load(std::memory_order_relaxed);
+    s.bytes = bytes_.load(std::memory_order_relaxed);
+    s.errors = errors_.load(std::memory_order_relaxed);
+    return s;
+}
+
+std::vector<std::string> FileHasher::Errors() const {
+    std::lock_guard<std::mutex> lock(errors_mutex_);
+    return error_messages_;
+}
+
+} // namespace RedTops
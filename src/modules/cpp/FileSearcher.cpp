@@ -0,0 +1,243 @@
+#include "../headers/FileSearcher.hpp"
+#include "../headers/IgnoreRules.hpp"
+#include "../headers/TextSearch.hpp"
+#include "../headers/TreeWalker.hpp"
+#include "../../core/header/Exceptions.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace RedTops {
+
+namespace {
+
+constexpr size_t kMaxErrorMessages = 10;
+constexpr size_t kReadLimit = 256 * 1024;       // smaller files are read, larger ones mapped
+constexpr size_t kBinaryProbe = 8192;
+
+std::string ErrorText(int err) {
+    return std::error_code(err, std::generic_category()).message();
+}
+
+bool ReadAll(int fd, char* buf, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = read(fd, buf + done, len - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+uint64_t ScanBuffer(const TextMatcher& matcher, const char* data, size_t len, uint64_t max_lines,
+                    std::vector<LineMatch>* out) {
+    uint64_t hits = 0;
+    uint64_t line = 1;
+    size_t counted = 0;     // line start up to which newlines have been counted
+    size_t pos = 0;
+    while (pos < len && (max_lines == 0 || hits < max_lines)) {
+        size_t match_len = 0;
+        size_t at = matcher.Find(data, len, pos, match_len);
+        if (at == kNoMatch) break;
+
+        const void* nl = memrchr(data + counted, '\n', at - counted);
+        size_t start = nl ? static_cast<size_t>(static_cast<const char*>(nl) - data) + 1 : counted;
+        line += CountNewlines(data + counted, start - counted);
+        counted = start;
+        const void* eol = std::memchr(data + at, '\n', len - at);
+        size_t end = eol ? static_cast<size_t>(static_cast<const char*>(eol) - data) : len;
+
+        if (out) {
+            LineMatch m;
+            m.line = line;
+            m.column = at - start + 1;
+            m.text = std::string_view(data + start, end - start);
+            m.match_length = std::min(match_len, end - at);
+            out->push_back(m);
+        }
+        ++hits;
+        pos = end + 1;
+    }
+    return hits;
+}
+
+FileSearcher::FileSearcher(const TextMatcher* matcher, Options options)
+    : matcher_(matcher), options_(std::move(options)),
+      threads_(options_.threads ? options_.threads : TreeWalker::DefaultThreads()) {
+    if (!options_.excludes.empty()) {
+        std::string text;
+        for (const auto& glob : options_.excludes) text += glob + "\n";
+        excludes_ = std::make_unique<IgnoreRules>("", text);
+    }
+}
+
+FileSearcher::~FileSearcher() = default;
+
+void FileSearcher::Fail(const std::string& path, int err) {
+    errors_.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(errors_mutex_);
+    if (error_messages_.size() < kMaxErrorMessages) error_messages_.push_back(path + ": " + ErrorText(err));
+}
+
+bool FileSearcher::Excluded(std::string_view rel, std::string_view name, bool is_dir,
+                            const std::shared_ptr<const IgnoreRules>& rules) const {
+    if (rules && rules->Ignored(rel, is_dir)) return true;
+    if (excludes_ && excludes_->Ignored(rel, is_dir)) return true;
+    if (is_dir || options_.includes.empty()) return false;
+    return std::none_of(options_.includes.begin(), options_.includes.end(), [&](const std::string& glob) {
+        return GlobMatch(glob, glob.find('/') == std::string::npos ? name : rel);
+    });
+}
+
+void FileSearcher::ScanFile(int dir_fd, const std::string& name, const std::string& path, const FileCallback& on_file) {
+    files_.fetch_add(1, std::memory_order_relaxed);
+    static const std::vector<LineMatch> kNoLines;
+    if (!matcher_) {
+        matched_files_.fetch_add(1, std::memory_order_relaxed);
+        on_file(path, 0, kNoLines, false);
+        return;
+    }
+
+    int fd = openat(dir_fd, name.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW | O_NONBLOCK);
+    if (fd < 0) return Fail(path, errno);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+        close(fd);
+        return;
+    }
+    size_t len = static_cast<size_t>(st.st_size);
+
+    // Small files go through one reusable per-thread buffer; mapping them
+    // would cost more in page-table setup than the copy
+    thread_local std::vector<char> buffer;
+    const char* data = nullptr;
+    void* map = MAP_FAILED;
+    if (len <= kReadLimit) {
+        if (buffer.size() < len) buffer.resize(std::max(len, size_t{64 * 1024}));
+        if (!ReadAll(fd, buffer.data(), len)) {
+            int err = errno ? errno : EIO;
+            close(fd);
+            return Fail(path, err);
+        }
+        data = buffer.data();
+    } else {
+        map = mmap(nullptr, len, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        if (map == MAP_FAILED) {
+            int err = errno;
+            close(fd);
+            return Fail(path, err);
+        }
+        data = static_cast<const char*>(map);
+    }
+    close(fd);
+    bytes_.fetch_add(len, std::memory_order_relaxed);
+
+    bool binary = std::memchr(data, '\0', std::min(len, kBinaryProbe)) != nullptr;
+    thread_local std::vector<LineMatch> lines;
+    lines.clear();
+    bool collect = options_.collect_lines && !binary;
+    uint64_t hits = ScanBuffer(*matcher_, data, len, binary ? 1 : options_.max_per_file, collect ? &lines : nullptr);
+    if (hits) {
+        matched_files_.fetch_add(1, std::memory_order_relaxed);
+        matched_lines_.fetch_add(hits, std::memory_order_relaxed);
+        on_file(path, hits, lines, binary);
+    }
+    if (map != MAP_FAILED) munmap(map, len);
+}
+
+bool FileSearcher::Search(const std::string& root, const FileCallback& on_file,
+                          const std::function<bool()>& should_stop, const std::function<void()>& on_tick) {
+    struct stat st;
+    if (stat(root.c_str(), &st) != 0) throw CommandError("search: " + root + ": " + ErrorText(errno));
+    if (!S_ISDIR(st.st_mode)) {
+        // A file named directly is always searched, whatever the filters say
+        size_t slash = root.rfind('/');
+        std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : root.substr(0, slash));
+        int dir_fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dir_fd < 0) throw CommandError("search: " + root + ": " + ErrorText(errno));
+        ScanFile(dir_fd, root.substr(slash == std::string::npos ? 0 : slash + 1), root, on_file);
+        close(dir_fd);
+        return true;
+    }
+
+    int root_fd = open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (root_fd < 0) throw CommandError("search: cannot open " + root + ": " + ErrorText(errno));
+
+    std::string prefix = root;
+    while (prefix.size() > 1 && prefix.back() == '/') prefix.pop_back();
+    if (prefix == ".") prefix.clear();
+    else if (prefix != "/") prefix += '/';
+    auto display = [&](const std::string& rel) { return prefix + rel; };
+
+    rules_.clear();
+    if (options_.use_ignore_files) {
+        auto top = IgnoreRules::Load(root_fd, ".gitignore", "", nullptr);
+        if (top) rules_[""] = top;
+    }
+    auto rules_for = [&](const std::string& dir) -> std::shared_ptr<const IgnoreRules> {
+        std::lock_guard<std::mutex> lock(rules_mutex_);
+        auto it = rules_.find(dir);
+        return it == rules_.end() ? nullptr : it->second;
+    };
+
+    TreeWalker::Visitor visitor;
+    visitor.directory = [&](const TreeWalker::Entry& e) {
+        if (e.name == ".git") return false;
+        std::string rel = e.Path();
+        auto rules = rules_for(e.dir.path);
+        if (Excluded(rel, e.name, true, rules)) return false;
+        if (options_.use_ignore_files) {
+            auto own = IgnoreRules::Load(e.dir.fd, std::string(e.name) + "/.gitignore", rel, rules);
+            if (own) {
+                std::lock_guard<std::mutex> lock(rules_mutex_);
+                rules_[rel] = own;
+            }
+        }
+        return true;
+    };
+    visitor.entry = [&](const TreeWalker::Entry& e) {
+        bool listable = e.type == DT_REG || (!matcher_ && e.type == DT_LNK);
+        if (!listable) return;
+        std::string rel = e.Path();
+        if (Excluded(rel, e.name, false, rules_for(e.dir.path))) return;
+        ScanFile(e.dir.fd, std::string(e.name), display(rel), on_file);
+    };
+    visitor.leave = [&](const TreeWalker::Dir& d) {
+        std::lock_guard<std::mutex> lock(rules_mutex_);
+        rules_.erase(d.path);
+    };
+    visitor.error = [&](const std::string& dir, int err) { Fail(dir.empty() ? root : display(dir), err); };
+
+    bool complete = TreeWalker(threads_).Walk(root_fd, visitor, should_stop, on_tick);
+    close(root_fd);
+    rules_.clear();
+    return complete;
+}
+
+SearchStats FileSearcher::Stats() const {
+    SearchStats s;
+    s.files = files_.load(std::memory_order_relaxed);
+    s.bytes = bytes_.load(std::memory_order_relaxed);
+    s.matched_files = matched_files_.load(std::memory_order_relaxed);
+    s.matched_lines = matched_lines_.load(std::memory_order_relaxed);
+    s.errors = errors_.load(std::memory_order_relaxed);
+    return s;
+}
+
+std::vector<std::string> FileSearcher::Errors() const {
+    std::lock_guard<std::mutex> lock(errors_mutex_);
+    return error_messages_;
+}
+
+} // namespace RedTops
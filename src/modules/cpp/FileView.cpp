@@ -0,0 +1,256 @@
+#include "../headers/FileView.hpp"
+#include "../headers/TextSearch.hpp"
+#include "../../core/header/Exceptions.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace RedTops {
+
+namespace {
+
+constexpr uint64_t kIndexBlock = 4 * 1024 * 1024;
+constexpr uint64_t kIndexStep = 4096;
+constexpr uint64_t kSearchSlice = 64 * 1024 * 1024;
+
+std::string ErrorText(int err) {
+    return std::error_code(err, std::generic_category()).message();
+}
+
+// Drops the page mappings of a scanned range. The pages stay in the page
+// cache and fault back in if shown again, so the pager's resident set does
+// not grow as the indexer and searches sweep the file.
+void Release(const char* base, uint64_t begin, uint64_t end) {
+    static const uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    begin = (begin + page - 1) / page * page;
+    end = end / page * page;
+    if (end > begin) madvise(const_cast<char*>(base) + begin, end - begin, MADV_DONTNEED);
+}
+
+} // namespace
+
+FileView::FileView(const std::string& path) {
+    fd_ = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) throw CommandError("view: cannot open " + path + ": " + ErrorText(errno));
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        int err = errno;
+        close(fd_);
+        throw CommandError("view: cannot stat " + path + ": " + ErrorText(err));
+    }
+    if (!S_ISREG(st.st_mode)) {
+        close(fd_);
+        throw CommandError("view: " + path + ": not a regular file");
+    }
+    size_ = map_size_ = static_cast<uint64_t>(st.st_size);
+    if (size_ > 0) {
+        void* map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (map == MAP_FAILED) {
+            int err = errno;
+            close(fd_);
+            throw CommandError("view: cannot map " + path + ": " + ErrorText(err));
+        }
+        data_ = static_cast<const char*>(map);
+    }
+    checkpoints_.push_back(0);
+}
+
+FileView::~FileView() {
+    stop_ = true;
+    if (indexer_.joinable()) indexer_.join();
+    if (data_) munmap(const_cast<char*>(data_), map_size_);
+    if (fd_ >= 0) close(fd_);
+}
+
+void FileView::StartIndexing() {
+    if (indexer_.joinable() || done_) return;
+    indexer_ = std::thread([this] { Index(); });
+}
+
+bool FileView::Shrunk(uint64_t end) const {
+    struct stat st;
+    return fstat(fd_, &st) == 0 && static_cast<uint64_t>(st.st_size) < end;
+}
+
+bool FileView::Refresh() {
+    struct stat st;
+    if (fstat(fd_, &st) != 0 || static_cast<uint64_t>(st.st_size) >= size_) return false;
+    uint64_t size = static_cast<uint64_t>(st.st_size);
+
+    // Whole pages past the new end fault with SIGBUS; anonymous zero pages
+    // over them make a read still in flight harmless. The page holding the
+    // new end reads zeros past it without faulting.
+    static const uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    uint64_t keep = (size + page - 1) / page * page;
+    if (keep < map_size_)
+        mmap(const_cast<char*>(data_) + keep, map_size_ - keep, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+
+    bool indexing = indexer_.joinable();
+    stop_ = true;
+    if (indexing) indexer_.join();
+    {
+        std::lock_guard<std::mutex> lock(index_mutex_);
+        size_ = size;
+        checkpoints_.assign(1, 0);
+        stride_ = 256;
+        indexed_bytes_ = 0;
+        indexed_lines_ = 0;
+        done_ = false;
+    }
+    stop_ = false;
+    if (indexing) StartIndexing();
+    return true;
+}
+
+// Newlines are counted a block, then a step, at a time; only the step that
+// holds the next checkpoint is walked newline by newline
+void FileView::Index() {
+    uint64_t pos = 0, lines = 0;
+    uint64_t next = stride_;        // line number of the next checkpoint
+    while (pos < size_ && !stop_.load(std::memory_order_relaxed)) {
+        uint64_t end = std::min(size_, pos + kIndexBlock);
+        if (Shrunk(end)) return;       // Refresh() starts over on the new size
+        uint64_t in_block = CountNewlines(data_ + pos, end - pos);
+        std::unique_lock<std::mutex> lock(index_mutex_);
+        if (lines + in_block < next) {
+            lines += in_block;
+        } else {
+            for (uint64_t p = pos; p < end;) {
+                // Count whole steps until the next checkpoint is inside one
+                uint64_t step = std::min(end, p + kIndexStep);
+                uint64_t in_step = CountNewlines(data_ + p, step - p);
+                if (lines + in_step < next) {
+                    lines += in_step;
+                    p = step;
+                    continue;
+                }
+                while (lines < next) {
+                    const void* nl = std::memchr(data_ + p, '\n', step - p);
+                    p = static_cast<uint64_t>(static_cast<const char*>(nl) - data_) + 1;
+                    ++lines;
+                }
+                if (checkpoints_.size() == kMaxCheckpoints) {
+                    // Keep every other checkpoint; the next one lands on the new stride
+                    for (size_t k = 0; k < kMaxCheckpoints / 2; ++k) checkpoints_[k] = checkpoints_[2 * k];
+                    checkpoints_.resize(kMaxCheckpoints / 2);
+                    stride_ *= 2;
+                }
+                checkpoints_.push_back(p);
+                next += stride_;
+            }
+        }
+        indexed_lines_.store(lines, std::memory_order_relaxed);
+        indexed_bytes_.store(end, std::memory_order_release);
+        lock.unlock();
+        Release(data_, pos, end);
+        pos = end;
+    }
+    if (pos >= size_) done_ = true;
+}
+
+IndexProgress FileView::Progress() const {
+    std::lock_guard<std::mutex> lock(index_mutex_);
+    IndexProgress p;
+    p.bytes = indexed_bytes_.load();
+    p.lines = indexed_lines_.load();
+    p.done = done_.load() || size_ == 0;
+    // An unterminated last line still counts as a line
+    if (p.done && size_ > 0 && data_[size_ - 1] != '\n') ++p.lines;
+    return p;
+}
+
+uint64_t FileView::LineStart(uint64_t offset) const {
+    if (offset == 0 || size_ == 0) return 0;
+    offset = std::min(offset, size_);
+    const void* nl = memrchr(data_, '\n', offset);
+    return nl ? static_cast<uint64_t>(static_cast<const char*>(nl) - data_) + 1 : 0;
+}
+
+uint64_t FileView::NextLine(uint64_t offset) const {
+    if (offset >= size_) return size_;
+    const void* nl = std::memchr(data_ + offset, '\n', size_ - offset);
+    return nl ? static_cast<uint64_t>(static_cast<const char*>(nl) - data_) + 1 : size_;
+}
+
+uint64_t FileView::PrevLine(uint64_t offset) const {
+    uint64_t start = LineStart(offset);
+    return start == 0 ? 0 : LineStart(start - 1);
+}
+
+std::string_view FileView::Line(uint64_t offset) const {
+    if (offset >= size_) return {};
+    const void* nl = std::memchr(data_ + offset, '\n', size_ - offset);
+    uint64_t end = nl ? static_cast<uint64_t>(static_cast<const char*>(nl) - data_) : size_;
+    return std::string_view(data_ + offset, end - offset);
+}
+
+bool FileView::LineOffset(uint64_t line, uint64_t& offset) const {
+    std::lock_guard<std::mutex> lock(index_mutex_);
+    if (line > indexed_lines_.load(std::memory_order_relaxed)) return false;
+    uint64_t k = line / stride_;
+    if (k >= checkpoints_.size()) return false;
+    uint64_t p = checkpoints_[k];
+    for (uint64_t rest = line % stride_; rest > 0; --rest) {
+        const void* nl = std::memchr(data_ + p, '\n', size_ - p);
+        if (!nl) return false;
+        p = static_cast<uint64_t>(static_cast<const char*>(nl) - data_) + 1;
+    }
+    if (p >= size_ && line > 0) return false;
+    offset = p;
+    return true;
+}
+
+bool FileView::LineNumber(uint64_t offset, uint64_t& line) const {
+    if (offset > indexed_bytes_.load(std::memory_order_acquire) && !done_) return false;
+    std::lock_guard<std::mutex> lock(index_mutex_);
+    auto it = std::upper_bound(checkpoints_.begin(), checkpoints_.end(), offset);
+    size_t k = static_cast<size_t>(it - checkpoints_.begin()) - 1;
+    uint64_t from = checkpoints_[k];
+    line = k * stride_ + (offset > from ? CountNewlines(data_ + from, offset - from) : 0);
+    return true;
+}
+
+uint64_t FileView::Search(const TextMatcher& matcher, uint64_t from, bool forward, size_t& match_len,
+                          const std::function<bool()>& should_stop) const {
+    if (size_ == 0) return kNoMatch;
+    if (forward) {
+        for (uint64_t pos = from; pos < size_;) {
+            // Finding a slice's end already reads past it
+            if (Shrunk(size_)) break;
+            uint64_t end = pos + kSearchSlice < size_ ? NextLine(pos + kSearchSlice) : size_;
+            size_t at = matcher.Find(data_, end, pos, match_len);
+            if (at != kNoMatch) return at;
+            Release(data_, pos, end);
+            pos = end;
+            if (should_stop && should_stop()) break;
+        }
+        return kNoMatch;
+    }
+    for (uint64_t end = std::min(from, size_); end > 0;) {
+        if (Shrunk(end)) break;
+        uint64_t begin = end > kSearchSlice ? LineStart(end - kSearchSlice) : 0;
+        uint64_t best = kNoMatch;
+        size_t len = 0;
+        for (uint64_t p = begin; p < end;) {
+            size_t at = matcher.Find(data_, end, p, len);
+            if (at == kNoMatch) break;
+            best = at;
+            match_len = len;
+            p = NextLine(at);       // a regex may only resume at a line start
+        }
+        if (best != kNoMatch) return best;
+        Release(data_, begin, end);
+        end = begin;
+        if (should_stop && should_stop()) break;
+    }
+    return kNoMatch;
+}
+
+} // namespace RedTops
@@ -0,0 +1,218 @@
+#include "../headers/HardwareInventory.hpp"
+#include "../headers/ProcSampler.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <set>
+#include <string_view>
+#include <utility>
+
+namespace RedTops {
+
+namespace {
+
+std::string_view Trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\n')) s.remove_suffix(1);
+    return s;
+}
+
+template <typename T>
+bool ParseNumber(std::string_view s, T& out) {
+    s = Trim(s);
+    auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), out);
+    return ec == std::errc() && ptr != s.data();
+}
+
+// "48K", "2048K", "266240 KB", "1M"
+uint64_t ParseSize(std::string_view s) {
+    s = Trim(s);
+    uint64_t value = 0;
+    auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+    if (ec != std::errc()) return 0;
+    std::string_view unit = Trim(s.substr(static_cast<size_t>(ptr - s.data())));
+    if (unit.empty()) return value;
+    switch (unit.front()) {
+        case 'K': case 'k': return value << 10;
+        case 'M': case 'm': return value << 20;
+        case 'G': case 'g': return value << 30;
+        default: return value;
+    }
+}
+
+// Whole small sysfs file, trimmed; empty when it does not exist
+std::string_view ReadSys(ProcFile& file, const char* path) {
+    if (!file.Open(path)) return {};
+    return Trim(file.Read());
+}
+
+template <typename T>
+bool ReadSysNumber(ProcFile& file, const char* path, T& out) {
+    return ParseNumber(ReadSys(file, path), out);
+}
+
+void AddTopology(HardwareInventory& inv) {
+    ProcFile file;
+    char path[128];
+
+    bool have_topology = false;
+    for (LogicalCpu& cpu : inv.cpus) {
+        std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu.id);
+        int socket = 0;
+        if (!ReadSysNumber(file, path, socket)) continue;
+        cpu.socket = socket;
+        std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu.id);
+        ReadSysNumber(file, path, cpu.core);
+        have_topology = true;
+    }
+
+    // NUMA nodes list their CPUs; absent on kernels built without NUMA
+    std::string_view nodes = ReadSys(file, "/sys/devices/system/node/online");
+    std::vector<int> node_ids = ParseCpuList(nodes);
+    for (int node : node_ids) {
+        std::snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        for (int id : ParseCpuList(ReadSys(file, path))) {
+            for (LogicalCpu& cpu : inv.cpus)
+                if (cpu.id == id) cpu.node = node;
+        }
+    }
+    inv.numa_nodes = node_ids.empty() ? 1 : static_cast<unsigned>(node_ids.size());
+
+    // Cache hierarchy as seen from the first CPU; instances are counted by
+    // the distinct sharing sets across all CPUs
+    if (!inv.cpus.empty()) {
+        int first = inv.cpus.front().id;
+        for (int index = 0;; ++index) {
+            std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/level", first, index);
+            CpuCache cache;
+            if (!ReadSysNumber(file, path, cache.level)) break;
+            std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/type", first, index);
+            cache.type = std::string(ReadSys(file, path));
+            std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/size", first, index);
+            cache.size_bytes = ParseSize(ReadSys(file, path));
+            std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/coherency_line_size", first, index);
+            ReadSysNumber(file, path, cache.line_size);
+            std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/ways_of_associativity", first, index);
+            ReadSysNumber(file, path, cache.ways);
+
+            std::set<std::string> sharing_sets;
+            for (const LogicalCpu& cpu : inv.cpus) {
+                std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list", cpu.id, index);
+                std::string_view list = ReadSys(file, path);
+                if (cpu.id == first) cache.shared_by = static_cast<unsigned>(ParseCpuList(list).size());
+                sharing_sets.emplace(list);
+            }
+            cache.instances = static_cast<unsigned>(sharing_sets.size());
+            inv.caches.push_back(std::move(cache));
+        }
+    }
+
+    if (!have_topology) return;
+    std::set<int> sockets;
+    std::set<std::pair<int, int>> cores;
+    for (const LogicalCpu& cpu : inv.cpus) {
+        sockets.insert(cpu.socket);
+        cores.emplace(cpu.socket, cpu.core);
+    }
+    inv.sockets = static_cast<unsigned>(sockets.size());
+    inv.physical_cores = static_cast<unsigned>(cores.size());
+    inv.threads_per_core = inv.physical_cores ? static_cast<unsigned>(inv.cpus.size() / inv.physical_cores) : 1;
+}
+
+} // namespace
+
+std::vector<int> ParseCpuList(std::string_view text) {
+    std::vector<int> ids;
+    text = Trim(text);
+    while (!text.empty()) {
+        size_t comma = text.find(',');
+        std::string_view range = text.substr(0, comma);
+        text.remove_prefix(comma == std::string_view::npos ? text.size() : comma + 1);
+
+        size_t dash = range.find('-');
+        int lo = 0, hi = 0;
+        if (!ParseNumber(range.substr(0, dash), lo)) continue;
+        hi = lo;
+        if (dash != std::string_view::npos && !ParseNumber(range.substr(dash + 1), hi)) continue;
+        for (int id = lo; id <= hi; ++id) ids.push_back(id);
+    }
+    return ids;
+}
+
+HardwareInventory HardwareInventory::FromCpuInfo(std::string_view text) {
+    HardwareInventory inv;
+    LogicalCpu* cpu = nullptr;
+
+    while (!text.empty()) {
+        size_t eol = text.find('\n');
+        std::string_view line = text.substr(0, eol);
+        text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) continue;
+        std::string_view key = Trim(line.substr(0, colon));
+        std::string_view value = Trim(line.substr(colon + 1));
+
+        if (key == "processor") {
+            // ARM kernels also print a machine-wide "Processor : <name>" line
+            int id = 0;
+            if (!ParseNumber(value, id)) {
+                if (inv.model.empty()) inv.model = std::string(value);
+                continue;
+            }
+            inv.cpus.emplace_back();
+            cpu = &inv.cpus.back();
+            cpu->id = id;
+            cpu->core = id;
+            continue;
+        }
+
+        // Fields before the first "processor" line or shared by every CPU
+        if (key == "model name" || key == "cpu model" || key == "Processor") {
+            if (inv.model.empty()) inv.model = std::string(value);
+        } else if (key == "vendor_id" || key == "CPU implementer") {
+            if (inv.vendor.empty()) inv.vendor = std::string(value);
+        } else if (key == "microcode") {
+            if (inv.microcode.empty()) inv.microcode = std::string(value);
+        } else if (key == "cache size") {
+            if (!inv.cache_size_bytes) inv.cache_size_bytes = ParseSize(value);
+        } else if (!cpu) {
+            continue;
+        } else if (key == "flags" || key == "Features") {
+            auto it = std::find(inv.flag_sets.begin(), inv.flag_sets.end(), value);
+            if (it == inv.flag_sets.end()) it = inv.flag_sets.emplace(inv.flag_sets.end(), value);
+            cpu->flag_set = static_cast<size_t>(it - inv.flag_sets.begin());
+        } else if (key == "bogomips" || key == "BogoMIPS") {
+            ParseNumber(value, cpu->bogomips);
+        } else if (key == "physical id") {
+            ParseNumber(value, cpu->socket);
+        } else if (key == "core id") {
+            ParseNumber(value, cpu->core);
+        }
+    }
+
+    std::set<int> sockets;
+    std::set<std::pair<int, int>> cores;
+    for (const LogicalCpu& c : inv.cpus) {
+        sockets.insert(c.socket);
+        cores.emplace(c.socket, c.core);
+    }
+    inv.sockets = static_cast<unsigned>(std::max<size_t>(1, sockets.size()));
+    inv.physical_cores = static_cast<unsigned>(cores.size());
+    inv.threads_per_core = inv.physical_cores ? static_cast<unsigned>(inv.cpus.size() / inv.physical_cores) : 1;
+    inv.numa_nodes = 1;
+    return inv;
+}
+
+const HardwareInventory& HardwareInventory::Get() {
+    static const HardwareInventory inventory = [] {
+        ProcFile cpuinfo("/proc/cpuinfo");
+        HardwareInventory inv = FromCpuInfo(cpuinfo.Read());
+        AddTopology(inv);
+        return inv;
+    }();
+    return inventory;
+}
+
+} // namespace RedTops
@@ -0,0 +1,129 @@
+#include "../headers/IfaceRateMonitor.hpp"
+#include "../../core/header/Exceptions.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+
+#include <dirent.h>
+
+namespace RedTops {
+
+namespace {
+
+constexpr const char* kCounterFiles[] = {
+    "rx_bytes", "tx_bytes", "rx_packets", "tx_packets",
+    "rx_errors", "tx_errors", "rx_dropped", "tx_dropped",
+};
+
+uint64_t MonotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// Drivers with 32-bit counters wrap; a reset or wrap reads as no traffic
+inline double Delta(uint64_t cur, uint64_t prev) { return cur >= prev ? static_cast<double>(cur - prev) : 0.0; }
+
+std::vector<std::string> AllInterfaces() {
+    std::vector<std::string> names;
+    DIR* dir = opendir("/sys/class/net");
+    if (!dir) return names;
+    while (dirent* d = readdir(dir)) {
+        if (d->d_name[0] == '.') continue;
+        names.emplace_back(d->d_name);
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+} // namespace
+
+IfaceRateMonitor::IfaceRateMonitor(const std::vector<std::string>& names) {
+    std::vector<std::string> wanted = names.empty() ? AllInterfaces() : names;
+    ifaces_.reserve(wanted.size());
+
+    char path[160];
+    for (const std::string& name : wanted) {
+        if (name.empty() || name.find('/') != std::string::npos || name.size() > 64)
+            throw CommandError("netinfo: invalid interface name '" + name + "'");
+        Iface iface;
+        iface.name = name;
+        for (size_t c = 0; c < kCounters; ++c) {
+            std::snprintf(path, sizeof(path), "/sys/class/net/%s/statistics/%s", name.c_str(), kCounterFiles[c]);
+            if (!iface.files[c].Open(path))
+                throw CommandError("netinfo: no statistics for interface '" + name + "'");
+            // Size the read buffer now so sampling never grows it
+            iface.files[c].Read();
+        }
+        ifaces_.push_back(std::move(iface));
+    }
+}
+
+IfaceRates IfaceRateMonitor::Rates(const Snapshot& from, const Snapshot& to, double seconds) {
+    IfaceRates r;
+    if (seconds <= 0) return r;
+    double k = 1.0 / seconds;
+    r.rx_bps = Delta(to[RxBytes], from[RxBytes]) * 8 * k;
+    r.tx_bps = Delta(to[TxBytes], from[TxBytes]) * 8 * k;
+    r.rx_pps = Delta(to[RxPackets], from[RxPackets]) * k;
+    r.tx_pps = Delta(to[TxPackets], from[TxPackets]) * k;
+    r.rx_errors = Delta(to[RxErrors], from[RxErrors]) * k;
+    r.tx_errors = Delta(to[TxErrors], from[TxErrors]) * k;
+    r.rx_drops = Delta(to[RxDropped], from[RxDropped]) * k;
+    r.tx_drops = Delta(to[TxDropped], from[TxDropped]) * k;
+    return r;
+}
+
+void IfaceRateMonitor::Sample() {
+    uint64_t now = MonotonicNs();
+    bool primed = last_ns_ != 0;
+    double seconds = primed ? static_cast<double>(now - last_ns_) / 1e9 : 0;
+
+    for (Iface& iface : ifaces_) {
+        Snapshot cur{};
+        iface.up = true;
+        for (size_t c = 0; c < kCounters; ++c) {
+            FieldReader r(iface.files[c].Read());
+            if (r.text.empty()) {
+                iface.up = false;   // interface went away; keep the last values
+                cur = iface.last;
+                break;
+            }
+            cur[c] = r.U64();
+        }
+
+        if (primed) {
+            iface.instant = Rates(iface.last, cur, seconds);
+            iface.history[history_pos_] = iface.instant.rx_bps + iface.instant.tx_bps;
+        } else {
+            iface.mark = cur;
+        }
+        iface.last = cur;
+    }
+
+    if (primed) {
+        history_pos_ = (history_pos_ + 1) % kHistory;
+        history_len_ = std::min(history_len_ + 1, kHistory);
+    } else {
+        mark_ns_ = now;
+    }
+    last_ns_ = now;
+}
+
+void IfaceRateMonitor::EndWindow() {
+    double seconds = static_cast<double>(last_ns_ - mark_ns_) / 1e9;
+    for (Iface& iface : ifaces_) {
+        iface.window = Rates(iface.mark, iface.last, seconds);
+        iface.mark = iface.last;
+    }
+    mark_ns_ = last_ns_;
+}
+
+double IfaceRateMonitor::History(size_t i, size_t age) const {
+    if (age >= history_len_) return 0;
+    return ifaces_[i].history[(history_pos_ + kHistory - 1 - age) % kHistory];
+}
+
+} // namespace RedTops
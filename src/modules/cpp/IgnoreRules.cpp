@@ -0,0 +1,159 @@
+#include "../headers/IgnoreRules.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace RedTops {
+
+namespace {
+
+// Matches one [...] class at the start of p against c; sets used to the
+// class length, or 0 if the bracket is not closed (then it is a literal '[')
+bool MatchClass(std::string_view p, char c, size_t& used) {
+    size_t i = 1;
+    bool negate = i < p.size() && (p[i] == '!' || p[i] == '^');
+    if (negate) ++i;
+    bool hit = false;
+    bool first = true;
+    for (; i < p.size() && (p[i] != ']' || first); first = false) {
+        char lo = p[i];
+        if (lo == '\\' && i + 1 < p.size()) lo = p[++i];
+        char hi = lo;
+        if (i + 2 < p.size() && p[i + 1] == '-' && p[i + 2] != ']') {
+            hi = p[i + 2];
+            i += 2;
+        }
+        if (c >= lo && c <= hi) hit = true;
+        ++i;
+    }
+    if (i >= p.size()) {
+        used = 0;
+        return false;
+    }
+    used = i + 1;
+    return hit != negate;
+}
+
+} // namespace
+
+bool GlobMatch(std::string_view p, std::string_view t) {
+    while (!p.empty()) {
+        if (p.size() >= 2 && p[0] == '*' && p[1] == '*') {
+            std::string_view rest = p.substr(2);
+            if (rest.empty()) return true;
+            if (rest[0] == '/') {
+                // "**/" is zero or more whole directories
+                rest.remove_prefix(1);
+                for (size_t k = 0;; ++k) {
+                    if (GlobMatch(rest, t.substr(k))) return true;
+                    k = t.find('/', k);
+                    if (k == std::string_view::npos) return false;
+                }
+            }
+            for (size_t k = 0; k <= t.size(); ++k)
+                if (GlobMatch(rest, t.substr(k))) return true;
+            return false;
+        }
+        switch (p[0]) {
+            case '*':
+                for (size_t k = 0; k <= t.size(); ++k) {
+                    if (GlobMatch(p.substr(1), t.substr(k))) return true;
+                    if (k < t.size() && t[k] == '/') break;
+                }
+                return false;
+            case '?':
+                if (t.empty() || t[0] == '/') return false;
+                break;
+            case '[': {
+                if (t.empty() || t[0] == '/') return false;
+                size_t used = 0;
+                bool hit = MatchClass(p, t[0], used);
+                if (used == 0) {
+                    if (t[0] != '[') return false;
+                    used = 1;
+                } else if (!hit) {
+                    return false;
+                }
+                p.remove_prefix(used);
+                t.remove_prefix(1);
+                continue;
+            }
+            case '\\':
+                if (p.size() > 1) p.remove_prefix(1);
+                [[fallthrough]];
+            default:
+                if (t.empty() || t[0] != p[0]) return false;
+        }
+        p.remove_prefix(1);
+        t.remove_prefix(1);
+    }
+    return t.empty();
+}
+
+IgnoreRules::IgnoreRules(std::string base, std::string_view text, std::shared_ptr<const IgnoreRules> parent)
+    : base_(std::move(base)), parent_(std::move(parent)) {
+    while (!text.empty()) {
+        size_t eol = text.find('\n');
+        std::string_view line = text.substr(0, eol);
+        text = eol == std::string_view::npos ? std::string_view() : text.substr(eol + 1);
+
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        // Trailing spaces are dropped unless escaped
+        while (!line.empty() && line.back() == ' ' && !(line.size() > 1 && line[line.size() - 2] == '\\'))
+            line.remove_suffix(1);
+        if (line.empty() || line[0] == '#') continue;
+
+        Rule rule;
+        if (line[0] == '!') {
+            rule.negate = true;
+            line.remove_prefix(1);
+        } else if (line[0] == '\\' && line.size() > 1 && (line[1] == '!' || line[1] == '#')) {
+            line.remove_prefix(1);
+        }
+        if (!line.empty() && line.back() == '/') {
+            rule.dir_only = true;
+            line.remove_suffix(1);
+        }
+        if (line.empty()) continue;
+        rule.anchored = line.find('/') != std::string_view::npos;
+        if (line[0] == '/') line.remove_prefix(1);
+        rule.glob = std::string(line);
+        rules_.push_back(std::move(rule));
+    }
+}
+
+std::shared_ptr<const IgnoreRules> IgnoreRules::Load(int at_fd, const std::string& file, const std::string& base,
+                                                     std::shared_ptr<const IgnoreRules> parent) {
+    int fd = openat(at_fd, file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return parent;
+    std::string text;
+    char buf[16 * 1024];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) text.append(buf, static_cast<size_t>(n));
+    close(fd);
+    auto rules = std::make_shared<IgnoreRules>(base, text, parent);
+    return rules->Empty() ? parent : rules;
+}
+
+int IgnoreRules::Decide(std::string_view path, bool is_dir) const {
+    std::string_view rel = path;
+    if (!base_.empty()) {
+        if (rel.size() <= base_.size() || rel.compare(0, base_.size(), base_) != 0 || rel[base_.size()] != '/')
+            return parent_ ? parent_->Decide(path, is_dir) : 0;
+        rel.remove_prefix(base_.size() + 1);
+    }
+    size_t slash = rel.rfind('/');
+    std::string_view name = slash == std::string_view::npos ? rel : rel.substr(slash + 1);
+
+    for (auto it = rules_.rbegin(); it != rules_.rend(); ++it) {
+        if (it->dir_only && !is_dir) continue;
+        if (GlobMatch(it->glob, it->anchored ? rel : name)) return it->negate ? -1 : 1;
+    }
+    return parent_ ? parent_->Decide(path, is_dir) : 0;
+}
+
+bool IgnoreRules::Ignored(std::string_view path, bool is_dir) const {
+    return Decide(path, is_dir) > 0;
+}
+
+} // namespace RedTops
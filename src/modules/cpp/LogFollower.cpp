@@ -0,0 +1,310 @@
+#include "../headers/LogFollower.hpp"
+#include "../headers/FileSearcher.hpp"
+#include "../headers/TextSearch.hpp"
+#include "../../core/header/Exceptions.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace RedTops {
+
+namespace {
+
+constexpr size_t kReadBlock = 256 * 1024;
+constexpr size_t kMaxLine = 1024 * 1024;        // a longer unterminated line is shown as it is
+constexpr uint32_t kFileMask = IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF;
+constexpr uint32_t kDirMask = IN_CREATE | IN_MOVED_TO;
+
+std::string ErrorText(int err) {
+    return std::error_code(err, std::generic_category()).message();
+}
+
+} // namespace
+
+LogFollower::LogFollower(std::vector<std::string> paths, Options options)
+    : options_(options), buf_(kReadBlock) {
+    for (auto& path : paths) {
+        File f;
+        size_t slash = path.rfind('/');
+        f.name = slash == std::string::npos ? path : path.substr(slash + 1);
+        f.path = std::move(path);
+        files_.push_back(std::move(f));
+    }
+}
+
+LogFollower::~LogFollower() {
+    for (auto& f : files_)
+        if (f.fd >= 0) close(f.fd);
+    if (inotify_ >= 0) close(inotify_);
+}
+
+bool LogFollower::Open(size_t i, const Handler& handler) {
+    File& f = files_[i];
+    auto notice = [&](const std::string& message) {
+        if (handler.notice) handler.notice(i, message);
+    };
+    int fd = open(f.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        notice("cannot open: " + ErrorText(errno) + "; waiting for it to appear");
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        notice("cannot stat: " + ErrorText(errno));
+        close(fd);
+        return false;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        notice("is a directory");
+        close(fd);
+        return false;
+    }
+    int wd = inotify_add_watch(inotify_, f.path.c_str(), kFileMask);
+    if (wd < 0) {
+        notice("cannot watch: " + ErrorText(errno));
+        close(fd);
+        return false;
+    }
+    f.fd = fd;
+    f.wd = wd;
+    f.dev = st.st_dev;
+    f.ino = st.st_ino;
+    f.offset = 0;
+    f.partial.clear();
+    f.gone = false;
+    watches_[wd].push_back(i);
+    return true;
+}
+
+void LogFollower::Close(size_t i) {
+    File& f = files_[i];
+    if (f.wd >= 0) {
+        auto it = watches_.find(f.wd);
+        if (it != watches_.end()) {
+            it->second.erase(std::remove(it->second.begin(), it->second.end(), i), it->second.end());
+            if (it->second.empty()) {
+                inotify_rm_watch(inotify_, f.wd);
+                watches_.erase(it);
+            }
+        }
+        f.wd = -1;
+    }
+    if (f.fd >= 0) close(f.fd);
+    f.fd = -1;
+}
+
+// Start of the last initial_lines lines. The final byte is skipped so a
+// trailing newline does not count as an empty last line.
+off_t LogFollower::TailOffset(int fd, off_t size) const {
+    if (options_.initial_lines == 0 || size == 0) return size;
+    size_t found = 0;
+    off_t end = size - 1;
+    std::vector<char> block(64 * 1024);
+    while (end > 0) {
+        off_t begin = std::max<off_t>(0, end - static_cast<off_t>(block.size()));
+        ssize_t n = pread(fd, block.data(), static_cast<size_t>(end - begin), begin);
+        if (n <= 0) break;
+        for (size_t len = static_cast<size_t>(n); len > 0;) {
+            const void* nl = memrchr(block.data(), '\n', len);
+            if (!nl) break;
+            len = static_cast<size_t>(static_cast<const char*>(nl) - block.data());
+            if (++found == options_.initial_lines) return begin + static_cast<off_t>(len) + 1;
+        }
+        end = begin;
+    }
+    return 0;
+}
+
+// data holds whole lines, each ending in a newline
+void LogFollower::Emit(size_t i, const char* data, size_t len, const Handler& handler) {
+    if (options_.matcher) {
+        stats_.lines += CountNewlines(data, len);
+        thread_local std::vector<LineMatch> matches;
+        matches.clear();
+        ScanBuffer(*options_.matcher, data, len, 0, &matches);
+        for (const auto& m : matches) handler.line(i, m.text);
+        stats_.shown += matches.size();
+        return;
+    }
+    const char* end = data + len;
+    for (const char* p = data; p < end;) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        handler.line(i, std::string_view(p, static_cast<size_t>(nl - p)));
+        p = nl + 1;
+        ++stats_.lines;
+        ++stats_.shown;
+    }
+}
+
+void LogFollower::ReadNew(size_t i, const Handler& handler) {
+    File& f = files_[i];
+    if (f.fd < 0) return;
+    struct stat st;
+    if (fstat(f.fd, &st) == 0 && st.st_size < f.offset) {
+        f.offset = 0;
+        f.partial.clear();
+        ++stats_.truncations;
+        if (handler.notice) handler.notice(i, "file truncated");
+    }
+
+    for (;;) {
+        ssize_t n = pread(f.fd, buf_.data(), buf_.size(), f.offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        f.offset += n;
+        stats_.bytes += static_cast<uint64_t>(n);
+
+        const char* chunk = buf_.data();
+        size_t len = static_cast<size_t>(n);
+        const void* last = memrchr(chunk, '\n', len);
+        if (!last) {
+            f.partial.append(chunk, len);
+            if (f.partial.size() >= kMaxLine) {
+                f.partial += '\n';
+                Emit(i, f.partial.data(), f.partial.size(), handler);
+                f.partial.clear();
+            }
+            continue;
+        }
+        size_t complete = static_cast<size_t>(static_cast<const char*>(last) - chunk) + 1;
+        size_t start = 0;
+        if (!f.partial.empty()) {
+            // Finish the held-back line; the rest of the block is scanned in place
+            size_t first = static_cast<size_t>(static_cast<const char*>(std::memchr(chunk, '\n', len)) - chunk) + 1;
+            f.partial.append(chunk, first);
+            Emit(i, f.partial.data(), f.partial.size(), handler);
+            f.partial.clear();
+            start = first;
+        }
+        if (complete > start) Emit(i, chunk + start, complete - start, handler);
+        f.partial.assign(chunk + complete, len - complete);
+        if (static_cast<size_t>(n) < buf_.size()) break;
+    }
+}
+
+// Follows a new file that has taken over the name, after draining the old one
+void LogFollower::CheckReplaced(size_t i, const Handler& handler) {
+    File& f = files_[i];
+    struct stat st;
+    if (stat(f.path.c_str(), &st) != 0) return;     // not there yet: keep reading the old one
+    if (f.fd >= 0 && st.st_dev == f.dev && st.st_ino == f.ino) return;
+    bool had = f.fd >= 0;
+    if (had) {
+        ReadNew(i, handler);
+        Close(i);
+    }
+    if (!Open(i, handler)) return;
+    if (had) ++stats_.rotations;
+    if (handler.notice) handler.notice(i, had ? "replaced; following the new file" : "appeared; following it");
+    ReadNew(i, handler);
+}
+
+void LogFollower::Start(const Handler& handler) {
+    inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_ < 0) throw CommandError("log: inotify: " + ErrorText(errno));
+
+    bool watching = false;
+    for (size_t i = 0; i < files_.size(); ++i) {
+        File& f = files_[i];
+        size_t slash = f.path.rfind('/');
+        std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : f.path.substr(0, slash));
+        f.dir_wd = inotify_add_watch(inotify_, dir.c_str(), kDirMask);
+        if (f.dir_wd >= 0) {
+            watches_[f.dir_wd].push_back(i);
+            watching = true;
+        }
+        if (!Open(i, handler)) continue;
+        watching = true;
+        struct stat st;
+        if (fstat(f.fd, &st) == 0) f.offset = TailOffset(f.fd, st.st_size);
+        ReadNew(i, handler);
+    }
+    if (!watching) throw CommandError("log: nothing to follow");
+    if (handler.flush) handler.flush();
+}
+
+bool LogFollower::Poll(const Handler& handler, int timeout_ms) {
+    struct pollfd pfd{inotify_, POLLIN, 0};
+    if (poll(&pfd, 1, timeout_ms) <= 0) return false;
+
+    // Writes are only noted while the events are decoded, so a burst of
+    // IN_MODIFY costs one read per file
+    std::vector<bool> dirty(files_.size(), false);
+    alignas(struct inotify_event) char events[64 * 1024];
+    for (;;) {
+        ssize_t n = read(inotify_, events, sizeof(events));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        for (char* p = events; p < events + n;) {
+            const auto* ev = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + ev->len;
+            if (ev->mask & IN_Q_OVERFLOW) {
+                for (size_t i = 0; i < files_.size(); ++i) {
+                    dirty[i] = true;
+                    CheckReplaced(i, handler);
+                }
+                continue;
+            }
+            auto it = watches_.find(ev->wd);
+            if (it == watches_.end()) continue;
+            std::vector<size_t> targets = it->second;
+            for (size_t i : targets) {
+                File& f = files_[i];
+                if (ev->wd == f.dir_wd) {
+                    if (ev->len && f.name == ev->name) CheckReplaced(i, handler);
+                    continue;
+                }
+                if (ev->wd != f.wd) continue;
+                if (ev->mask & (IN_MODIFY | IN_ATTRIB)) dirty[i] = true;
+                // An unlinked file stays open, so its deletion shows up as a
+                // link count change rather than IN_DELETE_SELF
+                struct stat own;
+                bool unlinked = (ev->mask & IN_ATTRIB) && f.fd >= 0 && fstat(f.fd, &own) == 0 && own.st_nlink == 0;
+                if (unlinked || (ev->mask & (IN_MOVE_SELF | IN_DELETE_SELF))) {
+                    ReadNew(i, handler);
+                    struct stat st;
+                    if (!f.gone && stat(f.path.c_str(), &st) != 0) {
+                        f.gone = true;
+                        if (handler.notice) handler.notice(i, "moved or deleted; waiting for a new file");
+                    }
+                    CheckReplaced(i, handler);
+                }
+                if (ev->mask & IN_IGNORED) {
+                    // The inode is gone and the kernel dropped its watch
+                    it = watches_.find(ev->wd);
+                    if (it != watches_.end()) watches_.erase(it);
+                    f.wd = -1;
+                }
+            }
+        }
+    }
+    for (size_t i = 0; i < files_.size(); ++i)
+        if (dirty[i]) ReadNew(i, handler);
+    if (handler.flush) handler.flush();
+    return true;
+}
+
+void LogFollower::Follow(const Handler& handler, const std::function<bool()>& should_stop) {
+    while (!(should_stop && should_stop())) Poll(handler, 100);
+}
+
+void LogFollower::Drain(const Handler& handler) {
+    for (size_t i = 0; i < files_.size(); ++i) {
+        File& f = files_[i];
+        if (f.partial.empty()) continue;
+        f.partial += '\n';
+        Emit(i, f.partial.data(), f.partial.size(), handler);
+        f.partial.clear();
+    }
+    if (handler.flush) handler.flush();
+}
+
+} // namespace RedTops
@@ -0,0 +1,390 @@
+#include "../headers/MetricsExporter.hpp"
+#include "../../core/header/Exceptions.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace RedTops {
+
+namespace {
+
+constexpr size_t kMaxRequest = 8 * 1024;      // request line plus headers
+constexpr size_t kMaxConnections = 256;
+constexpr uint64_t kWakeTag = ~0ull;
+constexpr uint64_t kListenTag = ~0ull - 1;
+constexpr const char* kContentType = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+constexpr const char* kIndexPage = "redtops exporter\n/metrics\n";
+
+void AppendEscaped(std::string& out, std::string_view value) {
+    for (char ch : value) {
+        if (ch == '\\') out += "\\\\";
+        else if (ch == '"') out += "\\\"";
+        else if (ch == '\n') out += "\\n";
+        else out += ch;
+    }
+}
+
+void AppendValue(std::string& out, double value) {
+    if (std::isnan(value)) { out += "NaN"; return; }
+    if (std::isinf(value)) { out += value > 0 ? "+Inf" : "-Inf"; return; }
+    char buf[32];
+    auto res = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, res.ptr);
+}
+
+} // namespace
+
+// ---------------- MetricsWriter ----------------
+
+void MetricsWriter::Family(std::string_view name, Type type, std::string_view help) {
+    name_.assign(name);
+    type_ = type;
+    out_ += "# TYPE ";
+    out_ += name;
+    out_ += type == Type::Counter ? " counter\n" : " gauge\n";
+    out_ += "# HELP ";
+    out_ += name;
+    out_ += ' ';
+    AppendEscaped(out_, help);
+    out_ += '\n';
+}
+
+void MetricsWriter::Sample(double value, std::initializer_list<Label> labels) {
+    out_ += name_;
+    if (type_ == Type::Counter) out_ += "_total";
+    if (labels.size()) {
+        out_ += '{';
+        bool first = true;
+        for (const auto& [key, val] : labels) {
+            if (!first) out_ += ',';
+            out_ += key;
+            out_ += "=\"";
+            AppendEscaped(out_, val);
+            out_ += '"';
+            first = false;
+        }
+        out_ += '}';
+    }
+    out_ += ' ';
+    AppendValue(out_, value);
+    out_ += '\n';
+}
+
+std::string MetricsWriter::Finish() {
+    out_ += "# EOF\n";
+    return std::move(out_);
+}
+
+// ---------------- MetricsExporter ----------------
+
+struct MetricsExporter::Connection {
+    int fd = -1;
+    std::string request;
+    std::string head;                               // status line and headers
+    std::shared_ptr<const std::string> body;        // keeps the scraped buffer alive
+    size_t body_len = 0;                            // 0 for HEAD
+    size_t sent = 0;
+    bool responding = false;
+};
+
+MetricsExporter::MetricsExporter(const std::string& listen, int interval_ms)
+    : listen_(listen), interval_ms_(std::max(100, interval_ms)) {}
+
+MetricsExporter::~MetricsExporter() { Stop(); }
+
+void MetricsExporter::AddCollector(const std::string& name, Collector collect) {
+    collectors_.emplace_back(name, std::move(collect));
+}
+
+size_t MetricsExporter::LastSize() const {
+    auto buf = current_.load();
+    return buf ? buf->size() : 0;
+}
+
+void MetricsExporter::Start() {
+    // Split host and port; a bare ":port" stays on loopback
+    std::string host, port;
+    if (!listen_.empty() && listen_.front() == '[') {
+        size_t close = listen_.find(']');
+        if (close == std::string::npos || close + 1 >= listen_.size() || listen_[close + 1] != ':')
+            throw NetworkError("exporter: invalid listen address: " + listen_);
+        host = listen_.substr(1, close - 1);
+        port = listen_.substr(close + 2);
+    } else {
+        size_t colon = listen_.rfind(':');
+        if (colon == std::string::npos) port = listen_;
+        else {
+            host = listen_.substr(0, colon);
+            port = listen_.substr(colon + 1);
+        }
+    }
+    if (host.empty()) host = "127.0.0.1";
+    if (port.empty()) throw NetworkError("exporter: listen address has no port: " + listen_);
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+    addrinfo* res = nullptr;
+    int rc = getaddrinfo(host.c_str(), port.c_str(), &hints, &res);
+    if (rc != 0) throw NetworkError("exporter: cannot resolve " + listen_ + ": " + gai_strerror(rc));
+
+    std::string error;
+    for (addrinfo* ai = res; ai && listen_fd_ < 0; ai = ai->ai_next) {
+        int fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) { error = strerror(errno); continue; }
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(fd, ai->ai_addr, ai->ai_addrlen) < 0 || ::listen(fd, 128) < 0) {
+            error = strerror(errno);
+            close(fd);
+            continue;
+        }
+        listen_fd_ = fd;
+    }
+    freeaddrinfo(res);
+    if (listen_fd_ < 0) throw NetworkError("exporter: cannot listen on " + listen_ + ": " + error);
+
+    sockaddr_storage bound{};
+    socklen_t len = sizeof(bound);
+    getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&bound), &len);
+    char text[INET6_ADDRSTRLEN] = "?";
+    if (bound.ss_family == AF_INET6) {
+        auto* sin6 = reinterpret_cast<sockaddr_in6*>(&bound);
+        inet_ntop(AF_INET6, &sin6->sin6_addr, text, sizeof(text));
+        address_ = "[" + std::string(text) + "]:" + std::to_string(ntohs(sin6->sin6_port));
+    } else {
+        auto* sin = reinterpret_cast<sockaddr_in*>(&bound);
+        inet_ntop(AF_INET, &sin->sin_addr, text, sizeof(text));
+        address_ = std::string(text) + ":" + std::to_string(ntohs(sin->sin_port));
+    }
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        std::string why = strerror(errno);
+        Stop();
+        throw NetworkError("exporter: epoll setup failed: " + why);
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = kListenTag;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &ev);
+    ev.data.u64 = kWakeTag;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+
+    // The first scrape already has data
+    Render();
+    stopping_ = false;
+    sampler_ = std::thread(&MetricsExporter::SamplerLoop, this);
+    server_ = std::thread(&MetricsExporter::ServerLoop, this);
+}
+
+void MetricsExporter::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (wake_fd_ >= 0) {
+        uint64_t one = 1;
+        (void)!write(wake_fd_, &one, sizeof(one));
+    }
+    if (sampler_.joinable()) sampler_.join();
+    if (server_.joinable()) server_.join();
+
+    for (auto& [fd, conn] : connections_) close(fd);
+    connections_.clear();
+    for (int* fd : {&listen_fd_, &epoll_fd_, &wake_fd_}) {
+        if (*fd >= 0) close(*fd);
+        *fd = -1;
+    }
+}
+
+void MetricsExporter::Render() {
+    auto t0 = std::chrono::steady_clock::now();
+    MetricsWriter w;
+    std::vector<bool> ok;
+    ok.reserve(collectors_.size());
+    for (auto& [name, collect] : collectors_) {
+        size_t mark = w.Size();
+        try {
+            collect(w);
+            ok.push_back(true);
+        } catch (...) {
+            // Drop the half-written families; the rest of the scrape stays valid
+            w.Truncate(mark);
+            ok.push_back(false);
+        }
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    w.Family("redtops_exporter_collector_success", MetricsWriter::Type::Gauge,
+             "Whether the collector succeeded in the last render");
+    for (size_t i = 0; i < collectors_.size(); ++i)
+        w.Sample(ok[i] ? 1 : 0, {{"collector", collectors_[i].first}});
+    w.Family("redtops_exporter_render_seconds", MetricsWriter::Type::Gauge,
+             "Time spent running collectors for the last render");
+    w.Sample(ms / 1000.0);
+    w.Family("redtops_exporter_scrapes", MetricsWriter::Type::Counter, "Scrapes answered");
+    w.Sample(static_cast<double>(scrapes_.load()));
+
+    current_.store(std::make_shared<const std::string>(w.Finish()));
+    last_render_ms_ = ms;
+    ++renders_;
+}
+
+void MetricsExporter::SamplerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        if (wake_.wait_for(lock, std::chrono::milliseconds(interval_ms_), [this] { return stopping_; })) return;
+        lock.unlock();
+        Render();
+        lock.lock();
+    }
+}
+
+void MetricsExporter::ServerLoop() {
+    epoll_event events[64];
+    for (;;) {
+        int n = epoll_wait(epoll_fd_, events, 64, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        for (int i = 0; i < n; ++i) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == kWakeTag) return;
+            if (tag == kListenTag) { Accept(); continue; }
+
+            int fd = static_cast<int>(tag);
+            auto it = connections_.find(fd);
+            if (it == connections_.end()) continue;
+            Connection& c = *it->second;
+            bool keep = true;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) keep = false;
+            else if (!c.responding && (events[i].events & EPOLLIN)) keep = Receive(c);
+            if (keep && c.responding) keep = Send(c);
+            if (!keep) {
+                close(fd);
+                connections_.erase(it);
+            }
+        }
+    }
+}
+
+void MetricsExporter::Accept() {
+    for (;;) {
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;   // EAGAIN, or a transient error; the next readiness retries
+        if (connections_.size() >= kMaxConnections) {
+            close(fd);
+            continue;
+        }
+        auto conn = std::make_unique<Connection>();
+        conn->fd = fd;
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+        ev.data.u64 = static_cast<uint64_t>(fd);
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            close(fd);
+            continue;
+        }
+        connections_[fd] = std::move(conn);
+    }
+}
+
+bool MetricsExporter::Receive(Connection& c) {
+    char buf[2048];
+    for (;;) {
+        ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+            c.request.append(buf, static_cast<size_t>(n));
+            if (c.request.find("\r\n\r\n") != std::string::npos) {
+                Respond(c);
+                return true;
+            }
+            if (c.request.size() > kMaxRequest) return false;
+            continue;
+        }
+        if (n == 0) return false;
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+}
+
+void MetricsExporter::Respond(Connection& c) {
+    // Request line: METHOD SP PATH SP VERSION
+    size_t eol = c.request.find("\r\n");
+    std::string_view line(c.request.data(), eol);
+    size_t sp1 = line.find(' ');
+    size_t sp2 = sp1 == std::string_view::npos ? sp1 : line.find(' ', sp1 + 1);
+    std::string_view method = line.substr(0, sp1);
+    std::string_view path = sp2 == std::string_view::npos ? std::string_view() : line.substr(sp1 + 1, sp2 - sp1 - 1);
+    path = path.substr(0, path.find('?'));
+
+    const char* status = "200 OK";
+    const char* type = "text/plain; charset=utf-8";
+    if (sp2 == std::string_view::npos) {
+        status = "400 Bad Request";
+        c.body = std::make_shared<const std::string>("bad request\n");
+    } else if (method != "GET" && method != "HEAD") {
+        status = "405 Method Not Allowed";
+        c.body = std::make_shared<const std::string>("method not allowed\n");
+    } else if (path == "/metrics") {
+        type = kContentType;
+        c.body = current_.load();
+        ++scrapes_;
+    } else if (path == "/") {
+        c.body = std::make_shared<const std::string>(kIndexPage);
+    } else {
+        status = "404 Not Found";
+        c.body = std::make_shared<const std::string>("not found\n");
+    }
+
+    c.head = std::string("HTTP/1.1 ") + status + "\r\nContent-Type: " + type +
+             "\r\nContent-Length: " + std::to_string(c.body->size()) + "\r\nConnection: close\r\n\r\n";
+    c.body_len = method == "HEAD" ? 0 : c.body->size();
+    c.sent = 0;
+    c.responding = true;
+}
+
+bool MetricsExporter::Send(Connection& c) {
+    const size_t total = c.head.size() + c.body_len;
+    while (c.sent < total) {
+        iovec iov[2];
+        int count = 0;
+        if (c.sent < c.head.size()) {
+            iov[count++] = {const_cast<char*>(c.head.data()) + c.sent, c.head.size() - c.sent};
+            if (c.body_len) iov[count++] = {const_cast<char*>(c.body->data()), c.body_len};
+        } else {
+            size_t off = c.sent - c.head.size();
+            iov[count++] = {const_cast<char*>(c.body->data()) + off, c.body_len - off};
+        }
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = static_cast<size_t>(count);
+        ssize_t n = sendmsg(c.fd, &msg, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;   // wait for EPOLLOUT
+        }
+        c.sent += static_cast<size_t>(n);
+    }
+    // Response complete; closing delimits it for clients that ignore Content-Length
+    return false;
+}
+
+} // namespace RedTops
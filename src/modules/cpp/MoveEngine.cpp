@@ -0,0 +1,533 @@
+#include "../headers/MoveEngine.hpp"
+#include "../headers/CopyEngine.hpp"
+#include "../headers/TreeWalker.hpp"
+#include "../../core/header/Exceptions.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <set>
+#include <system_error>
+#include <thread>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/xattr.h>
+#include <unistd.h>
+
+namespace RedTops {
+
+namespace {
+
+constexpr size_t kVerifyChunk = 1024 * 1024;
+constexpr size_t kMaxErrorMessages = 10;
+
+std::string ErrorText(int err) {
+    return std::error_code(err, std::generic_category()).message();
+}
+
+struct Fd {
+    int fd;
+    explicit Fd(int f) : fd(f) {}
+    ~Fd() { if (fd >= 0) close(fd); }
+    Fd(const Fd&) = delete;
+    Fd& operator=(const Fd&) = delete;
+};
+
+// Best effort: a namespace the destination refuses, such as trusted.*
+// without privilege, is left behind
+void CopyXattrs(int in, int out) {
+    ssize_t len = flistxattr(in, nullptr, 0);
+    if (len <= 0) return;
+    std::vector<char> names(static_cast<size_t>(len));
+    len = flistxattr(in, names.data(), names.size());
+    if (len <= 0) return;
+    std::vector<char> value;
+    for (const char* name = names.data(); name < names.data() + len; name += std::strlen(name) + 1) {
+        ssize_t n = fgetxattr(in, name, nullptr, 0);
+        if (n < 0) continue;
+        value.resize(static_cast<size_t>(n));
+        n = fgetxattr(in, name, value.data(), value.size());
+        if (n >= 0) fsetxattr(out, name, value.data(), static_cast<size_t>(n), 0);
+    }
+}
+
+// Owner first, since chown clears set-id bits, and times last, since every
+// other change would bump them. Without the right to give the file away it
+// stays ours and loses its set-id bits, as with cp -p.
+void ApplyMetadata(int out, const struct stat& st) {
+    mode_t mode = st.st_mode & 07777;
+    if (fchown(out, st.st_uid, st.st_gid) != 0) mode &= ~static_cast<mode_t>(S_ISUID | S_ISGID);
+    fchmod(out, mode);
+    const struct timespec times[2] = {st.st_atim, st.st_mtim};
+    futimens(out, times);
+}
+
+// The same for an entry that cannot be opened: a symlink or special file
+void ApplyMetadataAt(int dir, const std::string& name, const struct stat& st) {
+    mode_t mode = st.st_mode & 07777;
+    if (fchownat(dir, name.c_str(), st.st_uid, st.st_gid, AT_SYMLINK_NOFOLLOW) != 0)
+        mode &= ~static_cast<mode_t>(S_ISUID | S_ISGID);
+    if (!S_ISLNK(st.st_mode)) fchmodat(dir, name.c_str(), mode, 0);
+    const struct timespec times[2] = {st.st_atim, st.st_mtim};
+    utimensat(dir, name.c_str(), times, AT_SYMLINK_NOFOLLOW);
+}
+
+// Directory metadata goes on once everything below it is in place. The
+// source is name in src_dir, the copy rel below dst_root.
+void CopyDirMetadata(int src_dir, const std::string& name, int dst_root, const std::string& rel) {
+    Fd in(openat(src_dir, name.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+    Fd out(openat(dst_root, rel.empty() ? "." : rel.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+    struct stat st;
+    if (in.fd < 0 || out.fd < 0 || fstat(in.fd, &st) != 0) return;
+    CopyXattrs(in.fd, out.fd);
+    ApplyMetadata(out.fd, st);
+}
+
+// Opens the directories on the way to a root-relative path one component at
+// a time with O_NOFOLLOW, so a directory swapped for a symlink after the walk
+// cannot lead outside the tree. Paths in the same directory reuse the
+// descriptors already open, so callers go through them in sorted order.
+class DirChain {
+public:
+    explicit DirChain(int root) : root_(root) {}
+    ~DirChain() {
+        for (auto& d : open_) close(d.second);
+    }
+    DirChain(const DirChain&) = delete;
+    DirChain& operator=(const DirChain&) = delete;
+
+    // Descriptor of the directory holding rel, whose last component goes to
+    // name; -1 with errno set if a directory on the way cannot be opened
+    int Parent(const std::string& rel, std::string& name) {
+        std::vector<std::string> parts;
+        for (size_t start = 0;;) {
+            size_t slash = rel.find('/', start);
+            parts.push_back(rel.substr(start, slash - start));
+            if (slash == std::string::npos) break;
+            start = slash + 1;
+        }
+        name = std::move(parts.back());
+        parts.pop_back();
+
+        size_t keep = 0;
+        while (keep < open_.size() && keep < parts.size() && open_[keep].first == parts[keep]) ++keep;
+        while (open_.size() > keep) {
+            close(open_.back().second);
+            open_.pop_back();
+        }
+        for (size_t i = keep; i < parts.size(); ++i) {
+            int at = open_.empty() ? root_ : open_.back().second;
+            int fd = openat(at, parts[i].c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            if (fd < 0) return -1;
+            open_.emplace_back(std::move(parts[i]), fd);
+        }
+        return open_.empty() ? root_ : open_.back().second;
+    }
+
+private:
+    int root_;
+    std::vector<std::pair<std::string, int>> open_;
+};
+
+// Reads up to len bytes at off, short only at end of file
+ssize_t ReadFull(int fd, char* buf, size_t len, uint64_t off) {
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = pread(fd, buf + got, len - got, static_cast<off_t>(off + got));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) break;
+        got += static_cast<size_t>(n);
+    }
+    return static_cast<ssize_t>(got);
+}
+
+} // namespace
+
+MoveEngine::MoveEngine(Options options)
+    : options_(options), threads_(options.threads ? options.threads : TreeWalker::DefaultThreads()) {}
+
+void MoveEngine::Fail(const std::string& path, const std::string& reason) {
+    errors_.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(errors_mutex_);
+    if (error_messages_.size() < kMaxErrorMessages) error_messages_.push_back(path + ": " + reason);
+}
+
+bool MoveEngine::Verify(int in, int out, const struct stat& copied, std::string& reason) {
+    // Synced pages are clean, so dropping them makes the reads below come
+    // from the device rather than from what was just written
+    if (options_.sync) posix_fadvise(out, 0, 0, POSIX_FADV_DONTNEED);
+    thread_local std::vector<char> a, b;
+    a.resize(kVerifyChunk);
+    b.resize(kVerifyChunk);
+    for (uint64_t off = 0;;) {
+        if (stop_.load(std::memory_order_relaxed)) {
+            reason = ErrorText(EINTR);
+            return false;
+        }
+        ssize_t na = ReadFull(in, a.data(), a.size(), off);
+        ssize_t nb = ReadFull(out, b.data(), b.size(), off);
+        if (na < 0 || nb < 0) {
+            reason = "cannot verify: " + ErrorText(errno);
+            return false;
+        }
+        if (na != nb || std::memcmp(a.data(), b.data(), static_cast<size_t>(na)) != 0) {
+            reason = "copy does not match the source";
+            return false;
+        }
+        if (na == 0) break;
+        off += static_cast<uint64_t>(na);
+        verified_.fetch_add(static_cast<uint64_t>(na), std::memory_order_relaxed);
+    }
+    return Unchanged(in, copied, reason);
+}
+
+bool MoveEngine::Unchanged(int in, const struct stat& copied, std::string& reason) {
+    struct stat now;
+    if (fstat(in, &now) != 0 || now.st_size != copied.st_size ||
+        now.st_mtim.tv_sec != copied.st_mtim.tv_sec || now.st_mtim.tv_nsec != copied.st_mtim.tv_nsec) {
+        reason = "changed while being moved";
+        return false;
+    }
+    return true;
+}
+
+bool MoveEngine::CopyRegular(int src_dir, const std::string& name, int dst_dir, const std::string& dst_name,
+                             bool check, std::string& reason) {
+    Fd in(openat(src_dir, name.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC));
+    struct stat st;
+    if (in.fd < 0 || fstat(in.fd, &st) != 0) {
+        reason = ErrorText(errno);
+        return false;
+    }
+    Fd out(openat(dst_dir, dst_name.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600));
+    if (out.fd < 0) {
+        reason = ErrorText(errno);
+        return false;
+    }
+
+    auto copy = [&]() -> bool {
+        CopyControl control;
+        control.copied = &bytes_;
+        control.stop = &stop_;
+        CopyMethod method;
+        // Reflinks cannot span filesystems, so there is no point trying one
+        if (!CopyFileData(in.fd, out.fd, static_cast<uint64_t>(st.st_size), false, method, control)) {
+            reason = ErrorText(errno);
+            return false;
+        }
+        CopyXattrs(in.fd, out.fd);
+        ApplyMetadata(out.fd, st);
+        if (!check) return Unchanged(in.fd, st, reason);
+        if (options_.sync && fsync(out.fd) != 0) {
+            reason = "cannot sync: " + ErrorText(errno);
+            return false;
+        }
+        return options_.verify ? Verify(in.fd, out.fd, st, reason) : Unchanged(in.fd, st, reason);
+    };
+
+    if (!copy()) {
+        unlinkat(dst_dir, dst_name.c_str(), 0);
+        return false;
+    }
+    files_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool MoveEngine::Transfer(int src_dir, const std::string& name, int dst_dir, const std::string& dst_name,
+                          std::string& reason) {
+    struct stat st;
+    if (fstatat(src_dir, name.c_str(), &st, AT_SYMLINK_NOFOLLOW) != 0) {
+        reason = ErrorText(errno);
+        return false;
+    }
+    if (S_ISREG(st.st_mode)) return CopyRegular(src_dir, name, dst_dir, dst_name, true, reason);
+    if (S_ISDIR(st.st_mode)) {
+        reason = "is a directory";
+        return false;
+    }
+
+    if (S_ISLNK(st.st_mode)) {
+        char target[PATH_MAX];
+        ssize_t n = readlinkat(src_dir, name.c_str(), target, sizeof(target) - 1);
+        if (n < 0) {
+            reason = ErrorText(errno);
+            return false;
+        }
+        target[n] = '\0';
+        if (symlinkat(target, dst_dir, dst_name.c_str()) != 0) {
+            reason = ErrorText(errno);
+            return false;
+        }
+        symlinks_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        // FIFOs and sockets need no privilege; device nodes need CAP_MKNOD
+        if (mknodat(dst_dir, dst_name.c_str(), st.st_mode & (S_IFMT | 0777), st.st_rdev) != 0) {
+            reason = ErrorText(errno);
+            return false;
+        }
+        specials_.fetch_add(1, std::memory_order_relaxed);
+    }
+    ApplyMetadataAt(dst_dir, dst_name, st);
+    return true;
+}
+
+void MoveEngine::MoveEntry(int src_dir, const std::string& name, const std::string& rel) {
+    struct stat st;
+    if (fstatat(src_dir, name.c_str(), &st, AT_SYMLINK_NOFOLLOW) != 0) return Fail(rel, ErrorText(errno));
+    std::string reason;
+    if (!S_ISREG(st.st_mode) || st.st_nlink < 2) {
+        bool ok = S_ISREG(st.st_mode) ? CopyRegular(src_dir, name, dst_root_, rel, false, reason)
+                                      : Transfer(src_dir, name, dst_root_, rel, reason);
+        if (ok) Moved(rel, st);
+        else if (!stop_.load()) Fail(rel, reason);
+        return;
+    }
+
+    // The first name of a hard-linked file is copied; the others wait for
+    // that copy and link to it
+    const auto key = std::make_pair(static_cast<uint64_t>(st.st_dev), static_cast<uint64_t>(st.st_ino));
+    std::unique_lock<std::mutex> lock(links_mutex_);
+    auto it = link_targets_.find(key);
+    if (it != link_targets_.end()) {
+        links_cv_.wait(lock, [&] { return it->second.state != 0; });
+        if (it->second.state < 0) return Fail(rel, "not moved: the file it is linked to failed");
+        const std::string target = it->second.path;
+        lock.unlock();
+        if (linkat(dst_root_, target.c_str(), dst_root_, rel.c_str(), 0) != 0) return Fail(rel, ErrorText(errno));
+        links_.fetch_add(1, std::memory_order_relaxed);
+        Moved(rel, st);
+        return;
+    }
+    it = link_targets_.emplace(key, LinkTarget{rel, 0}).first;
+    lock.unlock();
+
+    bool ok = CopyRegular(src_dir, name, dst_root_, rel, false, reason);
+    lock.lock();
+    it->second.state = ok ? 1 : -1;
+    lock.unlock();
+    links_cv_.notify_all();
+    if (ok) Moved(rel, st);
+    else if (!stop_.load()) Fail(rel, reason);
+}
+
+void MoveEngine::Moved(const std::string& rel, const struct stat& st) {
+    std::lock_guard<std::mutex> lock(moved_mutex_);
+    moved_.push_back(MovedEntry{rel, S_ISDIR(st.st_mode), st.st_size, st.st_mtim});
+}
+
+void MoveEngine::RemoveMoved(int src_root) {
+    // Only what was copied goes: anything created in the source after the
+    // walk passed its directory keeps that directory, and so the source
+    std::vector<MovedEntry> files, dirs;
+    for (auto& m : moved_) (m.dir ? dirs : files).push_back(std::move(m));
+    moved_.clear();
+    auto by_path = [](const MovedEntry& a, const MovedEntry& b) { return a.path < b.path; };
+
+    DirChain chain(src_root);
+    std::string name;
+    std::sort(files.begin(), files.end(), by_path);
+    for (const auto& m : files) {
+        int dir = chain.Parent(m.path, name);
+        struct stat st;
+        if (dir < 0 || fstatat(dir, name.c_str(), &st, AT_SYMLINK_NOFOLLOW) != 0) {
+            if (errno != ENOENT) Fail(m.path, ErrorText(errno));
+            continue;
+        }
+        // Written to since it was verified: the copy is stale, so the source stays
+        if (S_ISREG(st.st_mode) && (st.st_size != m.size || st.st_mtim.tv_sec != m.mtime.tv_sec ||
+                                    st.st_mtim.tv_nsec != m.mtime.tv_nsec)) {
+            Fail(m.path, "changed while being moved; kept");
+            continue;
+        }
+        if (unlinkat(dir, name.c_str(), 0) != 0 && errno != ENOENT) Fail(m.path, ErrorText(errno));
+    }
+    // A parent's path is a prefix of its children's, so reverse order is bottom-up
+    std::sort(dirs.rbegin(), dirs.rend(), by_path);
+    for (const auto& d : dirs) {
+        int dir = chain.Parent(d.path, name);
+        if ((dir >= 0 && unlinkat(dir, name.c_str(), AT_REMOVEDIR) == 0) || errno == ENOENT) continue;
+        Fail(d.path, errno == ENOTEMPTY ? "has entries that were not moved; kept" : ErrorText(errno));
+    }
+}
+
+bool MoveEngine::MoveFile(const std::string& src, const std::string& dst,
+                          const std::function<bool()>& should_stop, const std::function<void()>& on_tick) {
+    // Both are opened through their parent directories, so the temporary
+    // copy sits beside dst and the final steps are renameat and unlinkat
+    auto split = [](const std::string& path) {
+        size_t slash = path.rfind('/');
+        if (slash == std::string::npos) return std::make_pair(std::string("."), path);
+        return std::make_pair(slash == 0 ? std::string("/") : path.substr(0, slash), path.substr(slash + 1));
+    };
+    const auto [src_parent, src_name] = split(src);
+    const auto [dst_parent, dst_name] = split(dst);
+    Fd src_dir(open(src_parent.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (src_dir.fd < 0) throw CommandError("mv: cannot open " + src_parent + ": " + ErrorText(errno));
+    Fd dst_dir(open(dst_parent.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (dst_dir.fd < 0) throw CommandError("mv: cannot open " + dst_parent + ": " + ErrorText(errno));
+
+    const std::string temp = "." + dst_name + ".mv-" + std::to_string(getpid());
+    unlinkat(dst_dir.fd, temp.c_str(), 0);     // left by a move that was killed
+    stop_ = false;
+
+    // The copy runs on its own thread so a large file still gets progress
+    // and can be stopped between chunks
+    std::string reason;
+    bool ok = false;
+    bool done = false;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread worker([&] {
+        ok = Transfer(src_dir.fd, src_name, dst_dir.fd, temp, reason);
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+        cv.notify_all();
+    });
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!cv.wait_for(lock, std::chrono::milliseconds(100), [&] { return done; })) {
+            lock.unlock();
+            if (should_stop && should_stop()) stop_ = true;
+            if (on_tick) on_tick();
+            lock.lock();
+        }
+    }
+    worker.join();
+
+    if (!ok) {
+        unlinkat(dst_dir.fd, temp.c_str(), 0);
+        if (stop_) return false;
+        throw CommandError("mv: " + src + ": " + reason);
+    }
+    if (renameat(dst_dir.fd, temp.c_str(), dst_dir.fd, dst_name.c_str()) != 0) {
+        int err = errno;
+        unlinkat(dst_dir.fd, temp.c_str(), 0);
+        throw CommandError("mv: cannot create " + dst + ": " + ErrorText(err));
+    }
+    // The new name must be durable before the only other copy goes away
+    if (options_.sync && fsync(dst_dir.fd) != 0)
+        throw CommandError("mv: cannot sync " + dst_parent + ": " + ErrorText(errno) + "; " + src + " was kept");
+    if (unlinkat(src_dir.fd, src_name.c_str(), 0) != 0)
+        throw CommandError("mv: " + dst + " is complete but " + src + " cannot be removed: " + ErrorText(errno));
+    return true;
+}
+
+bool MoveEngine::MoveTree(const std::string& src, const std::string& dst,
+                          const std::function<bool()>& should_stop, const std::function<void()>& on_tick) {
+    arrived_ = source_removed_ = false;
+    stop_ = false;
+    moved_.clear();
+    Fd src_root(open(src.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+    if (src_root.fd < 0) throw CommandError("mv: cannot open " + src + ": " + ErrorText(errno));
+
+    bool created = mkdir(dst.c_str(), 0700) == 0;
+    if (!created && errno != EEXIST) throw CommandError("mv: cannot create " + dst + ": " + ErrorText(errno));
+    Fd dst_root(open(dst.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (dst_root.fd < 0) throw CommandError("mv: cannot open " + dst + ": " + ErrorText(errno));
+    if (!created) {
+        // rename(2) only replaces an empty directory; neither does this
+        DirEntry entry;
+        if (DirReader(dst_root.fd).Next(entry)) throw CommandError("mv: " + dst + " is not empty");
+    }
+    dst_root_ = dst_root.fd;
+
+    TreeWalker::Visitor visitor;
+    // Directories are created owner-writable so they can be filled, and get
+    // their real owner, mode and times once everything below them is copied
+    visitor.directory = [&](const TreeWalker::Entry& e) {
+        std::string rel = e.Path();
+        if (mkdirat(dst_root_, rel.c_str(), 0700) != 0) {
+            Fail(rel, ErrorText(errno));
+            return false;
+        }
+        dirs_.fetch_add(1, std::memory_order_relaxed);
+        struct stat st{};
+        st.st_mode = S_IFDIR;
+        Moved(rel, st);
+        return true;
+    };
+    visitor.entry = [&](const TreeWalker::Entry& e) { MoveEntry(e.dir.fd, std::string(e.name), e.Path()); };
+    visitor.leave = [&](const TreeWalker::Dir& d) {
+        CopyDirMetadata(d.parent_fd, std::string(d.Name()), dst_root_, d.path);
+    };
+    visitor.error = [&](const std::string& path, int err) { Fail(path.empty() ? src : path, ErrorText(err)); };
+
+    // A stop also cuts short the files in flight, not only the walk
+    auto stop = [&] {
+        if (should_stop && should_stop()) stop_ = true;
+        return stop_.load();
+    };
+    bool complete = TreeWalker(threads_).Walk(src_root.fd, visitor, stop, on_tick);
+    dst_root_ = -1;
+    link_targets_.clear();
+    if (!complete || errors_.load() > 0) return complete;
+    CopyDirMetadata(src_root.fd, ".", dst_root.fd, "");
+
+    // One syncfs for the whole copy rather than an fsync per file, which
+    // would make a tree of small files wait on the journal once per file
+    if (options_.sync && syncfs(dst_root.fd) != 0) {
+        Fail(dst, "cannot sync: " + ErrorText(errno));
+        return true;
+    }
+    if (options_.verify) {
+        // Each copy carries its source's size and mtime, so the second walk
+        // also catches a source that changed after it was copied
+        std::mutex seen_mutex;
+        std::set<uint64_t> seen;        // inodes with several names, checked once
+        TreeWalker::Visitor check;
+        check.entry = [&](const TreeWalker::Entry& e) {
+            if (e.type != DT_REG) return;
+            std::string rel = e.Path(), reason;
+            Fd out(openat(e.dir.fd, std::string(e.name).c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC));
+            Fd in(openat(src_root.fd, rel.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC));
+            struct stat st;
+            if (out.fd < 0 || in.fd < 0 || fstat(out.fd, &st) != 0) return Fail(rel, ErrorText(errno));
+            if (st.st_nlink > 1) {
+                std::lock_guard<std::mutex> lock(seen_mutex);
+                if (!seen.insert(static_cast<uint64_t>(st.st_ino)).second) return;
+            }
+            if (!Verify(in.fd, out.fd, st, reason) && !stop_.load()) Fail(rel, reason);
+        };
+        check.error = visitor.error;
+        if (!TreeWalker(threads_).Walk(dst_root.fd, check, stop, on_tick)) return false;
+        if (errors_.load() > 0) return true;
+    }
+
+    // Everything arrived: what was moved goes, and is not interrupted half way
+    arrived_ = true;
+    RemoveMoved(src_root.fd);
+    if (errors_.load() > 0) return true;
+    if (rmdir(src.c_str()) != 0) {
+        Fail(src, errno == ENOTEMPTY ? "has entries that were not moved; kept" : ErrorText(errno));
+        return true;
+    }
+    source_removed_ = true;
+    return true;
+}
+
+MoveStats MoveEngine::Stats() const {
+    MoveStats s;
+    s.files = files_.load(std::memory_order_relaxed);
+    s.bytes = bytes_.load(std::memory_order_relaxed);
+    s.verified = verified_.load(std::memory_order_relaxed);
+    s.dirs = dirs_.load(std::memory_order_relaxed);
+    s.symlinks = symlinks_.load(std::memory_order_relaxed);
+    s.links = links_.load(std::memory_order_relaxed);
+    s.specials = specials_.load(std::memory_order_relaxed);
+    s.errors = errors_.load(std::memory_order_relaxed);
+    return s;
+}
+
+std::vector<std::string> MoveEngine::Errors() const {
+    std::lock_guard<std::mutex> lock(errors_mutex_);
+    return error_messages_;
+}
+
+} // namespace RedTops
@@ -0,0 +1,175 @@
+#include "../headers/MultiCapture.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <thread>
+#include <utility>
+
+namespace RedTops {
+
+namespace {
+
+constexpr int kPollTimeoutMs = 20;
+
+// A frame stamped before (now - kSettleNs) is guaranteed to sit in a retired
+// block once the ring reports nothing ready: blocks retire after the timeout
+constexpr uint64_t kSettleNs = (2ull * PacketRing::kBlockTimeoutMs + 20) * 1000000ull;
+
+uint64_t RealtimeNs() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+} // namespace
+
+MultiCapture::MultiCapture(MultiCaptureOptions options) : options_(std::move(options)) {}
+
+MultiCapture::~MultiCapture() = default;
+
+void MultiCapture::Open() {
+    sources_.clear();
+    for (const auto& name : options_.interfaces) {
+        // Room for two of the largest frames, so a wrap never waits on a lone one
+        size_t bytes = std::max(options_.queue_bytes, 2 * static_cast<size_t>(options_.snaplen));
+        sources_.push_back(std::make_unique<Source>(options_.queue_slots, bytes));
+        sources_.back()->ring.Open(name, options_.promiscuous);
+    }
+    stats_.assign(sources_.size(), InterfaceCaptureStats{});
+}
+
+bool MultiCapture::Reserve(Source& src, uint32_t n, Record& rec) {
+    // A frame never wraps: one that would is placed at the arena's start
+    uint64_t pos = src.written % src.arena_size;
+    uint64_t start = pos + n > src.arena_size ? src.written + (src.arena_size - pos) : src.written;
+    if (start + n - src.freed.load(std::memory_order_acquire) > src.arena_size) return false;
+    rec.start = start;
+    rec.end = start + n;
+    src.written = rec.end;
+    return true;
+}
+
+void MultiCapture::CaptureLoop(Source& src) {
+    PacketRing& ring = src.ring;
+    // Loopback shows every packet twice (outgoing and incoming); keep one copy
+    const bool skip_outgoing = ring.IsLoopback();
+
+    while (!stop_.load(std::memory_order_relaxed)) {
+        uint64_t now = RealtimeNs();
+        if (ring.Ready() == 0) {
+            uint64_t settled = now > kSettleNs ? now - kSettleNs : 0;
+            if (settled > src.watermark_ns.load(std::memory_order_relaxed))
+                src.watermark_ns.store(settled, std::memory_order_release);
+            ring.Wait(kPollTimeoutMs);
+            continue;
+        }
+
+        uint64_t last_ts = 0;
+        ring.ForEach([&](const RingFrame& f) {
+            if (skip_outgoing && f.outgoing) return true;
+            const uint32_t caplen = std::min(f.caplen, options_.snaplen);
+            Record* rec = src.queue.BeginPush();
+            if (!rec || !Reserve(src, caplen, *rec)) {
+                src.stats.queue_stalls++;
+                while (!rec || !Reserve(src, caplen, *rec)) {
+                    if (stop_.load(std::memory_order_relaxed)) return false;
+                    std::this_thread::yield();
+                    if (!rec) rec = src.queue.BeginPush();
+                }
+            }
+            rec->ts_ns = f.ts_ns;
+            rec->caplen = caplen;
+            if (caplen < f.caplen) src.stats.truncated++;
+            rec->len = f.len;
+            std::memcpy(src.Data(*rec), f.data, caplen);
+            src.queue.CommitPush();
+            src.stats.packets++;
+            src.stats.bytes += f.len;
+            last_ts = f.ts_ns;
+            return true;
+        });
+        ring.Release();
+
+        // Frames within one ring arrive in timestamp order
+        if (last_ts > src.watermark_ns.load(std::memory_order_relaxed))
+            src.watermark_ns.store(last_ts, std::memory_order_release);
+    }
+
+    src.stats.kernel_drops = ring.Drops();
+    src.watermark_ns.store(UINT64_MAX, std::memory_order_release);
+}
+
+void MultiCapture::Run(const std::function<bool()>& should_stop,
+                       const std::function<void(const CapturedFrame&)>& on_frame) {
+    if (sources_.empty()) Open();
+    stop_ = false;
+
+    std::vector<std::thread> threads;
+    threads.reserve(sources_.size());
+    for (auto& src : sources_) threads.emplace_back(&MultiCapture::CaptureLoop, this, std::ref(*src));
+
+    // Min-heap of (timestamp, source) over the sources that have a frame queued
+    using Head = std::pair<uint64_t, unsigned>;
+    std::vector<Head> heap;
+    heap.reserve(sources_.size());
+    std::vector<char> queued(sources_.size(), 0);
+    auto later = [](const Head& a, const Head& b) { return a > b; };
+
+    // on_frame may throw (e.g. a full disk under -w); the capture threads must be joined first
+    std::exception_ptr failure;
+    try {
+        uint64_t emitted = 0;
+        CapturedFrame out;
+        while (!(should_stop && should_stop())) {
+            for (unsigned i = 0; i < sources_.size(); ++i) {
+                if (queued[i]) continue;
+                if (Record* rec = sources_[i]->queue.Front()) {
+                    heap.emplace_back(rec->ts_ns, i);
+                    std::push_heap(heap.begin(), heap.end(), later);
+                    queued[i] = 1;
+                }
+            }
+
+            // The oldest queued frame may only go out once every idle interface
+            // has proven it holds nothing older
+            bool ready = !heap.empty();
+            for (unsigned i = 0; ready && i < sources_.size(); ++i) {
+                if (!queued[i] && sources_[i]->watermark_ns.load(std::memory_order_acquire) < heap.front().first)
+                    ready = false;
+            }
+            if (!ready) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+
+            std::pop_heap(heap.begin(), heap.end(), later);
+            unsigned i = heap.back().second;
+            heap.pop_back();
+            queued[i] = 0;
+
+            Record* rec = sources_[i]->queue.Front();
+            out.interface = i;
+            out.ts_ns = rec->ts_ns;
+            out.caplen = rec->caplen;
+            out.len = rec->len;
+            out.data = sources_[i]->Data(*rec);
+            on_frame(out);
+            sources_[i]->freed.store(rec->end, std::memory_order_release);
+            sources_[i]->queue.Pop();
+
+            if (options_.max_packets && ++emitted >= options_.max_packets) break;
+        }
+    } catch (...) {
+        failure = std::current_exception();
+    }
+
+    stop_ = true;
+    for (auto& t : threads) t.join();
+    for (size_t i = 0; i < sources_.size(); ++i) stats_[i] = sources_[i]->stats;
+    if (failure) std::rethrow_exception(failure);
+}
+
+} // namespace RedTops
@@ -0,0 +1,344 @@
+#include "../headers/NetlinkRoute.hpp"
+#include "../../core/header/Exceptions.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <linux/if_link.h>
+#include <linux/neighbour.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace RedTops {
+
+namespace {
+
+constexpr size_t kRecvBuffer = 64 * 1024;     // larger than any single dump chunk
+constexpr int kSocketBuffer = 4 * 1024 * 1024;
+
+// Walks the rtattr list that follows a family header of hdr_len bytes
+template <typename Fn>
+void ForEachAttr(const nlmsghdr* nlh, size_t hdr_len, Fn&& fn) {
+    const char* base = static_cast<const char*>(NLMSG_DATA(nlh)) + NLMSG_ALIGN(hdr_len);
+    int len = static_cast<int>(nlh->nlmsg_len) - static_cast<int>(NLMSG_LENGTH(hdr_len));
+    for (auto* rta = reinterpret_cast<const rtattr*>(base); RTA_OK(rta, len); rta = RTA_NEXT(rta, len))
+        fn(rta);
+}
+
+template <typename Fn>
+void ForEachNested(const rtattr* parent, Fn&& fn) {
+    int len = static_cast<int>(RTA_PAYLOAD(parent));
+    for (auto* rta = static_cast<const rtattr*>(RTA_DATA(parent)); RTA_OK(rta, len); rta = RTA_NEXT(rta, len))
+        fn(rta);
+}
+
+uint32_t AttrU32(const rtattr* rta) {
+    uint32_t v = 0;
+    if (RTA_PAYLOAD(rta) >= sizeof(v)) std::memcpy(&v, RTA_DATA(rta), sizeof(v));
+    return v;
+}
+
+std::string AttrString(const rtattr* rta) {
+    const char* s = static_cast<const char*>(RTA_DATA(rta));
+    return std::string(s, strnlen(s, RTA_PAYLOAD(rta)));
+}
+
+std::string AttrAddress(int family, const rtattr* rta) {
+    char text[INET6_ADDRSTRLEN] = {};
+    size_t need = family == AF_INET6 ? 16 : 4;
+    if (RTA_PAYLOAD(rta) < need || !inet_ntop(family, RTA_DATA(rta), text, sizeof(text))) return {};
+    return text;
+}
+
+std::string AttrHardware(const rtattr* rta) {
+    const auto* b = static_cast<const unsigned char*>(RTA_DATA(rta));
+    size_t n = RTA_PAYLOAD(rta);
+    std::string out;
+    char part[4];
+    for (size_t i = 0; i < n; ++i) {
+        std::snprintf(part, sizeof(part), i ? ":%02x" : "%02x", b[i]);
+        out += part;
+    }
+    return out;
+}
+
+LinkInfo ParseLink(const nlmsghdr* nlh) {
+    LinkInfo link;
+    const auto* ifi = static_cast<const ifinfomsg*>(NLMSG_DATA(nlh));
+    link.index = ifi->ifi_index;
+    link.flags = ifi->ifi_flags;
+    ForEachAttr(nlh, sizeof(ifinfomsg), [&](const rtattr* rta) {
+        switch (rta->rta_type) {
+            case IFLA_IFNAME:  link.name = AttrString(rta); break;
+            case IFLA_ADDRESS: link.mac = AttrHardware(rta); break;
+            case IFLA_MTU:     link.mtu = AttrU32(rta); break;
+            case IFLA_MASTER:  link.master = static_cast<int>(AttrU32(rta)); break;
+            case IFLA_STATS64:
+                if (RTA_PAYLOAD(rta) >= sizeof(rtnl_link_stats64)) {
+                    rtnl_link_stats64 stats;
+                    std::memcpy(&stats, RTA_DATA(rta), sizeof(stats));
+                    link.rx_bytes = stats.rx_bytes;
+                    link.tx_bytes = stats.tx_bytes;
+                    link.rx_packets = stats.rx_packets;
+                    link.tx_packets = stats.tx_packets;
+                    link.rx_errors = stats.rx_errors;
+                    link.tx_errors = stats.tx_errors;
+                    link.rx_dropped = stats.rx_dropped;
+                    link.tx_dropped = stats.tx_dropped;
+                }
+                break;
+            case IFLA_LINKINFO:
+                ForEachNested(rta, [&](const rtattr* nested) {
+                    if (nested->rta_type == IFLA_INFO_KIND) link.kind = AttrString(nested);
+                });
+                break;
+        }
+    });
+    return link;
+}
+
+AddrInfo ParseAddr(const nlmsghdr* nlh) {
+    AddrInfo addr;
+    const auto* ifa = static_cast<const ifaddrmsg*>(NLMSG_DATA(nlh));
+    addr.index = static_cast<int>(ifa->ifa_index);
+    addr.family = ifa->ifa_family;
+    addr.prefix = ifa->ifa_prefixlen;
+    addr.scope = ifa->ifa_scope;
+    std::string local, address;
+    ForEachAttr(nlh, sizeof(ifaddrmsg), [&](const rtattr* rta) {
+        if (rta->rta_type == IFA_LOCAL) local = AttrAddress(addr.family, rta);
+        else if (rta->rta_type == IFA_ADDRESS) address = AttrAddress(addr.family, rta);
+    });
+    // On point-to-point links IFA_ADDRESS is the peer; IFA_LOCAL is ours
+    addr.address = local.empty() ? address : local;
+    return addr;
+}
+
+RouteInfo ParseRoute(const nlmsghdr* nlh) {
+    RouteInfo route;
+    const auto* rtm = static_cast<const rtmsg*>(NLMSG_DATA(nlh));
+    route.family = rtm->rtm_family;
+    route.dst_len = rtm->rtm_dst_len;
+    route.table = rtm->rtm_table;
+    route.protocol = rtm->rtm_protocol;
+    route.scope = rtm->rtm_scope;
+    route.type = rtm->rtm_type;
+    ForEachAttr(nlh, sizeof(rtmsg), [&](const rtattr* rta) {
+        switch (rta->rta_type) {
+            case RTA_DST:      route.dst = AttrAddress(route.family, rta); break;
+            case RTA_GATEWAY:  route.gateway = AttrAddress(route.family, rta); break;
+            case RTA_PREFSRC:  route.prefsrc = AttrAddress(route.family, rta); break;
+            case RTA_OIF:      route.oif = static_cast<int>(AttrU32(rta)); break;
+            case RTA_TABLE:    route.table = AttrU32(rta); break;
+            case RTA_PRIORITY: route.metric = AttrU32(rta); break;
+        }
+    });
+    return route;
+}
+
+NeighInfo ParseNeigh(const nlmsghdr* nlh) {
+    NeighInfo neigh;
+    const auto* ndm = static_cast<const ndmsg*>(NLMSG_DATA(nlh));
+    neigh.index = ndm->ndm_ifindex;
+    neigh.family = ndm->ndm_family;
+    neigh.state = ndm->ndm_state;
+    ForEachAttr(nlh, sizeof(ndmsg), [&](const rtattr* rta) {
+        if (rta->rta_type == NDA_DST) neigh.address = AttrAddress(neigh.family, rta);
+        else if (rta->rta_type == NDA_LLADDR) neigh.lladdr = AttrHardware(rta);
+    });
+    return neigh;
+}
+
+} // namespace
+
+bool LinkInfo::up() const { return flags & IFF_UP; }
+bool LinkInfo::running() const { return flags & IFF_RUNNING; }
+
+std::string NetlinkSnapshot::LinkName(int index) const {
+    for (const LinkInfo& link : links)
+        if (link.index == index) return link.name;
+    return "if" + std::to_string(index);
+}
+
+const char* RouteProtocolName(unsigned char protocol) {
+    switch (protocol) {
+        case RTPROT_UNSPEC:   return "unspec";
+        case RTPROT_REDIRECT: return "redirect";
+        case RTPROT_KERNEL:   return "kernel";
+        case RTPROT_BOOT:     return "boot";
+        case RTPROT_STATIC:   return "static";
+        case RTPROT_RA:       return "ra";
+        case RTPROT_DHCP:     return "dhcp";
+        case RTPROT_BGP:      return "bgp";
+        case RTPROT_OSPF:     return "ospf";
+        default:              return "other";
+    }
+}
+
+const char* NeighStateName(uint16_t state) {
+    if (state & NUD_PERMANENT) return "PERMANENT";
+    if (state & NUD_REACHABLE) return "REACHABLE";
+    if (state & NUD_STALE)     return "STALE";
+    if (state & NUD_DELAY)     return "DELAY";
+    if (state & NUD_PROBE)     return "PROBE";
+    if (state & NUD_FAILED)    return "FAILED";
+    if (state & NUD_INCOMPLETE) return "INCOMPLETE";
+    if (state & NUD_NOARP)     return "NOARP";
+    return "NONE";
+}
+
+const char* ScopeName(unsigned char scope) {
+    switch (scope) {
+        case RT_SCOPE_UNIVERSE: return "global";
+        case RT_SCOPE_SITE:     return "site";
+        case RT_SCOPE_LINK:     return "link";
+        case RT_SCOPE_HOST:     return "host";
+        default:                return "nowhere";
+    }
+}
+
+NetlinkRoute::NetlinkRoute(bool watch) : buf_(kRecvBuffer) {
+    fd_ = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd_ < 0)
+        throw NetworkError(std::string("netinfo: netlink socket failed: ") + strerror(errno));
+
+    // Room for big dumps and event bursts; FORCE needs CAP_NET_ADMIN
+    int size = kSocketBuffer;
+    if (setsockopt(fd_, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) < 0)
+        setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+    sockaddr_nl local{};
+    local.nl_family = AF_NETLINK;
+    if (watch) {
+        local.nl_groups = RTMGRP_LINK | RTMGRP_NEIGH | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR |
+                          RTMGRP_IPV4_ROUTE | RTMGRP_IPV6_ROUTE;
+    }
+    if (bind(fd_, reinterpret_cast<sockaddr*>(&local), sizeof(local)) < 0) {
+        int err = errno;
+        close(fd_);
+        fd_ = -1;
+        throw NetworkError(std::string("netinfo: netlink bind failed: ") + strerror(err));
+    }
+    socklen_t len = sizeof(local);
+    getsockname(fd_, reinterpret_cast<sockaddr*>(&local), &len);
+    port_id_ = local.nl_pid;
+}
+
+NetlinkRoute::~NetlinkRoute() {
+    if (fd_ >= 0) close(fd_);
+}
+
+template <typename Fn>
+void NetlinkRoute::DumpRequest(uint16_t type, unsigned char family, Fn&& on_message) {
+    struct {
+        nlmsghdr nlh;
+        rtgenmsg gen;
+    } req{};
+    req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(rtgenmsg));
+    req.nlh.nlmsg_type = type;
+    req.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.nlh.nlmsg_seq = ++seq_;
+    req.gen.rtgen_family = family;
+
+    sockaddr_nl kernel{};
+    kernel.nl_family = AF_NETLINK;
+    if (sendto(fd_, &req, req.nlh.nlmsg_len, 0, reinterpret_cast<sockaddr*>(&kernel), sizeof(kernel)) < 0)
+        throw NetworkError(std::string("netinfo: netlink request failed: ") + strerror(errno));
+
+    for (;;) {
+        ssize_t n = recv(fd_, buf_.data(), buf_.size(), 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw NetworkError(std::string("netinfo: netlink receive failed: ") + strerror(errno));
+        }
+        int len = static_cast<int>(n);
+        for (auto* nlh = reinterpret_cast<const nlmsghdr*>(buf_.data()); NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+            if (nlh->nlmsg_seq != seq_ || nlh->nlmsg_pid != port_id_) continue;   // stale reply
+            if (nlh->nlmsg_type == NLMSG_DONE) return;
+            if (nlh->nlmsg_type == NLMSG_ERROR) {
+                const auto* err = static_cast<const nlmsgerr*>(NLMSG_DATA(nlh));
+                if (err->error == 0) continue;
+                throw NetworkError(std::string("netinfo: netlink dump failed: ") + strerror(-err->error));
+            }
+            on_message(nlh);
+        }
+    }
+}
+
+NetlinkSnapshot NetlinkRoute::Dump() {
+    NetlinkSnapshot snap;
+    DumpRequest(RTM_GETLINK, AF_UNSPEC, [&](const nlmsghdr* nlh) {
+        if (nlh->nlmsg_type == RTM_NEWLINK) snap.links.push_back(ParseLink(nlh));
+    });
+    DumpRequest(RTM_GETADDR, AF_UNSPEC, [&](const nlmsghdr* nlh) {
+        if (nlh->nlmsg_type == RTM_NEWADDR) snap.addrs.push_back(ParseAddr(nlh));
+    });
+    DumpRequest(RTM_GETROUTE, AF_UNSPEC, [&](const nlmsghdr* nlh) {
+        if (nlh->nlmsg_type == RTM_NEWROUTE) snap.routes.push_back(ParseRoute(nlh));
+    });
+    DumpRequest(RTM_GETNEIGH, AF_UNSPEC, [&](const nlmsghdr* nlh) {
+        if (nlh->nlmsg_type == RTM_NEWNEIGH) snap.neighbors.push_back(ParseNeigh(nlh));
+    });
+    return snap;
+}
+
+std::vector<LinkInfo> NetlinkRoute::Links() {
+    std::vector<LinkInfo> links;
+    DumpRequest(RTM_GETLINK, AF_UNSPEC, [&](const nlmsghdr* nlh) {
+        if (nlh->nlmsg_type == RTM_NEWLINK) links.push_back(ParseLink(nlh));
+    });
+    return links;
+}
+
+bool NetlinkRoute::ReadEvents(int timeout_ms, const std::function<void(const NetlinkEvent&)>& fn) {
+    pollfd pfd{fd_, POLLIN, 0};
+    if (poll(&pfd, 1, timeout_ms) <= 0) return true;
+
+    bool complete = true;
+    for (;;) {
+        ssize_t n = recv(fd_, buf_.data(), buf_.size(), MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS) { complete = false; continue; }   // overflow: events were lost
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return complete;
+            throw NetworkError(std::string("netinfo: netlink receive failed: ") + strerror(errno));
+        }
+        int len = static_cast<int>(n);
+        for (auto* nlh = reinterpret_cast<const nlmsghdr*>(buf_.data()); NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+            NetlinkEvent ev;
+            switch (nlh->nlmsg_type) {
+                case RTM_NEWLINK:  case RTM_DELLINK:
+                    ev.kind = NetlinkEvent::Kind::Link;
+                    ev.removed = nlh->nlmsg_type == RTM_DELLINK;
+                    ev.link = ParseLink(nlh);
+                    break;
+                case RTM_NEWADDR:  case RTM_DELADDR:
+                    ev.kind = NetlinkEvent::Kind::Addr;
+                    ev.removed = nlh->nlmsg_type == RTM_DELADDR;
+                    ev.addr = ParseAddr(nlh);
+                    break;
+                case RTM_NEWROUTE: case RTM_DELROUTE:
+                    ev.kind = NetlinkEvent::Kind::Route;
+                    ev.removed = nlh->nlmsg_type == RTM_DELROUTE;
+                    ev.route = ParseRoute(nlh);
+                    break;
+                case RTM_NEWNEIGH: case RTM_DELNEIGH:
+                    ev.kind = NetlinkEvent::Kind::Neigh;
+                    ev.removed = nlh->nlmsg_type == RTM_DELNEIGH;
+                    ev.neigh = ParseNeigh(nlh);
+                    break;
+                default:
+                    continue;
+            }
+            fn(ev);
+        }
+    }
+}
+
+} // namespace RedTops
@@ -0,0 +1,504 @@
+#include "../headers/PacketDissector.hpp"
+
+#include <cstring>
+#include <arpa/inet.h>
+
+namespace RedTops {
+
+namespace {
+
+constexpr uint16_t kEthIPv4 = 0x0800;
+constexpr uint16_t kEthARP = 0x0806;
+constexpr uint16_t kEthVLAN = 0x8100;
+constexpr uint16_t kEthQinQ = 0x88a8;
+constexpr uint16_t kEthQinQLegacy = 0x9100;
+constexpr uint16_t kEthIPv6 = 0x86dd;
+constexpr uint16_t kEthTransparentBridge = 0x6558;  // Ethernet over GRE
+
+constexpr uint8_t kProtoICMP = 1;
+constexpr uint8_t kProtoTCP = 6;
+constexpr uint8_t kProtoUDP = 17;
+constexpr uint8_t kProtoGRE = 47;
+constexpr uint8_t kProtoESP = 50;
+constexpr uint8_t kProtoAH = 51;
+constexpr uint8_t kProtoICMPv6 = 58;
+constexpr uint8_t kProtoNoNext = 59;
+
+constexpr int kMaxTunnelDepth = 2;
+constexpr int kMaxExtHeaders = 8;
+
+inline uint16_t Be16(const uint8_t* p) { return static_cast<uint16_t>(p[0] << 8 | p[1]); }
+inline uint32_t Be32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 |
+           static_cast<uint32_t>(p[2]) << 8 | p[3];
+}
+
+struct Cursor {
+    const uint8_t* data;
+    uint32_t caplen;
+    DissectedPacket& out;
+
+    bool Has(uint32_t off, uint32_t len) const { return off <= caplen && len <= caplen - off; }
+    bool Need(uint32_t off, uint32_t len) {
+        if (Has(off, len)) return true;
+        out.flags |= DissectFlag::Truncated;
+        return false;
+    }
+};
+
+void DissectEthernet(Cursor& c, uint32_t off, int depth);
+void DissectL3(Cursor& c, uint16_t ethertype, uint32_t off, int depth);
+
+void SetPayload(Cursor& c, uint32_t off, uint32_t end) {
+    if (end > c.caplen) end = c.caplen;
+    if (off > end) off = end;
+    c.out.payload_offset = off;
+    c.out.payload_length = end - off;
+}
+
+void DissectL4(Cursor& c, uint8_t proto, uint32_t off, uint32_t end, int depth) {
+    DissectedPacket& p = c.out;
+    p.l4_proto = proto;
+    p.l4_offset = off;
+
+    switch (proto) {
+        case kProtoTCP: {
+            if (!c.Need(off, 20)) return;
+            const uint8_t* h = c.data + off;
+            p.src_port = Be16(h);
+            p.dst_port = Be16(h + 2);
+            p.tcp_seq = Be32(h + 4);
+            p.tcp_ack = Be32(h + 8);
+            p.tcp_flags = h[13];
+            p.tcp_window = Be16(h + 14);
+            p.flags |= DissectFlag::HasPorts;
+            uint32_t doff = static_cast<uint32_t>(h[12] >> 4) * 4;
+            if (doff < 20 || off + doff > end) { p.flags |= DissectFlag::Malformed; return; }
+            SetPayload(c, off + doff, end);
+            return;
+        }
+        case kProtoUDP: {
+            if (!c.Need(off, 8)) return;
+            const uint8_t* h = c.data + off;
+            p.src_port = Be16(h);
+            p.dst_port = Be16(h + 2);
+            p.flags |= DissectFlag::HasPorts;
+            uint16_t ulen = Be16(h + 4);
+            if (ulen < 8 || off + ulen > end) { p.flags |= DissectFlag::Malformed; ulen = static_cast<uint16_t>(end > off + 8 ? end - off : 8); }
+            SetPayload(c, off + 8, off + ulen);
+            return;
+        }
+        case kProtoICMP:
+        case kProtoICMPv6: {
+            if (!c.Need(off, 4)) return;
+            const uint8_t* h = c.data + off;
+            p.icmp_type = h[0];
+            p.icmp_code = h[1];
+            p.flags |= DissectFlag::HasIcmp;
+            bool echo = proto == kProtoICMP ? (h[0] == 0 || h[0] == 8) : (h[0] == 128 || h[0] == 129);
+            if (echo && c.Has(off, 8)) {
+                p.icmp_id = Be16(h + 4);
+                p.icmp_seq = Be16(h + 6);
+            }
+            SetPayload(c, off + 8, end);
+            return;
+        }
+        case kProtoGRE: {
+            if (!c.Need(off, 4)) return;
+            const uint8_t* h = c.data + off;
+            uint16_t gflags = Be16(h);
+            if ((gflags & 0x0007) != 0) return;  // version 1 (PPTP) is not plain GRE
+            uint32_t len = 4;
+            if (gflags & 0x8000) len += 4;       // checksum + reserved
+            uint32_t key_off = off + len;
+            if (gflags & 0x2000) len += 4;       // key
+            if (gflags & 0x1000) len += 4;       // sequence
+            if (!c.Need(off, len)) return;
+            if ((p.flags & DissectFlag::HasGre) == 0) {
+                p.flags |= DissectFlag::HasGre;
+                p.gre_offset = off;
+                p.gre_protocol = Be16(h + 2);
+                if (gflags & 0x2000) p.gre_key = Be32(c.data + key_off);
+            }
+            if (depth >= kMaxTunnelDepth) { SetPayload(c, off + len, end); return; }
+            uint16_t inner = Be16(h + 2);
+            if (inner == kEthIPv4 || inner == kEthIPv6) {
+                p.flags |= DissectFlag::Tunneled;
+                DissectL3(c, inner, off + len, depth + 1);
+            } else if (inner == kEthTransparentBridge) {
+                p.flags |= DissectFlag::Tunneled;
+                DissectEthernet(c, off + len, depth + 1);
+            } else {
+                SetPayload(c, off + len, end);
+            }
+            return;
+        }
+        default:
+            SetPayload(c, off, end);
+            return;
+    }
+}
+
+void DissectIPv4(Cursor& c, uint32_t off, int depth) {
+    DissectedPacket& p = c.out;
+    if (!c.Need(off, 20)) return;
+    const uint8_t* h = c.data + off;
+    if ((h[0] >> 4) != 4) { p.flags |= DissectFlag::Malformed; return; }
+    uint32_t ihl = static_cast<uint32_t>(h[0] & 0x0f) * 4;
+    uint32_t total = Be16(h + 2);
+    if (ihl < 20 || total < ihl) { p.flags |= DissectFlag::Malformed; return; }
+
+    p.l3 = L3Proto::IPv4;
+    p.l3_offset = off;
+    p.ttl = h[8];
+    p.l4_proto = h[9];
+    std::memset(p.src_addr, 0, sizeof(p.src_addr));
+    std::memset(p.dst_addr, 0, sizeof(p.dst_addr));
+    std::memcpy(p.src_addr, h + 12, 4);
+    std::memcpy(p.dst_addr, h + 16, 4);
+
+    if (!c.Need(off, ihl)) return;
+    uint32_t end = off + total;
+    if (end > c.caplen) {
+        // A short snaplen is expected; a length beyond the wire frame is not
+        if (end > p.wirelen) p.flags |= DissectFlag::Malformed;
+        end = c.caplen;
+    }
+
+    uint16_t frag = Be16(h + 6);
+    if ((frag & 0x1fff) != 0) {
+        p.flags |= DissectFlag::Fragment;
+        SetPayload(c, off + ihl, end);
+        return;
+    }
+    DissectL4(c, h[9], off + ihl, end, depth);
+}
+
+void DissectIPv6(Cursor& c, uint32_t off, int depth) {
+    DissectedPacket& p = c.out;
+    if (!c.Need(off, 40)) return;
+    const uint8_t* h = c.data + off;
+    if ((h[0] >> 4) != 6) { p.flags |= DissectFlag::Malformed; return; }
+
+    p.l3 = L3Proto::IPv6;
+    p.l3_offset = off;
+    p.ttl = h[7];
+    std::memcpy(p.src_addr, h + 8, 16);
+    std::memcpy(p.dst_addr, h + 24, 16);
+
+    uint32_t end = off + 40 + Be16(h + 4);
+    if (end > c.caplen) end = c.caplen;
+
+    uint8_t next = h[6];
+    uint32_t cur = off + 40;
+    p.ipv6_ext_headers = 0;
+    for (int i = 0; i < kMaxExtHeaders; ++i) {
+        uint32_t len;
+        switch (next) {
+            case 0:    // hop-by-hop
+            case 43:   // routing
+            case 60:   // destination options
+            case 135:  // mobility
+                if (!c.Need(cur, 8)) { p.l4_proto = next; return; }
+                len = (static_cast<uint32_t>(c.data[cur + 1]) + 1) * 8;
+                break;
+            case 44:   // fragment
+                if (!c.Need(cur, 8)) { p.l4_proto = next; return; }
+                len = 8;
+                if ((Be16(c.data + cur + 2) & 0xfff8) != 0) {
+                    p.flags |= DissectFlag::Fragment;
+                    p.l4_proto = c.data[cur];
+                    p.ipv6_ext_headers++;
+                    SetPayload(c, cur + 8, end);
+                    return;
+                }
+                break;
+            case kProtoAH:
+                if (!c.Need(cur, 8)) { p.l4_proto = next; return; }
+                len = (static_cast<uint32_t>(c.data[cur + 1]) + 2) * 4;
+                break;
+            case kProtoESP:
+            case kProtoNoNext:
+                p.l4_proto = next;
+                SetPayload(c, cur, end);
+                return;
+            default:
+                DissectL4(c, next, cur, end, depth);
+                return;
+        }
+        if (cur + len > end) { p.flags |= DissectFlag::Malformed; p.l4_proto = next; return; }
+        next = c.data[cur];
+        cur += len;
+        p.ipv6_ext_headers++;
+    }
+    p.flags |= DissectFlag::Malformed;  // extension header chain too long
+    p.l4_proto = next;
+}
+
+void DissectARP(Cursor& c, uint32_t off) {
+    DissectedPacket& p = c.out;
+    if (!c.Need(off, 28)) return;
+    const uint8_t* h = c.data + off;
+    p.l3 = L3Proto::ARP;
+    p.l3_offset = off;
+    // Only Ethernet/IPv4 ARP carries the fixed 6/4 address layout decoded here
+    if (Be16(h) != 1 || Be16(h + 2) != kEthIPv4 || h[4] != 6 || h[5] != 4) {
+        p.flags |= DissectFlag::Malformed;
+        return;
+    }
+    p.arp_op = Be16(h + 6);
+    std::memcpy(p.arp_sender_mac, h + 8, 6);
+    std::memcpy(p.arp_sender_ip, h + 14, 4);
+    std::memcpy(p.arp_target_mac, h + 18, 6);
+    std::memcpy(p.arp_target_ip, h + 24, 4);
+}
+
+void DissectL3(Cursor& c, uint16_t ethertype, uint32_t off, int depth) {
+    c.out.ethertype = ethertype;
+    if (ethertype == kEthIPv4) DissectIPv4(c, off, depth);
+    else if (ethertype == kEthIPv6) DissectIPv6(c, off, depth);
+    else if (ethertype == kEthARP) DissectARP(c, off);
+    else SetPayload(c, off, c.caplen);
+}
+
+void DissectEthernet(Cursor& c, uint32_t off, int depth) {
+    DissectedPacket& p = c.out;
+    if (!c.Need(off, 14)) return;
+    const uint8_t* h = c.data + off;
+    if (depth == 0) {
+        std::memcpy(p.dst_mac, h, 6);
+        std::memcpy(p.src_mac, h + 6, 6);
+    }
+    uint16_t type = Be16(h + 12);
+    off += 14;
+    while (type == kEthVLAN || type == kEthQinQ || type == kEthQinQLegacy) {
+        if (!c.Need(off, 4)) return;
+        if (p.vlan_count < 2) p.vlan_ids[p.vlan_count++] = Be16(c.data + off) & 0x0fff;
+        else { p.flags |= DissectFlag::Malformed; return; }
+        type = Be16(c.data + off + 2);
+        off += 4;
+    }
+    DissectL3(c, type, off, depth);
+}
+
+// ---- formatting ----
+
+struct Writer {
+    char* p;
+    char* end;   // last byte, reserved for NUL
+    char* begin;
+    bool has_room;
+
+    Writer(char* buf, size_t cap) : p(buf), end(cap ? buf + cap - 1 : buf), begin(buf), has_room(cap > 0) {}
+    size_t Finish() { if (has_room) *p = '\0'; return static_cast<size_t>(p - begin); }
+
+    void Put(char ch) { if (p < end) *p++ = ch; }
+    void Str(const char* s) { while (*s && p < end) *p++ = *s++; }
+    void Dec(uint64_t v) {
+        char tmp[20];
+        int n = 0;
+        do { tmp[n++] = static_cast<char>('0' + v % 10); v /= 10; } while (v);
+        while (n && p < end) *p++ = tmp[--n];
+    }
+    void Hex2(uint8_t v) {
+        static const char* digits = "0123456789abcdef";
+        Put(digits[v >> 4]);
+        Put(digits[v & 0xf]);
+    }
+    void Mac(const uint8_t* m) {
+        for (int i = 0; i < 6; ++i) { if (i) Put(':'); Hex2(m[i]); }
+    }
+    void IPv4(const uint8_t* a) {
+        for (int i = 0; i < 4; ++i) { if (i) Put('.'); Dec(a[i]); }
+    }
+    void IPv6(const uint8_t* a) {
+        char tmp[INET6_ADDRSTRLEN];
+        if (inet_ntop(AF_INET6, a, tmp, sizeof(tmp))) Str(tmp);
+        else Put('?');
+    }
+    void Addr(const DissectedPacket& pkt, const uint8_t* a) {
+        if (pkt.l3 == L3Proto::IPv6) IPv6(a);
+        else IPv4(a);
+    }
+    void Endpoint(const DissectedPacket& pkt, const uint8_t* a, uint16_t port) {
+        bool bracket = pkt.l3 == L3Proto::IPv6 && (pkt.flags & DissectFlag::HasPorts);
+        if (bracket) Put('[');
+        Addr(pkt, a);
+        if (bracket) Put(']');
+        if (pkt.flags & DissectFlag::HasPorts) { Put(':'); Dec(port); }
+    }
+    void TcpFlags(uint8_t f) {
+        static const char names[] = "FSRPAUEC";
+        Put('[');
+        bool any = false;
+        for (int i = 0; i < 8; ++i) if (f & (1 << i)) { Put(names[i]); any = true; }
+        if (!any) Put('.');
+        Put(']');
+    }
+    void Line(const char* label) { Put('\n'); Str(label); }
+};
+
+void WriteL4Summary(Writer& w, const DissectedPacket& pkt) {
+    w.Str(ProtocolName(pkt.l4_proto));
+    if (pkt.l4_proto == kProtoTCP && (pkt.flags & DissectFlag::HasPorts)) {
+        w.Put(' ');
+        w.TcpFlags(pkt.tcp_flags);
+        w.Str(" seq="); w.Dec(pkt.tcp_seq);
+        if (pkt.tcp_flags & TcpFlag::ACK) { w.Str(" ack="); w.Dec(pkt.tcp_ack); }
+        w.Str(" win="); w.Dec(pkt.tcp_window);
+    }
+    if (pkt.flags & DissectFlag::HasIcmp) {
+        w.Str(" type="); w.Dec(pkt.icmp_type);
+        w.Str(" code="); w.Dec(pkt.icmp_code);
+        if (pkt.icmp_id || pkt.icmp_seq) { w.Str(" id="); w.Dec(pkt.icmp_id); w.Str(" seq="); w.Dec(pkt.icmp_seq); }
+    }
+    if (pkt.payload_offset != kNoOffset) { w.Str(" len="); w.Dec(pkt.payload_length); }
+}
+
+void WriteFlags(Writer& w, const DissectedPacket& pkt) {
+    if (pkt.flags & DissectFlag::Fragment) w.Str(" [frag]");
+    if (pkt.flags & DissectFlag::Truncated) w.Str(" [truncated]");
+    if (pkt.flags & DissectFlag::Malformed) w.Str(" [malformed]");
+}
+
+} // namespace
+
+bool Dissect(const uint8_t* frame, uint32_t caplen, uint32_t wirelen, DissectedPacket& out) noexcept {
+    out = DissectedPacket{};
+    out.caplen = caplen;
+    out.wirelen = wirelen;
+    if (frame == nullptr || caplen < 14) {
+        out.flags |= DissectFlag::Truncated;
+        return false;
+    }
+    Cursor c{frame, caplen, out};
+    DissectEthernet(c, 0, 0);
+    return true;
+}
+
+const char* ProtocolName(uint8_t ip_proto) noexcept {
+    switch (ip_proto) {
+        case kProtoICMP: return "ICMP";
+        case 2: return "IGMP";
+        case kProtoTCP: return "TCP";
+        case kProtoUDP: return "UDP";
+        case kProtoGRE: return "GRE";
+        case kProtoESP: return "ESP";
+        case kProtoAH: return "AH";
+        case kProtoICMPv6: return "ICMPv6";
+        case 89: return "OSPF";
+        case 132: return "SCTP";
+        default: return "IP";
+    }
+}
+
+size_t FormatAddress(const DissectedPacket& pkt, bool source, char* buf, size_t cap) noexcept {
+    Writer w(buf, cap);
+    if (pkt.l3 == L3Proto::IPv4 || pkt.l3 == L3Proto::IPv6)
+        w.Endpoint(pkt, source ? pkt.src_addr : pkt.dst_addr, source ? pkt.src_port : pkt.dst_port);
+    else if (pkt.l3 == L3Proto::ARP)
+        w.IPv4(source ? pkt.arp_sender_ip : pkt.arp_target_ip);
+    else
+        w.Mac(source ? pkt.src_mac : pkt.dst_mac);
+    return w.Finish();
+}
+
+size_t FormatSummary(const DissectedPacket& pkt, char* buf, size_t cap) noexcept {
+    Writer w(buf, cap);
+    if (pkt.vlan_count) {
+        w.Str("vlan ");
+        for (uint8_t i = 0; i < pkt.vlan_count; ++i) { if (i) w.Put('.'); w.Dec(pkt.vlan_ids[i]); }
+        w.Put(' ');
+    }
+    if (pkt.flags & DissectFlag::HasGre) w.Str("gre ");
+
+    switch (pkt.l3) {
+        case L3Proto::IPv4:
+        case L3Proto::IPv6:
+            w.Str(pkt.l3 == L3Proto::IPv4 ? "IPv4 " : "IPv6 ");
+            w.Endpoint(pkt, pkt.src_addr, pkt.src_port);
+            w.Str(" > ");
+            w.Endpoint(pkt, pkt.dst_addr, pkt.dst_port);
+            w.Put(' ');
+            WriteL4Summary(w, pkt);
+            break;
+        case L3Proto::ARP:
+            if (pkt.arp_op == 1) {
+                w.Str("ARP who-has "); w.IPv4(pkt.arp_target_ip);
+                w.Str(" tell "); w.IPv4(pkt.arp_sender_ip);
+            } else if (pkt.arp_op == 2) {
+                w.Str("ARP reply "); w.IPv4(pkt.arp_sender_ip);
+                w.Str(" is-at "); w.Mac(pkt.arp_sender_mac);
+            } else {
+                w.Str("ARP op="); w.Dec(pkt.arp_op);
+            }
+            break;
+        case L3Proto::None:
+            w.Mac(pkt.src_mac);
+            w.Str(" > ");
+            w.Mac(pkt.dst_mac);
+            w.Str(" ethertype=0x");
+            w.Hex2(static_cast<uint8_t>(pkt.ethertype >> 8));
+            w.Hex2(static_cast<uint8_t>(pkt.ethertype));
+            break;
+    }
+    w.Str(" (");
+    w.Dec(pkt.wirelen);
+    w.Str(" bytes)");
+    WriteFlags(w, pkt);
+    return w.Finish();
+}
+
+size_t FormatDetail(const DissectedPacket& pkt, char* buf, size_t cap) noexcept {
+    Writer w(buf, cap);
+    w.Str("----------------------------------------------------");
+    w.Line("Packet captured! Length: "); w.Dec(pkt.wirelen);
+    if (pkt.caplen < pkt.wirelen) { w.Str(" (captured "); w.Dec(pkt.caplen); w.Put(')'); }
+    w.Line("Source MAC: "); w.Mac(pkt.src_mac);
+    w.Line("Dest MAC:   "); w.Mac(pkt.dst_mac);
+    if (pkt.vlan_count) {
+        w.Line("VLAN:       ");
+        for (uint8_t i = 0; i < pkt.vlan_count; ++i) { if (i) w.Str(", "); w.Dec(pkt.vlan_ids[i]); }
+    }
+    if (pkt.flags & DissectFlag::HasGre) {
+        w.Line("GRE:        proto=0x");
+        w.Hex2(static_cast<uint8_t>(pkt.gre_protocol >> 8));
+        w.Hex2(static_cast<uint8_t>(pkt.gre_protocol));
+        if (pkt.gre_key) { w.Str(" key="); w.Dec(pkt.gre_key); }
+    }
+
+    if (pkt.l3 == L3Proto::IPv4 || pkt.l3 == L3Proto::IPv6) {
+        w.Line("Source IP: "); w.Addr(pkt, pkt.src_addr);
+        w.Line("Dest IP:   "); w.Addr(pkt, pkt.dst_addr);
+        w.Line("Protocol:  "); w.Dec(pkt.l4_proto);
+        w.Str(" ("); w.Str(ProtocolName(pkt.l4_proto)); w.Put(')');
+        w.Line(pkt.l3 == L3Proto::IPv4 ? "TTL:       " : "Hop Limit: "); w.Dec(pkt.ttl);
+        if (pkt.ipv6_ext_headers) { w.Line("Ext Hdrs:  "); w.Dec(pkt.ipv6_ext_headers); }
+        if (pkt.flags & DissectFlag::HasPorts) {
+            w.Line("Source Port: "); w.Dec(pkt.src_port);
+            w.Line("Dest Port:   "); w.Dec(pkt.dst_port);
+        }
+        if (pkt.l4_proto == kProtoTCP && (pkt.flags & DissectFlag::HasPorts)) {
+            w.Line("TCP Flags:   "); w.TcpFlags(pkt.tcp_flags);
+            w.Str(" seq="); w.Dec(pkt.tcp_seq);
+            w.Str(" ack="); w.Dec(pkt.tcp_ack);
+        }
+        if (pkt.flags & DissectFlag::HasIcmp) {
+            w.Line("ICMP:        type="); w.Dec(pkt.icmp_type);
+            w.Str(" code="); w.Dec(pkt.icmp_code);
+        }
+        if (pkt.payload_offset != kNoOffset) { w.Line("Payload:     "); w.Dec(pkt.payload_length); w.Str(" bytes"); }
+    } else if (pkt.l3 == L3Proto::ARP) {
+        w.Line("ARP Op:     "); w.Dec(pkt.arp_op);
+        w.Line("Sender:     "); w.IPv4(pkt.arp_sender_ip); w.Str(" / "); w.Mac(pkt.arp_sender_mac);
+        w.Line("Target:     "); w.IPv4(pkt.arp_target_ip); w.Str(" / "); w.Mac(pkt.arp_target_mac);
+    }
+    if (pkt.flags & (DissectFlag::Fragment | DissectFlag::Truncated | DissectFlag::Malformed)) {
+        w.Line("Notes:     ");
+        WriteFlags(w, pkt);
+    }
+    w.Line("----------------------------------------------------");
+    return w.Finish();
+}
+
+} // namespace RedTops
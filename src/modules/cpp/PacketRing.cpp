@@ -0,0 +1,146 @@
+#include "../headers/PacketRing.hpp"
+#include "../../core/header/Exceptions.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace RedTops {
+
+namespace {
+
+bool InterfaceIsLoopback(const std::string& interface) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return false;
+    ifreq ifr{};
+    std::strncpy(ifr.ifr_name, interface.c_str(), IFNAMSIZ - 1);
+    bool loopback = ioctl(fd, SIOCGIFFLAGS, &ifr) == 0 && (ifr.ifr_flags & IFF_LOOPBACK);
+    close(fd);
+    return loopback;
+}
+
+} // namespace
+
+PacketRing::~PacketRing() {
+    Close();
+}
+
+void PacketRing::Close() {
+    if (map_) munmap(map_, map_size_);
+    if (fd_ >= 0) close(fd_);
+    fd_ = -1;
+    map_ = nullptr;
+    map_size_ = 0;
+    block_ = 0;
+}
+
+void PacketRing::Open(const std::string& interface, bool promiscuous, int fanout_arg) {
+    Close();
+    unsigned ifindex = if_nametoindex(interface.c_str());
+    if (ifindex == 0)
+        throw NetworkError("sniff: no such interface: " + interface);
+    loopback_ = InterfaceIsLoopback(interface);
+
+    fd_ = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+    if (fd_ < 0) {
+        if (errno == EPERM || errno == EACCES)
+            throw PermissionError("sniff: raw packet sockets need root or CAP_NET_RAW");
+        throw NetworkError(std::string("sniff: socket(AF_PACKET) failed: ") + strerror(errno));
+    }
+
+    try {
+        int version = TPACKET_V3;
+        if (setsockopt(fd_, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0)
+            throw NetworkError(std::string("sniff: TPACKET_V3 unsupported: ") + strerror(errno));
+
+        tpacket_req3 req{};
+        req.tp_block_size = kBlockSize;
+        req.tp_block_nr = kBlockCount;
+        req.tp_frame_size = kFrameSize;
+        req.tp_frame_nr = (kBlockSize * kBlockCount) / kFrameSize;
+        req.tp_retire_blk_tov = kBlockTimeoutMs;
+        if (setsockopt(fd_, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0)
+            throw NetworkError(std::string("sniff: PACKET_RX_RING failed: ") + strerror(errno));
+
+        map_size_ = static_cast<size_t>(kBlockSize) * kBlockCount;
+        void* map = mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, fd_, 0);
+        if (map == MAP_FAILED) {
+            // MAP_LOCKED fails under a low RLIMIT_MEMLOCK; an unlocked ring still works
+            map = mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        }
+        if (map == MAP_FAILED)
+            throw NetworkError(std::string("sniff: mmap of capture ring failed: ") + strerror(errno));
+        map_ = static_cast<uint8_t*>(map);
+
+        sockaddr_ll sll{};
+        sll.sll_family = AF_PACKET;
+        sll.sll_protocol = htons(ETH_P_ALL);
+        sll.sll_ifindex = static_cast<int>(ifindex);
+        if (bind(fd_, reinterpret_cast<sockaddr*>(&sll), sizeof(sll)) < 0)
+            throw NetworkError("sniff: bind to " + interface + " failed: " + strerror(errno));
+
+        if (promiscuous) {
+            packet_mreq mreq{};
+            mreq.mr_ifindex = static_cast<int>(ifindex);
+            mreq.mr_type = PACKET_MR_PROMISC;
+            setsockopt(fd_, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq));
+        }
+
+        if (fanout_arg != 0 && setsockopt(fd_, SOL_PACKET, PACKET_FANOUT, &fanout_arg, sizeof(fanout_arg)) < 0)
+            throw NetworkError(std::string("sniff: PACKET_FANOUT failed: ") + strerror(errno));
+    } catch (...) {
+        Close();
+        throw;
+    }
+}
+
+uint32_t PacketRing::Ready() const {
+    auto* desc = reinterpret_cast<const tpacket_block_desc*>(map_ + static_cast<size_t>(block_) * kBlockSize);
+    if ((__atomic_load_n(&desc->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0) return 0;
+    return desc->hdr.bh1.num_pkts;
+}
+
+void PacketRing::Wait(int timeout_ms) const {
+    pollfd pfd{fd_, POLLIN | POLLERR, 0};
+    poll(&pfd, 1, timeout_ms);
+}
+
+const uint8_t* PacketRing::FirstFrame() const {
+    auto* desc = reinterpret_cast<const tpacket_block_desc*>(map_ + static_cast<size_t>(block_) * kBlockSize);
+    return reinterpret_cast<const uint8_t*>(desc) + desc->hdr.bh1.offset_to_first_pkt;
+}
+
+const uint8_t* PacketRing::Decode(const uint8_t* hdr, RingFrame& frame) {
+    auto* h = reinterpret_cast<const tpacket3_hdr*>(hdr);
+    auto* sll = reinterpret_cast<const sockaddr_ll*>(hdr + TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+    frame.data = hdr + h->tp_mac;
+    frame.caplen = h->tp_snaplen;
+    frame.len = h->tp_len;
+    frame.ts_ns = static_cast<uint64_t>(h->tp_sec) * 1000000000ull + h->tp_nsec;
+    frame.outgoing = sll->sll_pkttype == PACKET_OUTGOING;
+    return hdr + h->tp_next_offset;
+}
+
+void PacketRing::Release() {
+    auto* desc = reinterpret_cast<tpacket_block_desc*>(map_ + static_cast<size_t>(block_) * kBlockSize);
+    __atomic_store_n(&desc->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+    block_ = (block_ + 1) % kBlockCount;
+}
+
+uint64_t PacketRing::Drops() const {
+    tpacket_stats_v3 kstats{};
+    socklen_t len = sizeof(kstats);
+    if (getsockopt(fd_, SOL_PACKET, PACKET_STATISTICS, &kstats, &len) == 0) return kstats.tp_drops;
+    return 0;
+}
+
+} // namespace RedTops
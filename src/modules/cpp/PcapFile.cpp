@@ -0,0 +1,158 @@
+#include "../headers/PcapFile.hpp"
+#include "../../core/header/Exceptions.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace RedTops {
+
+namespace {
+
+constexpr size_t kWriteBuffer = 1 << 20;
+
+inline void Put32(uint8_t* p, uint32_t v) { std::memcpy(p, &v, 4); }  // host byte order, per the format
+inline void Put16(uint8_t* p, uint16_t v) { std::memcpy(p, &v, 2); }
+
+inline uint32_t Get32(const uint8_t* p, bool swapped) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return swapped ? __builtin_bswap32(v) : v;
+}
+
+} // namespace
+
+PcapWriter::PcapWriter(const std::string& path, uint32_t snaplen) : path_(path), snaplen_(snaplen) {
+    fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) throw CommandError("cannot create " + path + ": " + strerror(errno));
+    buffer_.reserve(kWriteBuffer + 65536);
+
+    uint8_t hdr[kPcapFileHeaderSize];
+    Put32(hdr, kPcapMagicNanos);
+    Put16(hdr + 4, 2);               // version 2.4
+    Put16(hdr + 6, 4);
+    Put32(hdr + 8, 0);               // thiszone
+    Put32(hdr + 12, 0);              // sigfigs
+    Put32(hdr + 16, snaplen_);
+    Put32(hdr + 20, kPcapLinkEthernet);
+    buffer_.insert(buffer_.end(), hdr, hdr + sizeof(hdr));
+    offset_ = sizeof(hdr);
+}
+
+PcapWriter::~PcapWriter() {
+    try {
+        Close();
+    } catch (const std::exception&) {
+        // Destructors must not throw; Close() reports errors when called explicitly
+    }
+}
+
+void PcapWriter::Write(uint64_t ts_ns, const uint8_t* data, uint32_t caplen, uint32_t len) {
+    caplen = std::min(caplen, snaplen_);
+    uint8_t rec[kPcapRecordHeaderSize];
+    Put32(rec, static_cast<uint32_t>(ts_ns / 1000000000ull));
+    Put32(rec + 4, static_cast<uint32_t>(ts_ns % 1000000000ull));
+    Put32(rec + 8, caplen);
+    Put32(rec + 12, len);
+    buffer_.insert(buffer_.end(), rec, rec + sizeof(rec));
+    buffer_.insert(buffer_.end(), data, data + caplen);
+    offset_ += sizeof(rec) + caplen;
+    packets_++;
+    if (buffer_.size() >= kWriteBuffer) Flush();
+}
+
+void PcapWriter::Flush() {
+    size_t done = 0;
+    while (fd_ >= 0 && done < buffer_.size()) {
+        ssize_t n = write(fd_, buffer_.data() + done, buffer_.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            buffer_.clear();
+            throw CommandError("write to " + path_ + " failed: " + strerror(errno));
+        }
+        done += static_cast<size_t>(n);
+    }
+    buffer_.clear();
+}
+
+void PcapWriter::Close() {
+    if (fd_ < 0) return;
+    try {
+        Flush();
+    } catch (...) {
+        close(fd_);
+        fd_ = -1;
+        throw;
+    }
+    close(fd_);
+    fd_ = -1;
+}
+
+PcapReader::PcapReader(const std::string& path) : path_(path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw CommandError("cannot open " + path + ": " + strerror(errno));
+    struct stat st{};
+    if (fstat(fd, &st) < 0) {
+        int err = errno;
+        close(fd);
+        throw CommandError("cannot stat " + path + ": " + strerror(err));
+    }
+    size_ = static_cast<uint64_t>(st.st_size);
+    mtime_ns_ = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    if (size_ < kPcapFileHeaderSize) {
+        close(fd);
+        throw CommandError(path + " is not a pcap file (too short)");
+    }
+
+    void* map = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    int err = errno;
+    close(fd);  // the mapping keeps the file referenced
+    if (map == MAP_FAILED) throw CommandError("cannot map " + path + ": " + strerror(err));
+    map_ = static_cast<const uint8_t*>(map);
+
+    uint32_t magic;
+    std::memcpy(&magic, map_, 4);
+    if (magic == kPcapMagicMicros || magic == kPcapMagicNanos) {
+        swapped_ = false;
+    } else if (__builtin_bswap32(magic) == kPcapMagicMicros || __builtin_bswap32(magic) == kPcapMagicNanos) {
+        swapped_ = true;
+        magic = __builtin_bswap32(magic);
+    } else {
+        munmap(const_cast<uint8_t*>(map_), size_);
+        map_ = nullptr;
+        throw CommandError(path + " is not a pcap file (pcapng is not supported)");
+    }
+    nanos_ = magic == kPcapMagicNanos;
+    link_type_ = Get32(map_ + 20, swapped_);
+}
+
+PcapReader::~PcapReader() {
+    if (map_) munmap(const_cast<uint8_t*>(map_), size_);
+}
+
+bool PcapReader::ReadAt(uint64_t offset, PcapRecord& rec) const {
+    if (offset < kPcapFileHeaderSize || offset + kPcapRecordHeaderSize > size_) return false;
+    const uint8_t* p = map_ + offset;
+    uint32_t caplen = Get32(p + 8, swapped_);
+    if (caplen > size_ - offset - kPcapRecordHeaderSize) return false;
+
+    uint64_t sub = Get32(p + 4, swapped_);
+    rec.offset = offset;
+    rec.next = offset + kPcapRecordHeaderSize + caplen;
+    rec.ts_ns = static_cast<uint64_t>(Get32(p, swapped_)) * 1000000000ull + (nanos_ ? sub : sub * 1000);
+    rec.caplen = caplen;
+    rec.len = Get32(p + 12, swapped_);
+    rec.data = p + kPcapRecordHeaderSize;
+    return true;
+}
+
+void PcapReader::Advise(bool sequential) const {
+    madvise(const_cast<uint8_t*>(map_), size_, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+}
+
+} // namespace RedTops
@@ -0,0 +1,489 @@
+#include "../headers/ProcSampler.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace RedTops {
+
+namespace {
+
+constexpr size_t kInitialBuffer = 4096;
+constexpr size_t kDirentBuffer = 32 * 1024;
+
+uint64_t MonotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+inline uint64_t Diff(uint64_t cur, uint64_t prev) { return cur >= prev ? cur - prev : 0; }
+
+bool ParsePid(const char* name, int& pid) {
+    int v = 0;
+    for (const char* p = name; *p; ++p) {
+        if (*p < '0' || *p > '9') return false;
+        v = v * 10 + (*p - '0');
+    }
+    pid = v;
+    return v > 0;
+}
+
+} // namespace
+
+// ---------------- ProcFile ----------------
+
+ProcFile::~ProcFile() {
+    Close();
+}
+
+ProcFile::ProcFile(ProcFile&& other) noexcept : fd_(other.fd_), buf_(std::move(other.buf_)) {
+    other.fd_ = -1;
+}
+
+ProcFile& ProcFile::operator=(ProcFile&& other) noexcept {
+    if (this != &other) {
+        Close();
+        fd_ = other.fd_;
+        buf_ = std::move(other.buf_);
+        other.fd_ = -1;
+    }
+    return *this;
+}
+
+bool ProcFile::Open(const char* path) {
+    return OpenAt(AT_FDCWD, path);
+}
+
+bool ProcFile::OpenAt(int dir_fd, const char* path) {
+    Close();
+    fd_ = openat(dir_fd, path, O_RDONLY | O_CLOEXEC);
+    return fd_ >= 0;
+}
+
+void ProcFile::Close() {
+    if (fd_ >= 0) close(fd_);
+    fd_ = -1;
+}
+
+std::string_view ProcFile::Read() {
+    if (fd_ < 0) return {};
+    if (buf_.empty()) buf_.resize(kInitialBuffer);
+    for (;;) {
+        ssize_t n = pread(fd_, buf_.data(), buf_.size(), 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return {};
+        }
+        // A full buffer may mean the file is larger; grow and re-read from the start
+        if (static_cast<size_t>(n) < buf_.size()) return {buf_.data(), static_cast<size_t>(n)};
+        buf_.resize(buf_.size() * 2);
+    }
+}
+
+// ---------------- FieldReader ----------------
+
+std::string_view FieldReader::Word() {
+    SkipSpaces();
+    size_t n = 0;
+    while (n < text.size() && text[n] != ' ' && text[n] != '\t' && text[n] != '\n') ++n;
+    std::string_view w = text.substr(0, n);
+    text.remove_prefix(n);
+    return w;
+}
+
+uint64_t FieldReader::U64() {
+    SkipSpaces();
+    uint64_t v = 0;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), v);
+    if (ec != std::errc()) return 0;
+    text.remove_prefix(static_cast<size_t>(ptr - text.data()));
+    return v;
+}
+
+double FieldReader::Double() {
+    SkipSpaces();
+    double v = 0;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), v);
+    if (ec != std::errc()) return 0;
+    text.remove_prefix(static_cast<size_t>(ptr - text.data()));
+    return v;
+}
+
+bool FieldReader::SkipPast(char ch) {
+    size_t pos = text.find(ch);
+    if (pos == std::string_view::npos) return false;
+    text.remove_prefix(pos + 1);
+    return true;
+}
+
+// ---------------- CpuSampler ----------------
+
+CpuSampler::CpuSampler() : stat_("/proc/stat"), loadavg_("/proc/loadavg") {}
+
+CpuUsage CpuSampler::Delta(const Counters& p, const Counters& c) {
+    uint64_t user = Diff(c.user, p.user) + Diff(c.nice, p.nice);
+    uint64_t system = Diff(c.system, p.system) + Diff(c.irq, p.irq) + Diff(c.softirq, p.softirq);
+    uint64_t idle = Diff(c.idle, p.idle);
+    uint64_t iowait = Diff(c.iowait, p.iowait);
+    uint64_t steal = Diff(c.steal, p.steal);
+    uint64_t total = user + system + idle + iowait + steal;
+
+    CpuUsage u;
+    if (total == 0) return u;
+    double scale = 100.0 / static_cast<double>(total);
+    u.user = user * scale;
+    u.system = system * scale;
+    u.iowait = iowait * scale;
+    u.steal = steal * scale;
+    u.busy = (user + system + steal) * scale;
+    return u;
+}
+
+void CpuSampler::Sample() {
+    uint64_t now = MonotonicNs();
+    std::string_view text = stat_.Read();
+    bool primed = last_ns_ != 0;
+
+    while (!text.empty()) {
+        size_t eol = text.find('\n');
+        std::string_view line = text.substr(0, eol);
+        text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+
+        if (line.rfind("cpu", 0) == 0) {
+            FieldReader r(line);
+            std::string_view label = r.Word();
+            Counters c;
+            c.user = r.U64(); c.nice = r.U64(); c.system = r.U64(); c.idle = r.U64();
+            c.iowait = r.U64(); c.irq = r.U64(); c.softirq = r.U64(); c.steal = r.U64();
+
+            if (label == "cpu") {
+                if (primed) total_ = Delta(total_prev_, c);
+                total_prev_ = c;
+                continue;
+            }
+            size_t index = 0;
+            std::from_chars(label.data() + 3, label.data() + label.size(), index);
+            if (index >= core_prev_.size()) {
+                // Cores can come online while we watch
+                core_prev_.resize(index + 1);
+                cores_.resize(index + 1);
+                core_prev_[index] = c;
+                continue;
+            }
+            if (primed) cores_[index] = Delta(core_prev_[index], c);
+            core_prev_[index] = c;
+        } else if (line.rfind("ctxt ", 0) == 0) {
+            FieldReader r(line.substr(5));
+            uint64_t ctxt = r.U64();
+            if (primed && now > last_ns_)
+                ctxt_rate_ = Diff(ctxt, ctxt_prev_) * 1000000000ull / (now - last_ns_);
+            ctxt_prev_ = ctxt;
+        }
+    }
+    last_ns_ = now;
+}
+
+LoadAverage CpuSampler::Load() {
+    LoadAverage la;
+    FieldReader r(loadavg_.Read());
+    la.one = r.Double();
+    la.five = r.Double();
+    la.fifteen = r.Double();
+    la.running = static_cast<unsigned>(r.U64());
+    if (r.SkipPast('/')) la.total = static_cast<unsigned>(r.U64());
+    return la;
+}
+
+// ---------------- ProcessSampler ----------------
+
+ProcessSampler::ProcessSampler() {
+    proc_fd_ = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    dirents_.resize(kDirentBuffer);
+    ticks_per_sec_ = std::max(1L, sysconf(_SC_CLK_TCK));
+    page_size_ = std::max(1L, sysconf(_SC_PAGESIZE));
+
+    // One descriptor per process adds up; stay under the caller's soft limit
+    // with headroom for the rest of the shell
+    rlimit lim{};
+    if (getrlimit(RLIMIT_NOFILE, &lim) == 0)
+        fd_budget_ = lim.rlim_cur > 512 ? static_cast<size_t>(lim.rlim_cur - 256) : static_cast<size_t>(lim.rlim_cur / 2);
+}
+
+ProcessSampler::~ProcessSampler() {
+    if (proc_fd_ >= 0) close(proc_fd_);
+}
+
+bool ProcessSampler::Update(Tracked& t, uint64_t elapsed_ns) {
+    std::string_view text = t.stat.Read();
+    if (text.empty()) return false;
+
+    // comm sits in parentheses and may itself contain spaces or ')'
+    size_t open_paren = text.find('(');
+    size_t close_paren = text.rfind(')');
+    if (open_paren == std::string_view::npos || close_paren == std::string_view::npos || close_paren < open_paren)
+        return false;
+    std::string_view name = text.substr(open_paren + 1, close_paren - open_paren - 1);
+    if (t.usage.name != name) t.usage.name.assign(name);
+
+    FieldReader r(text.substr(close_paren + 1));
+    std::string_view state = r.Word();                    // field 3
+    t.usage.state = state.empty() ? '?' : state.front();
+    for (int i = 4; i <= 13; ++i) r.Word();               // ppid .. cmajflt
+    uint64_t ticks = r.U64() + r.U64();                   // utime + stime (14, 15)
+    for (int i = 16; i <= 19; ++i) r.Word();              // cutime .. nice
+    t.usage.threads = static_cast<unsigned>(r.U64());     // 20
+    r.Word();                                             // itrealvalue
+    r.Word();                                             // starttime
+    r.Word();                                             // vsize
+    t.usage.rss_bytes = r.U64() * static_cast<uint64_t>(page_size_);  // 24
+
+    if (t.primed && elapsed_ns > 0) {
+        double secs = static_cast<double>(ticks - std::min(ticks, t.ticks)) / static_cast<double>(ticks_per_sec_);
+        t.usage.cpu_percent = secs * 1e9 / static_cast<double>(elapsed_ns) * 100.0;
+    }
+    t.ticks = ticks;
+    t.primed = true;
+    return true;
+}
+
+void ProcessSampler::Sample() {
+    if (proc_fd_ < 0) return;
+    uint64_t now = MonotonicNs();
+    uint64_t elapsed = last_ns_ ? now - last_ns_ : 0;
+    last_ns_ = now;
+    ++generation_;
+
+    char path[32];
+    lseek(proc_fd_, 0, SEEK_SET);
+    for (;;) {
+        long n = syscall(SYS_getdents64, proc_fd_, dirents_.data(), dirents_.size());
+        if (n <= 0) break;
+        for (long off = 0; off < n;) {
+            auto* d = reinterpret_cast<dirent64*>(dirents_.data() + off);
+            off += d->d_reclen;
+            int pid;
+            if (d->d_type != DT_DIR || !ParsePid(d->d_name, pid)) continue;
+
+            auto [it, inserted] = tracked_.try_emplace(pid);
+            Tracked& t = it->second;
+            t.usage.pid = pid;
+            if (!t.stat.IsOpen()) {
+                std::snprintf(path, sizeof(path), "%d/stat", pid);
+                if (!t.stat.OpenAt(proc_fd_, path)) {
+                    // Out of descriptors: keep fewer open from now on, and
+                    // leave spare ones to reopen the rest every sample
+                    if (errno == EMFILE || errno == ENFILE) fd_budget_ = open_fds_ > 64 ? open_fds_ - 64 : 0;
+                    continue;   // otherwise already gone
+                }
+                open_fds_++;
+            }
+            if (Update(t, elapsed)) t.generation = generation_;
+
+            // Past the descriptor budget, stat files are reopened every sample instead
+            if (open_fds_ > fd_budget_) {
+                t.stat.Close();
+                open_fds_--;
+            }
+        }
+    }
+
+    // Forget processes that exited (or whose pid now belongs to someone else)
+    for (auto it = tracked_.begin(); it != tracked_.end();) {
+        if (it->second.generation != generation_) {
+            if (it->second.stat.IsOpen()) open_fds_--;
+            it = tracked_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+std::vector<const ProcessUsage*> ProcessSampler::Top(size_t n) const {
+    std::vector<const ProcessUsage*> all;
+    all.reserve(tracked_.size());
+    for (const auto& [pid, t] : tracked_) all.push_back(&t.usage);
+    n = std::min(n, all.size());
+    std::partial_sort(all.begin(), all.begin() + static_cast<std::ptrdiff_t>(n), all.end(),
+                      [](const ProcessUsage* a, const ProcessUsage* b) {
+                          if (a->cpu_percent != b->cpu_percent) return a->cpu_percent > b->cpu_percent;
+                          return a->rss_bytes > b->rss_bytes;
+                      });
+    all.resize(n);
+    return all;
+}
+
+// ---------------- MemorySampler ----------------
+
+MemoryInfo MemorySampler::Sample() {
+    struct Field {
+        std::string_view key;
+        uint64_t MemoryInfo::*member;
+    };
+    static const Field fields[] = {
+        {"MemTotal", &MemoryInfo::total},         {"MemFree", &MemoryInfo::free},
+        {"MemAvailable", &MemoryInfo::available}, {"Buffers", &MemoryInfo::buffers},
+        {"Cached", &MemoryInfo::cached},          {"SwapCached", &MemoryInfo::swap_cached},
+        {"SwapTotal", &MemoryInfo::swap_total},   {"SwapFree", &MemoryInfo::swap_free},
+        {"Dirty", &MemoryInfo::dirty},            {"Writeback", &MemoryInfo::writeback},
+        {"AnonPages", &MemoryInfo::anon},         {"Mapped", &MemoryInfo::mapped},
+        {"Shmem", &MemoryInfo::shmem},            {"SReclaimable", &MemoryInfo::slab_reclaimable},
+        {"SUnreclaim", &MemoryInfo::slab_unreclaimable},
+    };
+
+    MemoryInfo mem;
+    bool have_available = false;
+    std::string_view text = meminfo_.Read();
+    while (!text.empty()) {
+        size_t eol = text.find('\n');
+        std::string_view line = text.substr(0, eol);
+        text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) continue;
+        std::string_view key = line.substr(0, colon);
+        for (const Field& f : fields) {
+            if (f.key != key) continue;
+            FieldReader r(line.substr(colon + 1));
+            mem.*f.member = r.U64() * 1024;     // meminfo reports kB
+            if (f.member == &MemoryInfo::available) have_available = true;
+            break;
+        }
+    }
+    // Kernels before 3.14 lack MemAvailable; approximate it the way free(1) did
+    if (!have_available) mem.available = mem.free + mem.buffers + mem.cached + mem.slab_reclaimable;
+    return mem;
+}
+
+// ---------------- PressureSampler ----------------
+
+PressureSampler::PressureSampler() {
+    files_[Cpu].Open("/proc/pressure/cpu");
+    files_[Memory].Open("/proc/pressure/memory");
+    files_[Io].Open("/proc/pressure/io");
+}
+
+const char* PressureSampler::Name(Resource r) {
+    switch (r) {
+        case Cpu:    return "cpu";
+        case Memory: return "memory";
+        case Io:     return "io";
+        default:     return "?";
+    }
+}
+
+void PressureSampler::Sample() {
+    uint64_t now = MonotonicNs();
+    double elapsed_us = last_ns_ ? static_cast<double>(now - last_ns_) / 1000.0 : 0;
+    last_ns_ = now;
+
+    for (int r = 0; r < kResources; ++r) {
+        Pressure& p = pressure_[r];
+        std::string_view text = files_[r].Read();
+        p.available = !text.empty();
+
+        // "some avg10=0.00 avg60=0.00 avg300=0.00 total=0"
+        while (!text.empty()) {
+            size_t eol = text.find('\n');
+            std::string_view line = text.substr(0, eol);
+            text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+
+            PressureLine* target = line.rfind("some", 0) == 0 ? &p.some : line.rfind("full", 0) == 0 ? &p.full : nullptr;
+            if (!target) continue;
+            FieldReader fr(line);
+            fr.SkipPast('='); target->avg10 = fr.Double();
+            fr.SkipPast('='); target->avg60 = fr.Double();
+            fr.SkipPast('='); target->avg300 = fr.Double();
+            fr.SkipPast('=');
+            uint64_t total = fr.U64();
+            if (elapsed_us > 0)
+                target->now = std::min(100.0, Diff(total, target->total_us) / elapsed_us * 100.0);
+            target->total_us = total;
+        }
+    }
+}
+
+// ---------------- DiskSampler ----------------
+
+void DiskSampler::Sample() {
+    uint64_t now = MonotonicNs();
+    double secs = last_ns_ ? static_cast<double>(now - last_ns_) / 1e9 : 0;
+    last_ns_ = now;
+    ++generation_;
+    disks_.clear();
+
+    std::string_view text = diskstats_.Read();
+    size_t hint = 0;
+    while (!text.empty()) {
+        size_t eol = text.find('\n');
+        std::string_view line = text.substr(0, eol);
+        text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+
+        //   major minor name reads merged sectors ms writes merged sectors ms in_flight io_ms weighted ...
+        FieldReader r(line);
+        r.Word();
+        r.Word();
+        std::string_view name = r.Word();
+        if (name.empty()) continue;
+        Counters c;
+        c.reads = r.U64(); r.U64(); c.read_sectors = r.U64(); c.read_ms = r.U64();
+        c.writes = r.U64(); r.U64(); c.write_sectors = r.U64(); c.write_ms = r.U64();
+        uint64_t in_flight = r.U64();
+        c.io_ms = r.U64();
+
+        // The device list rarely changes, so the previous position is usually right
+        Tracked* t = nullptr;
+        if (hint < tracked_.size() && tracked_[hint].name == name) {
+            t = &tracked_[hint];
+        } else {
+            for (Tracked& candidate : tracked_)
+                if (candidate.name == name) { t = &candidate; break; }
+        }
+        bool fresh = !t;
+        if (fresh) {
+            tracked_.emplace_back();
+            t = &tracked_.back();
+            t->name.assign(name);
+            char path[96];
+            std::snprintf(path, sizeof(path), "/sys/block/%s", t->name.c_str());
+            struct stat st;
+            bool virtual_dev = name.rfind("loop", 0) == 0 || name.rfind("ram", 0) == 0;
+            t->whole_disk = !virtual_dev && stat(path, &st) == 0;
+        }
+        hint = static_cast<size_t>(t - tracked_.data()) + 1;
+
+        if (!fresh && t->whole_disk && secs > 0) {
+            DiskUsage u;
+            u.name = t->name;
+            uint64_t reads = Diff(c.reads, t->last.reads), writes = Diff(c.writes, t->last.writes);
+            u.read_bps = Diff(c.read_sectors, t->last.read_sectors) * 512.0 / secs;    // diskstats sectors are always 512 B
+            u.write_bps = Diff(c.write_sectors, t->last.write_sectors) * 512.0 / secs;
+            u.read_iops = reads / secs;
+            u.write_iops = writes / secs;
+            u.util = std::min(100.0, Diff(c.io_ms, t->last.io_ms) / (secs * 10.0));
+            uint64_t ops = reads + writes;
+            if (ops) u.await_ms = static_cast<double>(Diff(c.read_ms, t->last.read_ms) + Diff(c.write_ms, t->last.write_ms)) / ops;
+            u.in_flight = in_flight;
+            disks_.push_back(std::move(u));
+        }
+        t->last = c;
+        t->generation = generation_;
+    }
+
+    // Drop devices that were removed (hot-unplug, detached loop devices)
+    tracked_.erase(std::remove_if(tracked_.begin(), tracked_.end(),
+                                  [&](const Tracked& t) { return t.generation != generation_; }),
+                   tracked_.end());
+}
+
+} // namespace RedTops
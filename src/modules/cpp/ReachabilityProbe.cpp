@@ -0,0 +1,367 @@
+#include "../headers/ReachabilityProbe.hpp"
+#include "../../core/header/Exceptions.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/icmp6.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/ip_icmp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace RedTops {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kResolverThreads = 16;
+constexpr int kEchoAttempts = 3;           // echoes per ICMP target, spread over the timeout
+constexpr uint64_t kIcmpTag = 1ull << 62;  // epoll data for the ICMP sockets
+
+uint16_t Checksum(const uint8_t* data, size_t len) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i + 1 < len; i += 2) sum += static_cast<uint32_t>(data[i] << 8 | data[i + 1]);
+    if (len & 1) sum += static_cast<uint32_t>(data[len - 1] << 8);
+    while (sum >> 16) sum = (sum & 0xffff) + (sum >> 16);
+    return htons(static_cast<uint16_t>(~sum));
+}
+
+bool SameHost(const sockaddr_storage& a, const sockaddr_storage& b) {
+    if (a.ss_family != b.ss_family) return false;
+    if (a.ss_family == AF_INET)
+        return reinterpret_cast<const sockaddr_in&>(a).sin_addr.s_addr == reinterpret_cast<const sockaddr_in&>(b).sin_addr.s_addr;
+    return std::memcmp(&reinterpret_cast<const sockaddr_in6&>(a).sin6_addr,
+                       &reinterpret_cast<const sockaddr_in6&>(b).sin6_addr, 16) == 0;
+}
+
+std::string Numeric(const sockaddr_storage& ss) {
+    char text[INET6_ADDRSTRLEN] = {};
+    if (ss.ss_family == AF_INET)
+        inet_ntop(AF_INET, &reinterpret_cast<const sockaddr_in&>(ss).sin_addr, text, sizeof(text));
+    else if (ss.ss_family == AF_INET6)
+        inet_ntop(AF_INET6, &reinterpret_cast<const sockaddr_in6&>(ss).sin6_addr, text, sizeof(text));
+    return text;
+}
+
+socklen_t AddrLen(const sockaddr_storage& ss) {
+    return ss.ss_family == AF_INET6 ? sizeof(sockaddr_in6) : sizeof(sockaddr_in);
+}
+
+struct Pending {
+    sockaddr_storage addr{};
+    bool resolved = false;
+    bool done = false;
+    int fd = -1;                       // TCP socket
+    int attempts = 0;                  // echoes sent
+    Clock::time_point sent;            // connect start, or the latest echo
+    Clock::time_point echo_sent[kEchoAttempts];
+};
+
+// Echo socket for one family: ping socket if the sysctl allows, else raw
+struct IcmpSocket {
+    int fd = -1;
+    bool raw = false;
+
+    bool Open(int family) {
+        int proto = family == AF_INET ? static_cast<int>(IPPROTO_ICMP) : static_cast<int>(IPPROTO_ICMPV6);
+        fd = socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, proto);
+        if (fd < 0) {
+            fd = socket(family, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, proto);
+            raw = fd >= 0;
+        }
+        return fd >= 0;
+    }
+};
+
+} // namespace
+
+ProbeTarget ParseProbeTarget(const std::string& text) {
+    ProbeTarget t;
+    t.spec = text;
+    std::string port;
+    if (!text.empty() && text.front() == '[') {
+        size_t close = text.find(']');
+        if (close == std::string::npos) throw CommandError("netinfo: unterminated '[' in " + text);
+        t.host = text.substr(1, close - 1);
+        if (close + 1 < text.size()) {
+            if (text[close + 1] != ':') throw CommandError("netinfo: expected ':port' after ']' in " + text);
+            port = text.substr(close + 2);
+        }
+    } else if (std::count(text.begin(), text.end(), ':') == 1) {
+        size_t colon = text.find(':');
+        t.host = text.substr(0, colon);
+        port = text.substr(colon + 1);
+    } else {
+        t.host = text;     // name, IPv4, or bare IPv6 literal
+    }
+    if (t.host.empty()) throw CommandError("netinfo: missing host in " + text);
+    if (!port.empty()) {
+        char* end = nullptr;
+        long p = std::strtol(port.c_str(), &end, 10);
+        if (*end || p < 1 || p > 65535) throw CommandError("netinfo: invalid port in " + text);
+        t.port = static_cast<uint16_t>(p);
+    }
+    return t;
+}
+
+const char* ProbeStatusName(ProbeStatus status) {
+    switch (status) {
+        case ProbeStatus::Reachable:     return "reachable";
+        case ProbeStatus::Refused:       return "refused";
+        case ProbeStatus::Unreachable:   return "unreachable";
+        case ProbeStatus::Timeout:       return "timeout";
+        case ProbeStatus::ResolveFailed: return "no address";
+        case ProbeStatus::Error:         return "error";
+    }
+    return "?";
+}
+
+std::vector<ProbeResult> ReachabilityProbe::Run(const std::function<bool()>& cancelled) {
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point deadline = start + std::chrono::milliseconds(timeout_ms_);
+    const size_t n = targets_.size();
+
+    std::vector<ProbeResult> results(n);
+    std::vector<Pending> pending(n);
+    for (size_t i = 0; i < n; ++i) results[i].target = targets_[i];
+    if (n == 0) return results;
+    if (n > 0xffff) throw CommandError("netinfo: at most 65535 targets per check");
+
+    // ---- Resolve: literals inline, names on a small pool of threads
+    std::vector<size_t> lookups;
+    for (size_t i = 0; i < n; ++i) {
+        Pending& p = pending[i];
+        const std::string& host = targets_[i].host;
+        auto* v4 = reinterpret_cast<sockaddr_in*>(&p.addr);
+        auto* v6 = reinterpret_cast<sockaddr_in6*>(&p.addr);
+        if (inet_pton(AF_INET, host.c_str(), &v4->sin_addr) == 1) {
+            v4->sin_family = AF_INET;
+            p.resolved = true;
+        } else if (inet_pton(AF_INET6, host.c_str(), &v6->sin6_addr) == 1) {
+            v6->sin6_family = AF_INET6;
+            p.resolved = true;
+        } else {
+            lookups.push_back(i);
+        }
+    }
+    if (!lookups.empty()) {
+        std::atomic<size_t> next{0};
+        auto worker = [&] {
+            for (size_t k; (k = next.fetch_add(1)) < lookups.size();) {
+                size_t i = lookups[k];
+                addrinfo hints{};
+                hints.ai_family = AF_UNSPEC;
+                hints.ai_socktype = SOCK_STREAM;
+                hints.ai_flags = AI_ADDRCONFIG;
+                addrinfo* res = nullptr;
+                int rc = getaddrinfo(targets_[i].host.c_str(), nullptr, &hints, &res);
+                if (rc != 0 || !res) {
+                    results[i].status = ProbeStatus::ResolveFailed;
+                    results[i].detail = gai_strerror(rc);
+                    continue;
+                }
+                std::memcpy(&pending[i].addr, res->ai_addr, std::min<size_t>(res->ai_addrlen, sizeof(sockaddr_storage)));
+                pending[i].resolved = true;
+                freeaddrinfo(res);
+            }
+        };
+        std::vector<std::thread> pool;
+        for (size_t t = 0; t < std::min(kResolverThreads, lookups.size()); ++t) pool.emplace_back(worker);
+        for (auto& th : pool) th.join();
+    }
+
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    if (ep < 0) throw NetworkError(std::string("netinfo: epoll_create1 failed: ") + strerror(errno));
+
+    IcmpSocket icmp4, icmp6;
+    uint16_t ident = static_cast<uint16_t>(getpid());
+    auto icmp_for = [&](int family) -> IcmpSocket* {
+        IcmpSocket& s = family == AF_INET ? icmp4 : icmp6;
+        if (s.fd < 0 && s.Open(family)) {
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.u64 = kIcmpTag | static_cast<uint64_t>(family);
+            epoll_ctl(ep, EPOLL_CTL_ADD, s.fd, &ev);
+        }
+        return s.fd >= 0 ? &s : nullptr;
+    };
+
+    auto finish = [&](size_t i, ProbeStatus status, Clock::time_point at) {
+        Pending& p = pending[i];
+        if (p.done) return;
+        p.done = true;
+        results[i].status = status;
+        if (status == ProbeStatus::Reachable || status == ProbeStatus::Refused)
+            results[i].rtt_ms = std::chrono::duration<double, std::milli>(at - p.sent).count();
+        if (p.fd >= 0) {
+            close(p.fd);
+            p.fd = -1;
+        }
+    };
+
+    auto send_echo = [&](size_t i) {
+        Pending& p = pending[i];
+        IcmpSocket* s = icmp_for(p.addr.ss_family);
+        if (!s) {
+            results[i].detail = "no ICMP socket (needs root or net.ipv4.ping_group_range)";
+            finish(i, ProbeStatus::Error, Clock::now());
+            return;
+        }
+        uint8_t pkt[16] = {};   // header + 8-byte payload
+        pkt[0] = p.addr.ss_family == AF_INET ? ICMP_ECHO : ICMP6_ECHO_REQUEST;
+        uint16_t id = htons(ident), seq = htons(static_cast<uint16_t>(i + 1));
+        std::memcpy(pkt + 4, &id, 2);
+        std::memcpy(pkt + 6, &seq, 2);
+        if (p.addr.ss_family == AF_INET) {
+            uint16_t sum = Checksum(pkt, sizeof(pkt));   // the kernel fills it in for ICMPv6
+            std::memcpy(pkt + 2, &sum, 2);
+        }
+        p.sent = Clock::now();
+        pkt[8] = static_cast<uint8_t>(p.attempts);      // echoed back: which attempt answered
+        p.echo_sent[p.attempts++] = p.sent;
+        if (sendto(s->fd, pkt, sizeof(pkt), 0, reinterpret_cast<const sockaddr*>(&p.addr), AddrLen(p.addr)) < 0) {
+            if (errno == ENETUNREACH || errno == EHOSTUNREACH) {
+                finish(i, ProbeStatus::Unreachable, p.sent);
+            } else if (errno != EAGAIN && errno != ENOBUFS) {
+                results[i].detail = strerror(errno);
+                finish(i, ProbeStatus::Error, p.sent);
+            }
+        }
+    };
+
+    auto start_connect = [&](size_t i) {
+        Pending& p = pending[i];
+        if (p.addr.ss_family == AF_INET) reinterpret_cast<sockaddr_in&>(p.addr).sin_port = htons(targets_[i].port);
+        else reinterpret_cast<sockaddr_in6&>(p.addr).sin6_port = htons(targets_[i].port);
+
+        p.fd = socket(p.addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (p.fd < 0) {
+            results[i].detail = strerror(errno);
+            finish(i, ProbeStatus::Error, Clock::now());
+            return;
+        }
+        p.sent = Clock::now();
+        if (connect(p.fd, reinterpret_cast<const sockaddr*>(&p.addr), AddrLen(p.addr)) == 0) {
+            finish(i, ProbeStatus::Reachable, Clock::now());
+            return;
+        }
+        if (errno != EINPROGRESS) {
+            int err = errno;
+            if (err == ECONNREFUSED) finish(i, ProbeStatus::Refused, Clock::now());
+            else if (err == ENETUNREACH || err == EHOSTUNREACH) finish(i, ProbeStatus::Unreachable, Clock::now());
+            else { results[i].detail = strerror(err); finish(i, ProbeStatus::Error, Clock::now()); }
+            return;
+        }
+        epoll_event ev{};
+        ev.events = EPOLLOUT;
+        ev.data.u64 = i;
+        epoll_ctl(ep, EPOLL_CTL_ADD, p.fd, &ev);
+    };
+
+    // ---- Launch every probe at once
+    size_t outstanding = 0;
+    for (size_t i = 0; i < n; ++i) {
+        Pending& p = pending[i];
+        if (!p.resolved) { p.done = true; continue; }
+        results[i].address = Numeric(p.addr);
+        if (targets_[i].port) start_connect(i);
+        else send_echo(i);
+        if (!p.done) ++outstanding;
+    }
+
+    auto on_echo_reply = [&](int family, IcmpSocket& s) {
+        uint8_t buf[1500];
+        for (;;) {
+            sockaddr_storage from{};
+            socklen_t from_len = sizeof(from);
+            ssize_t len = recvfrom(s.fd, buf, sizeof(buf), 0, reinterpret_cast<sockaddr*>(&from), &from_len);
+            if (len < 0) return;
+            Clock::time_point now = Clock::now();
+            const uint8_t* icmp = buf;
+            if (s.raw && family == AF_INET) {
+                // Raw IPv4 sockets hand over the IP header too
+                size_t ihl = static_cast<size_t>(buf[0] & 0x0f) * 4;
+                if (static_cast<size_t>(len) < ihl + 8) continue;
+                icmp += ihl;
+                len -= static_cast<ssize_t>(ihl);
+            }
+            if (len < 8) continue;
+            uint8_t reply_type = family == AF_INET ? ICMP_ECHOREPLY : ICMP6_ECHO_REPLY;
+            if (icmp[0] != reply_type) continue;
+            // Ping sockets rewrite the identifier and filter for us; raw sockets see everyone's echoes
+            if (s.raw && (icmp[4] << 8 | icmp[5]) != ident) continue;
+            size_t seq = static_cast<size_t>(icmp[6] << 8 | icmp[7]);
+            if (seq == 0 || seq > n) continue;
+            size_t i = seq - 1;
+            Pending& p = pending[i];
+            if (p.done || targets_[i].port || !SameHost(p.addr, from)) continue;
+            // Time the round trip from the echo that was answered, not the latest retry
+            if (len >= 9 && icmp[8] < p.attempts) p.sent = p.echo_sent[icmp[8]];
+            finish(i, ProbeStatus::Reachable, now);
+            --outstanding;
+        }
+    };
+
+    // ---- Wait for answers until the shared deadline
+    const auto resend_gap = std::chrono::milliseconds(std::max(1, timeout_ms_ / kEchoAttempts));
+    epoll_event events[256];
+    while (outstanding > 0) {
+        Clock::time_point now = Clock::now();
+        if (now >= deadline || (cancelled && cancelled())) break;
+
+        // Lost echoes are retried a couple of times within the deadline
+        for (size_t i = 0; i < n; ++i) {
+            Pending& p = pending[i];
+            if (!p.done && !targets_[i].port && p.attempts < kEchoAttempts && now - p.sent >= resend_gap) {
+                send_echo(i);
+                if (p.done) --outstanding;
+            }
+        }
+
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+        int timeout = static_cast<int>(std::min<long long>(std::min<long long>(wait, resend_gap.count()), 50)) + 1;
+        int ready = epoll_wait(ep, events, 256, timeout);
+        if (ready < 0 && errno != EINTR) break;
+        for (int e = 0; e < ready; ++e) {
+            uint64_t tag = events[e].data.u64;
+            if (tag & kIcmpTag) {
+                int family = static_cast<int>(tag & 0xffff);
+                on_echo_reply(family, family == AF_INET ? icmp4 : icmp6);
+                continue;
+            }
+            size_t i = static_cast<size_t>(tag);
+            Pending& p = pending[i];
+            if (p.done) continue;
+            int err = 0;
+            socklen_t len = sizeof(err);
+            getsockopt(p.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            Clock::time_point at = Clock::now();
+            if (err == 0) finish(i, ProbeStatus::Reachable, at);
+            else if (err == ECONNREFUSED) finish(i, ProbeStatus::Refused, at);
+            else if (err == ENETUNREACH || err == EHOSTUNREACH) finish(i, ProbeStatus::Unreachable, at);
+            else { results[i].detail = strerror(err); finish(i, ProbeStatus::Error, at); }
+            --outstanding;
+        }
+    }
+
+    // Whatever is left ran out of time
+    for (size_t i = 0; i < n; ++i)
+        if (!pending[i].done) finish(i, ProbeStatus::Timeout, Clock::now());
+    if (icmp4.fd >= 0) close(icmp4.fd);
+    if (icmp6.fd >= 0) close(icmp6.fd);
+    close(ep);
+    return results;
+}
+
+} // namespace RedTops
@@ -0,0 +1,466 @@
+#include "../headers/ResultStore.hpp"
+#include "../../core/header/Exceptions.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+#include <fcntl.h>
+#include <pwd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace RedTops {
+
+namespace {
+
+constexpr char kBlockMagic[4] = {'R', 'T', 'R', 'B'};
+constexpr uint32_t kBlockVersion = 1;
+constexpr uint64_t kSegmentLimit = 64ull << 20;
+constexpr size_t kTargetBytes = 80;
+
+struct BlockHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t run_id;
+    uint32_t rows;
+    uint32_t dict_bytes;      // u32 count, then (u16 length, bytes) per host
+    uint32_t payload_bytes;   // dictionary plus columns
+    uint32_t crc;             // CRC-32 of the payload
+};
+static_assert(sizeof(BlockHeader) == 32, "block header layout");
+
+struct RunEntry {
+    uint64_t id;
+    int64_t started_us;
+    uint32_t duration_ms;
+    uint32_t rows;
+    uint32_t segment;
+    uint32_t length;
+    uint64_t offset;
+    uint8_t kind;
+    uint8_t reserved[7];
+    char target[kTargetBytes];
+};
+static_assert(sizeof(RunEntry) == 128, "runs.idx entry layout");
+
+struct HostEntry {
+    uint64_t hash;
+    uint64_t run_id;
+};
+static_assert(sizeof(HostEntry) == 16, "hosts.idx entry layout");
+
+uint32_t Crc32(const char* data, size_t len) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    uint32_t crc = 0xffffffffu;
+    for (size_t i = 0; i < len; ++i) crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xff] ^ (crc >> 8);
+    return crc ^ 0xffffffffu;
+}
+
+uint64_t HostHash(std::string_view host) {
+    uint64_t h = 1469598103934665603ull;
+    for (char c : host) h = (h ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+    return h;
+}
+
+std::string SegmentPath(const std::string& dir, uint32_t segment) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "/seg-%06u.dat", segment);
+    return dir + name;
+}
+
+// Closes on scope exit
+struct Fd {
+    int fd = -1;
+    explicit Fd(int f) : fd(f) {}
+    ~Fd() { if (fd >= 0) close(fd); }
+    Fd(const Fd&) = delete;
+    Fd& operator=(const Fd&) = delete;
+};
+
+[[noreturn]] void Fail(const std::string& what, const std::string& path) {
+    throw CommandError("results: " + what + " " + path + ": " + strerror(errno));
+}
+
+void WriteAll(int fd, const void* data, size_t len, const std::string& path) {
+    const char* p = static_cast<const char*>(data);
+    while (len) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            Fail("cannot write", path);
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+}
+
+bool ReadAt(int fd, void* data, size_t len, uint64_t offset) {
+    char* p = static_cast<char*>(data);
+    while (len) {
+        ssize_t n = pread(fd, p, len, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+// Whole fixed-width index file; a torn tail from an interrupted append is dropped
+template <typename Entry>
+std::vector<Entry> ReadIndex(const std::string& path) {
+    std::vector<Entry> entries;
+    Fd f(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    if (f.fd < 0) return entries;
+    struct stat st{};
+    if (fstat(f.fd, &st) < 0) return entries;
+    entries.resize(static_cast<size_t>(st.st_size) / sizeof(Entry));
+    if (!entries.empty() && !ReadAt(f.fd, entries.data(), entries.size() * sizeof(Entry), 0)) entries.clear();
+    return entries;
+}
+
+RunInfo ToRunInfo(const RunEntry& e) {
+    RunInfo r;
+    r.id = e.id;
+    r.kind = static_cast<ResultKind>(e.kind);
+    r.target.assign(e.target, strnlen(e.target, kTargetBytes));
+    r.started_us = e.started_us;
+    r.duration_ms = e.duration_ms;
+    r.rows = e.rows;
+    r.segment = e.segment;
+    r.offset = e.offset;
+    r.length = e.length;
+    return r;
+}
+
+// Read-only view over a decoded block's columns
+struct BlockView {
+    std::vector<std::string_view> hosts;
+    const char* host_idx = nullptr;
+    const char* ports = nullptr;
+    const char* status = nullptr;
+    const char* values = nullptr;
+    uint32_t rows = 0;
+
+    uint32_t HostIndex(uint32_t row) const { uint32_t v; std::memcpy(&v, host_idx + row * 4, 4); return v; }
+
+    ResultRow Row(uint32_t row) const {
+        ResultRow r;
+        r.host.assign(hosts[HostIndex(row)]);
+        std::memcpy(&r.port, ports + row * 2, 2);
+        r.status = static_cast<ResultStatus>(static_cast<uint8_t>(status[row]));
+        std::memcpy(&r.value, values + row * 4, 4);
+        return r;
+    }
+};
+
+BlockView ParseBlock(const std::vector<char>& block) {
+    BlockHeader h;
+    std::memcpy(&h, block.data(), sizeof(h));
+    const char* p = block.data() + sizeof(h);
+    const char* end = p + h.payload_bytes;
+
+    // Every host name has to end inside the dictionary, not just start in it
+    if (h.dict_bytes < 4 || h.dict_bytes > h.payload_bytes) throw CommandError("results: corrupt host dictionary");
+    const char* cols = p + h.dict_bytes;
+
+    BlockView v;
+    v.rows = h.rows;
+    uint32_t count = 0;
+    std::memcpy(&count, p, 4);
+    const char* d = p + 4;
+    if (count > static_cast<uint64_t>(cols - d) / 2) throw CommandError("results: corrupt host dictionary");
+    v.hosts.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        uint16_t len = 0;
+        if (cols - d < 2) throw CommandError("results: corrupt host dictionary");
+        std::memcpy(&len, d, 2);
+        if (cols - d - 2 < len) throw CommandError("results: corrupt host dictionary");
+        v.hosts.emplace_back(d + 2, len);
+        d += 2 + len;
+    }
+    v.host_idx = cols;
+    v.ports = v.host_idx + 4ull * h.rows;
+    v.status = v.ports + 2ull * h.rows;
+    v.values = v.status + h.rows;
+    if (v.values + 4ull * h.rows != end) throw CommandError("results: corrupt block layout");
+    for (uint32_t i = 0; i < h.rows; ++i)
+        if (v.HostIndex(i) >= count) throw CommandError("results: corrupt host column");
+    return v;
+}
+
+bool RowLess(const ResultRow& a, const ResultRow& b) {
+    int c = a.host.compare(b.host);
+    return c != 0 ? c < 0 : a.port < b.port;
+}
+
+} // namespace
+
+const char* ResultKindName(ResultKind kind) {
+    switch (kind) {
+        case ResultKind::PortScan: return "portscan";
+        case ResultKind::Ping:     return "ping";
+        case ResultKind::Trace:    return "trace";
+        case ResultKind::Probe:    return "probe";
+    }
+    return "?";
+}
+
+bool ParseResultKind(const std::string& name, ResultKind& kind) {
+    for (ResultKind k : {ResultKind::PortScan, ResultKind::Ping, ResultKind::Trace, ResultKind::Probe}) {
+        if (name == ResultKindName(k)) {
+            kind = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* ResultStatusName(ResultStatus status) {
+    switch (status) {
+        case ResultStatus::Down:    return "down";
+        case ResultStatus::Up:      return "up";
+        case ResultStatus::Refused: return "refused";
+        case ResultStatus::Timeout: return "timeout";
+        case ResultStatus::Error:   return "error";
+    }
+    return "?";
+}
+
+std::string ResultStore::DefaultDir() {
+    const char* home = std::getenv("HOME");
+    if (!home) {
+        struct passwd* pw = getpwuid(getuid());
+        home = pw ? pw->pw_dir : "/tmp";
+    }
+    return std::string(home) + "/.redtops/results";
+}
+
+ResultStore::ResultStore(const std::string& dir) : dir_(dir) {
+    // mkdir -p, one level at a time
+    for (size_t pos = 1; pos != std::string::npos;) {
+        pos = dir_.find('/', pos + 1);
+        std::string part = dir_.substr(0, pos);
+        if (mkdir(part.c_str(), 0700) < 0 && errno != EEXIST) Fail("cannot create", part);
+    }
+}
+
+uint64_t ResultStore::Append(ResultKind kind, const std::string& target, int64_t started_us, uint32_t duration_ms,
+                             std::vector<ResultRow> rows) {
+    std::sort(rows.begin(), rows.end(), RowLess);
+
+    // Dictionary of distinct hosts in sorted order, then the columns
+    std::vector<char> payload(4);
+    std::vector<uint32_t> host_idx(rows.size());
+    uint32_t count = 0;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (i == 0 || rows[i].host != rows[i - 1].host) {
+            uint16_t len = static_cast<uint16_t>(std::min<size_t>(rows[i].host.size(), 0xffff));
+            payload.insert(payload.end(), reinterpret_cast<const char*>(&len), reinterpret_cast<const char*>(&len) + 2);
+            payload.insert(payload.end(), rows[i].host.data(), rows[i].host.data() + len);
+            ++count;
+        }
+        host_idx[i] = count - 1;
+    }
+    std::memcpy(payload.data(), &count, 4);
+    const uint32_t dict_bytes = static_cast<uint32_t>(payload.size());
+
+    auto column = [&payload](const void* data, size_t len) {
+        const char* p = static_cast<const char*>(data);
+        payload.insert(payload.end(), p, p + len);
+    };
+    column(host_idx.data(), host_idx.size() * 4);
+    for (const auto& r : rows) column(&r.port, 2);
+    for (const auto& r : rows) column(&r.status, 1);
+    for (const auto& r : rows) column(&r.value, 4);
+
+    BlockHeader h{};
+    std::memcpy(h.magic, kBlockMagic, 4);
+    h.version = kBlockVersion;
+    h.rows = static_cast<uint32_t>(rows.size());
+    h.dict_bytes = dict_bytes;
+    h.payload_bytes = static_cast<uint32_t>(payload.size());
+    h.crc = Crc32(payload.data(), payload.size());
+
+    // Everything below runs under the store lock
+    std::string lock_path = dir_ + "/lock";
+    Fd lock(open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600));
+    if (lock.fd < 0) Fail("cannot open", lock_path);
+    while (flock(lock.fd, LOCK_EX) < 0)
+        if (errno != EINTR) Fail("cannot lock", lock_path);
+
+    std::string runs_path = dir_ + "/runs.idx";
+    Fd runs(open(runs_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600));
+    if (runs.fd < 0) Fail("cannot open", runs_path);
+    struct stat st{};
+    if (fstat(runs.fd, &st) < 0) Fail("cannot stat", runs_path);
+    uint64_t existing = static_cast<uint64_t>(st.st_size) / sizeof(RunEntry);
+    if (static_cast<uint64_t>(st.st_size) % sizeof(RunEntry) && ftruncate(runs.fd, static_cast<off_t>(existing * sizeof(RunEntry))) < 0)
+        Fail("cannot repair", runs_path);
+
+    RunEntry last{};
+    uint32_t segment = 1;
+    if (existing && ReadAt(runs.fd, &last, sizeof(last), (existing - 1) * sizeof(RunEntry))) segment = std::max(1u, last.segment);
+
+    std::string seg_path = SegmentPath(dir_, segment);
+    struct stat seg_st{};
+    if (stat(seg_path.c_str(), &seg_st) == 0 && static_cast<uint64_t>(seg_st.st_size) + sizeof(h) + payload.size() > kSegmentLimit) {
+        ++segment;
+        seg_path = SegmentPath(dir_, segment);
+    }
+    Fd seg(open(seg_path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0600));
+    if (seg.fd < 0) Fail("cannot open", seg_path);
+    off_t offset = lseek(seg.fd, 0, SEEK_END);
+    if (offset < 0) Fail("cannot seek", seg_path);
+
+    h.run_id = existing + 1;
+    WriteAll(seg.fd, &h, sizeof(h), seg_path);
+    WriteAll(seg.fd, payload.data(), payload.size(), seg_path);
+
+    // The index entry goes last: a run is visible only once its block is complete
+    RunEntry e{};
+    e.id = h.run_id;
+    e.started_us = started_us;
+    e.duration_ms = duration_ms;
+    e.rows = h.rows;
+    e.segment = segment;
+    e.length = static_cast<uint32_t>(sizeof(h) + payload.size());
+    e.offset = static_cast<uint64_t>(offset);
+    e.kind = static_cast<uint8_t>(kind);
+    std::memcpy(e.target, target.data(), std::min(target.size(), kTargetBytes));
+    if (lseek(runs.fd, 0, SEEK_END) < 0) Fail("cannot seek", runs_path);
+    WriteAll(runs.fd, &e, sizeof(e), runs_path);
+
+    // A torn entry left by a crash would misalign every entry after it
+    std::string hosts_path = dir_ + "/hosts.idx";
+    Fd hosts(open(hosts_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600));
+    if (hosts.fd < 0) Fail("cannot open", hosts_path);
+    struct stat hosts_st{};
+    if (fstat(hosts.fd, &hosts_st) < 0) Fail("cannot stat", hosts_path);
+    if (static_cast<uint64_t>(hosts_st.st_size) % sizeof(HostEntry) &&
+        ftruncate(hosts.fd, hosts_st.st_size - static_cast<off_t>(static_cast<uint64_t>(hosts_st.st_size) % sizeof(HostEntry))) < 0)
+        Fail("cannot repair", hosts_path);
+    std::vector<HostEntry> host_entries;
+    for (size_t i = 0; i < rows.size(); ++i)
+        if (i == 0 || rows[i].host != rows[i - 1].host) host_entries.push_back({HostHash(rows[i].host), e.id});
+    if (!host_entries.empty()) WriteAll(hosts.fd, host_entries.data(), host_entries.size() * sizeof(HostEntry), hosts_path);
+
+    return e.id;
+}
+
+uint64_t ResultStore::Append(ResultKind kind, const std::string& target, std::chrono::system_clock::time_point started,
+                             std::vector<ResultRow> rows) {
+    using namespace std::chrono;
+    auto elapsed = duration_cast<milliseconds>(system_clock::now() - started).count();
+    return Append(kind, target, duration_cast<microseconds>(started.time_since_epoch()).count(),
+                  static_cast<uint32_t>(std::max<int64_t>(0, elapsed)), std::move(rows));
+}
+
+std::vector<RunInfo> ResultStore::Runs(const RunFilter& filter) const {
+    std::vector<RunInfo> out;
+    for (const RunEntry& e : ReadIndex<RunEntry>(dir_ + "/runs.idx")) {
+        if (!filter.any_kind && e.kind != static_cast<uint8_t>(filter.kind)) continue;
+        if (filter.since_us && e.started_us < filter.since_us) continue;
+        if (filter.until_us && e.started_us >= filter.until_us) continue;
+        RunInfo r = ToRunInfo(e);
+        if (!filter.target.empty() && r.target != filter.target) continue;
+        out.push_back(std::move(r));
+    }
+    return out;
+}
+
+bool ResultStore::Run(uint64_t id, RunInfo& out) const {
+    if (id == 0) return false;
+    Fd f(open((dir_ + "/runs.idx").c_str(), O_RDONLY | O_CLOEXEC));
+    RunEntry e{};
+    if (f.fd < 0 || !ReadAt(f.fd, &e, sizeof(e), (id - 1) * sizeof(RunEntry)) || e.id != id) return false;
+    out = ToRunInfo(e);
+    return true;
+}
+
+std::vector<char> ResultStore::ReadBlock(const RunInfo& run) const {
+    std::string path = SegmentPath(dir_, run.segment);
+    Fd f(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    if (f.fd < 0) Fail("cannot open", path);
+    std::vector<char> block(run.length);
+    if (run.length < sizeof(BlockHeader) || !ReadAt(f.fd, block.data(), block.size(), run.offset))
+        throw CommandError("results: run " + std::to_string(run.id) + " is truncated in " + path);
+
+    BlockHeader h;
+    std::memcpy(&h, block.data(), sizeof(h));
+    if (std::memcmp(h.magic, kBlockMagic, 4) != 0 || h.version != kBlockVersion || h.run_id != run.id ||
+        sizeof(h) + h.payload_bytes != run.length || h.dict_bytes > h.payload_bytes ||
+        Crc32(block.data() + sizeof(h), h.payload_bytes) != h.crc)
+        throw CommandError("results: run " + std::to_string(run.id) + " failed its checksum in " + path);
+    return block;
+}
+
+std::vector<ResultRow> ResultStore::Rows(const RunInfo& run) const {
+    std::vector<char> block = ReadBlock(run);
+    BlockView v = ParseBlock(block);
+    std::vector<ResultRow> rows;
+    rows.reserve(v.rows);
+    for (uint32_t i = 0; i < v.rows; ++i) rows.push_back(v.Row(i));
+    return rows;
+}
+
+std::vector<ResultRow> ResultStore::Rows(const RunInfo& run, const std::string& host) const {
+    std::vector<char> block = ReadBlock(run);
+    BlockView v = ParseBlock(block);
+    std::vector<ResultRow> rows;
+
+    // The dictionary is sorted, and so is the host-index column
+    auto it = std::lower_bound(v.hosts.begin(), v.hosts.end(), std::string_view(host));
+    if (it == v.hosts.end() || *it != host) return rows;
+    uint32_t want = static_cast<uint32_t>(it - v.hosts.begin());
+    uint32_t lo = 0, hi = v.rows;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (v.HostIndex(mid) < want) lo = mid + 1;
+        else hi = mid;
+    }
+    for (uint32_t i = lo; i < v.rows && v.HostIndex(i) == want; ++i) rows.push_back(v.Row(i));
+    return rows;
+}
+
+std::vector<uint64_t> ResultStore::RunsWithHost(const std::string& host) const {
+    uint64_t hash = HostHash(host);
+    std::vector<uint64_t> ids;
+    for (const HostEntry& e : ReadIndex<HostEntry>(dir_ + "/hosts.idx"))
+        if (e.hash == hash) ids.push_back(e.run_id);
+    return ids;
+}
+
+ResultDiff ResultStore::Diff(const std::vector<ResultRow>& older, const std::vector<ResultRow>& newer) {
+    ResultDiff d;
+    size_t i = 0, j = 0;
+    while (i < older.size() || j < newer.size()) {
+        if (j == newer.size() || (i < older.size() && RowLess(older[i], newer[j]))) {
+            d.removed.push_back(older[i++]);
+        } else if (i == older.size() || RowLess(newer[j], older[i])) {
+            d.added.push_back(newer[j++]);
+        } else {
+            if (older[i].status != newer[j].status) d.changed.emplace_back(older[i], newer[j]);
+            ++i;
+            ++j;
+        }
+    }
+    return d;
+}
+
+} // namespace RedTops
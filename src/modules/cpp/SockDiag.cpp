@@ -0,0 +1,209 @@
+#include "../headers/SockDiag.hpp"
+#include "../../core/header/Exceptions.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <strings.h>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <linux/inet_diag.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/sock_diag.h>
+#include <linux/tcp.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace RedTops {
+
+namespace {
+
+constexpr size_t kRecvBuffer = 256 * 1024;   // dump chunks grow with the reader's buffer
+constexpr int kSocketBuffer = 8 * 1024 * 1024;
+
+const char* kStateNames[] = {
+    "UNKNOWN", "ESTAB", "SYN-SENT", "SYN-RECV", "FIN-WAIT-1", "FIN-WAIT-2", "TIME-WAIT",
+    "UNCONN", "CLOSE-WAIT", "LAST-ACK", "LISTEN", "CLOSING", "NEW-SYN-RECV",
+};
+
+struct StateAlias {
+    const char* name;
+    int state;
+};
+
+const StateAlias kStateAliases[] = {
+    {"established", 1}, {"estab", 1}, {"syn-sent", 2}, {"syn-recv", 3}, {"fin-wait-1", 4},
+    {"fin-wait-2", 5}, {"time-wait", 6}, {"close", 7}, {"unconn", 7}, {"close-wait", 8},
+    {"last-ack", 9}, {"listen", 10}, {"listening", 10}, {"closing", 11},
+};
+
+// Kernel-side filter: a chain of range tests that must all pass. Each test
+// is two ops: the comparison, then an op whose "no" field carries the port.
+// A failing test jumps past the end of the program, which rejects.
+void AppendRange(std::vector<inet_diag_bc_op>& prog, uint8_t ge, uint8_t le, uint16_t lo, uint16_t hi) {
+    prog.push_back({ge, 8, 0});
+    prog.push_back({INET_DIAG_BC_NOP, 0, lo});
+    prog.push_back({le, 8, 0});
+    prog.push_back({INET_DIAG_BC_NOP, 0, hi});
+}
+
+std::vector<inet_diag_bc_op> BuildBytecode(const SocketFilter& f) {
+    std::vector<inet_diag_bc_op> prog;
+    if (f.sport_lo || f.sport_hi) AppendRange(prog, INET_DIAG_BC_S_GE, INET_DIAG_BC_S_LE, f.sport_lo, f.sport_hi);
+    if (f.dport_lo || f.dport_hi) AppendRange(prog, INET_DIAG_BC_D_GE, INET_DIAG_BC_D_LE, f.dport_lo, f.dport_hi);
+    const size_t total = prog.size() * sizeof(inet_diag_bc_op);
+    for (size_t i = 0; i < prog.size(); i += 2) {
+        size_t offset = i * sizeof(inet_diag_bc_op);
+        prog[i].no = static_cast<uint16_t>(total - offset + 4);
+    }
+    return prog;
+}
+
+class DiagSocket {
+public:
+    DiagSocket() {
+        fd_ = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+        if (fd_ < 0) throw NetworkError(std::string("sockets: sock_diag netlink socket failed: ") + strerror(errno));
+        int size = kSocketBuffer;
+        if (setsockopt(fd_, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) < 0)
+            setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+    ~DiagSocket() { close(fd_); }
+    DiagSocket(const DiagSocket&) = delete;
+    DiagSocket& operator=(const DiagSocket&) = delete;
+    int fd() const { return fd_; }
+
+private:
+    int fd_ = -1;
+};
+
+void Decode(const nlmsghdr* nlh, int protocol, SocketEntry& e) {
+    const auto* msg = static_cast<const inet_diag_msg*>(NLMSG_DATA(nlh));
+    e = SocketEntry{};
+    e.family = msg->idiag_family;
+    e.protocol = protocol;
+    e.state = msg->idiag_state;
+    e.local_port = ntohs(msg->id.idiag_sport);
+    e.remote_port = ntohs(msg->id.idiag_dport);
+    size_t addr_len = e.family == AF_INET6 ? 16 : 4;
+    std::memcpy(e.local, msg->id.idiag_src, addr_len);
+    std::memcpy(e.remote, msg->id.idiag_dst, addr_len);
+    e.recv_q = msg->idiag_rqueue;
+    e.send_q = msg->idiag_wqueue;
+    e.uid = msg->idiag_uid;
+    e.inode = msg->idiag_inode;
+
+    int len = static_cast<int>(nlh->nlmsg_len) - static_cast<int>(NLMSG_LENGTH(sizeof(*msg)));
+    for (auto* rta = reinterpret_cast<const rtattr*>(msg + 1); RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+        if (rta->rta_type != INET_DIAG_INFO) continue;
+        // tcp_info grows with kernel versions; older kernels send a shorter struct
+        tcp_info info{};
+        std::memcpy(&info, RTA_DATA(rta), std::min<size_t>(RTA_PAYLOAD(rta), sizeof(info)));
+        e.has_info = true;
+        e.rtt_us = info.tcpi_rtt;
+        e.rttvar_us = info.tcpi_rttvar;
+        e.snd_cwnd = info.tcpi_snd_cwnd;
+        e.retransmits = info.tcpi_retransmits;
+        e.total_retrans = info.tcpi_total_retrans;
+        e.bytes_acked = info.tcpi_bytes_acked;
+        e.bytes_received = info.tcpi_bytes_received;
+        e.delivery_rate = info.tcpi_delivery_rate;
+    }
+}
+
+// One request/response exchange for a single address family
+bool DumpFamily(DiagSocket& sock, std::vector<char>& buf, const SocketFilter& filter, int family,
+                const std::vector<inet_diag_bc_op>& bytecode, uint64_t& delivered,
+                const std::function<bool(const SocketEntry&)>& fn) {
+    struct {
+        nlmsghdr nlh;
+        inet_diag_req_v2 req;
+    } head{};
+
+    size_t bc_bytes = bytecode.size() * sizeof(inet_diag_bc_op);
+    size_t attr_len = bc_bytes ? RTA_LENGTH(bc_bytes) : 0;
+    std::vector<char> msg(NLMSG_ALIGN(sizeof(head)) + RTA_ALIGN(attr_len));
+
+    head.nlh.nlmsg_len = static_cast<uint32_t>(msg.size());
+    head.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    head.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    head.nlh.nlmsg_seq = static_cast<uint32_t>(family);
+    head.req.sdiag_family = static_cast<uint8_t>(family);
+    head.req.sdiag_protocol = static_cast<uint8_t>(filter.protocol);
+    head.req.idiag_states = filter.states;
+    if (filter.tcp_info && filter.protocol == IPPROTO_TCP) head.req.idiag_ext = 1 << (INET_DIAG_INFO - 1);
+    std::memcpy(msg.data(), &head, sizeof(head));
+    if (bc_bytes) {
+        auto* rta = reinterpret_cast<rtattr*>(msg.data() + NLMSG_ALIGN(sizeof(head)));
+        rta->rta_type = INET_DIAG_REQ_BYTECODE;
+        rta->rta_len = static_cast<unsigned short>(attr_len);
+        std::memcpy(RTA_DATA(rta), bytecode.data(), bc_bytes);
+    }
+
+    sockaddr_nl kernel{};
+    kernel.nl_family = AF_NETLINK;
+    if (sendto(sock.fd(), msg.data(), msg.size(), 0, reinterpret_cast<sockaddr*>(&kernel), sizeof(kernel)) < 0)
+        throw NetworkError(std::string("sockets: sock_diag request failed: ") + strerror(errno));
+
+    SocketEntry entry;
+    for (;;) {
+        ssize_t n = recv(sock.fd(), buf.data(), buf.size(), 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw NetworkError(std::string("sockets: sock_diag receive failed: ") + strerror(errno));
+        }
+        int len = static_cast<int>(n);
+        for (auto* nlh = reinterpret_cast<const nlmsghdr*>(buf.data()); NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+            if (nlh->nlmsg_type == NLMSG_DONE) return true;
+            if (nlh->nlmsg_type == NLMSG_ERROR) {
+                const auto* err = static_cast<const nlmsgerr*>(NLMSG_DATA(nlh));
+                // Kernels without IPv6 or UDP diag support answer ENOENT; nothing to list
+                if (err->error == -ENOENT) return true;
+                throw NetworkError(std::string("sockets: sock_diag dump failed: ") + strerror(-err->error));
+            }
+            if (nlh->nlmsg_type != SOCK_DIAG_BY_FAMILY) continue;
+            Decode(nlh, filter.protocol, entry);
+            ++delivered;
+            if (!fn(entry)) return false;
+        }
+    }
+}
+
+} // namespace
+
+const char* SocketStateName(uint8_t state) {
+    return state < sizeof(kStateNames) / sizeof(kStateNames[0]) ? kStateNames[state] : "UNKNOWN";
+}
+
+int ParseSocketState(const char* name) {
+    for (const auto& alias : kStateAliases)
+        if (strcasecmp(alias.name, name) == 0) return alias.state;
+    return -1;
+}
+
+void FormatSocketAddress(int family, const uint8_t* addr, char* out, size_t size) {
+    char text[INET6_ADDRSTRLEN] = "?";
+    inet_ntop(family, addr, text, sizeof(text));
+    if (family == AF_INET6) std::snprintf(out, size, "[%s]", text);
+    else std::snprintf(out, size, "%s", text);
+}
+
+uint64_t DumpSockets(const SocketFilter& filter, const std::function<bool(const SocketEntry&)>& fn) {
+    DiagSocket sock;
+    std::vector<char> buf(kRecvBuffer);
+    std::vector<inet_diag_bc_op> bytecode = BuildBytecode(filter);
+    uint64_t delivered = 0;
+
+    for (int family : {AF_INET, AF_INET6}) {
+        if (filter.family && filter.family != family) continue;
+        if (!DumpFamily(sock, buf, filter, family, bytecode, delivered, fn)) break;
+    }
+    return delivered;
+}
+
+} // namespace RedTops
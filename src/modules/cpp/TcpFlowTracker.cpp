@@ -0,0 +1,383 @@
+#include "../headers/TcpFlowTracker.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <arpa/inet.h>
+
+namespace RedTops {
+
+namespace {
+
+constexpr size_t kFlushThreshold = 64 * 1024;
+
+// Sequence-space comparisons that survive 32-bit wraparound
+inline bool SeqLT(uint32_t a, uint32_t b) { return static_cast<int32_t>(a - b) < 0; }
+inline bool SeqLE(uint32_t a, uint32_t b) { return static_cast<int32_t>(a - b) <= 0; }
+inline bool SeqGT(uint32_t a, uint32_t b) { return static_cast<int32_t>(a - b) > 0; }
+
+std::string SafeName(const std::string& endpoint) {
+    std::string out = endpoint;
+    for (char& ch : out)
+        if (!((ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F') || ch == '.'))
+            ch = '_';
+    return out;
+}
+
+} // namespace
+
+bool TcpFlowKey::operator==(const TcpFlowKey& o) const {
+    return ipv6 == o.ipv6 && port[0] == o.port[0] && port[1] == o.port[1] &&
+           std::memcmp(addr, o.addr, sizeof(addr)) == 0;
+}
+
+size_t TcpFlowKeyHash::operator()(const TcpFlowKey& k) const noexcept {
+    // FNV-1a over the key bytes
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&](const uint8_t* p, size_t n) {
+        for (size_t i = 0; i < n; ++i) { h ^= p[i]; h *= 1099511628211ull; }
+    };
+    size_t alen = k.ipv6 ? 16 : 4;
+    mix(k.addr[0], alen);
+    mix(k.addr[1], alen);
+    mix(reinterpret_cast<const uint8_t*>(k.port), sizeof(k.port));
+    return static_cast<size_t>(h);
+}
+
+const char* TcpFlowStateName(TcpFlowState state) {
+    switch (state) {
+        case TcpFlowState::SynSent: return "SYN_SENT";
+        case TcpFlowState::SynReceived: return "SYN_RECV";
+        case TcpFlowState::Established: return "ESTABLISHED";
+        case TcpFlowState::Closing: return "CLOSING";
+        case TcpFlowState::Closed: return "CLOSED";
+        case TcpFlowState::Reset: return "RESET";
+        case TcpFlowState::Midstream: return "MIDSTREAM";
+    }
+    return "?";
+}
+
+std::string TcpFlow::Endpoint(uint8_t side) const {
+    char buf[INET6_ADDRSTRLEN + 8];
+    if (key.ipv6) {
+        buf[0] = '[';
+        inet_ntop(AF_INET6, key.addr[side], buf + 1, INET6_ADDRSTRLEN);
+        std::strcat(buf, "]");
+    } else {
+        inet_ntop(AF_INET, key.addr[side], buf, INET_ADDRSTRLEN);
+    }
+    return std::string(buf) + ":" + std::to_string(key.port[side]);
+}
+
+TcpFlowTracker::TcpFlowTracker(TcpTrackerOptions options) : options_(std::move(options)) {
+    if (options_.max_flows == 0) options_.max_flows = 1;
+    if (options_.per_flow_buffer < kFlushThreshold) options_.per_flow_buffer = kFlushThreshold;
+    index_.reserve(std::min<size_t>(options_.max_flows, 1 << 16));
+}
+
+TcpFlowTracker::~TcpFlowTracker() {
+    Flush();
+}
+
+void TcpFlowTracker::Unlink(uint32_t idx) {
+    TcpFlow& f = pool_[idx];
+    if (f.lru_prev != UINT32_MAX) pool_[f.lru_prev].lru_next = f.lru_next;
+    else lru_head_ = f.lru_next;
+    if (f.lru_next != UINT32_MAX) pool_[f.lru_next].lru_prev = f.lru_prev;
+    else lru_tail_ = f.lru_prev;
+    f.lru_prev = f.lru_next = UINT32_MAX;
+}
+
+void TcpFlowTracker::Touch(uint32_t idx) {
+    if (lru_head_ == idx) return;
+    TcpFlow& f = pool_[idx];
+    bool linked = f.lru_prev != UINT32_MAX || f.lru_next != UINT32_MAX || lru_tail_ == idx;
+    if (linked) Unlink(idx);
+    f.lru_next = lru_head_;
+    if (lru_head_ != UINT32_MAX) pool_[lru_head_].lru_prev = idx;
+    lru_head_ = idx;
+    if (lru_tail_ == UINT32_MAX) lru_tail_ = idx;
+}
+
+void TcpFlowTracker::Evict(uint32_t idx) {
+    TcpFlow& f = pool_[idx];
+    FlushDirection(f, 0);
+    FlushDirection(f, 1);
+    DropBuffers(f, 0);
+    DropBuffers(f, 1);
+    index_.erase(f.key);
+    Unlink(idx);
+    f = TcpFlow{};
+    free_.push_back(idx);
+    stats_.flows_evicted++;
+}
+
+uint32_t TcpFlowTracker::Lookup(const TcpFlowKey& key, bool create, uint64_t ts_us) {
+    auto it = index_.find(key);
+    if (it != index_.end()) return it->second;
+    if (!create) return UINT32_MAX;
+
+    if (index_.size() >= options_.max_flows && lru_tail_ != UINT32_MAX) Evict(lru_tail_);
+
+    uint32_t idx;
+    if (!free_.empty()) {
+        idx = free_.back();
+        free_.pop_back();
+    } else {
+        idx = static_cast<uint32_t>(pool_.size());
+        pool_.emplace_back();
+    }
+    TcpFlow& f = pool_[idx];
+    f.key = key;
+    f.first_us = ts_us;
+    index_.emplace(key, idx);
+    stats_.flows_created++;
+    return idx;
+}
+
+void TcpFlowTracker::Process(const DissectedPacket& pkt, const uint8_t* frame, uint64_t ts_us) {
+    if (pkt.l4_proto != 6 || (pkt.flags & DissectFlag::HasPorts) == 0) return;
+    if (pkt.l3 != L3Proto::IPv4 && pkt.l3 != L3Proto::IPv6) return;
+    stats_.packets++;
+
+    // Build the canonical key and figure out which side sent this segment
+    TcpFlowKey key{};
+    key.ipv6 = pkt.l3 == L3Proto::IPv6;
+    size_t alen = key.ipv6 ? 16 : 4;
+    int cmp = std::memcmp(pkt.src_addr, pkt.dst_addr, alen);
+    uint8_t side = (cmp < 0 || (cmp == 0 && pkt.src_port <= pkt.dst_port)) ? 0 : 1;
+    std::memcpy(key.addr[side], pkt.src_addr, alen);
+    std::memcpy(key.addr[1 - side], pkt.dst_addr, alen);
+    key.port[side] = pkt.src_port;
+    key.port[1 - side] = pkt.dst_port;
+
+    uint32_t idx = Lookup(key, true, ts_us);
+    Touch(idx);
+    TcpFlow* flow = &pool_[idx];
+    flow->last_us = ts_us;
+
+    const uint8_t flags = pkt.tcp_flags;
+    const bool syn = flags & TcpFlag::SYN;
+    const bool ack = flags & TcpFlag::ACK;
+    const uint32_t seq = pkt.tcp_seq;
+    const uint32_t len = pkt.payload_offset != kNoOffset ? pkt.payload_length : 0;
+
+    // A fresh SYN on a finished tuple starts a new connection
+    if (syn && !ack && (flow->state == TcpFlowState::Closed || flow->state == TcpFlowState::Reset)) {
+        FlushDirection(*flow, 0);
+        FlushDirection(*flow, 1);
+        DropBuffers(*flow, 0);
+        DropBuffers(*flow, 1);
+        uint32_t prev = flow->lru_prev, next = flow->lru_next;
+        *flow = TcpFlow{};
+        flow->key = key;
+        flow->first_us = flow->last_us = ts_us;
+        flow->lru_prev = prev;
+        flow->lru_next = next;
+        stats_.flows_created++;
+    }
+
+    TcpDirection& d = flow->dir[side];
+    d.packets++;
+
+    if (syn && !ack) {
+        if (flow->syn_us && d.seen && seq == d.isn) {
+            // Karn: the RTT is measured from the last (re)transmitted SYN
+            flow->syn_retransmits++;
+            d.retransmits++;
+            stats_.retransmits++;
+        }
+        flow->client = side;
+        flow->state = TcpFlowState::SynSent;
+        flow->syn_us = ts_us;
+        d.seen = true;
+        d.isn = seq;
+        d.next_seq = d.deliver_seq = seq + 1;
+        return;
+    }
+
+    if (syn && ack) {
+        if (flow->state == TcpFlowState::Midstream && !flow->syn_us) flow->client = 1 - side;
+        if (side != flow->client) {
+            if (flow->synack_us && d.seen && seq == d.isn) {
+                d.retransmits++;
+                stats_.retransmits++;
+            }
+            flow->synack_us = ts_us;
+            flow->state = TcpFlowState::SynReceived;
+            d.seen = true;
+            d.isn = seq;
+            d.next_seq = d.deliver_seq = seq + 1;
+        }
+        return;
+    }
+
+    if (ack && flow->state == TcpFlowState::SynReceived && side == flow->client &&
+        pkt.tcp_ack == flow->dir[1 - side].isn + 1) {
+        flow->ack_us = ts_us;
+        flow->state = TcpFlowState::Established;
+        stats_.handshakes++;
+        if (on_handshake_) on_handshake_(*flow);
+    }
+
+    if (!d.seen) {
+        // Joined mid-connection: take the first segment as the stream origin
+        d.seen = true;
+        d.isn = seq - 1;
+        d.next_seq = d.deliver_seq = seq;
+    }
+
+    if (len > 0) {
+        uint32_t end = seq + len;
+        if (SeqLT(seq, d.next_seq)) {
+            d.retransmits++;
+            stats_.retransmits++;
+        }
+        if (SeqGT(end, d.next_seq)) d.next_seq = end;
+        d.bytes += len;
+        if (options_.reassemble && frame) {
+            Reassemble(*flow, side, seq, frame + pkt.payload_offset, len);
+            flow = &pool_[idx];
+        }
+    }
+
+    if (flags & TcpFlag::FIN) {
+        uint32_t fin_end = seq + len + 1;
+        if (SeqGT(fin_end, d.next_seq)) d.next_seq = fin_end;
+        d.fin = true;
+        flow->state = flow->dir[1 - side].fin ? TcpFlowState::Closed : TcpFlowState::Closing;
+    }
+    if (flags & TcpFlag::RST) flow->state = TcpFlowState::Reset;
+
+    if (flow->state == TcpFlowState::Closed || flow->state == TcpFlowState::Reset) {
+        FlushDirection(*flow, 0);
+        FlushDirection(*flow, 1);
+        DropBuffers(*flow, 0);
+        DropBuffers(*flow, 1);
+    }
+}
+
+void TcpFlowTracker::Reassemble(TcpFlow& flow, uint8_t side, uint32_t seq, const uint8_t* data, uint32_t len) {
+    TcpDirection& d = flow.dir[side];
+
+    // Trim bytes that were already delivered
+    if (SeqLT(seq, d.deliver_seq)) {
+        uint32_t overlap = d.deliver_seq - seq;
+        if (overlap >= len) return;
+        data += overlap;
+        len -= overlap;
+        seq = d.deliver_seq;
+    }
+
+    if (seq != d.deliver_seq) {
+        // Hole ahead of us: park the segment if the caps allow it
+        bool fits = d.buffered + len <= options_.per_flow_buffer &&
+                    stats_.buffered_bytes + len <= options_.total_buffer;
+        uint32_t rel = seq - d.isn;
+        if (fits && d.out_of_order.find(rel) == d.out_of_order.end()) {
+            d.out_of_order.emplace(rel, std::vector<uint8_t>(data, data + len));
+            d.buffered += len;
+            stats_.buffered_bytes += len;
+            return;
+        }
+        if (fits) return;  // duplicate out-of-order segment
+        // Out of room: give up on the hole and resume at this segment
+        d.gaps++;
+        stats_.reassembly_gaps++;
+        d.deliver_seq = seq;
+    }
+
+    Deliver(flow, side, data, len);
+    d.deliver_seq = seq + len;
+
+    // Drain parked segments that are now contiguous
+    while (!d.out_of_order.empty()) {
+        auto it = d.out_of_order.begin();
+        uint32_t seg_seq = d.isn + it->first;
+        if (SeqGT(seg_seq, d.deliver_seq)) break;
+        const std::vector<uint8_t>& seg = it->second;
+        uint32_t skip = d.deliver_seq - seg_seq;
+        if (skip < seg.size()) {
+            Deliver(flow, side, seg.data() + skip, seg.size() - skip);
+            d.deliver_seq = seg_seq + static_cast<uint32_t>(seg.size());
+        }
+        d.buffered -= seg.size();
+        stats_.buffered_bytes -= seg.size();
+        d.out_of_order.erase(it);
+    }
+
+    if (stats_.buffered_bytes > options_.total_buffer) {
+        ReclaimMemory(static_cast<uint32_t>(&flow - pool_.data()));
+    }
+}
+
+void TcpFlowTracker::Deliver(TcpFlow& flow, uint8_t side, const uint8_t* data, size_t len) {
+    TcpDirection& d = flow.dir[side];
+    d.pending.insert(d.pending.end(), data, data + len);
+    d.buffered += len;
+    d.delivered += len;
+    stats_.buffered_bytes += len;
+    stats_.bytes_reassembled += len;
+    if (d.pending.size() >= kFlushThreshold) FlushDirection(flow, side);
+}
+
+void TcpFlowTracker::FlushDirection(TcpFlow& flow, uint8_t side) {
+    TcpDirection& d = flow.dir[side];
+    if (d.pending.empty()) return;
+
+    if (!options_.stream_dir.empty()) {
+        uint8_t client = flow.client;
+        std::string name = SafeName(flow.Endpoint(client)) + "_" + SafeName(flow.Endpoint(1 - client)) +
+                           (side == client ? ".c2s" : ".s2c");
+        std::string path = options_.stream_dir + "/" + name;
+        if (FILE* f = std::fopen(path.c_str(), "ab")) {
+            std::fwrite(d.pending.data(), 1, d.pending.size(), f);
+            std::fclose(f);
+        }
+    }
+
+    d.buffered -= d.pending.size();
+    stats_.buffered_bytes -= d.pending.size();
+    d.pending.clear();
+    if (d.pending.capacity() > kFlushThreshold * 2) d.pending.shrink_to_fit();
+}
+
+void TcpFlowTracker::DropBuffers(TcpFlow& flow, uint8_t side) {
+    TcpDirection& d = flow.dir[side];
+    size_t parked = 0;
+    for (auto& kv : d.out_of_order) parked += kv.second.size();
+    if (parked) {
+        d.gaps++;
+        stats_.reassembly_gaps++;
+    }
+    d.out_of_order.clear();
+    d.buffered -= parked;
+    stats_.buffered_bytes -= parked;
+}
+
+void TcpFlowTracker::ReclaimMemory(uint32_t keep) {
+    // Walk from the least recently used flow, flushing and dropping buffers
+    for (uint32_t idx = lru_tail_; idx != UINT32_MAX && stats_.buffered_bytes > options_.total_buffer;
+         idx = pool_[idx].lru_prev) {
+        if (idx == keep) continue;
+        for (uint8_t side = 0; side < 2; ++side) {
+            FlushDirection(pool_[idx], side);
+            DropBuffers(pool_[idx], side);
+        }
+    }
+}
+
+void TcpFlowTracker::Flush() {
+    for (uint32_t idx = lru_head_; idx != UINT32_MAX; idx = pool_[idx].lru_next) {
+        FlushDirection(pool_[idx], 0);
+        FlushDirection(pool_[idx], 1);
+    }
+}
+
+std::vector<const TcpFlow*> TcpFlowTracker::Flows() const {
+    std::vector<const TcpFlow*> out;
+    out.reserve(index_.size());
+    for (uint32_t idx = lru_head_; idx != UINT32_MAX; idx = pool_[idx].lru_next) out.push_back(&pool_[idx]);
+    return out;
+}
+
+} // namespace RedTops
@@ -0,0 +1,227 @@
+#include "../headers/TextSearch.hpp"
+#include "../../core/header/Exceptions.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include <regex.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define REDTOPS_X86 1
+#endif
+
+namespace RedTops {
+
+namespace {
+
+uint8_t Lower(uint8_t c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<uint8_t>(c | 0x20) : c;
+}
+
+bool IsLetter(uint8_t c) {
+    return (c | 0x20) >= 'a' && (c | 0x20) <= 'z';
+}
+
+#ifdef REDTOPS_X86
+bool HasAvx2() {
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+
+using VerifyFn = bool (*)(const void*, const char*);
+
+// Both kernels return the first verified match, or kNoMatch with resume set
+// to where the vector loop stopped so the caller can finish the tail. Bit k
+// of the candidate mask means the first byte matches at i + k and the last
+// byte at i + k + n - 1.
+__attribute__((target("avx2")))
+size_t FindAvx2(const char* data, size_t len, size_t from, size_t n, uint8_t first, uint8_t last,
+                uint8_t first_fold, uint8_t last_fold, const void* self, VerifyFn verify, size_t& resume) {
+    const __m256i vf = _mm256_set1_epi8(static_cast<char>(first));
+    const __m256i vl = _mm256_set1_epi8(static_cast<char>(last));
+    const __m256i ff = _mm256_set1_epi8(static_cast<char>(first_fold));
+    const __m256i lf = _mm256_set1_epi8(static_cast<char>(last_fold));
+    size_t i = from;
+    for (; i + n - 1 + 32 <= len; i += 32) {
+        __m256i bf = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), ff);
+        __m256i bl = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + n - 1)), lf);
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(bf, vf), _mm256_cmpeq_epi8(bl, vl))));
+        while (mask) {
+            unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+            if (verify(self, data + i + bit)) {
+                resume = i;
+                return i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    resume = i;
+    return kNoMatch;
+}
+
+size_t FindSse2(const char* data, size_t len, size_t from, size_t n, uint8_t first, uint8_t last,
+                uint8_t first_fold, uint8_t last_fold, const void* self, VerifyFn verify, size_t& resume) {
+    const __m128i vf = _mm_set1_epi8(static_cast<char>(first));
+    const __m128i vl = _mm_set1_epi8(static_cast<char>(last));
+    const __m128i ff = _mm_set1_epi8(static_cast<char>(first_fold));
+    const __m128i lf = _mm_set1_epi8(static_cast<char>(last_fold));
+    size_t i = from;
+    for (; i + n - 1 + 16 <= len; i += 16) {
+        __m128i bf = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), ff);
+        __m128i bl = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + n - 1)), lf);
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(bf, vf), _mm_cmpeq_epi8(bl, vl))));
+        while (mask) {
+            unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+            if (verify(self, data + i + bit)) {
+                resume = i;
+                return i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    resume = i;
+    return kNoMatch;
+}
+#endif
+
+// Per-thread compiled copies of each regex: glibc's regexec serializes
+// callers that share one regex_t, which would undo the worker pool
+struct ThreadRegex {
+    uint64_t owner = 0;
+    bool compiled = false;
+    regex_t re;
+    ~ThreadRegex() {
+        if (compiled) regfree(&re);
+    }
+};
+
+std::atomic<uint64_t> next_matcher_id{1};
+
+bool HasRegexMeta(const std::string& s) {
+    return s.find_first_of(".[]()*+?{}|^$\\") != std::string::npos;
+}
+
+} // namespace
+
+LiteralSearcher::LiteralSearcher(std::string needle, bool ignore_case)
+    : needle_(std::move(needle)), ignore_case_(ignore_case) {
+    if (ignore_case_)
+        for (auto& c : needle_) c = static_cast<char>(Lower(static_cast<uint8_t>(c)));
+    if (needle_.empty()) return;
+    first_ = static_cast<uint8_t>(needle_.front());
+    last_ = static_cast<uint8_t>(needle_.back());
+    if (ignore_case_) {
+        first_fold_ = IsLetter(first_) ? 0x20 : 0;
+        last_fold_ = IsLetter(last_) ? 0x20 : 0;
+    }
+}
+
+bool LiteralSearcher::Verify(const char* at) const {
+    if (!ignore_case_) return std::memcmp(at, needle_.data(), needle_.size()) == 0;
+    for (size_t i = 0; i < needle_.size(); ++i)
+        if (Lower(static_cast<uint8_t>(at[i])) != static_cast<uint8_t>(needle_[i])) return false;
+    return true;
+}
+
+size_t LiteralSearcher::Find(const char* data, size_t len, size_t from) const {
+    const size_t n = needle_.size();
+    if (n == 0) return from <= len ? from : kNoMatch;
+    if (from + n > len) return kNoMatch;
+
+    if (!ignore_case_ && n == 1) {
+        const void* hit = std::memchr(data + from, first_, len - from);
+        return hit ? static_cast<size_t>(static_cast<const char*>(hit) - data) : kNoMatch;
+    }
+
+    size_t i = from;
+#ifdef REDTOPS_X86
+    auto verify = [](const void* self, const char* at) { return static_cast<const LiteralSearcher*>(self)->Verify(at); };
+    size_t resume = i;
+    size_t r = HasAvx2()
+        ? FindAvx2(data, len, i, n, first_, last_, first_fold_, last_fold_, this, verify, resume)
+        : FindSse2(data, len, i, n, first_, last_, first_fold_, last_fold_, this, verify, resume);
+    if (r != kNoMatch) return r;
+    i = resume;
+#endif
+    // Tail (and non-x86 targets)
+    for (; i + n <= len; ++i) {
+        uint8_t c = static_cast<uint8_t>(data[i]);
+        if ((ignore_case_ ? Lower(c) : c) == first_ && Verify(data + i)) return i;
+    }
+    return kNoMatch;
+}
+
+size_t CountNewlines(const char* data, size_t len) {
+    size_t count = 0;
+    size_t i = 0;
+#ifdef REDTOPS_X86
+    const __m128i nl = _mm_set1_epi8('\n');
+    for (; i + 16 <= len; i += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        count += static_cast<size_t>(__builtin_popcount(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, nl)))));
+    }
+#endif
+    for (; i < len; ++i) count += data[i] == '\n';
+    return count;
+}
+
+TextMatcher::TextMatcher(const std::vector<std::string>& patterns, bool fixed, bool ignore_case)
+    : ignore_case_(ignore_case), id_(next_matcher_id.fetch_add(1)) {
+    regex_ = !fixed && std::any_of(patterns.begin(), patterns.end(), HasRegexMeta);
+    if (!regex_) {
+        for (const auto& p : patterns) literals_.emplace_back(p, ignore_case);
+        return;
+    }
+
+    // Several -e patterns become one alternation
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        if (i) expression_ += '|';
+        expression_ += patterns.size() > 1 ? "(" + patterns[i] + ")" : patterns[i];
+    }
+    regex_t probe;
+    int rc = regcomp(&probe, expression_.c_str(), REG_EXTENDED | REG_NEWLINE | (ignore_case ? REG_ICASE : 0));
+    if (rc != 0) {
+        char msg[256];
+        regerror(rc, &probe, msg, sizeof(msg));
+        throw CommandError("search: invalid pattern: " + std::string(msg));
+    }
+    regfree(&probe);
+}
+
+TextMatcher::~TextMatcher() = default;
+
+size_t TextMatcher::Find(const char* data, size_t len, size_t from, size_t& match_len) const {
+    if (!regex_) {
+        // Earliest match over all literals
+        size_t best = kNoMatch;
+        for (const auto& lit : literals_) {
+            size_t limit = best == kNoMatch ? len : std::min(len, best + lit.Length());
+            size_t at = lit.Find(data, limit, from);
+            if (at != kNoMatch && (best == kNoMatch || at < best)) {
+                best = at;
+                match_len = lit.Length();
+            }
+        }
+        return best;
+    }
+
+    thread_local ThreadRegex local;
+    if (local.owner != id_) {
+        if (local.compiled) regfree(&local.re);
+        local.compiled = regcomp(&local.re, expression_.c_str(),
+                                 REG_EXTENDED | REG_NEWLINE | (ignore_case_ ? REG_ICASE : 0)) == 0;
+        local.owner = id_;
+        if (!local.compiled) return kNoMatch;
+    }
+    regmatch_t m[1];
+    m[0].rm_so = static_cast<regoff_t>(from);
+    m[0].rm_eo = static_cast<regoff_t>(len);
+    if (regexec(&local.re, data, 1, m, REG_STARTEND) != 0) return kNoMatch;
+    match_len = static_cast<size_t>(m[0].rm_eo - m[0].rm_so);
+    return static_cast<size_t>(m[0].rm_so);
+}
+
+} // namespace RedTops
@@ -0,0 +1,74 @@
+#include "../headers/TreeRemover.hpp"
+#include "../headers/TreeWalker.hpp"
+#include "../../core/header/Exceptions.hpp"
+
+#include <cerrno>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace RedTops {
+
+namespace {
+
+constexpr size_t kMaxErrorMessages = 10;
+
+std::string ErrorText(int err) {
+    return std::error_code(err, std::generic_category()).message();
+}
+
+} // namespace
+
+TreeRemover::TreeRemover(unsigned threads) : threads_(threads ? threads : TreeWalker::DefaultThreads()) {}
+
+void TreeRemover::Fail(const std::string& path, int err) {
+    errors_.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(errors_mutex_);
+    if (error_messages_.size() < kMaxErrorMessages) error_messages_.push_back(path + ": " + ErrorText(err));
+}
+
+bool TreeRemover::Remove(const std::string& path, const std::function<bool()>& should_stop,
+                         const std::function<void()>& on_tick) {
+    int root = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (root < 0) throw CommandError("rm: cannot open " + path + ": " + ErrorText(errno));
+
+    TreeWalker::Visitor visitor;
+    visitor.entry = [&](const TreeWalker::Entry& e) {
+        std::string name(e.name);
+        if (unlinkat(e.dir.fd, name.c_str(), 0) != 0 && errno != ENOENT) return Fail(e.Path(), errno);
+        files_.fetch_add(1, std::memory_order_relaxed);
+    };
+    // Called once nothing is left below the directory. It goes by name in its
+    // parent's descriptor, never by path from the root, so a parent swapped
+    // for a symlink cannot point the removal outside the tree.
+    visitor.leave = [&](const TreeWalker::Dir& d) {
+        std::string name(d.Name());
+        if (unlinkat(d.parent_fd, name.c_str(), AT_REMOVEDIR) != 0 && errno != ENOENT) return Fail(d.path, errno);
+        dirs_.fetch_add(1, std::memory_order_relaxed);
+    };
+    visitor.error = [&](const std::string& dir, int err) { Fail(dir.empty() ? path : dir, err); };
+
+    bool complete = TreeWalker(threads_).Walk(root, visitor, should_stop, on_tick);
+    close(root);
+    if (complete && errors_.load() == 0) {
+        if (rmdir(path.c_str()) != 0) Fail(path, errno);
+        else dirs_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return complete;
+}
+
+RemoveStats TreeRemover::Stats() const {
+    RemoveStats s;
+    s.files = files_.load(std::memory_order_relaxed);
+    s.dirs = dirs_.load(std::memory_order_relaxed);
+    s.errors = errors_.load(std::memory_order_relaxed);
+    return s;
+}
+
+std::vector<std::string> TreeRemover::Errors() const {
+    std::lock_guard<std::mutex> lock(errors_mutex_);
+    return error_messages_;
+}
+
+} // namespace RedTops
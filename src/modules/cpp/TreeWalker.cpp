@@ -0,0 +1,332 @@
+#include "../headers/TreeWalker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace RedTops {
+
+namespace {
+
+// Kernel layout of one getdents64 record
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+constexpr size_t kBatchEntries = 256;
+constexpr size_t kStopCheckEvery = 1024;
+
+uint8_t TypeFromMode(mode_t mode) {
+    switch (mode & S_IFMT) {
+        case S_IFDIR:  return DT_DIR;
+        case S_IFREG:  return DT_REG;
+        case S_IFLNK:  return DT_LNK;
+        case S_IFIFO:  return DT_FIFO;
+        case S_IFSOCK: return DT_SOCK;
+        case S_IFCHR:  return DT_CHR;
+        case S_IFBLK:  return DT_BLK;
+        default:       return DT_UNKNOWN;
+    }
+}
+
+struct Node {
+    TreeWalker::Dir dir;
+    std::shared_ptr<Node> parent;
+    bool owns_fd = true;
+    std::atomic<bool> failed{false};   // listing incomplete; never left, nor are its ancestors, unless leave_failed
+    std::atomic<int> users{1};     // the listing plus every outstanding batch
+    std::atomic<int> pending{1};   // this directory's own entries plus each unfinished subdirectory
+
+    ~Node() {
+        if (owns_fd && dir.fd >= 0) close(dir.fd);
+    }
+};
+
+// Non-directory entries of one directory, visited as a unit by any worker
+struct Batch {
+    struct Item {
+        uint32_t offset;
+        uint32_t length;
+        uint64_t ino;
+        uint8_t type;
+    };
+    std::shared_ptr<Node> node;
+    std::string names;
+    std::vector<Item> items;
+};
+
+struct Job {
+    std::shared_ptr<Node> node;    // a directory to list, unless batch is set
+    std::unique_ptr<Batch> batch;
+};
+
+class WalkState {
+public:
+    explicit WalkState(const TreeWalker::Visitor& visitor) : visitor_(visitor) {}
+
+    void Push(Job job, bool front) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++outstanding_;
+        if (front) queue_.push_front(std::move(job));
+        else queue_.push_back(std::move(job));
+        work_cv_.notify_one();
+    }
+
+    void Worker() {
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                work_cv_.wait(lock, [&] { return stop_ || !queue_.empty() || outstanding_ == 0; });
+                if (stop_ || queue_.empty()) return;
+                job = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            if (job.batch) Visit(*job.batch);
+            else List(job.node);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--outstanding_ == 0) {
+                work_cv_.notify_all();
+                done_cv_.notify_all();
+            }
+        }
+    }
+
+    // Waits up to `timeout` for the walk to drain; true when it has
+    bool WaitDone(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return done_cv_.wait_for(lock, timeout, [&] { return outstanding_ == 0; });
+    }
+
+    void Stop() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        work_cv_.notify_all();
+    }
+
+    void Drop() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.clear();
+    }
+
+private:
+    void List(const std::shared_ptr<Node>& node) {
+        if (node->dir.fd < 0) {
+            // By name in the parent's descriptor, never by path from the root:
+            // an intermediate directory swapped for a symlink mid-walk must
+            // not lead the walk out of the tree
+            std::string name(node->dir.Name());
+            node->dir.fd = openat(node->dir.parent_fd, name.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            if (node->dir.fd < 0) {
+                if (visitor_.error) visitor_.error(node->dir.path, errno);
+                node->failed = true;
+                Release(node);
+                return;
+            }
+        }
+
+        DirReader reader(node->dir.fd);
+        DirEntry raw;
+        std::unique_ptr<Batch> batch;
+        size_t seen = 0;
+        while (reader.Next(raw)) {
+            if (++seen % kStopCheckEvery == 0 && stop_) {
+                node->failed = true;
+                break;
+            }
+            uint8_t type = raw.type;
+            if (type == DT_UNKNOWN) {
+                // Some filesystems (XFS without ftype, many FUSE mounts) leave d_type empty
+                struct stat st;
+                std::string name(raw.name);
+                if (fstatat(node->dir.fd, name.c_str(), &st, AT_SYMLINK_NOFOLLOW) == 0) type = TypeFromMode(st.st_mode);
+            }
+
+            if (type == DT_DIR) {
+                TreeWalker::Entry entry{node->dir, raw.name, raw.ino, type};
+                if (visitor_.directory && !visitor_.directory(entry)) continue;
+                auto child = std::make_shared<Node>();
+                child->dir.path = node->dir.Child(raw.name);
+                child->dir.depth = node->dir.depth + 1;
+                child->dir.parent_fd = node->dir.fd;
+                child->parent = node;
+                node->pending.fetch_add(1);
+                Push(Job{std::move(child), nullptr}, true);
+                continue;
+            }
+
+            if (!visitor_.entry) continue;
+            if (!batch) {
+                batch = std::make_unique<Batch>();
+                batch->node = node;
+                batch->items.reserve(kBatchEntries);
+            }
+            batch->items.push_back({static_cast<uint32_t>(batch->names.size()), static_cast<uint32_t>(raw.name.size()), raw.ino, type});
+            batch->names.append(raw.name);
+            if (batch->items.size() == kBatchEntries) {
+                node->users.fetch_add(1);
+                Push(Job{nullptr, std::move(batch)}, true);
+            }
+        }
+        if (reader.Error()) {
+            if (visitor_.error) visitor_.error(node->dir.path, reader.Error());
+            node->failed = true;
+        }
+        if (batch) {
+            node->users.fetch_add(1);
+            Push(Job{nullptr, std::move(batch)}, true);
+        }
+        Release(node);
+    }
+
+    void Visit(Batch& batch) {
+        const std::shared_ptr<Node>& node = batch.node;
+        size_t n = 0;
+        for (const auto& item : batch.items) {
+            if (++n % 64 == 0 && stop_) {
+                node->failed = true;
+                break;
+            }
+            TreeWalker::Entry entry{node->dir, std::string_view(batch.names.data() + item.offset, item.length), item.ino, item.type};
+            visitor_.entry(entry);
+        }
+        Release(node);
+    }
+
+    // The listing or a batch of node is finished
+    void Release(const std::shared_ptr<Node>& node) {
+        if (node->users.fetch_sub(1) != 1) return;
+        Complete(node.get());
+    }
+
+    // Post-order: a directory is left once its entries and all its
+    // subdirectories are done. Its descriptor stays open until then, since
+    // the subdirectories are opened and removed relative to it; one that is
+    // never left closes with its node.
+    void Complete(Node* node) {
+        while (node && node->pending.fetch_sub(1) == 1) {
+            if (node->failed && !visitor_.leave_failed) return;    // its parent's count never drains either
+            if (!node->parent) return;     // the root is the caller's
+            if (node->failed) {
+                node->dir.complete = false;
+                node->parent->failed = true;
+            }
+            if (node->dir.fd >= 0) {
+                close(node->dir.fd);
+                node->dir.fd = -1;
+            }
+            if (visitor_.leave) visitor_.leave(node->dir);
+            node = node->parent.get();
+        }
+    }
+
+    const TreeWalker::Visitor& visitor_;
+
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    std::deque<Job> queue_;
+    size_t outstanding_ = 0;       // queued plus running jobs
+    std::atomic<bool> stop_{false};
+};
+
+} // namespace
+
+DirReader::DirReader(int fd, size_t buffer_bytes) : fd_(fd), buf_(buffer_bytes) {}
+
+bool DirReader::Next(DirEntry& entry) {
+    for (;;) {
+        if (pos_ >= len_) {
+            if (eof_ || error_) return false;
+            long n = syscall(SYS_getdents64, fd_, buf_.data(), buf_.size());
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                error_ = errno;
+                return false;
+            }
+            if (n == 0) {
+                eof_ = true;
+                return false;
+            }
+            pos_ = 0;
+            len_ = static_cast<size_t>(n);
+        }
+        const auto* d = reinterpret_cast<const LinuxDirent64*>(buf_.data() + pos_);
+        pos_ += d->d_reclen;
+        const char* name = d->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+        entry.name = std::string_view(name);
+        entry.ino = d->d_ino;
+        entry.type = d->d_type;
+        return true;
+    }
+}
+
+std::string_view TreeWalker::Dir::Name() const {
+    std::string_view p(path);
+    size_t slash = p.rfind('/');
+    return slash == std::string_view::npos ? p : p.substr(slash + 1);
+}
+
+std::string TreeWalker::Dir::Child(std::string_view name) const {
+    std::string out;
+    out.reserve(path.size() + 1 + name.size());
+    if (!path.empty()) {
+        out = path;
+        out += '/';
+    }
+    out.append(name);
+    return out;
+}
+
+TreeWalker::TreeWalker(unsigned threads) : threads_(std::max(1u, threads)) {}
+
+unsigned TreeWalker::DefaultThreads() {
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    return std::min(32u, std::max(4u, cores * 2));
+}
+
+bool TreeWalker::Walk(int root_fd, const Visitor& visitor, const std::function<bool()>& should_stop,
+                      const std::function<void()>& on_tick) {
+    WalkState state(visitor);
+    auto root = std::make_shared<Node>();
+    root->dir.fd = root_fd;
+    root->owns_fd = false;
+    state.Push(Job{std::move(root), nullptr}, false);
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads_);
+    for (unsigned i = 0; i < threads_; ++i) workers.emplace_back([&state] { state.Worker(); });
+
+    bool stopped = false;
+    while (!state.WaitDone(std::chrono::milliseconds(100))) {
+        if (on_tick) on_tick();
+        if (should_stop && should_stop()) {
+            stopped = true;
+            break;
+        }
+    }
+    state.Stop();
+    for (auto& t : workers) t.join();
+    state.Drop();     // jobs cut off by a stop; their descriptors close with them
+    return !stopped;
+}
+
+} // namespace RedTops
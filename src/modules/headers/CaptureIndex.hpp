@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace RedTops {
+
+struct DissectedPacket;
+class PcapReader;
+
+// A conversation given as "addr:port-addr:port" (IPv6 as "[addr]:port").
+// Direction-insensitive: matches both halves of the exchange.
+struct FlowFilter {
+    bool ipv6 = false;
+    uint8_t addr[2][16] = {};
+    uint16_t port[2] = {};
+
+    bool Matches(const DissectedPacket& pkt) const;
+    uint32_t Hash() const;
+};
+
+// Throws CommandError on malformed text
+FlowFilter ParseFlowFilter(const std::string& text);
+
+// Direction-insensitive hash of a packet's addresses and ports, 0 when the
+// packet carries no ports (ARP, ICMP, fragments)
+uint32_t PacketFlowHash(const DissectedPacket& pkt);
+
+// Sidecar index for a pcap file, stored next to it as <file>.rtidx.
+//
+// The capture is cut into record-aligned blocks of roughly kBlockBytes. For
+// each block the index keeps its file offset and the time span it covers; for
+// each flow hash it keeps the sorted list of blocks the flow appears in. A
+// time or flow query then touches only the matching blocks of the mapping.
+class CaptureIndexBuilder {
+public:
+    static constexpr uint32_t kBlockBytes = 256 * 1024;
+
+    void Add(uint64_t offset, uint64_t ts_ns, uint32_t flow_hash);
+
+    // Writes atomically (temp file + rename); throws CommandError on I/O failure
+    void Write(const std::string& index_path, uint64_t pcap_size, int64_t pcap_mtime_ns) const;
+
+    // Writes the sidecar for a finished, closed capture file
+    void WriteFor(const std::string& pcap_path) const;
+
+    size_t Blocks() const { return blocks_.size(); }
+    size_t Flows() const { return postings_.size(); }
+
+private:
+    struct Block {
+        uint64_t offset;
+        uint64_t first_ns;
+        uint64_t last_ns;
+        uint32_t packets;
+        uint32_t reserved;
+    };
+
+    std::vector<Block> blocks_;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> postings_;
+};
+
+class CaptureIndex {
+public:
+    CaptureIndex() = default;
+    ~CaptureIndex();
+
+    CaptureIndex(const CaptureIndex&) = delete;
+    CaptureIndex& operator=(const CaptureIndex&) = delete;
+
+    static std::string PathFor(const std::string& pcap_path) { return pcap_path + ".rtidx"; }
+
+    // Indexes every record of the capture and writes the sidecar
+    static void Build(const PcapReader& reader, const std::string& index_path);
+
+    // Maps the sidecar; false if it is missing, corrupt or stale for this pcap
+    bool Open(const std::string& index_path, uint64_t pcap_size, int64_t pcap_mtime_ns);
+
+    // Blocks overlapping [since_ns, until_ns] that may hold flow_hash (0 = any flow)
+    std::vector<uint32_t> Candidates(uint64_t since_ns, uint64_t until_ns, uint32_t flow_hash) const;
+
+    uint32_t BlockCount() const { return block_count_; }
+    uint32_t FlowCount() const { return flow_count_; }
+    uint64_t BlockOffset(uint32_t block) const;
+    uint64_t BlockEnd(uint32_t block) const;     // offset of the next block, or the pcap size
+    uint64_t FirstTimestamp() const;
+
+private:
+    void Close();
+
+    const uint8_t* map_ = nullptr;
+    size_t map_size_ = 0;
+    uint64_t pcap_size_ = 0;
+    uint32_t block_count_ = 0;
+    uint32_t flow_count_ = 0;
+    const uint8_t* blocks_ = nullptr;
+    const uint8_t* flows_ = nullptr;
+    const uint8_t* postings_ = nullptr;
+    uint64_t posting_count_ = 0;
+};
+
+} // namespace RedTops
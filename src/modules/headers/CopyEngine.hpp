@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace RedTops {
+
+// How a file's data was moved
+enum class CopyMethod {
+    Clone,          // FICLONE reflink: extents shared, no data read
+    CopyRange,      // copy_file_range(2): copied inside the kernel
+    ReadWrite       // plain read/write fallback
+};
+
+// Optional hooks for long copies: copied grows as data lands in out, and
+// stop is checked between chunks. A stopped copy fails with errno EINTR.
+struct CopyControl {
+    std::atomic<uint64_t>* copied = nullptr;
+    const std::atomic<bool>* stop = nullptr;
+};
+
+// Copies size bytes from in to out (both at offset 0): reflink first when
+// allow_clone, then copy_file_range, then read/write when the filesystems
+// support neither. Returns false with errno set on failure.
+bool CopyFileData(int in, int out, uint64_t size, bool allow_clone, CopyMethod& method,
+                  const CopyControl& control = {});
+
+struct CopyStats {
+    uint64_t files = 0;
+    uint64_t bytes = 0;
+    uint64_t dirs = 0;
+    uint64_t symlinks = 0;
+    uint64_t cloned = 0;        // files shared by reflink
+    uint64_t skipped = 0;       // sockets, devices and FIFOs
+    uint64_t errors = 0;
+};
+
+// Parallel recursive copy on top of TreeWalker: directories are listed with
+// getdents64 by a worker pool, every file is copied by whichever worker
+// picks up its batch, and data moves through CopyFileData so no bytes pass
+// through user space when the kernel can avoid it. Symlinks are recreated,
+// not followed; modes are preserved, directory modes once their contents
+// are in place.
+class CopyEngine {
+public:
+    explicit CopyEngine(unsigned threads = 0, bool allow_clone = true);
+
+    // Copies the contents of the directory src into dst, creating dst if
+    // needed. Returns false if should_stop() ended it early. Per-file
+    // failures are counted and kept in Errors(); throws CommandError only if
+    // src or dst cannot be opened.
+    bool CopyTree(const std::string& src, const std::string& dst,
+                  const std::function<bool()>& should_stop = {},
+                  const std::function<void()>& on_tick = {});
+
+    // Copies one regular file with its mode; throws CommandError, also when
+    // dst is src under another name
+    void CopyFile(const std::string& src, const std::string& dst);
+
+    // Consistent enough for progress output while a copy runs
+    CopyStats Stats() const;
+    // The first few failures, "path: reason"
+    std::vector<std::string> Errors() const;
+
+    unsigned Threads() const { return threads_; }
+
+private:
+    void CopyEntry(int src_dir, const std::string& name, const std::string& rel, uint8_t type);
+    void Fail(const std::string& path, int err);
+    void Fail(const std::string& path, const std::string& reason);
+
+    unsigned threads_;
+    bool allow_clone_;
+    int dst_root_ = -1;
+
+    std::atomic<uint64_t> files_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> dirs_{0};
+    std::atomic<uint64_t> symlinks_{0};
+    std::atomic<uint64_t> cloned_{0};
+    std::atomic<uint64_t> skipped_{0};
+    std::atomic<uint64_t> errors_{0};
+
+    mutable std::mutex errors_mutex_;
+    std::vector<std::string> error_messages_;
+};
+
+} // namespace RedTops
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace RedTops {
+
+enum class HashAlgorithm {
+    Xxh3,           // XXH3-64, seed 0: fast integrity checks, not cryptographic
+    Sha256,
+    Blake3          // 256-bit output
+};
+
+// "xxh3", "sha256" or "blake3"; false for anything else
+bool ParseHashAlgorithm(std::string_view name, HashAlgorithm& algorithm);
+const char* HashAlgorithmName(HashAlgorithm algorithm);
+
+// One-shot digests of a whole buffer, as raw bytes in the order their hex
+// form is printed (XXH3 big-endian, like xxhsum)
+std::vector<uint8_t> Xxh3Digest(const void* data, size_t len);
+std::vector<uint8_t> Sha256Digest(const void* data, size_t len);
+// BLAKE3 is a tree over 1 KiB chunks, so the two halves of a large input
+// are hashed on separate threads with the same result as a serial pass
+std::vector<uint8_t> Blake3Digest(const void* data, size_t len, unsigned threads = 1);
+
+std::vector<uint8_t> ComputeDigest(HashAlgorithm algorithm, const void* data, size_t len, unsigned threads = 1);
+
+// Leaf size of the tree mode for algorithms without a tree of their own
+constexpr size_t kDigestTreeLeaf = 16 * 1024 * 1024;
+
+// Tree mode for XXH3 and SHA-256: the digest of the concatenated digests of
+// each kDigestTreeLeaf slice, which lets one large file use several cores.
+// It is a different value from the plain digest; BLAKE3 is returned as is.
+std::vector<uint8_t> TreeDigest(HashAlgorithm algorithm, const void* data, size_t len, unsigned threads);
+
+std::string ToHex(const std::vector<uint8_t>& bytes);
+
+// Whether the AVX2 and SHA-extension paths may be used where the CPU has
+// them (the default); tests turn them off to check them against the scalar
+// code. Not for use while digests are being computed.
+void SetDigestSimd(bool enabled);
+
+} // namespace RedTops
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace RedTops {
+
+struct ListedEntry {
+    uint32_t name_offset = 0;   // into DirListing's name arena
+    uint32_t name_length = 0;
+    uint8_t type = 0;           // DT_* from getdents64, refined by statx
+    bool has_stat = false;      // statx succeeded
+    uint32_t mode = 0;          // st_mode, symlinks not followed
+    uint64_t size = 0;
+    int64_t mtime_ns = 0;
+};
+
+// The entries of one directory, read for listing.
+//
+// Names come from getdents64 into a single arena, so a million-entry
+// directory is one allocation for names plus one for the entry table. When
+// attributes are wanted, each entry gets exactly one statx(2) asking only for
+// type, mode, size and mtime with AT_STATX_DONT_SYNC; large directories
+// spread those calls over a few threads.
+class DirListing {
+public:
+    // Throws CommandError if path cannot be opened or listed
+    static DirListing Read(const std::string& path, bool include_hidden, bool with_stat, unsigned threads = 0);
+
+    size_t Size() const { return entries_.size(); }
+    const ListedEntry& operator[](size_t i) const { return entries_[i]; }
+    const std::vector<ListedEntry>& Entries() const { return entries_; }
+
+    std::string_view Name(const ListedEntry& e) const {
+        return std::string_view(names_.data() + e.name_offset, e.name_length);
+    }
+
+private:
+    std::string names_;
+    std::vector<ListedEntry> entries_;
+};
+
+// One statx for a path named on the command line, following symlinks like
+// ls(1) does for its operands; false if it fails
+bool StatEntry(const std::string& path, ListedEntry& out);
+
+} // namespace RedTops
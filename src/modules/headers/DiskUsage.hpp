@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace RedTops {
+
+// One directory and everything below it
+struct UsageEntry {
+    std::string path;           // relative to the scanned root; empty for the root
+    uint64_t bytes = 0;
+    uint64_t files = 0;
+    bool complete = true;       // false if part of it could not be read
+};
+
+struct UsageStats {
+    uint64_t files = 0;         // everything that is not a directory
+    uint64_t dirs = 0;
+    uint64_t bytes = 0;         // total of the root
+    uint64_t hardlinks = 0;     // extra links not counted again
+    uint64_t errors = 0;
+};
+
+// Parallel `du` on top of TreeWalker. Every entry gets one statx(2) for
+// blocks, size, link count and inode, relative to its open directory; files
+// with more than one link are counted once through a sharded (dev, ino) set.
+// Sizes roll up in post-order: a directory's running total lives only while
+// the walk is inside it and is folded into its parent when it is left, so
+// memory grows with the directories in flight, the hardlinked files and the
+// top-N list — never with the number of files.
+class DiskUsage {
+public:
+    struct Options {
+        bool apparent = false;      // st_size instead of allocated blocks
+        bool one_filesystem = false;
+        size_t top = 20;            // heaviest subtrees to keep
+        unsigned threads = 0;
+    };
+
+    explicit DiskUsage(Options options);
+    ~DiskUsage();
+
+    // Scans the directory path. Returns false if should_stop() ended it
+    // early; per-entry failures are counted and kept in Errors(); throws
+    // CommandError if path cannot be opened.
+    bool Scan(const std::string& path,
+              const std::function<bool()>& should_stop = {},
+              const std::function<void()>& on_tick = {});
+
+    // Consistent enough for progress output while a scan runs
+    UsageStats Stats() const;
+    // The heaviest subtrees, the root included, largest first
+    std::vector<UsageEntry> Top() const;
+    // The first few failures, "path: reason"
+    std::vector<std::string> Errors() const;
+
+    unsigned Threads() const { return threads_; }
+
+private:
+    struct Totals;
+    struct Shard;
+
+    Totals* Find(const std::string& path);
+    std::unique_ptr<Totals> Take(const std::string& path);
+    void Offer(UsageEntry entry);
+    bool FirstLink(uint64_t dev, uint64_t ino);
+    void Fail(const std::string& path, int err);
+
+    Options options_;
+    unsigned threads_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    mutable std::mutex top_mutex_;
+    std::vector<UsageEntry> top_;       // min-heap on bytes
+    UsageEntry root_;
+
+    std::atomic<uint64_t> files_{0};
+    std::atomic<uint64_t> dirs_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> hardlinks_{0};
+    std::atomic<uint64_t> errors_{0};
+
+    mutable std::mutex errors_mutex_;
+    std::vector<std::string> error_messages_;
+};
+
+} // namespace RedTops
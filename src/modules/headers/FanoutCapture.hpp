@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace RedTops {
+
+struct DissectedPacket;
+class PacketRing;
+
+// How the kernel spreads packets across the sockets of a PACKET_FANOUT group
+enum class FanoutMode {
+    Hash,       // flow hash, keeps a connection on one worker
+    Cpu,        // the CPU that received the packet
+    RoundRobin  // strict rotation
+};
+
+struct FanoutOptions {
+    std::string interface;
+    unsigned workers = 0;           // 0 = one per online core
+    FanoutMode mode = FanoutMode::Hash;
+    bool pin_workers = false;       // pin worker N to core N
+    uint64_t max_packets = 0;       // 0 = until stopped
+    bool promiscuous = true;
+
+    // Optional per-packet hook, called on the worker's own thread
+    std::function<void(unsigned worker, const DissectedPacket& pkt, const uint8_t* frame, uint64_t ts_us)> on_packet;
+};
+
+struct FanoutWorkerStats {
+    int cpu = -1;                   // pinned core, -1 when unpinned
+    uint64_t packets = 0;
+    uint64_t bytes = 0;
+    uint64_t ipv4 = 0;
+    uint64_t ipv6 = 0;
+    uint64_t tcp = 0;
+    uint64_t udp = 0;
+    uint64_t icmp = 0;
+    uint64_t other = 0;
+    uint64_t kernel_drops = 0;      // from PACKET_STATISTICS
+
+    FanoutWorkerStats& operator+=(const FanoutWorkerStats& o);
+};
+
+// Parses "hash" / "cpu" / "rr"; throws CommandError on anything else
+FanoutMode ParseFanoutMode(const std::string& name);
+const char* FanoutModeName(FanoutMode mode);
+
+// N AF_PACKET sockets joined to one fanout group, each drained by its own
+// thread through a TPACKET_V3 mmap ring. Linux only; needs CAP_NET_RAW.
+class FanoutCapture {
+public:
+    explicit FanoutCapture(FanoutOptions options);
+    ~FanoutCapture();
+
+    FanoutCapture(const FanoutCapture&) = delete;
+    FanoutCapture& operator=(const FanoutCapture&) = delete;
+
+    // Opens and maps every socket; throws NetworkError / PermissionError
+    void Open();
+
+    // Blocks until max_packets is reached or should_stop() returns true.
+    // on_tick is called roughly once per second from the calling thread.
+    void Run(const std::function<bool()>& should_stop,
+             const std::function<void(uint64_t packets)>& on_tick = {});
+
+    const FanoutOptions& Options() const { return options_; }
+    const std::vector<FanoutWorkerStats>& WorkerStats() const { return stats_; }
+    FanoutWorkerStats Totals() const;
+
+private:
+    void WorkerLoop(unsigned index);
+    void Close();
+
+    FanoutOptions options_;
+    std::vector<std::unique_ptr<PacketRing>> rings_;
+    std::vector<FanoutWorkerStats> stats_;
+    bool skip_outgoing_ = false;
+    std::atomic<bool> stop_{false};
+    std::atomic<uint64_t> captured_{0};
+};
+
+} // namespace RedTops
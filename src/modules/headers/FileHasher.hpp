@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Digest.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace RedTops {
+
+struct HashResult {
+    std::string path;
+    std::string digest;         // lowercase hex; empty when error is set
+    uint64_t bytes = 0;
+    std::string error;
+};
+
+struct HashStats {
+    uint64_t files = 0;         // hashed so far
+    uint64_t bytes = 0;
+    uint64_t errors = 0;
+};
+
+// Hashes many files at once, or one large file on many cores.
+//
+// Small files are read in one read(2) and larger ones mapped read-only with
+// sequential read-ahead requested, so the kernel fills pages ahead of the
+// hash. Files are spread over a pool of workers, one file per worker; when
+// the digest can be split (BLAKE3, or any algorithm in tree mode) files of
+// kSplitMin bytes or more are instead hashed one at a time by every worker.
+class FileHasher {
+public:
+    struct Options {
+        HashAlgorithm algorithm = HashAlgorithm::Blake3;
+        bool tree = false;          // TreeDigest instead of the plain digest
+        unsigned threads = 0;       // 0: one per online core
+    };
+
+    static constexpr uint64_t kSplitMin = 64ull * 1024 * 1024;
+
+    explicit FileHasher(Options options);
+
+    // Expands directories into the regular files below them, sorted by path;
+    // files named directly are kept as given, symlinks below a directory are
+    // skipped. Unreadable directories are counted in Errors().
+    std::vector<std::string> Collect(const std::vector<std::string>& paths,
+                                     const std::function<bool()>& should_stop = {});
+
+    // One result per file, in the order given. Returns false if
+    // should_stop() ended it early; the remaining results are then empty.
+    // should_stop and on_tick run on the calling thread about every 100 ms.
+    bool Hash(const std::vector<std::string>& files, std::vector<HashResult>& results,
+              const std::function<bool()>& should_stop = {},
+              const std::function<void()>& on_tick = {});
+
+    HashStats Stats() const;
+    // The first few failures, "path: reason"
+    std::vector<std::string> Errors() const;
+
+    unsigned Threads() const { return threads_; }
+
+private:
+    void HashOne(const std::string& path, unsigned threads, HashResult& result);
+    void Fail(const std::string& path, const std::string& reason);
+
+    Options options_;
+    unsigned threads_;
+
+    std::atomic<uint64_t> files_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> errors_{0};
+
+    mutable std::mutex errors_mutex_;
+    std::vector<std::string> error_messages_;
+};
+
+} // namespace RedTops
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace RedTops {
+
+class IgnoreRules;
+class TextMatcher;
+
+// One matching line; the views point into the file being scanned and are
+// only valid during the callback that receives them
+struct LineMatch {
+    uint64_t line = 0;          // 1-based
+    size_t column = 0;          // 1-based byte column of the first match
+    std::string_view text;      // the whole line without its newline
+    size_t match_length = 0;
+};
+
+// Scans one buffer line by line. Stops after max_lines matching lines (0
+// for no limit); returns how many lines matched. Lines are only collected
+// when out is non-null.
+uint64_t ScanBuffer(const TextMatcher& matcher, const char* data, size_t len, uint64_t max_lines,
+                    std::vector<LineMatch>* out);
+
+struct SearchStats {
+    uint64_t files = 0;         // files scanned (or listed, without a pattern)
+    uint64_t bytes = 0;
+    uint64_t matched_files = 0;
+    uint64_t matched_lines = 0;
+    uint64_t errors = 0;
+};
+
+// Parallel grep/find over a tree on top of TreeWalker.
+//
+// Each worker opens the files of its batch relative to their directory
+// descriptor, reads small ones in one read(2) and mmaps the rest, and hands
+// the buffer to the matcher. .gitignore files are read as the walk enters
+// each directory and chained to their parents', so ignored directories are
+// never listed at all; .git itself is always skipped. Symlinks are not
+// followed.
+class FileSearcher {
+public:
+    struct Options {
+        bool use_ignore_files = true;
+        std::vector<std::string> excludes;      // gitignore syntax, relative to the root
+        std::vector<std::string> includes;      // when set, a file must match one
+        uint64_t max_per_file = 0;              // matching lines per file, 0 = all
+        bool collect_lines = true;              // false for counts and file lists
+        unsigned threads = 0;
+    };
+
+    // Called from worker threads once per file with at least one match (or,
+    // with no matcher, once per file that passes the filters). binary is set
+    // when the file has a NUL byte near its start; its scan stops at the
+    // first match and no lines are collected.
+    using FileCallback = std::function<void(const std::string& path, uint64_t matches,
+                                            const std::vector<LineMatch>& lines, bool binary)>;
+
+    // A null matcher lists files instead of searching them
+    FileSearcher(const TextMatcher* matcher, Options options);
+    ~FileSearcher();
+
+    // Searches root, a directory or a single file. Paths are reported under
+    // root as given ("." is left off). Returns false if should_stop() ended
+    // it early; throws CommandError if root cannot be opened.
+    bool Search(const std::string& root, const FileCallback& on_file,
+                const std::function<bool()>& should_stop = {},
+                const std::function<void()>& on_tick = {});
+
+    SearchStats Stats() const;
+    // The first few failures, "path: reason"
+    std::vector<std::string> Errors() const;
+
+    unsigned Threads() const { return threads_; }
+
+private:
+    void ScanFile(int dir_fd, const std::string& name, const std::string& path, const FileCallback& on_file);
+    bool Excluded(std::string_view rel, std::string_view name, bool is_dir,
+                  const std::shared_ptr<const IgnoreRules>& rules) const;
+    void Fail(const std::string& path, int err);
+
+    const TextMatcher* matcher_;
+    Options options_;
+    unsigned threads_;
+    std::unique_ptr<IgnoreRules> excludes_;
+
+    // Ignore-file rules of the directories currently being walked
+    std::mutex rules_mutex_;
+    std::unordered_map<std::string, std::shared_ptr<const IgnoreRules>> rules_;
+
+    std::atomic<uint64_t> files_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> matched_files_{0};
+    std::atomic<uint64_t> matched_lines_{0};
+    std::atomic<uint64_t> errors_{0};
+
+    mutable std::mutex errors_mutex_;
+    std::vector<std::string> error_messages_;
+};
+
+} // namespace RedTops
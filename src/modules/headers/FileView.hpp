@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace RedTops {
+
+class TextMatcher;
+
+struct IndexProgress {
+    uint64_t bytes = 0;         // indexed so far
+    uint64_t lines = 0;         // complete lines in those bytes
+    bool done = false;
+};
+
+// Random access to the lines of a file of any size, for the pager.
+//
+// The file is mapped read-only and navigated by byte offset: moving a line
+// up or down is a memchr/memrchr away, so scrolling and percentage jumps
+// never wait for an index. Line numbers come from a sparse index built on a
+// background thread, which records the offset of every stride-th line and
+// doubles the stride whenever kMaxCheckpoints is reached; any line is then
+// at most one stride of newlines from a checkpoint, and the index stays a
+// few hundred KiB whatever the size of the file. The mapping is only paged
+// in where it is read, so resident memory follows what is shown and
+// searched, not the file size.
+//
+// A file that shrinks under the view (truncated, or rotated by copytruncate)
+// would fault with SIGBUS past its new end. The indexer and Search check the
+// size between blocks and give up on a shrunk file; Refresh() then clamps
+// the view to the new size, backs the lost tail of the mapping with zero
+// pages and restarts the index. Growth is not followed.
+class FileView {
+public:
+    static constexpr size_t kMaxCheckpoints = 64 * 1024;
+
+    // Maps path; throws CommandError if it cannot be opened or mapped
+    explicit FileView(const std::string& path);
+    ~FileView();
+    FileView(const FileView&) = delete;
+    FileView& operator=(const FileView&) = delete;
+
+    // Starts the background indexer; a no-op once it has run
+    void StartIndexing();
+    IndexProgress Progress() const;
+
+    // Re-checks the file size; true if it shrank and the view was clamped
+    // to it. Call before navigating; offsets past Size() are then invalid.
+    bool Refresh();
+
+    const char* Data() const { return data_; }
+    uint64_t Size() const { return size_; }
+
+    // Start of the line containing offset
+    uint64_t LineStart(uint64_t offset) const;
+    // Start of the next line, or Size() on the last line
+    uint64_t NextLine(uint64_t offset) const;
+    // Start of the previous line, or 0 on the first
+    uint64_t PrevLine(uint64_t offset) const;
+    // The line starting at offset, without its newline
+    std::string_view Line(uint64_t offset) const;
+
+    // Offset of 0-based line; false past the end, or past the part of the
+    // file indexed so far
+    bool LineOffset(uint64_t line, uint64_t& offset) const;
+    // 0-based number of the line containing offset; false if the indexer
+    // has not reached it yet
+    bool LineNumber(uint64_t offset, uint64_t& line) const;
+
+    // First match starting at or after from (forward), or the last one
+    // starting before from (backward). The scan runs in line-aligned slices
+    // with should_stop() checked between them. Returns kNoMatch if there is
+    // none, the search was stopped or the file shrank meanwhile.
+    uint64_t Search(const TextMatcher& matcher, uint64_t from, bool forward, size_t& match_len,
+                    const std::function<bool()>& should_stop = {}) const;
+
+private:
+    void Index();
+    // Whether the file no longer reaches end
+    bool Shrunk(uint64_t end) const;
+
+    int fd_ = -1;
+    const char* data_ = nullptr;
+    uint64_t size_ = 0;
+    uint64_t map_size_ = 0;
+
+    mutable std::mutex index_mutex_;
+    std::vector<uint64_t> checkpoints_;     // checkpoints_[k]: start of line k * stride_
+    uint64_t stride_ = 256;
+    std::atomic<uint64_t> indexed_bytes_{0};
+    std::atomic<uint64_t> indexed_lines_{0};
+    std::atomic<bool> done_{false};
+    std::atomic<bool> stop_{false};
+    std::thread indexer_;
+};
+
+} // namespace RedTops
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace RedTops {
+
+struct CpuCache {
+    unsigned level = 0;
+    std::string type;            // Data, Instruction, Unified
+    uint64_t size_bytes = 0;
+    unsigned line_size = 0;
+    unsigned ways = 0;
+    unsigned shared_by = 0;      // logical CPUs sharing one instance
+    unsigned instances = 0;      // distinct instances across the machine
+};
+
+struct LogicalCpu {
+    int id = 0;
+    int socket = 0;
+    int core = 0;                // core id within the socket
+    int node = 0;                // NUMA node
+    double bogomips = 0;
+    size_t flag_set = 0;         // index into HardwareInventory::flag_sets
+};
+
+// Static hardware facts from /proc/cpuinfo and /sys/devices/system/cpu.
+//
+// /proc/cpuinfo is read in one go and parsed with string_views; topology comes
+// from sysfs when present and falls back to cpuinfo's physical/core ids. None
+// of this changes while the process runs, so it is gathered once and cached.
+struct HardwareInventory {
+    std::string model;
+    std::string vendor;
+    std::string microcode;
+    uint64_t cache_size_bytes = 0;   // cpuinfo's "cache size" for the first CPU
+
+    std::vector<LogicalCpu> cpus;
+    // CPUs usually share one flag list; each distinct list is stored once
+    std::vector<std::string> flag_sets;
+    std::vector<CpuCache> caches;    // the hierarchy seen from the first CPU
+
+    unsigned sockets = 0;
+    unsigned physical_cores = 0;
+    unsigned numa_nodes = 0;
+    unsigned threads_per_core = 0;
+
+    // Gathered on first use; later calls return the same object
+    static const HardwareInventory& Get();
+
+    // Parses cpuinfo text into an inventory without touching sysfs
+    static HardwareInventory FromCpuInfo(std::string_view text);
+};
+
+// "0-3,8,10-11" -> {0,1,2,3,8,10,11}
+std::vector<int> ParseCpuList(std::string_view text);
+
+} // namespace RedTops
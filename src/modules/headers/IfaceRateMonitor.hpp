@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ProcSampler.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace RedTops {
+
+// Per-second rates derived from two snapshots of an interface's counters
+struct IfaceRates {
+    double rx_bps = 0, tx_bps = 0;       // bits per second
+    double rx_pps = 0, tx_pps = 0;
+    double rx_errors = 0, tx_errors = 0;
+    double rx_drops = 0, tx_drops = 0;
+};
+
+// Throughput monitor over /sys/class/net/<if>/statistics.
+//
+// Every counter file is opened once and re-read with pread, so a sample is a
+// handful of small syscalls per interface and touches no allocator: counters,
+// rates and the sparkline history all live in storage sized at construction.
+class IfaceRateMonitor {
+public:
+    static constexpr size_t kHistory = 120;   // samples kept for the sparkline
+
+    // Empty names = every interface under /sys/class/net
+    explicit IfaceRateMonitor(const std::vector<std::string>& names);
+
+    // Reads all counters; the first call only primes them
+    void Sample();
+
+    // Rates over everything sampled since the previous call (the display period)
+    void EndWindow();
+
+    size_t Count() const { return ifaces_.size(); }
+    const std::string& Name(size_t i) const { return ifaces_[i].name; }
+    bool Up(size_t i) const { return ifaces_[i].up; }
+    const IfaceRates& Window(size_t i) const { return ifaces_[i].window; }
+    const IfaceRates& Instant(size_t i) const { return ifaces_[i].instant; }
+
+    // rx+tx bits per second of the age-th most recent sample (0 = newest)
+    double History(size_t i, size_t age) const;
+    size_t HistoryLength() const { return history_len_; }
+
+private:
+    enum Counter { RxBytes, TxBytes, RxPackets, TxPackets, RxErrors, TxErrors, RxDropped, TxDropped, kCounters };
+    using Snapshot = std::array<uint64_t, kCounters>;
+
+    struct Iface {
+        std::string name;
+        std::array<ProcFile, kCounters> files;
+        Snapshot last{};          // previous sample
+        Snapshot mark{};          // start of the current window
+        bool up = true;
+        IfaceRates instant;
+        IfaceRates window;
+        std::array<double, kHistory> history{};
+    };
+
+    static IfaceRates Rates(const Snapshot& from, const Snapshot& to, double seconds);
+
+    std::vector<Iface> ifaces_;
+    uint64_t last_ns_ = 0;
+    uint64_t mark_ns_ = 0;
+    size_t history_pos_ = 0;
+    size_t history_len_ = 0;
+};
+
+} // namespace RedTops
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace RedTops {
+
+// Shell-style match of a whole string: '*', '?' and [...] classes stay
+// within one path component, "**" crosses '/', and a backslash escapes the
+// next character.
+bool GlobMatch(std::string_view pattern, std::string_view text);
+
+// One directory's .gitignore, chained to the rules of the directories above
+// it. Follows git's reading of the file: later lines win, '!' re-includes,
+// a trailing '/' matches only directories, and a pattern with a '/' before
+// its end is anchored to the directory holding the file while one without
+// matches a name at any depth. Deeper files take precedence over shallower
+// ones.
+class IgnoreRules {
+public:
+    // base is the directory the rules belong to, relative to the walk root
+    // ("" for the root itself)
+    IgnoreRules(std::string base, std::string_view text, std::shared_ptr<const IgnoreRules> parent = nullptr);
+
+    // Reads the ignore file at file (relative to at_fd) holding the rules of
+    // base; returns parent unchanged when there is none, so rule chains only
+    // grow where a file exists
+    static std::shared_ptr<const IgnoreRules> Load(int at_fd, const std::string& file, const std::string& base,
+                                                   std::shared_ptr<const IgnoreRules> parent);
+
+    // path is relative to the walk root
+    bool Ignored(std::string_view path, bool is_dir) const;
+
+    bool Empty() const { return rules_.empty(); }
+
+private:
+    struct Rule {
+        std::string glob;
+        bool negate = false;
+        bool dir_only = false;
+        bool anchored = false;
+    };
+
+    // 1 ignored, -1 re-included, 0 no rule here or above matched
+    int Decide(std::string_view path, bool is_dir) const;
+
+    std::string base_;
+    std::vector<Rule> rules_;
+    std::shared_ptr<const IgnoreRules> parent_;
+};
+
+} // namespace RedTops
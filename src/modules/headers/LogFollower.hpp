@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace RedTops {
+
+class TextMatcher;
+
+struct FollowStats {
+    uint64_t bytes = 0;         // read since Start, the initial lines included
+    uint64_t lines = 0;         // complete lines read
+    uint64_t shown = 0;         // lines that passed the filter
+    uint64_t rotations = 0;     // files replaced under their name
+    uint64_t truncations = 0;
+};
+
+// `tail -F` for several files, driven by inotify(7) rather than a stat
+// loop.
+//
+// Each file is watched for writes, and its directory for a new file under
+// the same name. A write reads only the bytes past the last offset, with
+// pread(2) in large blocks; complete lines are passed to the handler and an
+// unterminated tail is held until its newline arrives. With a matcher, a
+// whole block is searched at once and only matching lines are extracted, so
+// filtering costs about as much as one memchr pass over the new data.
+//
+// A file that shrinks below the offset was truncated (copytruncate) and is
+// read again from the start; as with tail, a truncation that is refilled
+// past the old offset before it is seen cannot be told from an append. When a new file appears under a followed name
+// (rename-and-create rotation), the old one is drained and the new one
+// followed from its beginning. Files missing at Start are picked up when
+// they are created.
+class LogFollower {
+public:
+    struct Options {
+        const TextMatcher* matcher = nullptr;   // show only matching lines
+        size_t initial_lines = 10;              // shown from the end of each file at Start
+    };
+
+    // Callbacks run on the calling thread, from Start and Poll
+    struct Handler {
+        // One line without its newline; the view is only valid during the call
+        std::function<void(size_t file, std::string_view line)> line;
+        // Rotation, truncation, a missing or reappearing file
+        std::function<void(size_t file, const std::string& message)> notice;
+        // After each batch of lines, to write buffered output
+        std::function<void()> flush;
+    };
+
+    LogFollower(std::vector<std::string> paths, Options options);
+    ~LogFollower();
+    LogFollower(const LogFollower&) = delete;
+    LogFollower& operator=(const LogFollower&) = delete;
+
+    // Sets up the watches and emits the last lines of each file. Throws
+    // CommandError if inotify is unavailable or no file or directory can be
+    // watched at all.
+    void Start(const Handler& handler);
+    // Waits up to timeout_ms for changes and handles all of them. Returns
+    // false if nothing changed.
+    bool Poll(const Handler& handler, int timeout_ms);
+    // Polls until should_stop(), which is checked about every 100 ms
+    void Follow(const Handler& handler, const std::function<bool()>& should_stop);
+    // Emits the held-back unterminated lines, when not following any further
+    void Drain(const Handler& handler);
+
+    const std::string& Path(size_t file) const { return files_[file].path; }
+    FollowStats Stats() const { return stats_; }
+
+private:
+    struct File {
+        std::string path;
+        std::string name;       // last component, as reported by directory events
+        int fd = -1;
+        int wd = -1;            // watch on the file itself
+        int dir_wd = -1;
+        dev_t dev = 0;
+        ino_t ino = 0;
+        off_t offset = 0;
+        std::string partial;    // an unterminated last line
+        bool gone = false;      // its name no longer leads to it
+    };
+
+    bool Open(size_t i, const Handler& handler);
+    void Close(size_t i);
+    void ReadNew(size_t i, const Handler& handler);
+    void Emit(size_t i, const char* data, size_t len, const Handler& handler);
+    void CheckReplaced(size_t i, const Handler& handler);
+    off_t TailOffset(int fd, off_t size) const;
+
+    std::vector<File> files_;
+    Options options_;
+    int inotify_ = -1;
+    std::unordered_map<int, std::vector<size_t>> watches_;     // watch descriptor to files
+    std::vector<char> buf_;
+    FollowStats stats_;
+};
+
+} // namespace RedTops
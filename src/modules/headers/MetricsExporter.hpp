@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace RedTops {
+
+// Builds one exposition in the OpenMetrics text format: a family header
+// (# TYPE / # HELP) followed by its samples, terminated by "# EOF".
+class MetricsWriter {
+public:
+    enum class Type { Gauge, Counter };
+    using Label = std::pair<std::string_view, std::string_view>;
+
+    // Starts a metric family. Counter samples get the "_total" suffix.
+    void Family(std::string_view name, Type type, std::string_view help);
+    void Sample(double value, std::initializer_list<Label> labels = {});
+
+    size_t Size() const { return out_.size(); }
+    void Truncate(size_t size) { out_.resize(size); }
+
+    // Appends "# EOF" and hands over the text
+    std::string Finish();
+
+private:
+    std::string out_;
+    std::string name_;
+    Type type_ = Type::Gauge;
+};
+
+// Serves /metrics over HTTP on a local socket.
+//
+// A sampler thread runs the collectors every interval and renders the whole
+// exposition into a fresh string, which is then published with one atomic
+// shared_ptr swap. The server thread (a single epoll loop) answers each
+// scrape from whichever buffer is current, so a slow collector — a probe
+// waiting on its timeout, say — never delays a scrape, and a scrape never
+// touches the samplers.
+class MetricsExporter {
+public:
+    using Collector = std::function<void(MetricsWriter&)>;
+
+    // listen is "host:port", "[v6]:port" or ":port" (loopback); port 0 picks one
+    MetricsExporter(const std::string& listen, int interval_ms);
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    // Collectors run in the order added. One that throws is dropped from that
+    // render and reported through redtops_exporter_collector_success.
+    void AddCollector(const std::string& name, Collector collect);
+
+    // Binds, renders once, then starts both threads. Throws NetworkError.
+    void Start();
+    void Stop();
+
+    std::string Address() const { return address_; }   // as bound, e.g. "127.0.0.1:9100"
+    uint64_t Scrapes() const { return scrapes_; }
+    uint64_t Renders() const { return renders_; }
+    double LastRenderMs() const { return last_render_ms_; }
+    size_t LastSize() const;
+
+private:
+    struct Connection;
+
+    void Render();
+    void SamplerLoop();
+    void ServerLoop();
+    void Accept();
+    bool Receive(Connection& c);
+    bool Send(Connection& c);
+    void Respond(Connection& c);
+
+    std::string listen_;
+    std::string address_;
+    int interval_ms_;
+    std::vector<std::pair<std::string, Collector>> collectors_;
+
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;                          // eventfd that ends the server loop
+    std::atomic<std::shared_ptr<const std::string>> current_;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections_;   // server thread only
+
+    std::thread sampler_;
+    std::thread server_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+
+    std::atomic<uint64_t> scrapes_{0};
+    std::atomic<uint64_t> renders_{0};
+    std::atomic<double> last_render_ms_{0};
+};
+
+} // namespace RedTops
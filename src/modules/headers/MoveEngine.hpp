@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/stat.h>
+
+namespace RedTops {
+
+struct MoveStats {
+    uint64_t files = 0;         // regular files copied
+    uint64_t bytes = 0;
+    uint64_t verified = 0;      // bytes read back and compared
+    uint64_t dirs = 0;
+    uint64_t symlinks = 0;
+    uint64_t links = 0;         // extra hard links recreated rather than copied
+    uint64_t specials = 0;      // FIFOs, sockets and device nodes
+    uint64_t errors = 0;
+};
+
+// What mv falls back to when rename(2) fails with EXDEV: a copy to the other
+// filesystem that is only allowed to replace the source once it is known to
+// be good.
+//
+// Each file goes through CopyFileData (copy_file_range, or read/write where
+// that cannot span the two filesystems) and gets its owner, mode, extended
+// attributes and timestamps. Once synced, it is read back with its cached
+// pages dropped and compared with the source, so the check covers what
+// reached the device. A source whose size or mtime changed meanwhile, such
+// as a capture still being written, fails rather than losing its tail.
+// Trees are copied by a TreeWalker pool, with hard links inside them kept as
+// links, then synced with one syncfs and verified by a second walk. Only
+// then are the source entries that were copied removed; anything that
+// appeared in the source meanwhile keeps its directory, and the source, in
+// place, as does any failure.
+class MoveEngine {
+public:
+    struct Options {
+        unsigned threads = 0;       // 0: TreeWalker::DefaultThreads()
+        bool sync = true;           // fsync a file, or syncfs a tree, before the source goes
+        bool verify = true;         // read back and compare each file
+    };
+
+    explicit MoveEngine(Options options);
+
+    // Moves a file, symlink or special file. The copy is written under a
+    // temporary name beside dst and renamed over it once synced and
+    // verified; src is unlinked last. Returns false if should_stop() ended
+    // it early, with nothing changed. Throws CommandError.
+    bool MoveFile(const std::string& src, const std::string& dst,
+                  const std::function<bool()>& should_stop = {},
+                  const std::function<void()>& on_tick = {});
+
+    // Moves the directory src to dst, which must not exist or be an empty
+    // directory. Returns false if should_stop() ended it early, leaving the
+    // source whole and a partial copy at dst. Per-entry failures are counted
+    // and kept in Errors(), and the source is then kept too; throws
+    // CommandError only if src or dst cannot be opened. In both calls
+    // should_stop and on_tick run on the calling thread about every 100 ms.
+    bool MoveTree(const std::string& src, const std::string& dst,
+                  const std::function<bool()>& should_stop = {},
+                  const std::function<void()>& on_tick = {});
+
+    // Whether everything of the last MoveTree reached dst and was synced,
+    // and whether the source was then deleted
+    bool Arrived() const { return arrived_; }
+    bool SourceRemoved() const { return source_removed_; }
+
+    MoveStats Stats() const;
+    // The first few failures, "path: reason"
+    std::vector<std::string> Errors() const;
+
+    unsigned Threads() const { return threads_; }
+
+private:
+    // An entry of the source that reached dst, to be removed at the end
+    struct MovedEntry {
+        std::string path;
+        bool dir = false;
+        off_t size = 0;
+        struct timespec mtime{};
+    };
+
+    struct LinkTarget {
+        std::string path;           // destination of the first name seen
+        int state = 0;              // 0 copying, 1 copied, -1 failed
+    };
+
+    bool Transfer(int src_dir, const std::string& name, int dst_dir, const std::string& dst_name, std::string& reason);
+    // check: fsync and verify now rather than in MoveTree's passes
+    bool CopyRegular(int src_dir, const std::string& name, int dst_dir, const std::string& dst_name,
+                     bool check, std::string& reason);
+    bool Verify(int in, int out, const struct stat& copied, std::string& reason);
+    bool Unchanged(int in, const struct stat& copied, std::string& reason);
+    void MoveEntry(int src_dir, const std::string& name, const std::string& rel);
+    void Moved(const std::string& rel, const struct stat& st);
+    void RemoveMoved(int src_root);
+    void Fail(const std::string& path, const std::string& reason);
+
+    Options options_;
+    unsigned threads_;
+    int dst_root_ = -1;
+    bool arrived_ = false;
+    bool source_removed_ = false;
+    std::atomic<bool> stop_{false};         // checked between chunks of the files in flight
+
+    std::atomic<uint64_t> files_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> verified_{0};
+    std::atomic<uint64_t> dirs_{0};
+    std::atomic<uint64_t> symlinks_{0};
+    std::atomic<uint64_t> links_{0};
+    std::atomic<uint64_t> specials_{0};
+    std::atomic<uint64_t> errors_{0};
+
+    // Files with more than one link, by (device, inode)
+    std::mutex links_mutex_;
+    std::condition_variable links_cv_;
+    std::map<std::pair<uint64_t, uint64_t>, LinkTarget> link_targets_;
+
+    std::mutex moved_mutex_;
+    std::vector<MovedEntry> moved_;
+
+    mutable std::mutex errors_mutex_;
+    std::vector<std::string> error_messages_;
+};
+
+} // namespace RedTops
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "PacketRing.hpp"
+#include "SpscRing.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace RedTops {
+
+struct MultiCaptureOptions {
+    std::vector<std::string> interfaces;
+    uint64_t max_packets = 0;       // 0 = until stopped
+    bool promiscuous = true;
+    size_t queue_slots = 4096;      // per interface
+    size_t queue_bytes = 16u << 20; // per interface: frame data waiting for the merger, allocated once
+    uint32_t snaplen = 65535;       // bytes kept of each frame; longer ones are cut and counted
+};
+
+// A frame handed to the consumer in global timestamp order
+struct CapturedFrame {
+    unsigned interface = 0;         // index into MultiCaptureOptions::interfaces
+    uint64_t ts_ns = 0;
+    uint32_t caplen = 0;
+    uint32_t len = 0;
+    const uint8_t* data = nullptr;  // valid only during the callback
+};
+
+struct InterfaceCaptureStats {
+    uint64_t packets = 0;
+    uint64_t bytes = 0;
+    uint64_t kernel_drops = 0;
+    uint64_t queue_stalls = 0;      // times the capture thread waited for the merger
+    uint64_t truncated = 0;         // frames cut to MultiCaptureOptions::snaplen
+};
+
+// Captures several interfaces at once and merges them into one stream ordered
+// by kernel timestamp. Each interface has its own capture thread, TPACKET_V3
+// ring and SPSC queue, so the capture threads never share a lock or a cache
+// line; the calling thread runs a k-way heap merge over the queue heads.
+class MultiCapture {
+public:
+    explicit MultiCapture(MultiCaptureOptions options);
+    ~MultiCapture();
+
+    MultiCapture(const MultiCapture&) = delete;
+    MultiCapture& operator=(const MultiCapture&) = delete;
+
+    // Opens every interface; throws NetworkError / PermissionError
+    void Open();
+
+    // Delivers frames to on_frame on the calling thread, oldest first, until
+    // max_packets is reached or should_stop() returns true
+    void Run(const std::function<bool()>& should_stop,
+             const std::function<void(const CapturedFrame&)>& on_frame);
+
+    const MultiCaptureOptions& Options() const { return options_; }
+    const std::vector<InterfaceCaptureStats>& Stats() const { return stats_; }
+
+private:
+    // A frame's bytes live in its source's arena, [start, end) in the
+    // arena's running byte count
+    struct Record {
+        uint64_t ts_ns = 0;
+        uint32_t caplen = 0;
+        uint32_t len = 0;
+        uint64_t start = 0;
+        uint64_t end = 0;
+    };
+
+    // The arena is a byte ring filled and drained in queue order, so frames
+    // take only the room they need: ordinary ones cost little, GRO and jumbo
+    // ones are never cut, and nothing is allocated once capture has begun
+    struct Source {
+        Source(size_t slots, size_t bytes)
+            : queue(slots), arena(std::make_unique_for_overwrite<uint8_t[]>(bytes)), arena_size(bytes) {}
+
+        uint8_t* Data(const Record& rec) const { return arena.get() + rec.start % arena_size; }
+
+        PacketRing ring;
+        SpscRing<Record> queue;
+        std::unique_ptr<uint8_t[]> arena;
+        size_t arena_size;
+        uint64_t written = 0;                       // capture thread: arena bytes handed out
+        alignas(64) std::atomic<uint64_t> freed{0}; // merger: arena bytes given back
+        // Every frame this interface will still deliver is at least this new
+        alignas(64) std::atomic<uint64_t> watermark_ns{0};
+        InterfaceCaptureStats stats;  // owned by the capture thread until it exits
+    };
+
+    void CaptureLoop(Source& source);
+    // Room in the arena for n contiguous bytes, or false while the merger still holds it
+    static bool Reserve(Source& source, uint32_t n, Record& rec);
+
+    MultiCaptureOptions options_;
+    std::vector<std::unique_ptr<Source>> sources_;
+    std::vector<InterfaceCaptureStats> stats_;
+    std::atomic<bool> stop_{false};
+};
+
+} // namespace RedTops
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct nlmsghdr;
+
+namespace RedTops {
+
+struct LinkInfo {
+    int index = 0;
+    std::string name;
+    std::string kind;          // IFLA_INFO_KIND: veth, bridge, vlan, ... (empty for physical)
+    std::string mac;
+    unsigned flags = 0;        // IFF_*
+    unsigned mtu = 0;
+    int master = 0;            // bridge/bond index, 0 if none
+    uint64_t rx_bytes = 0, tx_bytes = 0;
+    uint64_t rx_packets = 0, tx_packets = 0;
+    uint64_t rx_errors = 0, tx_errors = 0;
+    uint64_t rx_dropped = 0, tx_dropped = 0;
+    bool up() const;
+    bool running() const;
+};
+
+struct AddrInfo {
+    int index = 0;
+    int family = 0;            // AF_INET / AF_INET6
+    unsigned prefix = 0;
+    unsigned char scope = 0;   // RT_SCOPE_*
+    std::string address;
+};
+
+struct RouteInfo {
+    int family = 0;
+    unsigned dst_len = 0;
+    std::string dst;           // empty for the default route
+    std::string gateway;
+    std::string prefsrc;
+    int oif = 0;
+    uint32_t table = 0;
+    uint32_t metric = 0;
+    unsigned char protocol = 0;   // RTPROT_*
+    unsigned char scope = 0;
+    unsigned char type = 0;       // RTN_*
+};
+
+struct NeighInfo {
+    int index = 0;
+    int family = 0;
+    uint16_t state = 0;        // NUD_*
+    std::string address;
+    std::string lladdr;
+};
+
+// Everything one dump pass returns
+struct NetlinkSnapshot {
+    std::vector<LinkInfo> links;
+    std::vector<AddrInfo> addrs;
+    std::vector<RouteInfo> routes;
+    std::vector<NeighInfo> neighbors;
+
+    // Interface name for an index, or "if<N>" when unknown
+    std::string LinkName(int index) const;
+};
+
+// A single multicast notification
+struct NetlinkEvent {
+    enum class Kind { Link, Addr, Route, Neigh };
+    Kind kind = Kind::Link;
+    bool removed = false;
+    LinkInfo link;
+    AddrInfo addr;
+    RouteInfo route;
+    NeighInfo neigh;
+};
+
+// Names for RTPROT_*, NUD_* and RT_SCOPE_* values as `ip` prints them
+const char* RouteProtocolName(unsigned char protocol);
+const char* NeighStateName(uint16_t state);
+const char* ScopeName(unsigned char scope);
+
+// NETLINK_ROUTE client. Dump() loads links, addresses, routes and neighbours
+// over one socket with large receive buffers, i.e. a handful of recvmsg calls
+// even for thousands of entries. A client constructed with watch = true
+// subscribes to the link/address/route/neighbour multicast groups instead.
+// Throws NetworkError on socket or protocol failure.
+class NetlinkRoute {
+public:
+    explicit NetlinkRoute(bool watch = false);
+    ~NetlinkRoute();
+
+    NetlinkRoute(const NetlinkRoute&) = delete;
+    NetlinkRoute& operator=(const NetlinkRoute&) = delete;
+
+    NetlinkSnapshot Dump();
+
+    // Links only (with their IFLA_STATS64 counters), for periodic polling
+    std::vector<LinkInfo> Links();
+
+    // Waits up to timeout_ms for notifications and hands each to fn. Returns
+    // false if the kernel dropped events because the socket buffer overflowed.
+    bool ReadEvents(int timeout_ms, const std::function<void(const NetlinkEvent&)>& fn);
+
+private:
+    template <typename Fn>
+    void DumpRequest(uint16_t type, unsigned char family, Fn&& on_message);
+
+    int fd_ = -1;
+    uint32_t seq_ = 0;
+    uint32_t port_id_ = 0;
+    std::vector<char> buf_;
+};
+
+} // namespace RedTops
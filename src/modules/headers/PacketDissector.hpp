@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace RedTops {
+
+enum class L3Proto : uint8_t { None, IPv4, IPv6, ARP };
+
+// Bits in DissectedPacket::flags
+namespace DissectFlag {
+    constexpr uint16_t Truncated  = 1 << 0;  // a header ran past caplen
+    constexpr uint16_t Malformed  = 1 << 1;  // a length field is inconsistent
+    constexpr uint16_t Fragment   = 1 << 2;  // non-first IP fragment, no L4 header
+    constexpr uint16_t Tunneled   = 1 << 3;  // L3/L4 fields describe the packet inside GRE
+    constexpr uint16_t HasGre     = 1 << 4;
+    constexpr uint16_t HasPorts   = 1 << 5;  // src_port/dst_port are valid (TCP/UDP)
+    constexpr uint16_t HasIcmp    = 1 << 6;
+}
+
+constexpr uint32_t kNoOffset = 0xffffffffu;
+
+// Fixed-size decode result. Offsets index into the original frame so callers
+// can reach any header without copying; nothing here owns memory.
+struct DissectedPacket {
+    uint32_t caplen = 0;
+    uint32_t wirelen = 0;
+    uint16_t flags = 0;
+
+    // Offsets of each layer (kNoOffset when absent)
+    uint32_t l3_offset = kNoOffset;
+    uint32_t l4_offset = kNoOffset;
+    uint32_t payload_offset = kNoOffset;
+    uint32_t payload_length = 0;
+
+    // Ethernet
+    uint8_t src_mac[6] = {};
+    uint8_t dst_mac[6] = {};
+    uint8_t vlan_count = 0;
+    uint16_t vlan_ids[2] = {};
+    uint16_t ethertype = 0;            // innermost ethertype
+
+    // Network layer; IPv4 addresses use the first 4 bytes
+    L3Proto l3 = L3Proto::None;
+    uint8_t src_addr[16] = {};
+    uint8_t dst_addr[16] = {};
+    uint8_t ttl = 0;                   // TTL or hop limit
+    uint8_t ipv6_ext_headers = 0;
+    uint8_t l4_proto = 0;              // upper-layer protocol after any extension headers
+
+    // Transport layer
+    uint16_t src_port = 0;
+    uint16_t dst_port = 0;
+    uint8_t tcp_flags = 0;
+    uint16_t tcp_window = 0;
+    uint32_t tcp_seq = 0;
+    uint32_t tcp_ack = 0;
+    uint8_t icmp_type = 0;
+    uint8_t icmp_code = 0;
+    uint16_t icmp_id = 0;
+    uint16_t icmp_seq = 0;
+
+    // ARP (Ethernet/IPv4 only)
+    uint16_t arp_op = 0;
+    uint8_t arp_sender_mac[6] = {};
+    uint8_t arp_sender_ip[4] = {};
+    uint8_t arp_target_mac[6] = {};
+    uint8_t arp_target_ip[4] = {};
+
+    // GRE (outermost tunnel)
+    uint16_t gre_protocol = 0;
+    uint32_t gre_key = 0;
+    uint32_t gre_offset = kNoOffset;
+};
+
+// TCP flag bits as they appear in the header
+namespace TcpFlag {
+    constexpr uint8_t FIN = 0x01, SYN = 0x02, RST = 0x04, PSH = 0x08,
+                      ACK = 0x10, URG = 0x20, ECE = 0x40, CWR = 0x80;
+}
+
+// Decodes an Ethernet frame. Never reads beyond caplen and never allocates.
+// Returns false when not even the Ethernet header is present; otherwise
+// returns true with Truncated/Malformed set in flags if decoding stopped early.
+bool Dissect(const uint8_t* frame, uint32_t caplen, uint32_t wirelen, DissectedPacket& out) noexcept;
+
+// Formatters write into a caller-provided buffer, always NUL-terminate when
+// cap > 0, and return the number of characters written (excluding the NUL).
+size_t FormatAddress(const DissectedPacket& pkt, bool source, char* buf, size_t cap) noexcept;
+size_t FormatSummary(const DissectedPacket& pkt, char* buf, size_t cap) noexcept;  // one line
+size_t FormatDetail(const DissectedPacket& pkt, char* buf, size_t cap) noexcept;   // multi-line block
+
+const char* ProtocolName(uint8_t ip_proto) noexcept;
+
+} // namespace RedTops
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace RedTops {
+
+// One captured frame inside a ring block; data points into the shared mapping
+// and is only valid until the block is released
+struct RingFrame {
+    const uint8_t* data = nullptr;
+    uint32_t caplen = 0;
+    uint32_t len = 0;
+    uint64_t ts_ns = 0;       // CLOCK_REALTIME, from the kernel
+    bool outgoing = false;    // PACKET_OUTGOING (sent by this host)
+};
+
+// An AF_PACKET socket bound to one interface with a TPACKET_V3 mmap ring.
+// Blocks are consumed strictly in order: Ready() -> ForEach() -> Release().
+// Linux only; needs CAP_NET_RAW.
+class PacketRing {
+public:
+    static constexpr unsigned kBlockSize = 1u << 20;   // 1 MiB per ring block
+    static constexpr unsigned kBlockCount = 8;         // 8 MiB of ring per socket
+    static constexpr unsigned kFrameSize = 2048;
+    static constexpr unsigned kBlockTimeoutMs = 50;    // kernel retires partially filled blocks after this
+
+    PacketRing() = default;
+    ~PacketRing();
+
+    PacketRing(const PacketRing&) = delete;
+    PacketRing& operator=(const PacketRing&) = delete;
+
+    // Opens, maps and binds the socket. fanout_arg, when non-zero, is passed
+    // to PACKET_FANOUT. Throws NetworkError / PermissionError.
+    void Open(const std::string& interface, bool promiscuous = true, int fanout_arg = 0);
+    void Close();
+
+    // Number of frames in the current block, 0 while the kernel still owns it
+    uint32_t Ready() const;
+
+    // Waits up to timeout_ms for the socket to become readable
+    void Wait(int timeout_ms) const;
+
+    // Visits the frames of the current block in order; fn returns false to stop early
+    template <typename Fn>
+    void ForEach(Fn&& fn) const {
+        const uint8_t* hdr = FirstFrame();
+        for (uint32_t i = 0, n = Ready(); i < n; ++i) {
+            RingFrame frame;
+            hdr = Decode(hdr, frame);
+            if (!fn(static_cast<const RingFrame&>(frame))) break;
+        }
+    }
+
+    // Hands the current block back to the kernel and advances to the next
+    void Release();
+
+    // Kernel-side drops since the last call (PACKET_STATISTICS resets on read)
+    uint64_t Drops() const;
+
+    bool IsLoopback() const { return loopback_; }
+    int Fd() const { return fd_; }
+
+private:
+    const uint8_t* FirstFrame() const;
+    // Fills frame from the header at hdr and returns the next header
+    static const uint8_t* Decode(const uint8_t* hdr, RingFrame& frame);
+
+    int fd_ = -1;
+    uint8_t* map_ = nullptr;
+    size_t map_size_ = 0;
+    unsigned block_ = 0;
+    bool loopback_ = false;
+};
+
+} // namespace RedTops
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace RedTops {
+
+// Classic libpcap file format (nanosecond variant, LINKTYPE_ETHERNET), as read
+// by tcpdump, Wireshark and libpcap's pcap_open_offline
+constexpr uint32_t kPcapMagicNanos = 0xa1b23c4d;
+constexpr uint32_t kPcapMagicMicros = 0xa1b2c3d4;
+constexpr uint32_t kPcapLinkEthernet = 1;
+constexpr size_t kPcapFileHeaderSize = 24;
+constexpr size_t kPcapRecordHeaderSize = 16;
+
+// Buffered pcap writer. Records are batched into one large buffer and written
+// with a single write(2) per megabyte. Throws CommandError on I/O failure.
+class PcapWriter {
+public:
+    explicit PcapWriter(const std::string& path, uint32_t snaplen = 65535);
+    ~PcapWriter();
+
+    PcapWriter(const PcapWriter&) = delete;
+    PcapWriter& operator=(const PcapWriter&) = delete;
+
+    void Write(uint64_t ts_ns, const uint8_t* data, uint32_t caplen, uint32_t len);
+    void Flush();
+    void Close();
+
+    const std::string& Path() const { return path_; }
+    uint64_t Packets() const { return packets_; }
+    // File offset the next record will be written at
+    uint64_t Offset() const { return offset_; }
+
+private:
+    std::string path_;
+    int fd_ = -1;
+    uint32_t snaplen_;
+    std::vector<uint8_t> buffer_;
+    uint64_t packets_ = 0;
+    uint64_t offset_ = 0;
+};
+
+// One record of a mapped capture; data points into the mapping
+struct PcapRecord {
+    uint64_t offset = 0;            // file offset of the record header
+    uint64_t next = 0;              // file offset of the following record
+    uint64_t ts_ns = 0;
+    uint32_t caplen = 0;
+    uint32_t len = 0;
+    const uint8_t* data = nullptr;
+};
+
+// Read-only mmap view of a pcap file. Accepts both byte orders and both
+// timestamp resolutions; every record is bounds-checked against the mapping.
+// Throws CommandError when the file cannot be opened or is not a pcap.
+class PcapReader {
+public:
+    explicit PcapReader(const std::string& path);
+    ~PcapReader();
+
+    PcapReader(const PcapReader&) = delete;
+    PcapReader& operator=(const PcapReader&) = delete;
+
+    // Decodes the record at offset; false at end of file or on a truncated record
+    bool ReadAt(uint64_t offset, PcapRecord& rec) const;
+
+    // Tells the kernel whether the next reads are a linear scan or index-driven seeks
+    void Advise(bool sequential) const;
+
+    uint64_t FirstRecord() const { return kPcapFileHeaderSize; }
+    uint64_t Size() const { return size_; }
+    int64_t MtimeNs() const { return mtime_ns_; }
+    uint32_t LinkType() const { return link_type_; }
+    const std::string& Path() const { return path_; }
+
+private:
+    std::string path_;
+    const uint8_t* map_ = nullptr;
+    uint64_t size_ = 0;
+    int64_t mtime_ns_ = 0;
+    uint32_t link_type_ = 0;
+    bool swapped_ = false;
+    bool nanos_ = false;
+};
+
+} // namespace RedTops
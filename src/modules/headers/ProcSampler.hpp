@@ -0,0 +1,237 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace RedTops {
+
+// A /proc or /sys file kept open and re-read with pread(2) from offset 0, so
+// periodic sampling costs one syscall per file and no allocation once the
+// buffer has grown to fit.
+class ProcFile {
+public:
+    ProcFile() = default;
+    explicit ProcFile(const char* path) { Open(path); }
+    ~ProcFile();
+
+    ProcFile(ProcFile&& other) noexcept;
+    ProcFile& operator=(ProcFile&& other) noexcept;
+    ProcFile(const ProcFile&) = delete;
+    ProcFile& operator=(const ProcFile&) = delete;
+
+    bool Open(const char* path);
+    bool OpenAt(int dir_fd, const char* path);
+    void Close();
+    bool IsOpen() const { return fd_ >= 0; }
+
+    // Current contents; empty when the file is gone (e.g. the process exited)
+    std::string_view Read();
+
+private:
+    int fd_ = -1;
+    std::vector<char> buf_;
+};
+
+// Cursor over whitespace-separated fields of a /proc text buffer
+struct FieldReader {
+    std::string_view text;
+
+    explicit FieldReader(std::string_view t) : text(t) {}
+    void SkipSpaces() { while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1); }
+    std::string_view Word();
+    uint64_t U64();
+    double Double();
+    // Moves past the next occurrence of ch; false if there is none
+    bool SkipPast(char ch);
+};
+
+struct CpuUsage {
+    double user = 0;      // user + nice
+    double system = 0;    // system + irq + softirq
+    double iowait = 0;
+    double steal = 0;
+    double busy = 0;      // everything except idle and iowait
+};
+
+struct LoadAverage {
+    double one = 0, five = 0, fifteen = 0;
+    unsigned running = 0, total = 0;
+};
+
+// Per-core and aggregate utilisation from /proc/stat deltas
+class CpuSampler {
+public:
+    CpuSampler();
+
+    // Re-reads /proc/stat; the first call only primes the counters
+    void Sample();
+
+    const CpuUsage& Total() const { return total_; }
+    const std::vector<CpuUsage>& Cores() const { return cores_; }
+    uint64_t ContextSwitchesPerSec() const { return ctxt_rate_; }
+
+    LoadAverage Load();
+
+private:
+    struct Counters {
+        uint64_t user = 0, nice = 0, system = 0, idle = 0, iowait = 0, irq = 0, softirq = 0, steal = 0;
+    };
+    static CpuUsage Delta(const Counters& prev, const Counters& cur);
+
+    ProcFile stat_;
+    ProcFile loadavg_;
+    Counters total_prev_;
+    std::vector<Counters> core_prev_;
+    CpuUsage total_;
+    std::vector<CpuUsage> cores_;
+    uint64_t ctxt_prev_ = 0;
+    uint64_t ctxt_rate_ = 0;
+    uint64_t last_ns_ = 0;
+};
+
+struct ProcessUsage {
+    int pid = 0;
+    char state = '?';
+    std::string name;
+    double cpu_percent = 0;   // of one core, like top
+    uint64_t rss_bytes = 0;
+    unsigned threads = 0;
+};
+
+// Per-process CPU and memory from /proc/<pid>/stat. Each process's stat file
+// stays open between samples; /proc itself is re-listed with getdents64 on a
+// persistent directory fd to pick up new processes.
+class ProcessSampler {
+public:
+    ProcessSampler();
+    ~ProcessSampler();
+
+    ProcessSampler(const ProcessSampler&) = delete;
+    ProcessSampler& operator=(const ProcessSampler&) = delete;
+
+    void Sample();
+
+    // The n busiest processes of the last sample, highest CPU first
+    std::vector<const ProcessUsage*> Top(size_t n) const;
+    size_t Count() const { return tracked_.size(); }
+
+private:
+    struct Tracked {
+        ProcFile stat;
+        uint64_t ticks = 0;        // utime + stime at the previous sample
+        uint64_t generation = 0;
+        bool primed = false;
+        ProcessUsage usage;
+    };
+
+    bool Update(Tracked& t, uint64_t elapsed_ns);
+
+    int proc_fd_ = -1;
+    std::vector<char> dirents_;
+    std::unordered_map<int, Tracked> tracked_;
+    uint64_t generation_ = 0;
+    uint64_t last_ns_ = 0;
+    size_t fd_budget_ = 0;         // how many stat files may stay open
+    size_t open_fds_ = 0;
+    long ticks_per_sec_ = 100;
+    long page_size_ = 4096;
+};
+
+// /proc/meminfo in bytes. "Used" follows free(1): total minus MemAvailable,
+// so reclaimable page cache and slab do not count as used.
+struct MemoryInfo {
+    uint64_t total = 0, free = 0, available = 0;
+    uint64_t buffers = 0, cached = 0, shmem = 0;
+    uint64_t slab_reclaimable = 0, slab_unreclaimable = 0;
+    uint64_t swap_total = 0, swap_free = 0, swap_cached = 0;
+    uint64_t dirty = 0, writeback = 0;
+    uint64_t anon = 0, mapped = 0;
+
+    uint64_t used() const { return total > available ? total - available : 0; }
+    uint64_t cache() const { return buffers + cached + slab_reclaimable; }
+    uint64_t swap_used() const { return swap_total > swap_free ? swap_total - swap_free : 0; }
+};
+
+class MemorySampler {
+public:
+    MemorySampler() : meminfo_("/proc/meminfo") {}
+    MemoryInfo Sample();
+
+private:
+    ProcFile meminfo_;
+};
+
+// One line of /proc/pressure/<resource>
+struct PressureLine {
+    double avg10 = 0, avg60 = 0, avg300 = 0;
+    double now = 0;            // stall % over the last sample interval, from the total counter
+    uint64_t total_us = 0;
+};
+
+struct Pressure {
+    bool available = false;    // false without CONFIG_PSI or when disabled
+    PressureLine some;
+    PressureLine full;         // not reported for cpu on older kernels
+};
+
+// Pressure stall information for cpu, memory and io
+class PressureSampler {
+public:
+    enum Resource { Cpu, Memory, Io, kResources };
+
+    PressureSampler();
+    void Sample();
+    const Pressure& Get(Resource r) const { return pressure_[r]; }
+
+    static const char* Name(Resource r);
+
+private:
+    ProcFile files_[kResources];
+    Pressure pressure_[kResources];
+    uint64_t last_ns_ = 0;
+};
+
+struct DiskUsage {
+    std::string name;
+    double read_bps = 0, write_bps = 0;     // bytes per second
+    double read_iops = 0, write_iops = 0;
+    double util = 0;                        // % of time with I/O in flight
+    double await_ms = 0;                    // average time per completed request
+    uint64_t in_flight = 0;
+};
+
+// Per-disk throughput from /proc/diskstats deltas. Only whole disks are
+// reported (names present in /sys/block); loop and ram devices are skipped.
+class DiskSampler {
+public:
+    DiskSampler() : diskstats_("/proc/diskstats") {}
+
+    // Re-reads /proc/diskstats; the first call only primes the counters
+    void Sample();
+    const std::vector<DiskUsage>& Disks() const { return disks_; }
+
+private:
+    struct Counters {
+        uint64_t reads = 0, read_sectors = 0, read_ms = 0;
+        uint64_t writes = 0, write_sectors = 0, write_ms = 0;
+        uint64_t io_ms = 0;
+    };
+    struct Tracked {
+        std::string name;
+        bool whole_disk = false;
+        Counters last;
+        uint64_t generation = 0;
+    };
+
+    ProcFile diskstats_;
+    std::vector<Tracked> tracked_;
+    std::vector<DiskUsage> disks_;
+    uint64_t generation_ = 0;
+    uint64_t last_ns_ = 0;
+};
+
+} // namespace RedTops
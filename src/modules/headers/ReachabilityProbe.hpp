@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace RedTops {
+
+// "host" probes with ICMP echo, "host:port" / "[v6]:port" with a TCP connect
+struct ProbeTarget {
+    std::string spec;          // as the user wrote it
+    std::string host;
+    uint16_t port = 0;         // 0 = ICMP
+};
+
+// Throws CommandError on a malformed port
+ProbeTarget ParseProbeTarget(const std::string& text);
+
+enum class ProbeStatus {
+    Reachable,      // echo reply, or TCP handshake completed
+    Refused,        // RST: the host is up but nothing listens on the port
+    Unreachable,    // the network or host is unreachable
+    Timeout,
+    ResolveFailed,
+    Error,
+};
+
+const char* ProbeStatusName(ProbeStatus status);
+
+struct ProbeResult {
+    ProbeTarget target;
+    std::string address;       // numeric address that was probed
+    ProbeStatus status = ProbeStatus::Timeout;
+    double rtt_ms = 0;
+    std::string detail;        // error text for Error / ResolveFailed
+};
+
+// Probes many endpoints concurrently from one thread: every TCP connect is a
+// non-blocking socket in one epoll set, and all ICMP echoes share one socket
+// per address family (unprivileged ping sockets where permitted, raw sockets
+// otherwise). Everything runs against one deadline, so a batch takes about
+// one timeout no matter how many targets it holds.
+class ReachabilityProbe {
+public:
+    explicit ReachabilityProbe(int timeout_ms) : timeout_ms_(timeout_ms) {}
+
+    void Add(const ProbeTarget& target) { targets_.push_back(target); }
+    size_t Count() const { return targets_.size(); }
+
+    // Results are in the order targets were added. cancelled is polled
+    // while waiting; when it returns true, pending probes end as Timeout.
+    std::vector<ProbeResult> Run(const std::function<bool()>& cancelled = {});
+
+private:
+    int timeout_ms_;
+    std::vector<ProbeTarget> targets_;
+};
+
+} // namespace RedTops
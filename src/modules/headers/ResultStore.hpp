@@ -0,0 +1,107 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace RedTops {
+
+// Which command produced a run
+enum class ResultKind : uint8_t { PortScan = 1, Ping = 2, Trace = 3, Probe = 4 };
+
+const char* ResultKindName(ResultKind kind);
+// "portscan", "ping", "trace", "probe"; false for anything else
+bool ParseResultKind(const std::string& name, ResultKind& kind);
+
+enum class ResultStatus : uint8_t { Down = 0, Up = 1, Refused = 2, Timeout = 3, Error = 4 };
+
+const char* ResultStatusName(ResultStatus status);
+
+// One observation. `port` is the TCP port for scans and probes (0 for ICMP)
+// and the hop number for traces; `value` is a round-trip time in ms.
+struct ResultRow {
+    std::string host;
+    uint16_t port = 0;
+    ResultStatus status = ResultStatus::Up;
+    float value = 0;
+};
+
+struct RunInfo {
+    uint64_t id = 0;
+    ResultKind kind = ResultKind::PortScan;
+    std::string target;          // what the user asked for (host, "host 1-1024", ...)
+    int64_t started_us = 0;      // Unix time
+    uint32_t duration_ms = 0;
+    uint32_t rows = 0;
+
+    // Location of the run's block
+    uint32_t segment = 0;
+    uint64_t offset = 0;
+    uint32_t length = 0;
+};
+
+struct RunFilter {
+    bool any_kind = true;
+    ResultKind kind = ResultKind::PortScan;
+    std::string target;          // exact match when non-empty
+    int64_t since_us = 0;        // inclusive; 0 = unbounded
+    int64_t until_us = 0;        // exclusive; 0 = unbounded
+};
+
+struct ResultDiff {
+    std::vector<ResultRow> added;                        // only in the newer run
+    std::vector<ResultRow> removed;                      // only in the older run
+    std::vector<std::pair<ResultRow, ResultRow>> changed; // same host/port, different status
+};
+
+// Append-only store of command results under ~/.redtops/results.
+//
+// Each run is written once as a columnar block — a sorted host dictionary
+// followed by host-index, port, status and value columns, rows ordered by
+// (host, port) — appended to a log segment (seg-NNNNNN.dat, rolled at
+// 64 MiB). Two fixed-width index files make lookups cheap:
+//   runs.idx   one 128-byte entry per run: kind, target, time, block location;
+//              run ids are positions, so fetching a run is a single pread
+//   hosts.idx  (host hash, run id) for every distinct host in every run
+// Listing and filtering runs reads only runs.idx, a host query reads
+// hosts.idx and then binary-searches the matching blocks, and a diff reads
+// exactly two blocks and merge-joins them. Appends take an flock so several
+// shells can record at once; blocks carry a CRC and torn index tails are
+// ignored. Throws CommandError on I/O failure.
+class ResultStore {
+public:
+    explicit ResultStore(const std::string& dir = DefaultDir());
+
+    static std::string DefaultDir();
+
+    // Records one run and returns its id. Rows need not be sorted.
+    uint64_t Append(ResultKind kind, const std::string& target, int64_t started_us, uint32_t duration_ms,
+                    std::vector<ResultRow> rows);
+    // Same, for a run that began at started and has just finished
+    uint64_t Append(ResultKind kind, const std::string& target, std::chrono::system_clock::time_point started,
+                    std::vector<ResultRow> rows);
+
+    std::vector<RunInfo> Runs(const RunFilter& filter = {}) const;
+    bool Run(uint64_t id, RunInfo& out) const;
+
+    // Rows of a run, sorted by (host, port)
+    std::vector<ResultRow> Rows(const RunInfo& run) const;
+    // Rows of a run for one host, found by binary search within the block
+    std::vector<ResultRow> Rows(const RunInfo& run, const std::string& host) const;
+
+    // Ids of runs that contain host (may include hash collisions; Rows() filters them)
+    std::vector<uint64_t> RunsWithHost(const std::string& host) const;
+
+    // Changes from older to newer; rows must be sorted by (host, port) as Rows() returns them
+    static ResultDiff Diff(const std::vector<ResultRow>& older, const std::vector<ResultRow>& newer);
+
+    const std::string& Directory() const { return dir_; }
+
+private:
+    std::vector<char> ReadBlock(const RunInfo& run) const;
+
+    std::string dir_;
+};
+
+} // namespace RedTops
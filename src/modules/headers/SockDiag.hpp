@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace RedTops {
+
+// Which sockets the kernel should return. State and port tests run in the
+// kernel (idiag_states and an inet_diag bytecode program), so filtered-out
+// sockets never cross into user space.
+struct SocketFilter {
+    int protocol = 6;                  // IPPROTO_TCP or IPPROTO_UDP
+    int family = 0;                    // AF_INET, AF_INET6, or 0 for both
+    uint32_t states = 0xffffffffu;     // bit per TCP_* state
+    uint16_t sport_lo = 0, sport_hi = 0;   // inclusive; 0/0 = any
+    uint16_t dport_lo = 0, dport_hi = 0;
+    bool tcp_info = false;             // request INET_DIAG_INFO (rtt, cwnd, retrans)
+};
+
+// One socket as decoded from an inet_diag_msg. Addresses are raw network-order
+// bytes (4 or 16 used) so that aggregation never formats strings.
+struct SocketEntry {
+    int family = 0;
+    int protocol = 0;
+    uint8_t state = 0;
+    uint16_t local_port = 0, remote_port = 0;
+    uint8_t local[16] = {}, remote[16] = {};
+    uint32_t recv_q = 0, send_q = 0;
+    uint32_t uid = 0;
+    uint32_t inode = 0;
+
+    bool has_info = false;             // the fields below are valid
+    uint32_t rtt_us = 0, rttvar_us = 0;
+    uint32_t snd_cwnd = 0;
+    uint32_t retransmits = 0;          // unrecovered retransmits of the current segment
+    uint32_t total_retrans = 0;
+    uint64_t bytes_acked = 0, bytes_received = 0;
+    uint64_t delivery_rate = 0;        // bytes per second
+};
+
+// Short state names as ss(8) prints them; UDP reports ESTAB or UNCONN
+const char* SocketStateName(uint8_t state);
+
+// Parses "established", "listen", "time-wait", ... (case-insensitive);
+// returns the state number or -1
+int ParseSocketState(const char* name);
+
+// Formats the address part of an entry ("10.0.0.1" or "[fe80::1]")
+void FormatSocketAddress(int family, const uint8_t* addr, char* out, size_t size);
+
+// Streams every matching socket through fn as the dump arrives; fn returns
+// false to stop early. Throws NetworkError when sock_diag is unavailable.
+// Returns the number of sockets delivered.
+uint64_t DumpSockets(const SocketFilter& filter, const std::function<bool(const SocketEntry&)>& fn);
+
+} // namespace RedTops
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace RedTops {
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Slots are written and read in place, so large records are never
+// copied through the queue. Capacity is rounded up to a power of two.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        mask_ = cap - 1;
+        slots_ = std::make_unique<T[]>(cap);
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer: a free slot to fill, or nullptr when the ring is full
+    T* BeginPush() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_cache_ > mask_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head - tail_cache_ > mask_) return nullptr;
+        }
+        return &slots_[head & mask_];
+    }
+
+    // Producer: publishes the slot returned by BeginPush
+    void CommitPush() { head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    // Consumer: the oldest record, or nullptr when empty
+    T* Front() {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_cache_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail == head_cache_) return nullptr;
+        }
+        return &slots_[tail & mask_];
+    }
+
+    // Consumer: releases the record returned by Front
+    void Pop() { tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    size_t Capacity() const { return mask_ + 1; }
+
+private:
+    // Producer and consumer indices live on separate cache lines so the two
+    // threads only share a line when one of them has to refresh its cache
+    alignas(64) std::atomic<size_t> head_{0};
+    size_t tail_cache_ = 0;
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t head_cache_ = 0;
+    alignas(64) size_t mask_ = 0;
+    std::unique_ptr<T[]> slots_;
+};
+
+} // namespace RedTops
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "PacketDissector.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace RedTops {
+
+struct TcpTrackerOptions {
+    size_t max_flows = 100000;                 // LRU-evicted beyond this
+    bool reassemble = false;
+    std::string stream_dir;                    // where reassembled streams are written
+    size_t per_flow_buffer = 256 * 1024;       // pending + out-of-order bytes per direction
+    size_t total_buffer = 64 * 1024 * 1024;    // across all flows
+};
+
+enum class TcpFlowState : uint8_t { SynSent, SynReceived, Established, Closing, Closed, Reset, Midstream };
+
+// Canonical flow key: endpoint 0 is always the lexicographically smaller one
+struct TcpFlowKey {
+    uint8_t addr[2][16];
+    uint16_t port[2];
+    uint8_t ipv6;
+
+    bool operator==(const TcpFlowKey& o) const;
+};
+
+struct TcpFlowKeyHash {
+    size_t operator()(const TcpFlowKey& k) const noexcept;
+};
+
+struct TcpDirection {
+    bool seen = false;
+    uint32_t isn = 0;
+    uint32_t next_seq = 0;           // highest sequence number sent + 1
+    uint64_t packets = 0;
+    uint64_t bytes = 0;              // payload bytes, retransmissions included
+    uint64_t retransmits = 0;
+    bool fin = false;
+
+    // Reassembly state
+    uint32_t deliver_seq = 0;        // next byte the stream sink expects
+    std::vector<uint8_t> pending;    // in-order bytes not yet flushed
+    std::map<uint32_t, std::vector<uint8_t>> out_of_order;
+    size_t buffered = 0;             // pending + out_of_order bytes
+    uint64_t delivered = 0;
+    uint64_t gaps = 0;               // holes skipped because a buffer cap was hit
+};
+
+struct TcpFlow {
+    TcpFlowKey key{};
+    uint8_t client = 0;              // index into key of the side that sent SYN
+    TcpFlowState state = TcpFlowState::Midstream;
+
+    uint64_t first_us = 0;
+    uint64_t last_us = 0;
+    uint64_t syn_us = 0;
+    uint64_t synack_us = 0;
+    uint64_t ack_us = 0;
+    uint64_t syn_retransmits = 0;
+
+    TcpDirection dir[2];             // indexed like key: dir[i] = sent by endpoint i
+
+    // SYN -> SYN/ACK (network + server accept latency), 0 if not observed
+    uint64_t ServerRttUs() const { return synack_us && syn_us ? synack_us - syn_us : 0; }
+    // SYN/ACK -> ACK (client-side round trip), 0 if not observed
+    uint64_t ClientRttUs() const { return ack_us && synack_us ? ack_us - synack_us : 0; }
+    bool HandshakeComplete() const { return ack_us != 0; }
+
+    // "a.b.c.d:p" style endpoint text for side i
+    std::string Endpoint(uint8_t side) const;
+
+    // LRU links (indices into the tracker's pool)
+    uint32_t lru_prev = UINT32_MAX;
+    uint32_t lru_next = UINT32_MAX;
+};
+
+struct TcpTrackerStats {
+    uint64_t packets = 0;
+    uint64_t flows_created = 0;
+    uint64_t flows_evicted = 0;
+    uint64_t handshakes = 0;
+    uint64_t retransmits = 0;
+    uint64_t bytes_reassembled = 0;
+    uint64_t reassembly_gaps = 0;
+    size_t buffered_bytes = 0;
+};
+
+const char* TcpFlowStateName(TcpFlowState state);
+
+// Passive TCP connection tracker. Measures handshake latency and
+// retransmissions per flow and optionally writes each direction's payload
+// to <stream_dir>/<client>_<server>.{c2s,s2c}. Memory is bounded by
+// max_flows and the two buffer caps. Not thread-safe: use one per worker.
+class TcpFlowTracker {
+public:
+    using FlowCallback = std::function<void(const TcpFlow&)>;
+
+    explicit TcpFlowTracker(TcpTrackerOptions options = {});
+    ~TcpFlowTracker();
+
+    TcpFlowTracker(const TcpFlowTracker&) = delete;
+    TcpFlowTracker& operator=(const TcpFlowTracker&) = delete;
+
+    void OnHandshake(FlowCallback cb) { on_handshake_ = std::move(cb); }
+
+    // Feeds one dissected frame; non-TCP packets are ignored
+    void Process(const DissectedPacket& pkt, const uint8_t* frame, uint64_t ts_us);
+
+    // Flushes every pending stream buffer to disk
+    void Flush();
+
+    // Live flows, most recently active first
+    std::vector<const TcpFlow*> Flows() const;
+    const TcpTrackerStats& Stats() const { return stats_; }
+
+private:
+    uint32_t Lookup(const TcpFlowKey& key, bool create, uint64_t ts_us);
+    void Touch(uint32_t idx);
+    void Unlink(uint32_t idx);
+    void Evict(uint32_t idx);
+    void Reassemble(TcpFlow& flow, uint8_t side, uint32_t seq, const uint8_t* data, uint32_t len);
+    void Deliver(TcpFlow& flow, uint8_t side, const uint8_t* data, size_t len);
+    void FlushDirection(TcpFlow& flow, uint8_t side);
+    void DropBuffers(TcpFlow& flow, uint8_t side);
+    void ReclaimMemory(uint32_t keep);
+
+    TcpTrackerOptions options_;
+    std::unordered_map<TcpFlowKey, uint32_t, TcpFlowKeyHash> index_;
+    std::vector<TcpFlow> pool_;
+    std::vector<uint32_t> free_;
+    uint32_t lru_head_ = UINT32_MAX;   // most recent
+    uint32_t lru_tail_ = UINT32_MAX;   // least recent
+    TcpTrackerStats stats_;
+    FlowCallback on_handshake_;
+};
+
+} // namespace RedTops
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace RedTops {
+
+constexpr size_t kNoMatch = static_cast<size_t>(-1);
+
+// Finds one literal in a buffer. Candidate positions are found 32 (AVX2) or
+// 16 (SSE2) bytes at a time by comparing the needle's first and last bytes
+// against two shifted loads, and only the surviving positions are verified
+// with memcmp — so the scan rarely touches a byte twice whatever the needle
+// looks like. Case-insensitive search folds ASCII letters with an OR of 0x20
+// in the same compare.
+class LiteralSearcher {
+public:
+    LiteralSearcher(std::string needle, bool ignore_case);
+
+    // Offset of the first occurrence at or after from, or kNoMatch
+    size_t Find(const char* data, size_t len, size_t from) const;
+
+    size_t Length() const { return needle_.size(); }
+
+private:
+    bool Verify(const char* at) const;
+
+    std::string needle_;        // lower-cased when ignore_case
+    bool ignore_case_;
+    uint8_t first_ = 0, last_ = 0;
+    uint8_t first_fold_ = 0, last_fold_ = 0;   // 0x20 when that byte is a letter
+};
+
+// Number of '\n' bytes in [data, data + len), counted a vector at a time
+size_t CountNewlines(const char* data, size_t len);
+
+// What `search` looks for: one or more literals (SIMD path) or a POSIX
+// extended regex, compiled once and shared by every worker thread.
+class TextMatcher {
+public:
+    // Patterns are taken literally when `fixed` is set, or when none of them
+    // contains a regex metacharacter; throws CommandError on a bad regex.
+    TextMatcher(const std::vector<std::string>& patterns, bool fixed, bool ignore_case);
+    ~TextMatcher();
+
+    TextMatcher(const TextMatcher&) = delete;
+    TextMatcher& operator=(const TextMatcher&) = delete;
+
+    // First match at or after from (which must be a line start for a regex);
+    // returns its offset and length, or kNoMatch
+    size_t Find(const char* data, size_t len, size_t from, size_t& match_len) const;
+
+    bool IsRegex() const { return regex_; }
+
+private:
+    bool regex_ = false;
+    bool ignore_case_ = false;
+    std::string expression_;
+    uint64_t id_;
+    std::vector<LiteralSearcher> literals_;
+};
+
+} // namespace RedTops
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace RedTops {
+
+struct RemoveStats {
+    uint64_t files = 0;         // everything that is not a directory
+    uint64_t dirs = 0;
+    uint64_t errors = 0;
+};
+
+// Parallel `rm -r` on top of TreeWalker. Workers list directories with
+// getdents64 and unlink each entry with unlinkat(2) relative to its open
+// directory descriptor, so no path is resolved per file; a directory is
+// removed as soon as the walk has finished everything below it. Symlinks
+// are unlinked, never followed.
+class TreeRemover {
+public:
+    explicit TreeRemover(unsigned threads = 0);
+
+    // Deletes the directory path and everything below it. Returns false if
+    // should_stop() ended it early; whatever was removed stays removed.
+    // Per-entry failures are counted and kept in Errors(); throws
+    // CommandError only if path cannot be opened.
+    bool Remove(const std::string& path,
+                const std::function<bool()>& should_stop = {},
+                const std::function<void()>& on_tick = {});
+
+    RemoveStats Stats() const;
+    // The first few failures, "path: reason"
+    std::vector<std::string> Errors() const;
+
+    unsigned Threads() const { return threads_; }
+
+private:
+    void Fail(const std::string& path, int err);
+
+    unsigned threads_;
+    std::atomic<uint64_t> files_{0};
+    std::atomic<uint64_t> dirs_{0};
+    std::atomic<uint64_t> errors_{0};
+
+    mutable std::mutex errors_mutex_;
+    std::vector<std::string> error_messages_;
+};
+
+} // namespace RedTops
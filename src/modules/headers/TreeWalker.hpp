@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace RedTops {
+
+// One raw directory entry. `type` is a DT_* value from <dirent.h>.
+struct DirEntry {
+    std::string_view name;
+    uint64_t ino = 0;
+    uint8_t type = 0;
+};
+
+// Streams the entries of an open directory with getdents64(2), skipping "."
+// and "..". Entries are decoded in place from one reusable buffer, so a
+// listing costs one syscall per buffer-full rather than one per entry.
+class DirReader {
+public:
+    explicit DirReader(int fd, size_t buffer_bytes = 64 * 1024);
+
+    // False at the end of the directory or on error
+    bool Next(DirEntry& entry);
+    // errno of the failed getdents64 call, 0 if the listing completed
+    int Error() const { return error_; }
+
+private:
+    int fd_;
+    std::vector<char> buf_;
+    size_t pos_ = 0;
+    size_t len_ = 0;
+    int error_ = 0;
+    bool eof_ = false;
+};
+
+// Parallel traversal of a directory tree.
+//
+// Each directory is opened with openat(2) by name in its parent's
+// descriptor, with O_NOFOLLOW, and listed with DirReader by a pool of worker
+// threads. Paths from the root are never resolved, so replacing a directory
+// with a symlink mid-walk cannot lead the walk, or a visitor working through
+// the descriptors it is given, outside the tree. Non-directory entries are
+// handed out in batches as separate jobs, so one huge flat directory is still
+// spread across every worker. Jobs run newest first, depth-first, which keeps
+// the descriptors held open for unfinished subtrees near the tree's depth.
+// DT_UNKNOWN entries are resolved with fstatat, so visitors always see a
+// concrete type, and symlinks are never followed.
+class TreeWalker {
+public:
+    struct Dir {
+        int fd = -1;            // open while this directory's entries are visited
+        int parent_fd = -1;     // the parent's descriptor, open until this directory is left
+        std::string path;       // relative to the root; empty for the root
+        unsigned depth = 0;
+        bool complete = true;   // in leave: false if something below could not be listed
+
+        // Last component of path: this directory's name in parent_fd
+        std::string_view Name() const;
+        // Root-relative path of a child
+        std::string Child(std::string_view name) const;
+    };
+
+    struct Entry {
+        const Dir& dir;
+        std::string_view name;
+        uint64_t ino;
+        uint8_t type;           // DT_DIR, DT_REG, DT_LNK, ...
+
+        std::string Path() const { return dir.Child(name); }
+    };
+
+    // Every callback except on_tick runs concurrently on worker threads.
+    struct Visitor {
+        // A subdirectory was found; return false to skip it. Runs before any
+        // entry below it is visited.
+        std::function<bool(const Entry&)> directory;
+        // Anything that is not a directory
+        std::function<void(const Entry&)> entry;
+        // Everything below dir has been visited (post-order). dir.fd is closed
+        // by then; reach the directory as dir.Name() in dir.parent_fd, which
+        // is still open. Not called for the root, or for a directory that
+        // failed, was cut off by a stop, or contains one that did (see
+        // leave_failed).
+        std::function<void(const Dir& dir)> leave;
+        // A directory could not be opened or listed
+        std::function<void(const std::string& path, int err)> error;
+        // Also leave directories that failed or contain one that did, with
+        // dir.complete cleared, so totals can still be rolled up
+        bool leave_failed = false;
+    };
+
+    explicit TreeWalker(unsigned threads = DefaultThreads());
+
+    // Twice the online cores, at least 4: the work is mostly waiting on I/O
+    static unsigned DefaultThreads();
+
+    // Walks everything below root_fd, which stays owned by the caller.
+    // should_stop and on_tick run on the calling thread about every 100 ms.
+    // Returns false if the walk was stopped early.
+    bool Walk(int root_fd, const Visitor& visitor,
+              const std::function<bool()>& should_stop = {},
+              const std::function<void()>& on_tick = {});
+
+    unsigned Threads() const { return threads_; }
+
+private:
+    unsigned threads_;
+};
+
+} // namespace RedTops
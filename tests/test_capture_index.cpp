@@ -0,0 +1,125 @@
+#include <catch2/catch_all.hpp>
+#include "../src/modules/headers/CaptureIndex.hpp"
+#include "../src/modules/headers/PacketDissector.hpp"
+#include "../src/modules/headers/PcapFile.hpp"
+#include "../src/core/header/Exceptions.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace RedTops;
+
+namespace {
+
+// Ethernet/IPv4/UDP frame between 10.0.0.<host>:<port> and 10.0.1.1:53
+std::vector<uint8_t> UdpFrame(uint8_t host, uint16_t port, bool reply) {
+    std::vector<uint8_t> f(14, 0);
+    f[12] = 0x08;
+    uint8_t a[4] = {10, 0, 0, host}, b[4] = {10, 0, 1, 1};
+    uint16_t sport = port, dport = 53;
+    if (reply) { std::swap(a, b); std::swap(sport, dport); }
+    uint8_t ip[20] = {0x45, 0, 0, 28 + 4, 0, 0, 0, 0, 64, 17, 0, 0};
+    std::copy(a, a + 4, ip + 12);
+    std::copy(b, b + 4, ip + 16);
+    f.insert(f.end(), ip, ip + 20);
+    uint8_t udp[8] = {uint8_t(sport >> 8), uint8_t(sport), uint8_t(dport >> 8), uint8_t(dport), 0, 12, 0, 0};
+    f.insert(f.end(), udp, udp + 8);
+    f.insert(f.end(), 4, 0xab);
+    return f;
+}
+
+std::string TempPath(const char* name) {
+    return "/tmp/redtops_test_" + std::to_string(getpid()) + "_" + name;
+}
+
+} // namespace
+
+TEST_CASE("Flow filters parse and match both directions", "[index]") {
+    FlowFilter f = ParseFlowFilter("10.0.0.5:1234-10.0.1.1:53");
+    DissectedPacket pkt;
+    auto query = UdpFrame(5, 1234, false);
+    auto reply = UdpFrame(5, 1234, true);
+    auto other = UdpFrame(6, 1234, false);
+
+    REQUIRE(Dissect(query.data(), uint32_t(query.size()), uint32_t(query.size()), pkt));
+    REQUIRE(f.Matches(pkt));
+    REQUIRE(PacketFlowHash(pkt) == f.Hash());
+    REQUIRE(Dissect(reply.data(), uint32_t(reply.size()), uint32_t(reply.size()), pkt));
+    REQUIRE(f.Matches(pkt));
+    REQUIRE(PacketFlowHash(pkt) == f.Hash());
+    REQUIRE(Dissect(other.data(), uint32_t(other.size()), uint32_t(other.size()), pkt));
+    REQUIRE_FALSE(f.Matches(pkt));
+
+    REQUIRE(ParseFlowFilter("[2001:db8::1]:443-[2001:db8::2]:5000").ipv6);
+    REQUIRE_THROWS_AS(ParseFlowFilter("10.0.0.1-10.0.0.2:80"), CommandError);
+    REQUIRE_THROWS_AS(ParseFlowFilter("10.0.0.1:80-[::1]:80"), CommandError);
+}
+
+TEST_CASE("Capture index narrows time and flow queries to matching blocks", "[index]") {
+    const std::string pcap = TempPath("index.pcap");
+    const uint64_t t0 = 1700000000ull * 1000000000ull;
+    constexpr int kPackets = 60000;   // ~4 MB, so the index has many blocks
+
+    {
+        PcapWriter writer(pcap);
+        CaptureIndexBuilder builder;
+        DissectedPacket pkt;
+        for (int i = 0; i < kPackets; ++i) {
+            // Host 7 only talks during the second half of the capture
+            uint8_t host = (i >= kPackets / 2 && i % 100 == 0) ? 7 : uint8_t(100 + i % 50);
+            auto frame = UdpFrame(host, 4000, i % 2);
+            uint64_t ts = t0 + uint64_t(i) * 1000000;   // 1 ms apart
+            uint64_t offset = writer.Offset();
+            writer.Write(ts, frame.data(), uint32_t(frame.size()), uint32_t(frame.size()));
+            Dissect(frame.data(), uint32_t(frame.size()), uint32_t(frame.size()), pkt);
+            builder.Add(offset, ts, PacketFlowHash(pkt));
+        }
+        writer.Close();
+        builder.WriteFor(pcap);
+    }
+
+    PcapReader reader(pcap);
+    CaptureIndex index;
+    REQUIRE(index.Open(CaptureIndex::PathFor(pcap), reader.Size(), reader.MtimeNs()));
+    REQUIRE(index.BlockCount() > 10);
+    REQUIRE(index.FirstTimestamp() == t0);
+
+    // The index is rejected once the capture changes underneath it
+    CaptureIndex stale;
+    REQUIRE_FALSE(stale.Open(CaptureIndex::PathFor(pcap), reader.Size() + 1, reader.MtimeNs()));
+
+    SECTION("flow postings skip the first half") {
+        FlowFilter f = ParseFlowFilter("10.0.0.7:4000-10.0.1.1:53");
+        auto blocks = index.Candidates(0, UINT64_MAX, f.Hash());
+        REQUIRE(!blocks.empty());
+        REQUIRE(blocks.size() <= index.BlockCount() / 2 + 1);
+
+        int matched = 0;
+        DissectedPacket pkt;
+        PcapRecord rec;
+        for (uint32_t b : blocks)
+            for (uint64_t off = index.BlockOffset(b); off < index.BlockEnd(b) && reader.ReadAt(off, rec); off = rec.next)
+                if (Dissect(rec.data, rec.caplen, rec.len, pkt) && f.Matches(pkt)) matched++;
+        REQUIRE(matched == kPackets / 2 / 100);
+    }
+
+    SECTION("time window selects only overlapping blocks") {
+        uint64_t since = t0 + 10000ull * 1000000, until = t0 + 10100ull * 1000000;
+        auto blocks = index.Candidates(since, until, 0);
+        REQUIRE(!blocks.empty());
+        REQUIRE(blocks.size() <= 2);
+
+        int in_window = 0;
+        PcapRecord rec;
+        for (uint32_t b : blocks)
+            for (uint64_t off = index.BlockOffset(b); off < index.BlockEnd(b) && reader.ReadAt(off, rec); off = rec.next)
+                if (rec.ts_ns >= since && rec.ts_ns <= until) in_window++;
+        REQUIRE(in_window == 101);
+    }
+
+    std::remove(pcap.c_str());
+    std::remove(CaptureIndex::PathFor(pcap).c_str());
+}
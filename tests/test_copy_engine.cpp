@@ -0,0 +1,199 @@
+#include <catch2/catch_all.hpp>
+#include "../src/modules/headers/CopyEngine.hpp"
+#include "../src/modules/headers/TreeWalker.hpp"
+#include "../src/core/header/Exceptions.hpp"
+#include "test_helpers.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace RedTops;
+namespace fs = std::filesystem;
+
+namespace {
+
+// 3 levels of 4 directories with 20 files each, plus one wide directory
+void BuildTree(const fs::path& root) {
+    for (int a = 0; a < 4; ++a)
+        for (int b = 0; b < 4; ++b)
+            for (int f = 0; f < 20; ++f)
+                WriteFile(root / ("d" + std::to_string(a)) / ("e" + std::to_string(b)) / ("f" + std::to_string(f)),
+                          "file " + std::to_string(a * 1000 + b * 100 + f));
+    for (int f = 0; f < 600; ++f) WriteFile(root / "wide" / ("w" + std::to_string(f)), std::to_string(f));
+}
+
+} // namespace
+
+TEST_CASE("TreeWalker visits every entry once and leaves directories after their contents", "[copy]") {
+    TempDir dir;
+    BuildTree(dir.path);
+
+    int root = open(dir.path.c_str(), O_RDONLY | O_DIRECTORY);
+    REQUIRE(root >= 0);
+    std::mutex mutex;
+    std::set<std::string> files, dirs, left;
+    bool ordered = true;
+    TreeWalker::Visitor v;
+    v.directory = [&](const TreeWalker::Entry& e) {
+        std::lock_guard<std::mutex> lock(mutex);
+        dirs.insert(e.Path());
+        return true;
+    };
+    v.entry = [&](const TreeWalker::Entry& e) {
+        std::lock_guard<std::mutex> lock(mutex);
+        files.insert(e.Path());
+        if (left.count(e.dir.path)) ordered = false;
+    };
+    v.leave = [&](const TreeWalker::Dir& d) {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Every child directory must already have been left
+        for (const auto& other : dirs)
+            if (other.size() > d.path.size() && other.compare(0, d.path.size() + 1, d.path + "/") == 0 && !left.count(other))
+                ordered = false;
+        left.insert(d.path);
+    };
+    REQUIRE(TreeWalker(8).Walk(root, v));
+    close(root);
+
+    CHECK(files.size() == 4 * 4 * 20 + 600);
+    CHECK(dirs.size() == 4 + 16 + 1);
+    CHECK(left == dirs);
+    CHECK(ordered);
+}
+
+TEST_CASE("TreeWalker stays in the tree when a directory is swapped for a symlink", "[copy]") {
+    TempDir dir, outside;
+    WriteFile(dir.path / "a" / "b" / "inside", "x");
+    WriteFile(outside.path / "b" / "secret", "x");
+
+    int root = open(dir.path.c_str(), O_RDONLY | O_DIRECTORY);
+    REQUIRE(root >= 0);
+    std::mutex mutex;
+    std::set<std::string> files;
+    struct stat b_st, left_st{};
+    REQUIRE(stat((dir.path / "a" / "b").c_str(), &b_st) == 0);
+    TreeWalker::Visitor v;
+    // a/b is queued by now; a is replaced by a link to a tree that also has a b
+    v.directory = [&](const TreeWalker::Entry& e) {
+        if (e.Path() != "a/b") return true;
+        fs::rename(dir.path / "a", dir.path / "a.moved");
+        fs::create_directory_symlink(outside.path, dir.path / "a");
+        return true;
+    };
+    v.entry = [&](const TreeWalker::Entry& e) {
+        std::lock_guard<std::mutex> lock(mutex);
+        files.insert(std::string(e.name));
+    };
+    v.leave = [&](const TreeWalker::Dir& d) {
+        if (d.path == "a/b") fstatat(d.parent_fd, std::string(d.Name()).c_str(), &left_st, AT_SYMLINK_NOFOLLOW);
+    };
+    REQUIRE(TreeWalker(4).Walk(root, v));
+    close(root);
+
+    CHECK(files == std::set<std::string>{"inside"});
+    CHECK(left_st.st_ino == b_st.st_ino);
+}
+
+TEST_CASE("CopyEngine copies a tree with contents, modes and symlinks", "[copy]") {
+    TempDir dir;
+    fs::path src = dir.path / "src";
+    fs::path dst = dir.path / "dst";
+    BuildTree(src);
+    std::string big(3 * 1024 * 1024 + 7, 'x');
+    for (size_t i = 0; i < big.size(); i += 4096) big[i] = static_cast<char>('a' + i / 4096 % 26);
+    WriteFile(src / "big.bin", big);
+    chmod((src / "big.bin").c_str(), 0640);
+    fs::create_symlink("d0/e0/f1", src / "link");
+    chmod((src / "d1").c_str(), 0555);      // read-only directory must still be filled
+
+    CopyEngine engine(6);
+    REQUIRE(engine.CopyTree(src.string(), dst.string()));
+    CopyStats st = engine.Stats();
+    CHECK(st.errors == 0);
+    CHECK(st.files == 4 * 4 * 20 + 600 + 1);
+    CHECK(st.symlinks == 1);
+    CHECK(st.dirs == 21);
+
+    CHECK(ReadFile(dst / "big.bin") == big);
+    CHECK(ReadFile(dst / "d3" / "e2" / "f19") == "file 3219");
+    CHECK(ReadFile(dst / "wide" / "w599") == "599");
+    CHECK(fs::is_symlink(dst / "link"));
+    CHECK(fs::read_symlink(dst / "link") == "d0/e0/f1");
+    struct stat sb;
+    REQUIRE(stat((dst / "big.bin").c_str(), &sb) == 0);
+    CHECK((sb.st_mode & 0777) == 0640);
+    REQUIRE(stat((dst / "d1").c_str(), &sb) == 0);
+    CHECK((sb.st_mode & 0777) == 0555);
+    chmod((src / "d1").c_str(), 0755);
+    chmod((dst / "d1").c_str(), 0755);
+}
+
+TEST_CASE("CopyEngine refuses to copy a file onto itself", "[copy]") {
+    TempDir dir;
+    WriteFile(dir.path / "src" / "a", "keep me");
+    fs::create_hard_link(dir.path / "src" / "a", dir.path / "src" / "b");
+
+    CopyEngine engine(2);
+    fs::path a = dir.path / "src" / "a";
+    CHECK_THROWS_AS(engine.CopyFile(a.string(), a.string()), CommandError);
+    CHECK_THROWS_AS(engine.CopyFile(a.string(), (dir.path / "src" / "." / "a").string()), CommandError);
+    CHECK_THROWS_AS(engine.CopyFile(a.string(), (dir.path / "src" / "b").string()), CommandError);
+    CHECK(ReadFile(a) == "keep me");
+
+    // A tree copied over itself fails each file rather than emptying it
+    REQUIRE(engine.CopyTree((dir.path / "src").string(), (dir.path / "src").string()));
+    CHECK(engine.Stats().errors == 2);
+    CHECK(ReadFile(a) == "keep me");
+
+    // An ordinary existing destination is still truncated and overwritten
+    WriteFile(dir.path / "c", "a much longer old file");
+    engine.CopyFile(a.string(), (dir.path / "c").string());
+    CHECK(ReadFile(dir.path / "c") == "keep me");
+}
+
+TEST_CASE("CopyFileData falls back when reflink is unavailable", "[copy]") {
+    TempDir dir;
+    WriteFile(dir.path / "a", std::string(100000, 'q'));
+    int in = open((dir.path / "a").c_str(), O_RDONLY);
+    int out = open((dir.path / "b").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    REQUIRE(in >= 0);
+    REQUIRE(out >= 0);
+    CopyMethod method;
+    REQUIRE(CopyFileData(in, out, 100000, true, method));
+    close(in);
+    close(out);
+    CHECK(ReadFile(dir.path / "b") == std::string(100000, 'q'));
+}
+
+TEST_CASE("CopyFileData reports progress and stops when asked", "[copy]") {
+    TempDir dir;
+    WriteFile(dir.path / "a", std::string(300000, 'z'));
+    int in = open((dir.path / "a").c_str(), O_RDONLY);
+    int out = open((dir.path / "b").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    REQUIRE(in >= 0);
+    REQUIRE(out >= 0);
+    std::atomic<uint64_t> copied{0};
+    std::atomic<bool> stop{true};
+    CopyControl control;
+    control.copied = &copied;
+    control.stop = &stop;
+    CopyMethod method;
+    CHECK_FALSE(CopyFileData(in, out, 300000, false, method, control));
+    CHECK(errno == EINTR);
+    CHECK(copied == 0);
+
+    stop = false;
+    REQUIRE(CopyFileData(in, out, 300000, false, method, control));
+    close(in);
+    close(out);
+    CHECK(copied == 300000);
+    CHECK(ReadFile(dir.path / "b") == std::string(300000, 'z'));
+}
@@ -0,0 +1,117 @@
+#include <catch2/catch_all.hpp>
+#include "../src/modules/headers/Digest.hpp"
+#include "../src/modules/headers/FileHasher.hpp"
+#include "test_helpers.hpp"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace RedTops;
+namespace fs = std::filesystem;
+
+namespace {
+
+std::vector<uint8_t> Pattern(size_t n) {
+    std::vector<uint8_t> data(n);
+    for (size_t i = 0; i < n; ++i) data[i] = static_cast<uint8_t>(i * 31 + 7);
+    return data;
+}
+
+std::string Hex(HashAlgorithm algorithm, const std::vector<uint8_t>& data, unsigned threads = 1) {
+    return ToHex(ComputeDigest(algorithm, data.data(), data.size(), threads));
+}
+
+} // namespace
+
+TEST_CASE("Digests match the reference implementations", "[hash]") {
+    std::vector<uint8_t> empty, abc{'a', 'b', 'c'};
+    CHECK(Hex(HashAlgorithm::Xxh3, empty) == "2d06800538d394c2");
+    CHECK(Hex(HashAlgorithm::Xxh3, abc) == "78af5f94892f3950");
+    CHECK(Hex(HashAlgorithm::Sha256, abc) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    CHECK(Hex(HashAlgorithm::Blake3, empty) == "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262");
+    CHECK(Hex(HashAlgorithm::Blake3, abc) == "6437b3ac38465133ffb63b75273a8db548c558465d79db03fd359c6cd5bd9d85");
+
+    // Across the short, mid and long-input paths of each algorithm
+    struct Vector { size_t len; const char* xxh3; const char* sha256; const char* blake3; };
+    const Vector vectors[] = {
+        {1025, "c09fdfbc398c7d82", "15b5bbecf752ad00e85ff42843b5dce9df388bc38ab97cf06e528727f5937413",
+         "b8c5c46b114817810a6ed499350cb4d2423cd23dd08d32c137b226d8559b8ab0"},
+        {100000, "ccf90df7e7e37036", "731620161155f68e1209f22bc34a726bf5a583f40acf23ae55684b674fdbebf2",
+         "4e14b1e550c5a286b2fa16dc0046a7291b3c0cb164d880200354a68982e113ef"},
+        {3000001, "65f3fbe5210a58d8", "9edbdc3ee31fc094536998ae05ce80752c02929067f1bf002d042746ffd5f3f9",
+         "0877dd2f7b4af1b64140b0c9b5b5e16f90fe2e8d120d3cddd582667c86e3d62a"},
+    };
+    for (const auto& v : vectors) {
+        std::vector<uint8_t> data = Pattern(v.len);
+        CHECK(Hex(HashAlgorithm::Xxh3, data) == v.xxh3);
+        CHECK(Hex(HashAlgorithm::Sha256, data) == v.sha256);
+        CHECK(Hex(HashAlgorithm::Blake3, data) == v.blake3);
+        CHECK(Hex(HashAlgorithm::Blake3, data, 4) == v.blake3);     // subtrees on other threads
+    }
+}
+
+TEST_CASE("SIMD and scalar digests agree across input lengths", "[hash]") {
+    // Every length up to four XXH3 blocks covers each short-input path and
+    // SHA-256 padding case; the longer ones cross whole blocks and BLAKE3's
+    // eight-chunk subtrees
+    std::vector<size_t> lengths;
+    for (size_t n = 0; n <= 4096; ++n) lengths.push_back(n);
+    for (size_t n : {8191, 8192, 8193, 16385, 65536, 100003, (1 << 20) + 17}) lengths.push_back(n);
+    std::vector<uint8_t> data = Pattern(lengths.back());
+
+    std::vector<std::string> mismatches;
+    for (HashAlgorithm algorithm : {HashAlgorithm::Xxh3, HashAlgorithm::Sha256, HashAlgorithm::Blake3}) {
+        for (size_t n : lengths) {
+            SetDigestSimd(true);
+            std::vector<uint8_t> simd = ComputeDigest(algorithm, data.data(), n);
+            SetDigestSimd(false);
+            std::vector<uint8_t> scalar = ComputeDigest(algorithm, data.data(), n);
+            if (simd != scalar) mismatches.push_back(std::string(HashAlgorithmName(algorithm)) + " " + std::to_string(n));
+        }
+    }
+    SetDigestSimd(true);
+    CHECK(mismatches.empty());
+}
+
+TEST_CASE("Tree digests do not depend on the thread count", "[hash]") {
+    std::vector<uint8_t> data = Pattern(kDigestTreeLeaf * 2 + 12345);
+    for (HashAlgorithm algorithm : {HashAlgorithm::Xxh3, HashAlgorithm::Sha256}) {
+        std::vector<uint8_t> serial = TreeDigest(algorithm, data.data(), data.size(), 1);
+        CHECK(TreeDigest(algorithm, data.data(), data.size(), 3) == serial);
+        CHECK(serial != ComputeDigest(algorithm, data.data(), data.size()));
+    }
+    CHECK(TreeDigest(HashAlgorithm::Blake3, data.data(), data.size(), 2) ==
+          Blake3Digest(data.data(), data.size()));
+}
+
+TEST_CASE("FileHasher expands directories and hashes every file", "[hash]") {
+    TempDir dir;
+    std::vector<uint8_t> big = Pattern(300000), small = Pattern(10);
+    WriteFile(dir.path / "b" / "big", big);
+    WriteFile(dir.path / "a", small);
+    WriteFile(dir.path / "b" / "empty", std::string());
+    fs::create_symlink("a", dir.path / "link");
+
+    FileHasher::Options options;
+    options.algorithm = HashAlgorithm::Sha256;
+    options.threads = 3;
+    FileHasher hasher(options);
+    std::string root = dir.path.string();
+    std::vector<std::string> files = hasher.Collect({root, root + "/missing"});
+    REQUIRE(files == std::vector<std::string>{root + "/a", root + "/b/big", root + "/b/empty", root + "/missing"});
+
+    std::vector<HashResult> results;
+    REQUIRE(hasher.Hash(files, results));
+    REQUIRE(results.size() == 4);
+    CHECK(results[0].digest == Hex(HashAlgorithm::Sha256, small));
+    CHECK(results[1].digest == Hex(HashAlgorithm::Sha256, big));
+    CHECK(results[1].bytes == big.size());
+    CHECK(results[2].digest == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    CHECK(results[3].digest.empty());
+    CHECK_FALSE(results[3].error.empty());
+
+    HashStats st = hasher.Stats();
+    CHECK(st.files == 3);
+    CHECK(st.errors == 1);
+}
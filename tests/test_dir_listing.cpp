@@ -0,0 +1,52 @@
+#include <catch2/catch_all.hpp>
+#include "../src/modules/headers/DirListing.hpp"
+#include "test_helpers.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+
+#include <sys/stat.h>
+
+using namespace RedTops;
+namespace fs = std::filesystem;
+
+TEST_CASE("DirListing reads names and attributes with one statx per entry", "[ls]") {
+    TempDir dir;
+    std::ofstream(dir.path / "data.pcap") << std::string(1234, 'x');
+    std::ofstream(dir.path / ".hidden") << "h";
+    fs::create_directory(dir.path / "sub");
+    fs::create_symlink("data.pcap", dir.path / "link");
+    // Enough entries to take the threaded statx path
+    fs::create_directory(dir.path / "many");
+    for (int i = 0; i < 5000; ++i) std::ofstream(dir.path / "many" / std::to_string(i)) << std::string(i % 7, 'y');
+
+    DirListing visible = DirListing::Read(dir.path.string(), false, true);
+    std::map<std::string, ListedEntry> by_name;
+    for (const auto& e : visible.Entries()) by_name[std::string(visible.Name(e))] = e;
+    CHECK(by_name.size() == 4);
+    CHECK_FALSE(by_name.count(".hidden"));
+    REQUIRE(by_name.count("data.pcap"));
+    CHECK(by_name["data.pcap"].size == 1234);
+    CHECK(S_ISREG(by_name["data.pcap"].mode));
+    CHECK(S_ISDIR(by_name["sub"].mode));
+    CHECK(S_ISLNK(by_name["link"].mode));      // not followed
+    CHECK(by_name["data.pcap"].mtime_ns > 0);
+
+    CHECK(DirListing::Read(dir.path.string(), true, false).Size() == 5);
+
+    DirListing many = DirListing::Read((dir.path / "many").string(), false, true, 4);
+    REQUIRE(many.Size() == 5000);
+    bool sizes_ok = true;
+    for (const auto& e : many.Entries()) {
+        int i = std::stoi(std::string(many.Name(e)));
+        if (!e.has_stat || e.size != static_cast<uint64_t>(i % 7)) sizes_ok = false;
+    }
+    CHECK(sizes_ok);
+
+    ListedEntry target;
+    REQUIRE(StatEntry((dir.path / "link").string(), target));
+    CHECK(S_ISREG(target.mode));               // operands are followed
+    CHECK_THROWS(DirListing::Read((dir.path / "missing").string(), false, false));
+}
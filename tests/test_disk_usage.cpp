@@ -0,0 +1,78 @@
+#include <catch2/catch_all.hpp>
+#include "../src/modules/headers/DiskUsage.hpp"
+#include "test_helpers.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <sys/stat.h>
+
+using namespace RedTops;
+namespace fs = std::filesystem;
+
+namespace {
+
+void FillFile(const fs::path& p, size_t size) {
+    fs::create_directories(p.parent_path());
+    std::ofstream(p, std::ios::binary) << std::string(size, 'x');
+}
+
+// Apparent size of a directory inode itself
+uint64_t DirSize(const fs::path& p) {
+    struct stat st;
+    return lstat(p.c_str(), &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+}
+
+} // namespace
+
+TEST_CASE("DiskUsage rolls sizes up bottom-up and counts hardlinks once", "[du]") {
+    TempDir dir;
+    FillFile(dir.path / "big" / "a", 500000);
+    FillFile(dir.path / "big" / "deep" / "b", 300000);
+    for (int i = 0; i < 300; ++i) FillFile(dir.path / "wide" / ("f" + std::to_string(i)), 100);
+    FillFile(dir.path / "small" / "c", 10);
+    fs::create_hard_link(dir.path / "big" / "a", dir.path / "small" / "a-link");
+    fs::create_symlink("big/a", dir.path / "sym");
+
+    DiskUsage::Options options;
+    options.apparent = true;
+    options.top = 3;
+    options.threads = 6;
+    DiskUsage du(options);
+    REQUIRE(du.Scan(dir.path.string()));
+
+    UsageStats st = du.Stats();
+    CHECK(st.errors == 0);
+    CHECK(st.hardlinks == 1);
+    CHECK(st.files == 2 + 300 + 1 + 1);     // the symlink counts, the second link does not
+    CHECK(st.dirs == 5);
+
+    std::vector<UsageEntry> top = du.Top();
+    REQUIRE(top.size() == 4);                // the root plus the three heaviest
+    CHECK(top[0].path.empty());
+    CHECK(top[0].bytes == st.bytes);
+    CHECK(top[0].complete);
+
+    // Which directory the shared inode is charged to depends on walk order
+    uint64_t dirs = DirSize(dir.path) + DirSize(dir.path / "big") + DirSize(dir.path / "big" / "deep") +
+                    DirSize(dir.path / "wide") + DirSize(dir.path / "small");
+    uint64_t sym = fs::read_symlink(dir.path / "sym").string().size();
+    CHECK(top[0].bytes == dirs + 500000 + 300000 + 300 * 100 + 10 + sym);
+
+    bool saw_deep = false;
+    for (size_t i = 1; i < top.size(); ++i) {
+        CHECK(top[i - 1].bytes >= top[i].bytes);
+        if (top[i].path == "big/deep") {
+            saw_deep = true;
+            CHECK(top[i].bytes == DirSize(dir.path / "big" / "deep") + 300000);
+            CHECK(top[i].files == 1);
+        }
+    }
+    CHECK(saw_deep);
+}
+
+TEST_CASE("DiskUsage rejects a missing root", "[du]") {
+    DiskUsage du(DiskUsage::Options{});
+    CHECK_THROWS(du.Scan("/nonexistent/redtops_du"));
+}
@@ -0,0 +1,150 @@
+#include <catch2/catch_all.hpp>
+#include "../src/modules/headers/FileView.hpp"
+#include "../src/modules/headers/TextSearch.hpp"
+#include "../src/core/header/Exceptions.hpp"
+#include "test_helpers.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+using namespace RedTops;
+namespace fs = std::filesystem;
+
+namespace {
+
+void WaitForIndex(FileView& view) {
+    view.StartIndexing();
+    while (!view.Progress().done) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+}
+
+} // namespace
+
+TEST_CASE("FileView moves between lines by byte offset", "[view]") {
+    TempDir dir;
+    WriteFile(dir.path / "f.txt", "alpha\n\ngamma\ndelta");
+    FileView view((dir.path / "f.txt").string());
+    REQUIRE(view.Size() == 18);
+
+    CHECK(view.Line(0) == "alpha");
+    CHECK(view.NextLine(0) == 6);
+    CHECK(view.Line(6).empty());
+    CHECK(view.NextLine(6) == 7);
+    CHECK(view.LineStart(10) == 7);
+    CHECK(view.PrevLine(13) == 7);
+    CHECK(view.PrevLine(7) == 6);
+    CHECK(view.PrevLine(3) == 0);
+    // The unterminated last line still reads and ends at Size()
+    CHECK(view.Line(13) == "delta");
+    CHECK(view.NextLine(13) == view.Size());
+
+    WaitForIndex(view);
+    CHECK(view.Progress().lines == 4);
+}
+
+TEST_CASE("FileView line index maps numbers and offsets both ways", "[view]") {
+    TempDir dir;
+    const uint64_t total = 300000;
+    std::string text;
+    for (uint64_t i = 0; i < total; ++i) text += std::to_string(i) + (i % 7 == 0 ? " padding padding\n" : "\n");
+    WriteFile(dir.path / "n.txt", text);
+
+    FileView view((dir.path / "n.txt").string());
+    WaitForIndex(view);
+    CHECK(view.Progress().lines == total);
+    CHECK(view.Progress().bytes == text.size());
+
+    for (uint64_t line : {0ull, 1ull, 255ull, 256ull, 257ull, 12345ull, 299999ull}) {
+        uint64_t offset = 0, back = 0;
+        REQUIRE(view.LineOffset(line, offset));
+        std::string_view shown = view.Line(offset);
+        CHECK(shown.substr(0, shown.find(' ')) == std::to_string(line));
+        REQUIRE(view.LineNumber(offset, back));
+        CHECK(back == line);
+        // Any offset inside the line maps to the same number
+        REQUIRE(view.LineNumber(offset + shown.size() / 2, back));
+        CHECK(back == line);
+    }
+    uint64_t offset = 0;
+    CHECK_FALSE(view.LineOffset(total, offset));
+}
+
+TEST_CASE("FileView searches forward and backward", "[view]") {
+    TempDir dir;
+    std::string text;
+    for (int i = 0; i < 20000; ++i) text += (i % 5000 == 42 ? "hit " : "line ") + std::to_string(i) + "\n";
+    WriteFile(dir.path / "s.txt", text);
+    FileView view((dir.path / "s.txt").string());
+
+    TextMatcher fixed({"hit"}, true, false);
+    size_t len = 0;
+    uint64_t first = view.Search(fixed, 0, true, len);
+    REQUIRE(first != kNoMatch);
+    CHECK(len == 3);
+    CHECK(view.Line(first) == "hit 42");
+    uint64_t second = view.Search(fixed, first + 1, true, len);
+    REQUIRE(second != kNoMatch);
+    CHECK(view.Line(second) == "hit 5042");
+
+    uint64_t last = view.Search(fixed, view.Size(), false, len);
+    REQUIRE(last != kNoMatch);
+    CHECK(view.Line(last) == "hit 15042");
+    uint64_t before = view.Search(fixed, last, false, len);
+    REQUIRE(before != kNoMatch);
+    CHECK(view.Line(before) == "hit 10042");
+    CHECK(view.Search(fixed, first, false, len) == kNoMatch);
+
+    TextMatcher regex({"^hit [0-9]+042$"}, false, false);
+    uint64_t r = view.Search(regex, view.Size(), false, len);
+    REQUIRE(r != kNoMatch);
+    CHECK(view.Line(r) == "hit 15042");
+}
+
+TEST_CASE("FileView survives the file shrinking underneath it", "[view]") {
+    TempDir dir;
+    std::string text;
+    for (int i = 0; i < 200000; ++i) text += "line " + std::to_string(i) + "\n";
+    WriteFile(dir.path / "t.log", text);
+    FileView view((dir.path / "t.log").string());
+    CHECK_FALSE(view.Refresh());
+    WaitForIndex(view);
+
+    // copytruncate: the log is cut back to a few lines
+    REQUIRE(truncate((dir.path / "t.log").c_str(), 14) == 0);
+    TextMatcher matcher({"line 150000"}, true, false);
+    size_t len = 0;
+    CHECK(view.Search(matcher, 0, true, len) == kNoMatch);
+    REQUIRE(view.Refresh());
+    CHECK(view.Size() == 14);
+    CHECK(view.Line(7) == "line 1");
+    CHECK(view.NextLine(7) == 14);
+    CHECK(view.Line(100000).empty());
+    // Reading the old tail of the mapping no longer faults
+    CHECK(view.Data()[text.size() - 1] == '\0');
+
+    WaitForIndex(view);
+    CHECK(view.Progress().lines == 2);
+    uint64_t offset = 0;
+    CHECK_FALSE(view.LineOffset(2, offset));
+    CHECK_FALSE(view.Refresh());
+}
+
+TEST_CASE("FileView handles empty and missing files", "[view]") {
+    TempDir dir;
+    WriteFile(dir.path / "empty", "");
+    FileView view((dir.path / "empty").string());
+    CHECK(view.Size() == 0);
+    CHECK(view.Line(0).empty());
+    view.StartIndexing();
+    CHECK(view.Progress().done);
+    CHECK(view.Progress().lines == 0);
+    TextMatcher matcher({"x"}, true, false);
+    size_t len = 0;
+    CHECK(view.Search(matcher, 0, true, len) == kNoMatch);
+
+    CHECK_THROWS_AS(FileView((dir.path / "missing").string()), CommandError);
+    CHECK_THROWS_AS(FileView(dir.path.string()), CommandError);
+}
@@ -0,0 +1,45 @@
+#include <catch2/catch_all.hpp>
+#include "../src/modules/headers/HardwareInventory.hpp"
+
+using namespace RedTops;
+
+TEST_CASE("CPU lists expand ranges and singles", "[hardware]") {
+    CHECK(ParseCpuList("0-3,8,10-11\n") == std::vector<int>{0, 1, 2, 3, 8, 10, 11});
+    CHECK(ParseCpuList("5") == std::vector<int>{5});
+    CHECK(ParseCpuList("").empty());
+}
+
+TEST_CASE("cpuinfo is parsed into logical CPUs and topology", "[hardware]") {
+    // Two sockets, one core each, two hardware threads per core
+    std::string text;
+    const int sockets[] = {0, 0, 1, 1};
+    for (int i = 0; i < 4; ++i) {
+        text += "processor\t: " + std::to_string(i) + "\n"
+                "vendor_id\t: GenuineIntel\n"
+                "model name\t: Test CPU @ 2.00GHz\n"
+                "microcode\t: 0x2a\n"
+                "cache size\t: 1024 KB\n"
+                "physical id\t: " + std::to_string(sockets[i]) + "\n"
+                "core id\t\t: 0\n"
+                "flags\t\t: " + std::string(i == 3 ? "fpu sse" : "fpu sse avx") + "\n"
+                "bogomips\t: 4000.00\n"
+                "\n";
+    }
+
+    HardwareInventory inv = HardwareInventory::FromCpuInfo(text);
+    REQUIRE(inv.cpus.size() == 4);
+    CHECK(inv.model == "Test CPU @ 2.00GHz");
+    CHECK(inv.vendor == "GenuineIntel");
+    CHECK(inv.microcode == "0x2a");
+    CHECK(inv.cache_size_bytes == 1024 * 1024);
+    CHECK(inv.sockets == 2);
+    CHECK(inv.physical_cores == 2);
+    CHECK(inv.threads_per_core == 2);
+    CHECK(inv.cpus[2].socket == 1);
+    CHECK(inv.cpus[1].bogomips == 4000.0);
+
+    // Identical flag lists are stored once
+    REQUIRE(inv.flag_sets.size() == 2);
+    CHECK(inv.cpus[0].flag_set == inv.cpus[2].flag_set);
+    CHECK(inv.flag_sets[inv.cpus[3].flag_set] == "fpu sse");
+}
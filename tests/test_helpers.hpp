@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Scratch files for the tests of the filesystem modules
+
+// A fresh directory, removed with everything in it at the end of the test.
+// /dev/shm is tmpfs where it exists, so a base there usually puts the
+// directory on a different filesystem from /tmp.
+struct TempDir {
+    std::filesystem::path path;
+    explicit TempDir(const char* base = "/tmp") {
+        std::string tmpl = std::string(std::filesystem::is_directory(base) ? base : "/tmp") + "/redtops_test_XXXXXX";
+        path = mkdtemp(tmpl.data());
+    }
+    ~TempDir() { std::filesystem::remove_all(path); }
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+};
+
+// Writes data to p, creating its parent directories
+inline void WriteFile(const std::filesystem::path& p, const std::string& data) {
+    std::filesystem::create_directories(p.parent_path());
+    std::ofstream(p, std::ios::binary) << data;
+}
+
+inline void WriteFile(const std::filesystem::path& p, const std::vector<uint8_t>& data) {
+    std::filesystem::create_directories(p.parent_path());
+    std::ofstream(p, std::ios::binary)
+        .write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+inline std::string ReadFile(const std::filesystem::path& p) {
+    std::ifstream in(p, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), {});
+}
@@ -0,0 +1,114 @@
+#include <catch2/catch_all.hpp>
+#include "../src/modules/headers/LogFollower.hpp"
+#include "../src/modules/headers/TextSearch.hpp"
+#include "test_helpers.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace RedTops;
+namespace fs = std::filesystem;
+
+namespace {
+
+void Append(const fs::path& p, const std::string& text) {
+    std::ofstream(p, std::ios::app | std::ios::binary) << text;
+}
+
+struct Collector {
+    std::vector<std::string> lines;
+    std::vector<std::string> notices;
+    LogFollower::Handler handler;
+
+    Collector() {
+        handler.line = [this](size_t, std::string_view line) { lines.emplace_back(line); };
+        handler.notice = [this](size_t, const std::string& message) { notices.push_back(message); };
+    }
+
+    // Polls until nothing more arrives
+    void Drain(LogFollower& follower) {
+        while (follower.Poll(handler, 200)) {}
+    }
+};
+
+} // namespace
+
+TEST_CASE("LogFollower shows the last lines, then only what is appended", "[log]") {
+    TempDir dir;
+    fs::path log = dir.path / "app.log";
+    Append(log, "one\ntwo\nthree\nfour\n");
+
+    LogFollower::Options options;
+    options.initial_lines = 2;
+    LogFollower follower({log.string()}, options);
+    Collector c;
+    follower.Start(c.handler);
+    CHECK(c.lines == std::vector<std::string>{"three", "four"});
+
+    // An unterminated line waits for its newline
+    Append(log, "five\nsi");
+    c.Drain(follower);
+    CHECK(c.lines.back() == "five");
+    Append(log, "x\n");
+    c.Drain(follower);
+    CHECK(c.lines.back() == "six");
+    CHECK(c.lines.size() == 4);
+    CHECK(follower.Stats().lines == 4);
+}
+
+TEST_CASE("LogFollower survives truncation and rotation", "[log]") {
+    TempDir dir;
+    fs::path log = dir.path / "app.log";
+    Append(log, "old\n");
+
+    LogFollower follower({log.string()}, LogFollower::Options{});
+    Collector c;
+    follower.Start(c.handler);
+
+    // copytruncate, seen before the next write as it is with a live writer
+    fs::resize_file(log, 0);
+    c.Drain(follower);
+    Append(log, "after truncate\n");
+    c.Drain(follower);
+    CHECK(c.lines.back() == "after truncate");
+    CHECK(follower.Stats().truncations == 1);
+
+    // rename and create: the old file is drained, the new one read from its start
+    fs::rename(log, dir.path / "app.log.1");
+    Append(dir.path / "app.log.1", "last of old\n");
+    c.Drain(follower);
+    Append(log, "first of new\n");
+    c.Drain(follower);
+    REQUIRE(c.lines.size() >= 4);
+    CHECK(c.lines[c.lines.size() - 2] == "last of old");
+    CHECK(c.lines.back() == "first of new");
+    CHECK(follower.Stats().rotations == 1);
+
+    Append(log, "more\n");
+    c.Drain(follower);
+    CHECK(c.lines.back() == "more");
+}
+
+TEST_CASE("LogFollower filters lines and waits for missing files", "[log]") {
+    TempDir dir;
+    fs::path log = dir.path / "later.log";
+    TextMatcher matcher({"ERROR"}, true, false);
+    LogFollower::Options options;
+    options.matcher = &matcher;
+    LogFollower follower({log.string()}, options);
+    Collector c;
+    follower.Start(c.handler);
+    CHECK(c.lines.empty());
+    CHECK(c.notices.size() == 1);
+
+    std::string text;
+    for (int i = 0; i < 5000; ++i) text += (i % 1000 == 7 ? "ERROR " : "info ") + std::to_string(i) + "\n";
+    Append(log, text);
+    c.Drain(follower);
+    CHECK(c.lines == std::vector<std::string>{"ERROR 7", "ERROR 1007", "ERROR 2007", "ERROR 3007", "ERROR 4007"});
+    CHECK(follower.Stats().lines == 5000);
+    CHECK(follower.Stats().shown == 5);
+}
@@ -0,0 +1,99 @@
+#include <catch2/catch_all.hpp>
+#include "../src/modules/headers/MetricsExporter.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+using namespace RedTops;
+
+namespace {
+
+// Minimal loopback HTTP client: one request, read until the server closes
+std::string HttpGet(const std::string& address, const std::string& request) {
+    size_t colon = address.rfind(':');
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(std::atoi(address.c_str() + colon + 1)));
+    inet_pton(AF_INET, address.substr(0, colon).c_str(), &addr.sin_addr);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    REQUIRE(fd >= 0);
+    REQUIRE(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    REQUIRE(send(fd, request.data(), request.size(), 0) == static_cast<ssize_t>(request.size()));
+    std::string response;
+    char buf[4096];
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) response.append(buf, static_cast<size_t>(n));
+    close(fd);
+    return response;
+}
+
+std::string Body(const std::string& response) {
+    size_t split = response.find("\r\n\r\n");
+    return split == std::string::npos ? std::string() : response.substr(split + 4);
+}
+
+} // namespace
+
+TEST_CASE("MetricsWriter renders OpenMetrics families", "[exporter]") {
+    MetricsWriter w;
+    w.Family("test_bytes", MetricsWriter::Type::Counter, "Bytes seen");
+    w.Sample(1024, {{"device", "eth0"}});
+    w.Family("test_temp", MetricsWriter::Type::Gauge, "A \"quoted\" help");
+    w.Sample(0.5, {{"path", "a\\b\n"}, {"x", "y"}});
+    w.Sample(1.0 / 0.0);
+
+    CHECK(w.Finish() ==
+          "# TYPE test_bytes counter\n"
+          "# HELP test_bytes Bytes seen\n"
+          "test_bytes_total{device=\"eth0\"} 1024\n"
+          "# TYPE test_temp gauge\n"
+          "# HELP test_temp A \\\"quoted\\\" help\n"
+          "test_temp{path=\"a\\\\b\\n\",x=\"y\"} 0.5\n"
+          "test_temp +Inf\n"
+          "# EOF\n");
+}
+
+TEST_CASE("Exporter answers scrapes over loopback HTTP", "[exporter]") {
+    std::atomic<int> calls{0};
+    MetricsExporter exporter("127.0.0.1:0", 100);
+    exporter.AddCollector("test", [&](MetricsWriter& w) {
+        w.Family("test_value", MetricsWriter::Type::Gauge, "A test value");
+        w.Sample(42);
+        ++calls;
+    });
+    exporter.AddCollector("broken", [](MetricsWriter& w) {
+        w.Family("broken_value", MetricsWriter::Type::Gauge, "Never completes");
+        throw std::runtime_error("collector failed");
+    });
+    exporter.Start();
+    CHECK(calls >= 1);   // rendered before the first scrape
+
+    std::string response = HttpGet(exporter.Address(), "GET /metrics HTTP/1.1\r\nHost: x\r\n\r\n");
+    CHECK(response.rfind("HTTP/1.1 200 OK\r\n", 0) == 0);
+    CHECK(response.find("Content-Type: application/openmetrics-text") != std::string::npos);
+    std::string body = Body(response);
+    CHECK(response.find("Content-Length: " + std::to_string(body.size()) + "\r\n") != std::string::npos);
+    CHECK(body.find("test_value 42\n") != std::string::npos);
+    CHECK(body.find("broken_value") == std::string::npos);
+    CHECK(body.find("redtops_exporter_collector_success{collector=\"test\"} 1\n") != std::string::npos);
+    CHECK(body.find("redtops_exporter_collector_success{collector=\"broken\"} 0\n") != std::string::npos);
+    CHECK(body.size() >= 6);
+    CHECK(body.substr(body.size() - 6) == "# EOF\n");
+
+    CHECK(HttpGet(exporter.Address(), "GET /nope HTTP/1.1\r\n\r\n").rfind("HTTP/1.1 404", 0) == 0);
+    CHECK(HttpGet(exporter.Address(), "POST /metrics HTTP/1.1\r\n\r\n").rfind("HTTP/1.1 405", 0) == 0);
+    std::string head = HttpGet(exporter.Address(), "HEAD /metrics HTTP/1.1\r\n\r\n");
+    CHECK(head.rfind("HTTP/1.1 200 OK\r\n", 0) == 0);
+    CHECK(Body(head).empty());
+    CHECK(exporter.Scrapes() == 2);
+
+    exporter.Stop();
+}
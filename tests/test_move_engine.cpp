@@ -0,0 +1,124 @@
+#include <catch2/catch_all.hpp>
+#include "../src/modules/headers/MoveEngine.hpp"
+#include "../src/core/header/Exceptions.hpp"
+#include "test_helpers.hpp"
+
+#include <filesystem>
+#include <iterator>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace RedTops;
+namespace fs = std::filesystem;
+
+namespace {
+
+struct stat Lstat(const fs::path& p) {
+    struct stat st{};
+    lstat(p.c_str(), &st);
+    return st;
+}
+
+} // namespace
+
+TEST_CASE("MoveEngine moves a tree with its metadata and links, then removes it", "[move]") {
+    TempDir from("/dev/shm"), to;
+    fs::path src = from.path / "captures";
+    std::string big(3 * 1024 * 1024 + 17, 'x');
+    for (size_t i = 0; i < big.size(); i += 4096) big[i] = static_cast<char>('a' + i % 26);
+    WriteFile(src / "big.pcap", big);
+    for (int d = 0; d < 5; ++d)
+        for (int f = 0; f < 40; ++f)
+            WriteFile(src / ("d" + std::to_string(d)) / ("f" + std::to_string(f)), std::to_string(d * 100 + f));
+    chmod((src / "d1" / "f1").c_str(), 0640);
+    chmod((src / "d2").c_str(), 0750);
+    fs::create_symlink("d0/f0", src / "link");
+    fs::create_hard_link(src / "d3" / "f3", src / "d4" / "hard");
+    mkfifo((src / "pipe").c_str(), 0600);
+    struct timespec old[2] = {{1000000000, 0}, {1000000000, 123456789}};
+    utimensat(AT_FDCWD, (src / "d0" / "f0").c_str(), old, 0);
+    utimensat(AT_FDCWD, (src / "d2").c_str(), old, 0);
+
+    MoveEngine engine(MoveEngine::Options{});
+    fs::path dst = to.path / "archive";
+    REQUIRE(engine.MoveTree(src.string(), dst.string()));
+    CHECK(engine.Errors().empty());
+    CHECK(engine.Arrived());
+    CHECK(engine.SourceRemoved());
+    CHECK_FALSE(fs::exists(src));
+
+    MoveStats st = engine.Stats();
+    CHECK(st.files == 201);     // the second name of d3/f3 is a link, not a copy
+    CHECK(st.links == 1);
+    CHECK(st.symlinks == 1);
+    CHECK(st.specials == 1);
+    CHECK(st.dirs == 5);
+    CHECK(st.verified == st.bytes);
+
+    CHECK(ReadFile(dst / "big.pcap") == big);
+    CHECK(ReadFile(dst / "d4" / "f39") == "439");
+    CHECK((Lstat(dst / "d1" / "f1").st_mode & 07777) == 0640);
+    CHECK((Lstat(dst / "d2").st_mode & 07777) == 0750);
+    CHECK(Lstat(dst / "d0" / "f0").st_mtim.tv_nsec == 123456789);
+    CHECK(Lstat(dst / "d2").st_mtim.tv_sec == 1000000000);
+    CHECK(fs::read_symlink(dst / "link") == "d0/f0");
+    CHECK(Lstat(dst / "d3" / "f3").st_ino == Lstat(dst / "d4" / "hard").st_ino);
+    CHECK(S_ISFIFO(Lstat(dst / "pipe").st_mode));
+}
+
+TEST_CASE("MoveEngine keeps what appeared in the source during the move", "[move]") {
+    TempDir from("/dev/shm"), to;
+    fs::path src = from.path / "captures";
+    // Big enough for the copy and verify to outlast a few 100 ms ticks
+    WriteFile(src / "big.pcap", std::string(96 * 1024 * 1024, 'p'));
+    WriteFile(src / "d0" / "f0", "f0");
+
+    bool written = false;
+    auto tick = [&] {
+        if (written) return;
+        WriteFile(src / "d0" / "late.pcap", "late");
+        written = true;
+    };
+    MoveEngine engine(MoveEngine::Options{});
+    fs::path dst = to.path / "archive";
+    REQUIRE(engine.MoveTree(src.string(), dst.string(), {}, tick));
+    REQUIRE(written);
+    CHECK(engine.Arrived());
+    CHECK_FALSE(engine.SourceRemoved());
+    CHECK(engine.Stats().errors >= 1);
+    // The file that was not copied survives, with the directories above it
+    CHECK(ReadFile(src / "d0" / "late.pcap") == "late");
+    CHECK_FALSE(fs::exists(src / "big.pcap"));
+    CHECK_FALSE(fs::exists(src / "d0" / "f0"));
+    CHECK(ReadFile(dst / "d0" / "f0") == "f0");
+}
+
+TEST_CASE("MoveEngine replaces a file and leaves no temporary behind", "[move]") {
+    TempDir from("/dev/shm"), to;
+    WriteFile(from.path / "a.log", "new contents\n");
+    chmod((from.path / "a.log").c_str(), 0604);
+    WriteFile(to.path / "a.log", "old");
+
+    MoveEngine engine(MoveEngine::Options{});
+    REQUIRE(engine.MoveFile((from.path / "a.log").string(), (to.path / "a.log").string()));
+    CHECK_FALSE(fs::exists(from.path / "a.log"));
+    CHECK(ReadFile(to.path / "a.log") == "new contents\n");
+    CHECK((Lstat(to.path / "a.log").st_mode & 07777) == 0604);
+    CHECK(std::distance(fs::directory_iterator(to.path), fs::directory_iterator{}) == 1);
+    CHECK(engine.Stats().verified == 13);
+}
+
+TEST_CASE("MoveEngine keeps the source when the destination is not empty", "[move]") {
+    TempDir from, to;
+    WriteFile(from.path / "src" / "f", "data");
+    WriteFile(to.path / "dst" / "other", "x");
+
+    MoveEngine engine(MoveEngine::Options{});
+    CHECK_THROWS_AS(engine.MoveTree((from.path / "src").string(), (to.path / "dst").string()), CommandError);
+    CHECK(ReadFile(from.path / "src" / "f") == "data");
+    CHECK_FALSE(fs::exists(to.path / "dst" / "f"));
+    CHECK_FALSE(engine.SourceRemoved());
+}
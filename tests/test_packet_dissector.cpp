@@ -0,0 +1,197 @@
+#include <catch2/catch_all.hpp>
+#include "../src/modules/headers/PacketDissector.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace RedTops;
+
+namespace {
+
+// Small frame builder; tests only, so allocation is fine here
+struct Frame {
+    std::vector<uint8_t> bytes;
+
+    Frame& U8(uint8_t v) { bytes.push_back(v); return *this; }
+    Frame& U16(uint16_t v) { U8(static_cast<uint8_t>(v >> 8)); return U8(static_cast<uint8_t>(v)); }
+    Frame& U32(uint32_t v) { U16(static_cast<uint16_t>(v >> 16)); return U16(static_cast<uint16_t>(v)); }
+    Frame& Raw(std::initializer_list<uint8_t> v) { bytes.insert(bytes.end(), v); return *this; }
+    Frame& Zero(size_t n) { bytes.insert(bytes.end(), n, 0); return *this; }
+
+    Frame& Ethernet(uint16_t type) {
+        Raw({0x00, 0x11, 0x22, 0x33, 0x44, 0x55});  // dst
+        Raw({0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb});  // src
+        return U16(type);
+    }
+    Frame& IPv4(uint8_t proto, uint16_t payload) {
+        U8(0x45).U8(0).U16(static_cast<uint16_t>(20 + payload)).U16(1).U16(0x4000).U8(64).U8(proto).U16(0);
+        Raw({10, 0, 0, 1});
+        return Raw({10, 0, 0, 2});
+    }
+    Frame& IPv6(uint8_t next, uint16_t payload) {
+        U32(0x60000000).U16(payload).U8(next).U8(32);
+        Raw({0x20, 0x01, 0x0d, 0xb8}).Zero(11).U8(1);
+        return Raw({0x20, 0x01, 0x0d, 0xb8}).Zero(11).U8(2);
+    }
+    Frame& Tcp(uint16_t sport, uint16_t dport, uint8_t flags) {
+        return U16(sport).U16(dport).U32(1000).U32(2000).U8(0x50).U8(flags).U16(65535).U16(0).U16(0);
+    }
+    Frame& Udp(uint16_t sport, uint16_t dport, uint16_t payload) {
+        return U16(sport).U16(dport).U16(static_cast<uint16_t>(8 + payload)).U16(0);
+    }
+
+    DissectedPacket Decode(uint32_t caplen = 0) const {
+        DissectedPacket pkt;
+        uint32_t len = static_cast<uint32_t>(bytes.size());
+        Dissect(bytes.data(), caplen ? caplen : len, len, pkt);
+        return pkt;
+    }
+};
+
+} // namespace
+
+TEST_CASE("Dissector decodes Ethernet/IPv4/TCP", "[dissector]") {
+    Frame f;
+    f.Ethernet(0x0800).IPv4(6, 20 + 4).Tcp(443, 51000, TcpFlag::SYN | TcpFlag::ACK).Raw({1, 2, 3, 4});
+    DissectedPacket pkt = f.Decode();
+
+    REQUIRE(pkt.l3 == L3Proto::IPv4);
+    REQUIRE(pkt.l4_proto == 6);
+    REQUIRE(pkt.src_port == 443);
+    REQUIRE(pkt.dst_port == 51000);
+    REQUIRE(pkt.tcp_flags == (TcpFlag::SYN | TcpFlag::ACK));
+    REQUIRE(pkt.tcp_seq == 1000);
+    REQUIRE(pkt.l3_offset == 14);
+    REQUIRE(pkt.l4_offset == 34);
+    REQUIRE(pkt.payload_offset == 54);
+    REQUIRE(pkt.payload_length == 4);
+    REQUIRE(pkt.flags == DissectFlag::HasPorts);
+
+    char line[256];
+    size_t n = FormatSummary(pkt, line, sizeof(line));
+    REQUIRE(n == std::strlen(line));
+    REQUIRE(std::string(line).find("10.0.0.1:443 > 10.0.0.2:51000 TCP [SA]") != std::string::npos);
+}
+
+TEST_CASE("Dissector walks QinQ tags", "[dissector]") {
+    Frame f;
+    f.Ethernet(0x88a8).U16(100).U16(0x8100).U16(200).U16(0x0800).IPv4(17, 8).Udp(53, 5353, 0);
+    DissectedPacket pkt = f.Decode();
+
+    REQUIRE(pkt.vlan_count == 2);
+    REQUIRE(pkt.vlan_ids[0] == 100);
+    REQUIRE(pkt.vlan_ids[1] == 200);
+    REQUIRE(pkt.l3_offset == 22);
+    REQUIRE(pkt.l4_proto == 17);
+    REQUIRE(pkt.dst_port == 5353);
+}
+
+TEST_CASE("Dissector follows IPv6 extension headers", "[dissector]") {
+    Frame f;
+    // hop-by-hop (8 bytes) -> destination options (8 bytes) -> ICMPv6 echo request
+    f.Ethernet(0x86dd).IPv6(0, 8 + 8 + 8);
+    f.U8(60).U8(0).Zero(6);
+    f.U8(58).U8(0).Zero(6);
+    f.U8(128).U8(0).U16(0).U16(7).U16(9);
+    DissectedPacket pkt = f.Decode();
+
+    REQUIRE(pkt.l3 == L3Proto::IPv6);
+    REQUIRE(pkt.ipv6_ext_headers == 2);
+    REQUIRE(pkt.l4_proto == 58);
+    REQUIRE((pkt.flags & DissectFlag::HasIcmp) != 0);
+    REQUIRE(pkt.icmp_type == 128);
+    REQUIRE(pkt.icmp_id == 7);
+    REQUIRE(pkt.icmp_seq == 9);
+
+    char addr[64];
+    FormatAddress(pkt, true, addr, sizeof(addr));
+    REQUIRE(std::string(addr) == "2001:db8::1");
+}
+
+TEST_CASE("Dissector decodes ARP", "[dissector]") {
+    Frame f;
+    f.Ethernet(0x0806).U16(1).U16(0x0800).U8(6).U8(4).U16(1);
+    f.Raw({0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb}).Raw({192, 168, 1, 10});
+    f.Zero(6).Raw({192, 168, 1, 1});
+    DissectedPacket pkt = f.Decode();
+
+    REQUIRE(pkt.l3 == L3Proto::ARP);
+    REQUIRE(pkt.arp_op == 1);
+    char line[128];
+    FormatSummary(pkt, line, sizeof(line));
+    REQUIRE(std::string(line).rfind("ARP who-has 192.168.1.1 tell 192.168.1.10", 0) == 0);
+}
+
+TEST_CASE("Dissector decodes the packet inside GRE", "[dissector]") {
+    Frame f;
+    f.Ethernet(0x0800).IPv4(47, 8 + 20 + 8);
+    f.U16(0x2000).U16(0x0800).U32(42);          // GRE with key
+    f.IPv4(17, 8).Udp(4789, 4789, 0);
+    DissectedPacket pkt = f.Decode();
+
+    REQUIRE((pkt.flags & DissectFlag::HasGre) != 0);
+    REQUIRE((pkt.flags & DissectFlag::Tunneled) != 0);
+    REQUIRE(pkt.gre_key == 42);
+    REQUIRE(pkt.gre_offset == 34);
+    REQUIRE(pkt.l4_proto == 17);
+    REQUIRE(pkt.dst_port == 4789);
+}
+
+TEST_CASE("Dissector bounds-checks truncated and lying headers", "[dissector]") {
+    Frame f;
+    f.Ethernet(0x0800).IPv4(6, 20).Tcp(1, 2, TcpFlag::SYN);
+
+    SECTION("caplen cuts into the TCP header") {
+        DissectedPacket pkt = f.Decode(40);
+        REQUIRE((pkt.flags & DissectFlag::Truncated) != 0);
+        REQUIRE((pkt.flags & DissectFlag::HasPorts) == 0);
+    }
+    SECTION("ihl claims more than was captured") {
+        Frame bad = f;
+        bad.bytes[14] = 0x4f;  // ihl = 60 bytes
+        bad.bytes[17] = 80;    // total length that agrees with it
+        DissectedPacket pkt = bad.Decode(40);
+        REQUIRE((pkt.flags & DissectFlag::Truncated) != 0);
+        REQUIRE(pkt.l4_offset == kNoOffset);
+    }
+    SECTION("frame shorter than an Ethernet header") {
+        DissectedPacket pkt;
+        REQUIRE_FALSE(Dissect(f.bytes.data(), 10, 10, pkt));
+    }
+    SECTION("formatters respect tiny buffers") {
+        DissectedPacket pkt = f.Decode();
+        char tiny[8];
+        size_t n = FormatDetail(pkt, tiny, sizeof(tiny));
+        REQUIRE(n == 7);
+        REQUIRE(tiny[7] == '\0');
+    }
+}
+
+// Decode-rate microbenchmark. Hidden from the default run and from ctest, since
+// a wall-clock figure depends on the machine; run it with
+// `redtops_tests "[benchmark]"` to print packets/sec.
+TEST_CASE("Dissector decode rate", "[.][benchmark]") {
+    std::vector<Frame> frames(4);
+    frames[0].Ethernet(0x0800).IPv4(6, 20 + 64).Tcp(443, 51000, TcpFlag::ACK).Zero(64);
+    frames[1].Ethernet(0x8100).U16(10).U16(0x86dd).IPv6(17, 8 + 32).Udp(53, 40000, 32).Zero(32);
+    frames[2].Ethernet(0x0800).IPv4(47, 4 + 20 + 8).U16(0).U16(0x0800).IPv4(17, 8).Udp(1, 2, 0);
+    frames[3].Ethernet(0x0806).U16(1).U16(0x0800).U8(6).U8(4).U16(2).Zero(20);
+
+    constexpr uint64_t kIterations = 2'000'000;
+    DissectedPacket pkt;
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < kIterations; ++i) {
+        const Frame& f = frames[i & 3];
+        Dissect(f.bytes.data(), static_cast<uint32_t>(f.bytes.size()), static_cast<uint32_t>(f.bytes.size()), pkt);
+        checksum += pkt.l4_proto + pkt.dst_port;
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double pps = kIterations / secs;
+
+    std::cout << "PacketDissector: " << static_cast<uint64_t>(pps) << " packets/sec ("
+              << kIterations << " packets in " << secs << "s, checksum " << checksum << ")\n";
+    CHECK(checksum > 0);
+}
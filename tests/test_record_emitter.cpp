@@ -0,0 +1,92 @@
+#include <catch2/catch_all.hpp>
+#include "../src/core/header/RecordEmitter.hpp"
+#include "../src/core/header/TerminalRenderer.hpp"
+#include "../src/core/header/Exceptions.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+// Points fd 1, std::cout and std::cerr at buffers the test can read back
+struct CapturedOutput {
+    std::ostringstream out, err;
+    std::streambuf* saved_out;
+    std::streambuf* saved_err;
+    int saved_fd;
+    FILE* records;
+
+    CapturedOutput() {
+        std::cout.flush();
+        records = std::tmpfile();
+        saved_fd = dup(STDOUT_FILENO);
+        dup2(fileno(records), STDOUT_FILENO);
+        saved_out = std::cout.rdbuf(out.rdbuf());
+        saved_err = std::cerr.rdbuf(err.rdbuf());
+    }
+    ~CapturedOutput() {
+        std::cout.rdbuf(saved_out);
+        std::cerr.rdbuf(saved_err);
+        dup2(saved_fd, STDOUT_FILENO);
+        close(saved_fd);
+        std::fclose(records);
+    }
+
+    // What went to fd 1 through write(2)
+    std::string Records() {
+        std::string text;
+        char buf[4096];
+        std::rewind(records);
+        for (ssize_t n; (n = read(fileno(records), buf, sizeof(buf))) > 0;) text.append(buf, static_cast<size_t>(n));
+        return text;
+    }
+};
+
+// How Shell::Dispatch runs a command: the scope is declared outside the
+// try, so its handlers report while it is still in effect
+bool Run(OutputFormat format, bool fail) {
+    std::optional<StructuredOutputScope> output;
+    try {
+        output.emplace(format);
+        std::cout << "progress\n";
+        RecordEmitter::Instance().Record("hash").Field("path", "a.pcap").Field("bytes", 42).Commit();
+        if (fail) throw RedTops::CommandError("hash: a.pcap: Permission denied");
+        return true;
+    } catch (const RedTops::RedTopsException& e) {
+        TerminalRenderer::Instance().PrintError(e.what());
+    }
+    return false;
+}
+
+} // namespace
+
+TEST_CASE("Structured output keeps records on stdout and text on stderr", "[output]") {
+    CapturedOutput capture;
+    REQUIRE(Run(OutputFormat::Ndjson, false));
+    CHECK(capture.Records() == "{\"type\":\"hash\",\"path\":\"a.pcap\",\"bytes\":42}\n");
+    CHECK(capture.out.str().empty());
+    CHECK(capture.err.str() == "progress\n");
+    CHECK_FALSE(RecordEmitter::Instance().Active());
+}
+
+TEST_CASE("Errors under --output go to stderr, after the records", "[output]") {
+    CapturedOutput capture;
+    REQUIRE_FALSE(Run(OutputFormat::Json, true));
+    std::string records = capture.Records();
+    CHECK(records.find("\"bytes\":42") != std::string::npos);
+    CHECK(records.find("ERROR") == std::string::npos);
+    CHECK(records.substr(records.size() - 3) == "\n]\n");
+    CHECK(capture.out.str().empty());
+    CHECK(capture.err.str().find("ERROR: hash: a.pcap: Permission denied") != std::string::npos);
+
+    // Text output leaves std::cout alone
+    REQUIRE_FALSE(Run(OutputFormat::Text, true));
+    CHECK(capture.out.str().find("ERROR: hash: a.pcap") != std::string::npos);
+}
@@ -0,0 +1,119 @@
+#include <catch2/catch_all.hpp>
+#include "../src/modules/headers/ResultStore.hpp"
+#include "test_helpers.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace RedTops;
+
+namespace {
+
+ResultRow Open(const std::string& host, uint16_t port) {
+    ResultRow r;
+    r.host = host;
+    r.port = port;
+    r.status = ResultStatus::Up;
+    return r;
+}
+
+} // namespace
+
+TEST_CASE("Result store round-trips runs and filters by kind, target and time", "[results]") {
+    TempDir dir;
+    ResultStore store(dir.path.string());
+
+    uint64_t a = store.Append(ResultKind::PortScan, "10.0.0.1", 1000, 50, {Open("10.0.0.1", 443), Open("10.0.0.1", 22)});
+    uint64_t b = store.Append(ResultKind::Ping, "10.0.0.2", 2000, 10, {Open("10.0.0.2", 0)});
+    uint64_t c = store.Append(ResultKind::PortScan, "10.0.0.1", 3000, 60, {Open("10.0.0.1", 22), Open("10.0.0.1", 8080)});
+    CHECK(a == 1);
+    CHECK(b == 2);
+    CHECK(c == 3);
+
+    RunFilter scans;
+    scans.any_kind = false;
+    scans.kind = ResultKind::PortScan;
+    CHECK(store.Runs(scans).size() == 2);
+    RunFilter late;
+    late.since_us = 1500;
+    CHECK(store.Runs(late).size() == 2);
+    RunFilter target;
+    target.target = "10.0.0.2";
+    REQUIRE(store.Runs(target).size() == 1);
+    CHECK(store.Runs(target)[0].kind == ResultKind::Ping);
+
+    // A fresh instance sees the same data
+    ResultStore reopened(dir.path.string());
+    RunInfo run;
+    REQUIRE(reopened.Run(a, run));
+    CHECK(run.target == "10.0.0.1");
+    CHECK(run.duration_ms == 50);
+    std::vector<ResultRow> rows = reopened.Rows(run);
+    REQUIRE(rows.size() == 2);
+    CHECK(rows[0].port == 22);     // sorted by (host, port)
+    CHECK(rows[1].port == 443);
+    CHECK_FALSE(reopened.Run(99, run));
+}
+
+TEST_CASE("Host lookups go through hosts.idx and the block dictionary", "[results]") {
+    TempDir dir;
+    ResultStore store(dir.path.string());
+    store.Append(ResultKind::Probe, "batch", 1, 1, {Open("a.example", 80), Open("b.example", 80), Open("b.example", 443)});
+    store.Append(ResultKind::Probe, "batch", 2, 1, {Open("c.example", 80)});
+
+    std::vector<uint64_t> ids = store.RunsWithHost("b.example");
+    REQUIRE(ids == std::vector<uint64_t>{1});
+    RunInfo run;
+    REQUIRE(store.Run(1, run));
+    std::vector<ResultRow> rows = store.Rows(run, "b.example");
+    REQUIRE(rows.size() == 2);
+    CHECK(rows[1].port == 443);
+    CHECK(store.Rows(run, "c.example").empty());
+    CHECK(store.RunsWithHost("nowhere").empty());
+}
+
+TEST_CASE("Diff reports opened, closed and changed ports", "[results]") {
+    std::vector<ResultRow> older = {Open("h", 22), Open("h", 80), Open("h", 443)};
+    std::vector<ResultRow> newer = {Open("h", 22), Open("h", 443), Open("h", 8080)};
+    newer[1].status = ResultStatus::Refused;
+
+    ResultDiff d = ResultStore::Diff(older, newer);
+    REQUIRE(d.added.size() == 1);
+    CHECK(d.added[0].port == 8080);
+    REQUIRE(d.removed.size() == 1);
+    CHECK(d.removed[0].port == 80);
+    REQUIRE(d.changed.size() == 1);
+    CHECK(d.changed[0].second.status == ResultStatus::Refused);
+}
+
+TEST_CASE("Corrupt blocks and torn index tails are detected", "[results]") {
+    TempDir dir;
+    ResultStore store(dir.path.string());
+    store.Append(ResultKind::PortScan, "x", 1, 1, {Open("x", 1)});
+
+    // A half-written index entry is ignored, then repaired by the next append
+    { std::ofstream(dir.path / "runs.idx", std::ios::app | std::ios::binary) << "partial"; }
+    CHECK(store.Runs().size() == 1);
+    CHECK(store.Append(ResultKind::PortScan, "x", 2, 1, {Open("x", 2)}) == 2);
+    CHECK(store.Runs().size() == 2);
+
+    // Likewise a torn hosts.idx entry, which would otherwise shift every later one
+    { std::ofstream(dir.path / "hosts.idx", std::ios::app | std::ios::binary) << "torn"; }
+    CHECK(store.Append(ResultKind::PortScan, "y", 3, 1, {Open("y.example", 3)}) == 3);
+    CHECK(store.RunsWithHost("y.example") == std::vector<uint64_t>{3});
+    CHECK(store.RunsWithHost("x") == std::vector<uint64_t>{1, 2});
+
+    // Flip a payload byte of the first block
+    {
+        std::fstream seg(dir.path / "seg-000001.dat", std::ios::in | std::ios::out | std::ios::binary);
+        seg.seekp(40);
+        seg.put('\x7f');
+    }
+    RunInfo run;
+    REQUIRE(store.Run(1, run));
+    CHECK_THROWS(store.Rows(run));
+    REQUIRE(store.Run(2, run));
+    CHECK(store.Rows(run).size() == 1);
+}
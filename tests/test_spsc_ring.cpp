@@ -0,0 +1,51 @@
+#include <catch2/catch_all.hpp>
+#include "../src/modules/headers/SpscRing.hpp"
+
+#include <cstdint>
+#include <thread>
+
+using namespace RedTops;
+
+TEST_CASE("SpscRing reports full and empty", "[spsc]") {
+    SpscRing<int> ring(3);
+    REQUIRE(ring.Capacity() == 4);
+    REQUIRE(ring.Front() == nullptr);
+
+    for (int i = 0; i < 4; ++i) {
+        int* slot = ring.BeginPush();
+        REQUIRE(slot != nullptr);
+        *slot = i;
+        ring.CommitPush();
+    }
+    REQUIRE(ring.BeginPush() == nullptr);
+
+    REQUIRE(*ring.Front() == 0);
+    ring.Pop();
+    REQUIRE(ring.BeginPush() != nullptr);
+}
+
+TEST_CASE("SpscRing keeps order across threads", "[spsc]") {
+    constexpr uint64_t kCount = 200000;
+    SpscRing<uint64_t> ring(64);
+
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < kCount; ++i) {
+            uint64_t* slot;
+            while (!(slot = ring.BeginPush())) std::this_thread::yield();
+            *slot = i;
+            ring.CommitPush();
+        }
+    });
+
+    uint64_t expected = 0;
+    bool in_order = true;
+    while (expected < kCount) {
+        uint64_t* v = ring.Front();
+        if (!v) { std::this_thread::yield(); continue; }
+        in_order &= *v == expected;
+        ring.Pop();
+        expected++;
+    }
+    producer.join();
+    REQUIRE(in_order);
+}
@@ -0,0 +1,194 @@
+#include <catch2/catch_all.hpp>
+#include "../src/modules/headers/TcpFlowTracker.hpp"
+#include "test_helpers.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace RedTops;
+
+namespace {
+
+constexpr uint32_t kClientIsn = 1000;
+constexpr uint32_t kServerIsn = 50000;
+
+// Builds the dissector's view of one IPv4 TCP segment; the payload is the
+// whole frame, so payload_offset is 0
+struct Segment {
+    DissectedPacket pkt;
+    std::vector<uint8_t> payload;
+
+    Segment(uint8_t src_host, uint16_t sport, uint8_t dst_host, uint16_t dport, uint8_t flags, uint32_t seq,
+            uint32_t ack = 0) {
+        pkt.l3 = L3Proto::IPv4;
+        pkt.l4_proto = 6;
+        pkt.flags = DissectFlag::HasPorts;
+        const uint8_t src[4] = {10, 0, 0, src_host}, dst[4] = {10, 0, 0, dst_host};
+        std::memcpy(pkt.src_addr, src, 4);
+        std::memcpy(pkt.dst_addr, dst, 4);
+        pkt.src_port = sport;
+        pkt.dst_port = dport;
+        pkt.tcp_flags = flags;
+        pkt.tcp_seq = seq;
+        pkt.tcp_ack = ack;
+    }
+
+    Segment& Data(const std::string& text) {
+        payload.assign(text.begin(), text.end());
+        pkt.payload_offset = 0;
+        pkt.payload_length = static_cast<uint32_t>(payload.size());
+        return *this;
+    }
+
+    void Feed(TcpFlowTracker& tracker, uint64_t ts_us) const { tracker.Process(pkt, payload.data(), ts_us); }
+};
+
+// 10.0.0.2:51000 is the client, 10.0.0.1:80 the server
+Segment FromClient(uint8_t flags, uint32_t seq, uint32_t ack = 0) { return Segment(2, 51000, 1, 80, flags, seq, ack); }
+Segment FromServer(uint8_t flags, uint32_t seq, uint32_t ack = 0) { return Segment(1, 80, 2, 51000, flags, seq, ack); }
+
+void Handshake(TcpFlowTracker& tracker, uint64_t ts_us = 1000) {
+    FromClient(TcpFlag::SYN, kClientIsn).Feed(tracker, ts_us);
+    FromServer(TcpFlag::SYN | TcpFlag::ACK, kServerIsn, kClientIsn + 1).Feed(tracker, ts_us + 250);
+    FromClient(TcpFlag::ACK, kClientIsn + 1, kServerIsn + 1).Feed(tracker, ts_us + 400);
+}
+
+} // namespace
+
+TEST_CASE("TCP tracker measures handshake RTT from the last SYN", "[tcp]") {
+    TcpFlowTracker tracker;
+    int callbacks = 0;
+    tracker.OnHandshake([&](const TcpFlow& f) {
+        ++callbacks;
+        CHECK(f.state == TcpFlowState::Established);
+    });
+
+    // The first SYN is lost and resent; Karn's rule times the resent one
+    FromClient(TcpFlag::SYN, kClientIsn).Feed(tracker, 1);
+    Handshake(tracker, 1000000);
+
+    REQUIRE(tracker.Flows().size() == 1);
+    const TcpFlow& f = *tracker.Flows()[0];
+    CHECK(f.ServerRttUs() == 250);
+    CHECK(f.ClientRttUs() == 150);
+    CHECK(f.HandshakeComplete());
+    CHECK(f.syn_retransmits == 1);
+    CHECK(f.Endpoint(f.client) == "10.0.0.2:51000");
+    CHECK(f.Endpoint(1 - f.client) == "10.0.0.1:80");
+    CHECK(callbacks == 1);
+    CHECK(tracker.Stats().handshakes == 1);
+    CHECK(tracker.Stats().retransmits == 1);
+}
+
+TEST_CASE("TCP tracker counts retransmitted payload", "[tcp]") {
+    TcpFlowTracker tracker;
+    Handshake(tracker);
+    FromClient(TcpFlag::ACK, kClientIsn + 1, kServerIsn + 1).Data(std::string(100, 'a')).Feed(tracker, 2000);
+    FromClient(TcpFlag::ACK, kClientIsn + 101, kServerIsn + 1).Data(std::string(100, 'b')).Feed(tracker, 2100);
+    // The first segment again, then one that only partly overlaps what was sent
+    FromClient(TcpFlag::ACK, kClientIsn + 1, kServerIsn + 1).Data(std::string(100, 'a')).Feed(tracker, 2500);
+    FromClient(TcpFlag::ACK, kClientIsn + 151, kServerIsn + 1).Data(std::string(100, 'c')).Feed(tracker, 2600);
+    FromServer(TcpFlag::ACK, kServerIsn + 1, kClientIsn + 251).Data("ok").Feed(tracker, 2700);
+
+    const TcpFlow& f = *tracker.Flows()[0];
+    const TcpDirection& c2s = f.dir[f.client];
+    const TcpDirection& s2c = f.dir[1 - f.client];
+    CHECK(c2s.retransmits == 2);
+    CHECK(c2s.bytes == 400);
+    CHECK(c2s.next_seq == kClientIsn + 251);
+    CHECK(s2c.retransmits == 0);
+    CHECK(s2c.bytes == 2);
+    CHECK(tracker.Stats().retransmits == 2);
+}
+
+TEST_CASE("TCP tracker reassembles out of order and gives up on a hole at the cap", "[tcp]") {
+    TempDir dir;
+    TcpTrackerOptions options;
+    options.reassemble = true;
+    options.stream_dir = dir.path.string();
+    options.per_flow_buffer = 64 * 1024;
+    const std::string c2s_path = (dir.path / "10.0.0.2_51000_10.0.0.1_80.c2s").string();
+
+    SECTION("a late segment fills its hole") {
+        TcpFlowTracker tracker(options);
+        Handshake(tracker);
+        FromClient(TcpFlag::ACK, kClientIsn + 6, kServerIsn + 1).Data("world").Feed(tracker, 2000);
+        CHECK(tracker.Stats().buffered_bytes == 5);
+        FromClient(TcpFlag::ACK, kClientIsn + 1, kServerIsn + 1).Data("hello").Feed(tracker, 2100);
+        tracker.Flush();
+        CHECK(ReadFile(c2s_path) == "helloworld");
+        CHECK(tracker.Stats().bytes_reassembled == 10);
+        CHECK(tracker.Stats().reassembly_gaps == 0);
+        CHECK(tracker.Stats().buffered_bytes == 0);
+    }
+
+    SECTION("a hole that outlasts the buffer is skipped") {
+        TcpFlowTracker tracker(options);
+        Handshake(tracker);
+        // The first 1000 bytes never arrive; 65 KiB behind them fit the cap, the 66th does not
+        const uint32_t origin = kClientIsn + 1 + 1000;
+        for (uint32_t i = 0; i < 70; ++i)
+            FromClient(TcpFlag::ACK, origin + i * 1000, kServerIsn + 1)
+                .Data(std::string(1000, static_cast<char>('A' + i % 26)))
+                .Feed(tracker, 2000 + i);
+        const TcpFlow& f = *tracker.Flows()[0];
+        CHECK(f.dir[f.client].gaps == 1);
+        CHECK(tracker.Stats().reassembly_gaps == 1);
+        // Delivery resumed at the segment that did not fit, and continued from there
+        CHECK(f.dir[f.client].delivered == 5 * 1000);
+        CHECK(tracker.Stats().buffered_bytes <= options.per_flow_buffer);
+        tracker.Flush();
+        std::string stream = ReadFile(c2s_path);
+        REQUIRE(stream.size() == 5000);
+        CHECK(stream.front() == static_cast<char>('A' + 65 % 26));
+    }
+}
+
+TEST_CASE("TCP tracker starts a new flow when a finished tuple sees a fresh SYN", "[tcp]") {
+    TcpFlowTracker tracker;
+    Handshake(tracker);
+    FromClient(TcpFlag::RST, kClientIsn + 1).Feed(tracker, 2000);
+    REQUIRE(tracker.Flows()[0]->state == TcpFlowState::Reset);
+
+    // Same ports, new connection: counted again and timed from its own SYN
+    FromClient(TcpFlag::SYN, kClientIsn + 7000).Feed(tracker, 5000);
+    FromServer(TcpFlag::SYN | TcpFlag::ACK, kServerIsn + 7000, kClientIsn + 7001).Feed(tracker, 5300);
+
+    REQUIRE(tracker.Flows().size() == 1);
+    const TcpFlow& f = *tracker.Flows()[0];
+    CHECK(f.first_us == 5000);
+    CHECK(f.ServerRttUs() == 300);
+    CHECK(f.syn_retransmits == 0);
+    CHECK(tracker.Stats().flows_created == 2);
+}
+
+TEST_CASE("TCP tracker evicts the least recently active flow", "[tcp]") {
+    TcpTrackerOptions options;
+    options.max_flows = 3;
+    TcpFlowTracker tracker(options);
+
+    auto open = [&](uint16_t port, uint64_t ts) { Segment(2, port, 1, 80, TcpFlag::SYN, kClientIsn).Feed(tracker, ts); };
+    open(1001, 1);
+    open(1002, 2);
+    open(1003, 3);
+    // 1001 is active again, leaving 1002 as the oldest
+    Segment(2, 1001, 1, 80, TcpFlag::ACK, kClientIsn + 1).Data("x").Feed(tracker, 4);
+    open(1004, 5);
+
+    std::vector<const TcpFlow*> flows = tracker.Flows();
+    REQUIRE(flows.size() == 3);
+    CHECK(flows[0]->Endpoint(flows[0]->client) == "10.0.0.2:1004");
+    CHECK(flows[1]->Endpoint(flows[1]->client) == "10.0.0.2:1001");
+    CHECK(flows[2]->Endpoint(flows[2]->client) == "10.0.0.2:1003");
+    CHECK(tracker.Stats().flows_created == 4);
+    CHECK(tracker.Stats().flows_evicted == 1);
+
+    // The evicted flow comes back as a new one, pushing out 1003
+    open(1002, 6);
+    flows = tracker.Flows();
+    CHECK(flows[0]->Endpoint(flows[0]->client) == "10.0.0.2:1002");
+    CHECK(flows[2]->Endpoint(flows[2]->client) == "10.0.0.2:1001");
+    CHECK(tracker.Stats().flows_evicted == 2);
+}
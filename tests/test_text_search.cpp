@@ -0,0 +1,174 @@
+#include <catch2/catch_all.hpp>
+#include "../src/modules/headers/FileSearcher.hpp"
+#include "../src/modules/headers/IgnoreRules.hpp"
+#include "../src/modules/headers/TextSearch.hpp"
+#include "test_helpers.hpp"
+
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+
+using namespace RedTops;
+namespace fs = std::filesystem;
+
+namespace {
+
+size_t FoldFind(std::string hay, std::string needle, size_t from) {
+    for (auto& c : hay) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    for (auto& c : needle) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    size_t at = hay.find(needle, from);
+    return at == std::string::npos ? kNoMatch : at;
+}
+
+} // namespace
+
+TEST_CASE("LiteralSearcher agrees with std::string::find at every offset", "[search]") {
+    std::mt19937 rng(7);
+    std::string hay(5000, 'a');
+    for (auto& c : hay) c = "abcAB\n"[rng() % 6];
+    for (std::string needle : {"a", "ab", "bca", "aBc", "cab\nab", "abcabcabcabcabcabcabcabcabcabcabcabcab"}) {
+        LiteralSearcher exact(needle, false);
+        LiteralSearcher folded(needle, true);
+        for (size_t from = 0; from < hay.size(); from += 37) {
+            size_t want = hay.find(needle, from);
+            CHECK(exact.Find(hay.data(), hay.size(), from) == (want == std::string::npos ? kNoMatch : want));
+            CHECK(folded.Find(hay.data(), hay.size(), from) == FoldFind(hay, needle, from));
+        }
+    }
+    // A match ending exactly at the buffer end, past the vector loop
+    std::string tail(100, 'x');
+    tail += "needle";
+    CHECK(LiteralSearcher("needle", false).Find(tail.data(), tail.size(), 0) == 100);
+    CHECK(LiteralSearcher("NEEDLE", true).Find(tail.data(), tail.size(), 0) == 100);
+    CHECK(LiteralSearcher("needles", false).Find(tail.data(), tail.size(), 0) == kNoMatch);
+}
+
+TEST_CASE("CountNewlines counts across vector boundaries", "[search]") {
+    std::string text;
+    size_t want = 0;
+    for (int i = 0; i < 1000; ++i) {
+        text += std::string(static_cast<size_t>(i % 23), 'x');
+        text += '\n';
+        ++want;
+    }
+    CHECK(CountNewlines(text.data(), text.size()) == want);
+    CHECK(CountNewlines(text.data() + 1, 0) == 0);
+}
+
+TEST_CASE("ScanBuffer reports each matching line once with its number and column", "[search]") {
+    std::string text = "alpha\nbeta gamma gamma\n\ndelta GAMMA\nlast gamma";
+    TextMatcher literal({"gamma"}, false, false);
+    std::vector<LineMatch> lines;
+    CHECK(ScanBuffer(literal, text.data(), text.size(), 0, &lines) == 2);
+    REQUIRE(lines.size() == 2);
+    CHECK(lines[0].line == 2);
+    CHECK(lines[0].column == 6);
+    CHECK(lines[0].text == "beta gamma gamma");
+    CHECK(lines[1].line == 5);
+    CHECK(lines[1].text == "last gamma");
+
+    TextMatcher folded({"gamma"}, false, true);
+    CHECK(ScanBuffer(folded, text.data(), text.size(), 0, nullptr) == 3);
+    CHECK(ScanBuffer(folded, text.data(), text.size(), 2, nullptr) == 2);
+
+    TextMatcher regex({"^(beta|delta) [a-z]+"}, false, false);
+    REQUIRE(regex.IsRegex());
+    lines.clear();
+    CHECK(ScanBuffer(regex, text.data(), text.size(), 0, &lines) == 1);
+    REQUIRE(lines.size() == 1);
+    CHECK(lines[0].match_length == 10);
+
+    TextMatcher several({"alpha", "delta"}, true, false);
+    CHECK_FALSE(several.IsRegex());
+    CHECK(ScanBuffer(several, text.data(), text.size(), 0, nullptr) == 2);
+
+    CHECK_THROWS(TextMatcher({"(unclosed"}, false, false));
+}
+
+TEST_CASE("GlobMatch and IgnoreRules follow gitignore semantics", "[search]") {
+    CHECK(GlobMatch("*.log", "app.log"));
+    CHECK_FALSE(GlobMatch("*.log", "dir/app.log"));
+    CHECK(GlobMatch("**/*.log", "app.log"));
+    CHECK(GlobMatch("**/*.log", "a/b/app.log"));
+    CHECK(GlobMatch("logs/**", "logs/a/b"));
+    CHECK(GlobMatch("a/**/z", "a/z"));
+    CHECK(GlobMatch("a/**/z", "a/b/c/z"));
+    CHECK(GlobMatch("file[0-9].?", "file7.c"));
+    CHECK_FALSE(GlobMatch("file[!0-9]", "file7"));
+    CHECK(GlobMatch("\\*literal", "*literal"));
+
+    IgnoreRules root("", "# comment\n*.tmp\nbuild/\n/only-top\n!keep.tmp\n");
+    CHECK(root.Ignored("x.tmp", false));
+    CHECK(root.Ignored("deep/er/x.tmp", false));
+    CHECK_FALSE(root.Ignored("keep.tmp", false));
+    CHECK(root.Ignored("build", true));
+    CHECK_FALSE(root.Ignored("build", false));
+    CHECK(root.Ignored("only-top", false));
+    CHECK_FALSE(root.Ignored("sub/only-top", false));
+
+    auto parent = std::make_shared<IgnoreRules>("", "*.tmp\n");
+    IgnoreRules child("sub", "!*.tmp\nlocal\n", parent);
+    CHECK_FALSE(child.Ignored("sub/a.tmp", false));
+    CHECK(child.Ignored("other/a.tmp", false));
+    CHECK(child.Ignored("sub/x/local", false));
+    CHECK_FALSE(child.Ignored("local", false));
+}
+
+TEST_CASE("FileSearcher walks a tree honoring .gitignore and filters", "[search]") {
+    TempDir dir;
+    WriteFile(dir.path / ".gitignore", "ignored/\n*.bak\n");
+    WriteFile(dir.path / "a.txt", "one\nIOC-1234\n");
+    WriteFile(dir.path / "sub" / "b.conf", "x\ny\nz IOC-1234 z\n");
+    WriteFile(dir.path / "sub" / ".gitignore", "secret.txt\n");
+    WriteFile(dir.path / "sub" / "secret.txt", "IOC-1234\n");
+    WriteFile(dir.path / "sub" / "c.bak", "IOC-1234\n");
+    WriteFile(dir.path / "ignored" / "d.txt", "IOC-1234\n");
+    WriteFile(dir.path / ".git" / "e", "IOC-1234\n");
+    WriteFile(dir.path / "bin.dat", std::string("\0\1IOC-1234", 10));
+    std::string big(1 << 20, 'q');
+    big += "\nIOC-1234 at the end\n";
+    WriteFile(dir.path / "sub" / "big.log", big);
+
+    TextMatcher matcher({"IOC-1234"}, false, false);
+    std::mutex mutex;
+    std::map<std::string, std::pair<uint64_t, bool>> found;
+    std::map<std::string, uint64_t> first_line;
+    auto collect = [&](const std::string& path, uint64_t n, const std::vector<LineMatch>& lines, bool binary) {
+        std::lock_guard<std::mutex> lock(mutex);
+        found[path] = {n, binary};
+        if (!lines.empty()) first_line[path] = lines.front().line;
+    };
+
+    FileSearcher::Options options;
+    options.threads = 4;
+    FileSearcher searcher(&matcher, options);
+    REQUIRE(searcher.Search(dir.path.string(), collect));
+    std::string root = dir.path.string() + "/";
+    CHECK(found.size() == 4);
+    CHECK(found.count(root + "a.txt"));
+    CHECK(first_line[root + "a.txt"] == 2);
+    CHECK(first_line[root + "sub/b.conf"] == 3);
+    CHECK(first_line[root + "sub/big.log"] == 2);
+    CHECK(found[root + "bin.dat"].second);
+    CHECK(searcher.Stats().matched_files == 4);
+
+    found.clear();
+    options.use_ignore_files = false;
+    options.excludes = {"sub/big.log"};
+    options.includes = {"*.txt", "*.bak"};
+    FileSearcher unfiltered(&matcher, options);
+    REQUIRE(unfiltered.Search(dir.path.string(), collect));
+    CHECK(found.size() == 4);     // a.txt, secret.txt, c.bak and ignored/d.txt; never .git
+    CHECK(found.count(root + "ignored/d.txt"));
+    CHECK_FALSE(found.count(root + ".git/e"));
+
+    found.clear();
+    FileSearcher::Options by_name;
+    by_name.includes = {"*.conf"};
+    FileSearcher lister(nullptr, by_name);
+    REQUIRE(lister.Search(dir.path.string(), collect));
+    CHECK(found.size() == 1);
+    CHECK(found.count(root + "sub/b.conf"));
+}
@@ -0,0 +1,36 @@
+#include <catch2/catch_all.hpp>
+#include "../src/modules/headers/TreeRemover.hpp"
+#include "test_helpers.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace RedTops;
+namespace fs = std::filesystem;
+
+TEST_CASE("TreeRemover deletes a nested tree without following symlinks", "[rm]") {
+    TempDir dir;
+    fs::path victim = dir.path / "victim";
+    fs::path keep = dir.path / "keep";
+    fs::create_directories(keep);
+    std::ofstream(keep / "precious") << "x";
+    for (int a = 0; a < 5; ++a)
+        for (int b = 0; b < 5; ++b) {
+            fs::path d = victim / std::to_string(a) / std::to_string(b);
+            fs::create_directories(d);
+            for (int f = 0; f < 40; ++f) std::ofstream(d / std::to_string(f)) << f;
+        }
+    fs::create_directories(victim / "empty" / "deeper");
+    fs::create_directory_symlink(keep, victim / "link-to-keep");
+
+    TreeRemover remover(4);
+    REQUIRE(remover.Remove(victim.string()));
+    RemoveStats st = remover.Stats();
+    CHECK(st.errors == 0);
+    CHECK(st.files == 5 * 5 * 40 + 1);
+    CHECK(st.dirs == 5 + 25 + 2 + 1);
+    CHECK_FALSE(fs::exists(victim));
+    CHECK(fs::exists(keep / "precious"));
+    CHECK_THROWS(remover.Remove((dir.path / "missing").string()));
+}